@@ -31,7 +31,11 @@
 #include <cassert>
 #include <chrono>
 #include <thread>
+#include <mutex>
+#include <functional>
+#include <type_traits>
 #include <unordered_set>
+#include <cstdio>
 // offsetof() is defined here
 #include <cstddef>
 #include <vector>
@@ -61,7 +65,6 @@ using NodeID = uint64_t;
 
 #include "sorted_small_set.h"
 #include "bloom_filter.h"
-#include "atomic_stack.h"
 
 // Copied from Linux kernel code to facilitate branch prediction unit on CPU
 // if there is one
@@ -148,6 +151,33 @@ extern bool print_flag;
 // The maximum number of nodes we could map in this index
 #define MAPPING_TABLE_SIZE ((size_t)(1 << 20))
 
+// The number of leaf contention counters; NodeIDs are hashed into it
+#define CONTENTION_TABLE_SIZE ((size_t)(1 << 14))
+
+// Leaves whose contention counter reaches this are split even if they are
+// below the split threshold (0 disables it). Counters are halved on each
+// epoch, so this is about half the CAS failures per epoch of a hot leaf
+#define LEAF_CONTENTION_SPLIT_THRESHOLD ((int)8)
+
+// Number of underfull leaves each thread could queue for deferred merge,
+// and the number of slots probed for a leaf. Leaves that do not fit are
+// queued again when they are visited after the queue is drained
+#define DEFERRED_MERGE_BUFFER_SIZE ((size_t)256)
+#define DEFERRED_MERGE_PROBE_LIMIT ((size_t)16)
+
+// Deferred merges are processed by the next write operation after the
+// epoch has advanced this many times (0 disables it)
+#define DEFERRED_MERGE_EPOCH_INTERVAL ((uint64_t)4)
+
+// After a failed CAS on leaf data deltas threads pause before retrying.
+// The number of spins doubles from the min to the max on each failure of
+// the same operation, after which threads yield instead
+#define BACKOFF_MIN_SPIN_COUNT ((size_t)4)
+#define BACKOFF_MAX_SPIN_COUNT ((size_t)1024)
+
+// Number of key-value pairs in each leaf of a frozen tree (see Freeze())
+#define FROZEN_LEAF_NODE_SIZE ((size_t)16)
+
 // If the length of delta chain exceeds ( >= ) this then we consolidate the node
 #define INNER_DELTA_CHAIN_LENGTH_THRESHOLD ((int)8)
 #define LEAF_DELTA_CHAIN_LENGTH_THRESHOLD ((int)8)
@@ -166,10 +196,12 @@ extern bool print_flag;
  *                               initialize it using placement new and then 
  *                               return its pointer
  *
- * This is used for InnerNode delta chains
+ * This is used for InnerNode delta chains. It must be expanded inside a
+ * member function of BwTree, since chunks grown for the new delta record
+ * are accounted in the tree's memory counter
  */
 #define InnerInlineAllocateOfType(T, node_p, ...) (static_cast<T *>( \
-                                                     new(ElasticNode<KeyNodeIDPair>::InlineAllocate( \
+                                                     new(InlineAllocateDelta<KeyNodeIDPair>( \
                                                          &node_p->GetLowKeyPair(), \
                                                          sizeof(T)) \
                                                      ) T{ __VA_ARGS__ } ))
@@ -179,18 +211,48 @@ extern bool print_flag;
  *                              initialize it using placement new and then 
  *                              return its pointer
  *
- * This is used for LeafNode delta chains
+ * This is used for LeafNode delta chains. See InnerInlineAllocateOfType()
  */
 #define LeafInlineAllocateOfType(T, node_p, ...) (static_cast<T *>( \
-                                                    new(ElasticNode<KeyValuePair>::InlineAllocate( \
+                                                    new(InlineAllocateDelta<KeyValuePair>( \
                                                         &node_p->GetLowKeyPair(), \
                                                         sizeof(T)) \
                                                     ) T{__VA_ARGS__} ))
 
+/*
+ * class VoidType - Maps any type to void
+ *
+ * This is used to detect member types with partial specialization
+ */
+template <typename T>
+class VoidType {
+ public:
+  using type = void;
+};
+
+/*
+ * class IsTransparentComparator - Whether a key comparator also compares
+ *                                 keys with other types
+ *
+ * As for std::less<void>, a comparator declares this by having a member
+ * type is_transparent. Lookups with a key view, e.g. a pointer and a length
+ * into a string, are only enabled for such comparators, and then do not
+ * need to construct a KeyType
+ */
+template <typename Comparator, typename = void>
+class IsTransparentComparator : public std::false_type {};
+
+template <typename Comparator>
+class IsTransparentComparator<
+  Comparator,
+  typename VoidType<typename Comparator::is_transparent>::type> : 
+  public std::true_type {};
+
 /*
  * class BwTreeBase - Base class of BwTree that stores some common members
  */
 class BwTreeBase {
+ protected:
   // This is the presumed size of cache line
   static constexpr size_t CACHE_LINE_SIZE = 64;
   
@@ -216,19 +278,28 @@ class BwTreeBase {
     void *node_p;
     GarbageNode *next_p;
     
+    // Number of bytes that will be freed with this garbage node. This is
+    // recorded when the node is unlinked such that memory accounting
+    // is exact even if the chain changes afterwards
+    size_t memory_size;
+    
     /*
      * Constructor
      */
-    GarbageNode(uint64_t p_delete_epoch, void *p_node_p) :
+    GarbageNode(uint64_t p_delete_epoch, 
+                void *p_node_p, 
+                size_t p_memory_size) :
       delete_epoch{p_delete_epoch},
       node_p{p_node_p},
-      next_p{nullptr}
+      next_p{nullptr},
+      memory_size{p_memory_size}
     {}
     
     GarbageNode() :
       delete_epoch{0UL},
       node_p{nullptr},
-      next_p{nullptr}
+      next_p{nullptr},
+      memory_size{0UL}
     {}
   };
   
@@ -257,7 +328,13 @@ class BwTreeBase {
     
     // The number of nodes inside this GC context
     // We use this as a threshold to trigger GC
-    uint64_t node_count;
+    uint32_t node_count;
+    
+    // The number of outstanding epoch pins held by this thread (e.g. by
+    // zero-copy iterators that refer to tree nodes directly). While this is
+    // non-zero last_active_epoch is not refreshed, such that nodes observed
+    // under the pin are not recycled
+    uint32_t pin_count;
     
     /*
      * Default constructor
@@ -266,7 +343,8 @@ class BwTreeBase {
       last_active_epoch{0UL},
       header{},
       last_p{&header},
-      node_count{0UL}
+      node_count{0U},
+      pin_count{0U}
     {}
   };
   
@@ -274,6 +352,323 @@ class BwTreeBase {
   static_assert(sizeof(GCMetaData) < CACHE_LINE_SIZE,
                 "class Data size exceeds cache line length!");
   
+  /*
+   * class MemoryCounter - Per-thread memory accounting of a tree instance
+   *
+   * Counters are only modified by the thread owning them, so no atomic
+   * instruction is needed. Memory is always subtracted from the counter of
+   * the thread freeing it, which might not be the thread allocating it, so
+   * a single counter could become negative, while the sum over all
+   * threads is exact
+   */
+  class MemoryCounter {
+   public:
+    // Bytes of base nodes, including the first chunk for delta records
+    // that is embedded into every base node
+    int64_t base_node_size;
+    
+    // Bytes of chunks grown for delta records after the base node is
+    // allocated, and of delta records allocated separately (remove and
+    // abort nodes)
+    int64_t delta_size;
+    
+    // Bytes of unlinked nodes that are pending reclamation. This is
+    // a subset of the two above
+    int64_t garbage_size;
+    
+    // Total bytes ever handed to the garbage collector and ever freed by
+    // it. These two only increase
+    int64_t retired_size;
+    int64_t freed_size;
+    
+    /*
+     * Default constructor
+     */
+    MemoryCounter() :
+      base_node_size{0L},
+      delta_size{0L},
+      garbage_size{0L},
+      retired_size{0L},
+      freed_size{0L}
+    {}
+    
+    /*
+     * Add() - Adds all counters of another instance into this one
+     */
+    void Add(const MemoryCounter &other) {
+      base_node_size += other.base_node_size;
+      delta_size += other.delta_size;
+      garbage_size += other.garbage_size;
+      retired_size += other.retired_size;
+      freed_size += other.freed_size;
+      
+      return;
+    }
+  };
+  
+  /*
+   * enum class CASSite - Places where a mapping table CAS could fail
+   *
+   * This is used as index into the per-site CAS failure counters
+   */
+  enum class CASSite : int {
+    // Leaf insert and delete delta
+    LeafData = 0,
+    // Installing a consolidated node
+    Consolidate,
+    // Leaf and inner split delta
+    Split,
+    // Index term insert and delete delta on the parent
+    IndexTermInsert,
+    IndexTermDelete,
+    // Leaf and inner remove delta
+    Remove,
+    // Leaf and inner merge delta
+    Merge,
+    // Abort delta blocking the parent of a removed node
+    Abort,
+    // Switching the root NodeID after a root split
+    Root,
+    
+    // This must be the last one
+    SiteCount,
+  };
+  
+  static constexpr int CAS_SITE_COUNT = static_cast<int>(CASSite::SiteCount);
+  
+  /*
+   * class OperationCounter - Per-thread statistics of tree operations
+   *
+   * Like MemoryCounter, each counter is only written by its owning thread
+   * with plain increments, so they could be left on in release builds
+   * without introducing any contention
+   */
+  class OperationCounter {
+   public:
+    // Calls to Insert(), ConditionalInsert() and Delete()
+    uint64_t insert_count;
+    uint64_t delete_count;
+    
+    // Point lookups and leaf level scans
+    uint64_t read_count;
+    uint64_t scan_count;
+    
+    // CAS failures on the mapping table, indexed by CASSite
+    uint64_t cas_failure_count[CAS_SITE_COUNT];
+    
+    // The number of times a traversal restarts from the root
+    uint64_t traverse_abort_count;
+    
+    // Successfully installed SMOs and consolidations
+    uint64_t consolidate_count;
+    uint64_t split_count;
+    uint64_t merge_count;
+    
+    // Removals finished by a thread that observed the abort node on the
+    // parent before the thread that started the removal
+    uint64_t removal_help_count;
+    
+    // Leaf splits that keep most items in the left node since keys are
+    // appended to the leaf; these are also counted in split_count
+    uint64_t append_split_count;
+    
+    // Leaf splits caused by contention rather than size; these are also
+    // counted in split_count
+    uint64_t contention_split_count;
+    
+    // Underfull leaves queued for a deferred merge, and those of them
+    // that were no longer underfull when the queue was processed
+    uint64_t deferred_merge_count;
+    uint64_t avoided_merge_count;
+    
+    // Pauses after failed leaf data CASes, the total number of spins in
+    // them, and the number of pauses that yielded the CPU instead
+    uint64_t backoff_count;
+    uint64_t backoff_spin_count;
+    uint64_t backoff_yield_count;
+    
+    // Traversals that restarted on a known leaf, i.e. retries after a
+    // failed leaf data CAS and writes after an asynchronous descent, and
+    // those that had to start from the root instead
+    uint64_t leaf_retry_count;
+    uint64_t root_retry_count;
+    
+    // Lookups and scans served by the frozen layout, and writes that
+    // found the tree frozen and thawed it
+    uint64_t frozen_read_count;
+    uint64_t thaw_count;
+    
+    /*
+     * Default constructor
+     */
+    OperationCounter() :
+      insert_count{0UL},
+      delete_count{0UL},
+      read_count{0UL},
+      scan_count{0UL},
+      cas_failure_count{},
+      traverse_abort_count{0UL},
+      consolidate_count{0UL},
+      split_count{0UL},
+      merge_count{0UL},
+      removal_help_count{0UL},
+      append_split_count{0UL},
+      contention_split_count{0UL},
+      deferred_merge_count{0UL},
+      avoided_merge_count{0UL},
+      backoff_count{0UL},
+      backoff_spin_count{0UL},
+      backoff_yield_count{0UL},
+      leaf_retry_count{0UL},
+      root_retry_count{0UL},
+      frozen_read_count{0UL},
+      thaw_count{0UL}
+    {}
+    
+    /*
+     * Add() - Adds all counters of another instance into this one
+     */
+    void Add(const OperationCounter &other) {
+      insert_count += other.insert_count;
+      delete_count += other.delete_count;
+      read_count += other.read_count;
+      scan_count += other.scan_count;
+      
+      for(int i = 0;i < CAS_SITE_COUNT;i++) {
+        cas_failure_count[i] += other.cas_failure_count[i];
+      }
+      
+      traverse_abort_count += other.traverse_abort_count;
+      consolidate_count += other.consolidate_count;
+      split_count += other.split_count;
+      merge_count += other.merge_count;
+      removal_help_count += other.removal_help_count;
+      append_split_count += other.append_split_count;
+      contention_split_count += other.contention_split_count;
+      deferred_merge_count += other.deferred_merge_count;
+      avoided_merge_count += other.avoided_merge_count;
+      backoff_count += other.backoff_count;
+      backoff_spin_count += other.backoff_spin_count;
+      backoff_yield_count += other.backoff_yield_count;
+      leaf_retry_count += other.leaf_retry_count;
+      root_retry_count += other.root_retry_count;
+      frozen_read_count += other.frozen_read_count;
+      thaw_count += other.thaw_count;
+      
+      return;
+    }
+    
+    /*
+     * CASFailed() - Records a CAS failure at the given site
+     */
+    inline void CASFailed(CASSite site) {
+      cas_failure_count[static_cast<int>(site)]++;
+      
+      return;
+    }
+  };
+  
+  /*
+   * class Backoff - Bounded exponential backoff of one operation
+   *
+   * Without it threads that failed to install a delta on a hot leaf retry
+   * at once, and most of the retries fail again on the same leaf. Each
+   * Wait() spins twice as long as the previous one until max_spin_count
+   * is exceeded, after which the thread only yields the CPU, such that a
+   * single operation never waits for long
+   */
+  class Backoff {
+   public:
+    size_t spin_count;
+    size_t max_spin_count;
+    
+    /*
+     * Constructor - max_spin_count being 0 disables backoff
+     */
+    Backoff(size_t p_max_spin_count) :
+      spin_count{BACKOFF_MIN_SPIN_COUNT},
+      max_spin_count{p_max_spin_count}
+    {}
+    
+    /*
+     * Pause() - Hints the CPU that this is a spin loop
+     */
+    static inline void Pause() {
+      #if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+      #endif
+      
+      return;
+    }
+    
+    /*
+     * Wait() - Waits before the next retry and records it
+     */
+    void Wait(OperationCounter *counter_p) {
+      if(max_spin_count == 0) {
+        return;
+      }
+      
+      counter_p->backoff_count++;
+      
+      if(spin_count > max_spin_count) {
+        counter_p->backoff_yield_count++;
+        
+        std::this_thread::yield();
+        
+        return;
+      }
+      
+      for(size_t i = 0;i < spin_count;i++) {
+        Pause();
+      }
+      
+      counter_p->backoff_spin_count += spin_count;
+      spin_count *= 2;
+      
+      return;
+    }
+  };
+  
+  // The number of fresh NodeIDs a thread reserves from the global counter
+  // in one atomic operation
+  static constexpr size_t NODE_ID_BLOCK_SIZE = 64;
+  
+  // The number of recycled NodeIDs a thread keeps before handing them to
+  // the shared pool as one batch. Batches are also taken from the pool
+  // with this size
+  static constexpr size_t NODE_ID_MAGAZINE_SIZE = 32;
+  
+  /*
+   * class NodeIDCache - Per-thread cache of NodeIDs
+   *
+   * IDs are first taken from the magazine of recycled IDs and then from
+   * the block of fresh IDs. Both are only accessed by the owning thread,
+   * so in the common case allocating and recycling a NodeID does not
+   * execute any atomic instruction. The shared pool and the global
+   * counter are only touched once per batch
+   */
+  class NodeIDCache {
+   public:
+    // Fresh IDs in range [next_id, end_id) reserved from the counter
+    NodeID next_id;
+    NodeID end_id;
+    
+    // Recycled IDs used as a stack
+    size_t recycled_count;
+    NodeID recycled_list[NODE_ID_MAGAZINE_SIZE];
+    
+    /*
+     * Default constructor
+     */
+    NodeIDCache() :
+      next_id{0UL},
+      end_id{0UL},
+      recycled_count{0UL},
+      recycled_list{}
+    {}
+  };
+  
   /*
    * class PaddedData - Padded data to the length of a cache line 
    */
@@ -300,12 +695,78 @@ class BwTreeBase {
   };
   
   using PaddedGCMetadata = PaddedData<GCMetaData, CACHE_LINE_SIZE>;
+  using PaddedMemoryCounter = PaddedData<MemoryCounter, CACHE_LINE_SIZE>;
+  
+  // Operation counters span more than one cache line; round it up to
+  // the next multiple of cache line size
+  using PaddedOperationCounter = \
+    PaddedData<OperationCounter,
+               (sizeof(OperationCounter) / CACHE_LINE_SIZE + 1) * \
+                 CACHE_LINE_SIZE>;
+  using PaddedNodeIDCache = \
+    PaddedData<NodeIDCache,
+               (sizeof(NodeIDCache) / CACHE_LINE_SIZE + 1) * \
+                 CACHE_LINE_SIZE>;
+  
+  // NodeIDs of underfull leaves whose merge is deferred
+  using DeferredMergeSet = std::unordered_set<NodeID>;
+  
+  /*
+   * class DeferredMergeBuffer - Deferred merges of one thread
+   *
+   * Only the owning thread fills empty slots, and whichever thread calls
+   * MergeDeferredNodes() empties them by exchanging with INVALID_NODE_ID,
+   * so neither side takes a lock. NodeIDs are hashed into the slots such
+   * that a leaf which is seen underfull repeatedly is usually found and
+   * only queued once
+   */
+  class DeferredMergeBuffer {
+   public:
+    std::atomic<NodeID> slot_list[DEFERRED_MERGE_BUFFER_SIZE];
+    
+    /*
+     * Default constructor
+     */
+    DeferredMergeBuffer() {
+      for(size_t i = 0;i < DEFERRED_MERGE_BUFFER_SIZE;i++) {
+        slot_list[i].store(INVALID_NODE_ID);
+      }
+    }
+  };
+  
+  using PaddedDeferredMergeBuffer = \
+    PaddedData<DeferredMergeBuffer,
+               (sizeof(DeferredMergeBuffer) / CACHE_LINE_SIZE + 1) * \
+                 CACHE_LINE_SIZE>;
+  
+  // Bytes of thread local data of each thread
+  static constexpr size_t THREAD_LOCAL_SIZE = \
+    sizeof(PaddedGCMetadata) + \
+    sizeof(PaddedMemoryCounter) + \
+    sizeof(PaddedOperationCounter) + \
+    sizeof(PaddedNodeIDCache) + \
+    sizeof(PaddedDeferredMergeBuffer);
   
   static_assert(sizeof(PaddedGCMetadata) == PaddedGCMetadata::ALIGNMENT, 
                 "class PaddedGCMetadata size does"
                 " not conform to the alignment!");
+  static_assert(sizeof(PaddedMemoryCounter) == \
+                  PaddedMemoryCounter::ALIGNMENT, 
+                "class PaddedMemoryCounter size does"
+                " not conform to the alignment!");
+  static_assert(sizeof(PaddedOperationCounter) == \
+                  PaddedOperationCounter::ALIGNMENT, 
+                "class PaddedOperationCounter size does"
+                " not conform to the alignment!");
+  static_assert(sizeof(PaddedNodeIDCache) == PaddedNodeIDCache::ALIGNMENT,
+                "class PaddedNodeIDCache size does"
+                " not conform to the alignment!");
+  static_assert(sizeof(PaddedDeferredMergeBuffer) == \
+                  PaddedDeferredMergeBuffer::ALIGNMENT,
+                "class PaddedDeferredMergeBuffer size does"
+                " not conform to the alignment!");
  
- private: 
+ protected: 
   // This is used as the garbage collection ID, and is maintained in a per
   // thread level
   // This is initialized to -1 in order to distinguish between registered 
@@ -320,6 +781,50 @@ class BwTreeBase {
   // The allocation aligns its address to cache line boundary
   PaddedGCMetadata *gc_metadata_p;
   
+  // This is the array of per-thread memory counters which is placed right
+  // after the GC metadata array
+  PaddedMemoryCounter *memory_counter_p;
+  
+  // This is the array of per-thread operation counters which is placed
+  // after the memory counter array
+  PaddedOperationCounter *operation_counter_p;
+  
+  // This is the array of per-thread NodeID caches which is placed after
+  // the operation counter array
+  PaddedNodeIDCache *node_id_cache_p;
+  
+  // This is the array of per-thread deferred merge buffers which is placed
+  // after the NodeID cache array
+  PaddedDeferredMergeBuffer *deferred_merge_buffer_p;
+  
+  // Counters of threads before the thread local array is reallocated, and
+  // of allocations made without a valid GC ID (i.e. inside constructor
+  // and destructor). This is only modified under single threaded
+  // environment
+  MemoryCounter unowned_memory_counter;
+  
+  // Operation counters of the same kind as unowned_memory_counter
+  OperationCounter unowned_operation_counter;
+  
+  // Recycled NodeIDs shared by all threads. Threads move IDs in and out
+  // in batches of node_id_magazine_size under the lock, and the size is
+  // mirrored in an atomic such that an empty pool could be detected
+  // without taking the lock
+  std::vector<NodeID> free_node_id_pool;
+  std::atomic<size_t> free_node_id_count;
+  std::mutex free_node_id_lock;
+  
+  // The number of recycled NodeIDs used as one batch, which is at most
+  // NODE_ID_MAGAZINE_SIZE. A smaller magazine makes IDs reachable to
+  // other threads sooner after they are recycled
+  size_t node_id_magazine_size;
+  
+  // Deferred merges of threads before the thread local array is
+  // reallocated. This is protected by the lock since it is taken by
+  // whichever thread processes deferred merges next
+  DeferredMergeSet unowned_deferred_merge_set;
+  std::mutex deferred_merge_lock;
+  
   // We use this to compute aligned memory address to be
   // used as the gc metadata array
   unsigned char *original_p;
@@ -352,10 +857,40 @@ class BwTreeBase {
     assert(original_p != nullptr);
     
     // Manually call destructor
+    // Memory counters are preserved since the memory they record is not
+    // freed together with the thread local array
     for(size_t i = 0;i < thread_num;i++) {
       assert((gc_metadata_p + i)->data.header.next_p == nullptr);
       
       (gc_metadata_p + i)->~PaddedGCMetadata();
+      
+      unowned_memory_counter.Add((memory_counter_p + i)->data);
+      (memory_counter_p + i)->~PaddedMemoryCounter();
+      
+      unowned_operation_counter.Add((operation_counter_p + i)->data);
+      (operation_counter_p + i)->~PaddedOperationCounter();
+      
+      // NodeIDs cached by the thread are given back to the shared pool,
+      // including fresh IDs that have never been used
+      NodeIDCache *cache_p = &(node_id_cache_p + i)->data;
+      PushFreeNodeID(cache_p->recycled_list, cache_p->recycled_count);
+      for(NodeID node_id = cache_p->next_id;
+          node_id < cache_p->end_id;
+          node_id++) {
+        PushFreeNodeID(&node_id, 1);
+      }
+      
+      (node_id_cache_p + i)->~PaddedNodeIDCache();
+      
+      DeferredMergeBuffer *buffer_p = &(deferred_merge_buffer_p + i)->data;
+      for(size_t j = 0;j < DEFERRED_MERGE_BUFFER_SIZE;j++) {
+        NodeID node_id = buffer_p->slot_list[j].load();
+        if(node_id != INVALID_NODE_ID) {
+          unowned_deferred_merge_set.insert(node_id);
+        }
+      }
+      
+      (deferred_merge_buffer_p + i)->~PaddedDeferredMergeBuffer();
     }
     
     // Free memory using original pointer rather than adjusted pointer
@@ -373,10 +908,12 @@ class BwTreeBase {
     bwt_printf("Preparing %lu thread local slots\n", thread_num);
     
     // This is the unaligned base address
-    // We allocate one more element than requested as the buffer
-    // for doing alignment
+    // We allocate one more cache line than requested as the buffer
+    // for doing alignment. Each thread has one GC metadata, one
+    // memory counter, one operation counter, one NodeID cache and one
+    // deferred merge buffer
     original_p = static_cast<unsigned char *>(
-      malloc(CACHE_LINE_SIZE * (thread_num + 1)));
+      malloc(THREAD_LOCAL_SIZE * thread_num + CACHE_LINE_SIZE));
     assert(original_p != nullptr);
     
     // Align the address to cache line boundary
@@ -387,13 +924,34 @@ class BwTreeBase {
     // Make sure it is aligned
     assert(((size_t)gc_metadata_p % CACHE_LINE_SIZE) == 0);
     
+    // Memory counters are stored after all GC metadata
+    memory_counter_p = \
+      reinterpret_cast<PaddedMemoryCounter *>(gc_metadata_p + thread_num);
+    
+    // Operation counters are stored after all memory counters
+    operation_counter_p = \
+      reinterpret_cast<PaddedOperationCounter *>(memory_counter_p + thread_num);
+    
+    // NodeID caches are stored after all operation counters
+    node_id_cache_p = \
+      reinterpret_cast<PaddedNodeIDCache *>(operation_counter_p + thread_num);
+    
+    // Deferred merge buffers are stored after all NodeID caches
+    deferred_merge_buffer_p = \
+      reinterpret_cast<PaddedDeferredMergeBuffer *>(node_id_cache_p + thread_num);
+    
     // Make sure we do not overflow the chunk of memory
-    assert(((size_t)gc_metadata_p + thread_num * CACHE_LINE_SIZE) <= \
-             ((size_t)original_p + (thread_num + 1) * CACHE_LINE_SIZE));
+    assert(((size_t)(deferred_merge_buffer_p + thread_num)) <= \
+             ((size_t)original_p + THREAD_LOCAL_SIZE * thread_num + \
+              CACHE_LINE_SIZE));
     
     // At last call constructor of the class; we use placement new
     for(size_t i = 0;i < thread_num;i++) {
       new (gc_metadata_p + i) PaddedGCMetadata{};
+      new (memory_counter_p + i) PaddedMemoryCounter{};
+      new (operation_counter_p + i) PaddedOperationCounter{};
+      new (node_id_cache_p + i) PaddedNodeIDCache{};
+      new (deferred_merge_buffer_p + i) PaddedDeferredMergeBuffer{};
     }
     
     return; 
@@ -415,6 +973,18 @@ class BwTreeBase {
    */
   BwTreeBase() :
     gc_metadata_p{nullptr},
+    memory_counter_p{nullptr},
+    operation_counter_p{nullptr},
+    node_id_cache_p{nullptr},
+    deferred_merge_buffer_p{nullptr},
+    unowned_memory_counter{},
+    unowned_operation_counter{},
+    free_node_id_pool{},
+    free_node_id_count{0UL},
+    free_node_id_lock{},
+    node_id_magazine_size{NODE_ID_MAGAZINE_SIZE},
+    unowned_deferred_merge_set{},
+    deferred_merge_lock{},
     original_p{nullptr},
     thread_num{total_thread_num.load()},
     epoch{0UL} {
@@ -445,6 +1015,27 @@ class BwTreeBase {
     return thread_num; 
   }
   
+  /*
+   * SetNodeIDMagazineSize() - Sets the number of recycled NodeIDs a thread
+   *                           keeps before handing them to the shared pool
+   *
+   * With a small magazine, IDs of removed nodes are reused by other
+   * threads soon after they are recycled, at the cost of taking the pool
+   * lock more often. The size must be between 1 and NODE_ID_MAGAZINE_SIZE,
+   * otherwise nothing is changed and false is returned
+   *
+   * NOTE: This should be called before the tree is shared by threads
+   */
+  bool SetNodeIDMagazineSize(size_t magazine_size) {
+    if((magazine_size == 0UL) || (magazine_size > NODE_ID_MAGAZINE_SIZE)) {
+      return false;
+    }
+    
+    node_id_magazine_size = magazine_size;
+    
+    return true;
+  }
+  
   /*
    * AssignGCID() - Assigns a gc_id manually
    *
@@ -456,6 +1047,15 @@ class BwTreeBase {
     return;
   }
   
+  /*
+   * GetGCID() - Returns the gc_id of the calling thread
+   *
+   * This is -1 if no ID has been assigned to the thread
+   */
+  inline static int GetGCID() {
+    return gc_id;
+  }
+  
   /*
    * RegisterThread() - Registers a thread for GC for all instances of BwTree
    *                    in the current process's address space
@@ -505,7 +1105,55 @@ class BwTreeBase {
    * resources have been released
    */
   inline void UpdateLastActiveEpoch() {
-    GetCurrentGCMetaData()->last_active_epoch = GetGlobalEpoch();
+    GCMetaData *metadata_p = GetCurrentGCMetaData();
+    
+    // If the thread is holding pinned references then the epoch must
+    // stay where it was when the first pin was taken
+    if(metadata_p->pin_count == 0UL) {
+      metadata_p->last_active_epoch = GetGlobalEpoch();
+    }
+    
+    return;
+  }
+  
+  /*
+   * PinLastActiveEpoch() - Prevents the last active epoch of the current
+   *                        thread from being refreshed
+   *
+   * Pins could be nested; the epoch is frozen until the last pin is released
+   */
+  inline void PinLastActiveEpoch() {
+    GetCurrentGCMetaData()->pin_count++;
+    
+    return;
+  }
+  
+  /*
+   * AdvancePinnedEpoch() - Moves the last active epoch of a thread holding
+   *                        pins forward to the given epoch
+   *
+   * The caller must not hold any reference observed before that epoch,
+   * e.g. because all pinned operations that started earlier have finished
+   */
+  inline void AdvancePinnedEpoch(uint64_t p_epoch) {
+    GCMetaData *metadata_p = GetCurrentGCMetaData();
+    
+    assert(metadata_p->pin_count != 0UL);
+    if(p_epoch > metadata_p->last_active_epoch) {
+      metadata_p->last_active_epoch = p_epoch;
+    }
+    
+    return;
+  }
+  
+  /*
+   * UnpinLastActiveEpoch() - Releases a pin taken by PinLastActiveEpoch()
+   */
+  inline void UnpinLastActiveEpoch() {
+    GCMetaData *metadata_p = GetCurrentGCMetaData();
+    
+    assert(metadata_p->pin_count != 0UL);
+    metadata_p->pin_count--;
     
     return;
   }
@@ -550,43 +1198,283 @@ class BwTreeBase {
   }
   
   /*
-   * SummarizeGCEpoch() - Returns the minimum epochs among the current epoch
-   *                      counters of all threads
+   * GetCurrentMemoryCounter() - Returns the memory counter of the current
+   *                             thread
    *
-   * Note that if this is called then it must be true that there are at least
-   * one thread participating into the GC process
+   * If the thread does not have a valid GC ID then the unowned counter is
+   * returned. This only happens in constructor and destructor which are
+   * single threaded
    */
-  uint64_t SummarizeGCEpoch() {
-    assert(thread_num >= 1);
+  inline MemoryCounter *GetCurrentMemoryCounter() {
+    if((gc_id < 0) || (gc_id >= static_cast<int>(thread_num))) {
+      return &unowned_memory_counter;
+    }
     
-    // Use the first metadata's epoch as min and update it on the fly
-    uint64_t min_epoch = GetGCMetaData(0)->last_active_epoch;
+    return &(memory_counter_p + gc_id)->data;
+  }
+  
+  /*
+   * GetCurrentOperationCounter() - Returns the operation counter of the
+   *                                current thread
+   *
+   * Threads without a valid GC ID share the unowned counter. See
+   * GetCurrentMemoryCounter()
+   */
+  inline OperationCounter *GetCurrentOperationCounter() {
+    if((gc_id < 0) || (gc_id >= static_cast<int>(thread_num))) {
+      return &unowned_operation_counter;
+    }
     
-    // This might not be executed if there is only one thread
-    for(int i = 1; i < static_cast<int>(thread_num); i++) {
-      // Note: std::min pass a const & of into the function. We need to first copy the shared GetGCMetaData(i)->last_active_epoch
-      // into a local variable before calling std::min. Otherwise we will have a Heisenbug where std::min first check which one is smaller,
-      // and before it returns, other thread modify the variable and we actually return the larger one.
-      auto ts = GetGCMetaData(i)->last_active_epoch;
-      min_epoch = std::min(ts, min_epoch);
+    return &(operation_counter_p + gc_id)->data;
+  }
+  
+  /*
+   * GetCurrentNodeIDCache() - Returns the NodeID cache of the current thread
+   *
+   * Threads without a valid GC ID do not have a cache, in which case
+   * nullptr is returned and the shared pool should be used directly
+   */
+  inline NodeIDCache *GetCurrentNodeIDCache() {
+    if((gc_id < 0) || (gc_id >= static_cast<int>(thread_num))) {
+      return nullptr;
     }
     
-    return min_epoch;
+    return &(node_id_cache_p + gc_id)->data;
   }
-};
-
-/*
- * class BwTree - Lock-free BwTree index implementation
- *
- * Template Arguments:
- *
- * template <typename KeyType,
- *           typename ValueType,
- *           typename KeyComparator = std::less<KeyType>,
- *           typename KeyEqualityChecker = std::equal_to<KeyType>,
- *           typename KeyHashFunc = std::hash<KeyType>,
- *           typename ValueEqualityChecker = std::equal_to<ValueType>,
- *           typename ValueHashFunc = std::hash<ValueType>>
+  
+  /*
+   * PushFreeNodeID() - Adds NodeIDs to the shared pool
+   */
+  void PushFreeNodeID(const NodeID *node_id_list, size_t count) {
+    if(count == 0UL) {
+      return;
+    }
+    
+    std::lock_guard<std::mutex> guard{free_node_id_lock};
+    
+    free_node_id_pool.insert(free_node_id_pool.end(),
+                             node_id_list,
+                             node_id_list + count);
+    free_node_id_count.store(free_node_id_pool.size(),
+                             std::memory_order_relaxed);
+    
+    return;
+  }
+  
+  /*
+   * PopFreeNodeID() - Moves at most count NodeIDs from the shared pool into
+   *                   the given array
+   *
+   * Returns the number of NodeIDs moved. The lock is not taken if the pool
+   * looks empty, which is the case unless nodes have been removed
+   */
+  size_t PopFreeNodeID(NodeID *node_id_list, size_t count) {
+    if(free_node_id_count.load(std::memory_order_relaxed) == 0UL) {
+      return 0UL;
+    }
+    
+    std::lock_guard<std::mutex> guard{free_node_id_lock};
+    
+    size_t pop_count = std::min(count, free_node_id_pool.size());
+    std::copy(free_node_id_pool.end() - pop_count,
+              free_node_id_pool.end(),
+              node_id_list);
+    free_node_id_pool.resize(free_node_id_pool.size() - pop_count);
+    free_node_id_count.store(free_node_id_pool.size(),
+                             std::memory_order_relaxed);
+    
+    return pop_count;
+  }
+  
+  /*
+   * RecycleNodeID() - Puts a NodeID that is no longer used into the
+   *                   current thread's magazine
+   *
+   * If the magazine is full then all of its IDs are moved to the shared
+   * pool at once
+   */
+  void RecycleNodeID(NodeID node_id) {
+    NodeIDCache *cache_p = GetCurrentNodeIDCache();
+    if(cache_p == nullptr) {
+      PushFreeNodeID(&node_id, 1);
+      
+      return;
+    }
+    
+    if(cache_p->recycled_count >= node_id_magazine_size) {
+      PushFreeNodeID(cache_p->recycled_list, cache_p->recycled_count);
+      cache_p->recycled_count = 0UL;
+    }
+    
+    cache_p->recycled_list[cache_p->recycled_count] = node_id;
+    cache_p->recycled_count++;
+    
+    return;
+  }
+  
+  /*
+   * DeferMerge() - Queues an underfull node in the current thread's
+   *                deferred merge buffer
+   *
+   * Returns false if the thread does not have a valid GC ID, in which case
+   * the caller should not defer the merge. If there is no free slot near
+   * the hashed one then the node is not queued this time, which is still
+   * reported as deferred such that a burst of deletes does not turn into
+   * immediate merges
+   */
+  bool DeferMerge(NodeID node_id) {
+    if((gc_id < 0) || (gc_id >= static_cast<int>(thread_num))) {
+      return false;
+    }
+    
+    DeferredMergeBuffer *buffer_p = &(deferred_merge_buffer_p + gc_id)->data;
+    
+    // Probe from the hashed slot until the NodeID or an empty slot is
+    // found. Slots emptied by a concurrent drain might let a NodeID be
+    // queued twice, which is fine since drained NodeIDs are deduplicated
+    for(size_t i = 0;i < DEFERRED_MERGE_PROBE_LIMIT;i++) {
+      std::atomic<NodeID> *slot_p = \
+        &buffer_p->slot_list[(node_id + i) % DEFERRED_MERGE_BUFFER_SIZE];
+      NodeID slot_node_id = slot_p->load();
+      
+      // Underfull nodes are visited repeatedly before they are merged,
+      // but each of them is only queued once
+      if(slot_node_id == node_id) {
+        return true;
+      }
+      
+      // Other threads only ever empty slots, so a plain store is enough
+      if(slot_node_id == INVALID_NODE_ID) {
+        slot_p->store(node_id);
+        GetCurrentOperationCounter()->deferred_merge_count++;
+        
+        return true;
+      }
+    }
+    
+    return true;
+  }
+  
+  /*
+   * TakeDeferredMergeSet() - Moves deferred merges of all threads and of
+   *                          unregistered threads into the given set
+   */
+  void TakeDeferredMergeSet(DeferredMergeSet *merge_set_p) {
+    for(size_t i = 0;i < thread_num;i++) {
+      DeferredMergeBuffer *buffer_p = &(deferred_merge_buffer_p + i)->data;
+      
+      for(size_t j = 0;j < DEFERRED_MERGE_BUFFER_SIZE;j++) {
+        std::atomic<NodeID> *slot_p = &buffer_p->slot_list[j];
+        
+        // Only write to slots that are in use
+        if(slot_p->load() == INVALID_NODE_ID) {
+          continue;
+        }
+        
+        NodeID node_id = slot_p->exchange(INVALID_NODE_ID);
+        if(node_id != INVALID_NODE_ID) {
+          merge_set_p->insert(node_id);
+        }
+      }
+    }
+    
+    std::lock_guard<std::mutex> guard{deferred_merge_lock};
+    
+    merge_set_p->insert(unowned_deferred_merge_set.begin(),
+                        unowned_deferred_merge_set.end());
+    unowned_deferred_merge_set.clear();
+    
+    return;
+  }
+  
+  /*
+   * SummarizeFreeNodeID() - Returns the number of NodeIDs that are either
+   *                         in the shared pool or cached by threads
+   *
+   * This has the same synchronization caveat as SummarizeMemoryCounter()
+   */
+  size_t SummarizeFreeNodeID() {
+    size_t count = free_node_id_count.load(std::memory_order_relaxed);
+    
+    for(size_t i = 0; i < thread_num; i++) {
+      const NodeIDCache *cache_p = &(node_id_cache_p + i)->data;
+      
+      count += cache_p->recycled_count;
+      count += cache_p->end_id - cache_p->next_id;
+    }
+    
+    return count;
+  }
+  
+  /*
+   * SummarizeOperationCounter() - Returns the sum of all operation counters
+   *
+   * This has the same synchronization caveat as SummarizeMemoryCounter()
+   */
+  OperationCounter SummarizeOperationCounter() {
+    OperationCounter counter{unowned_operation_counter};
+    
+    for(size_t i = 0; i < thread_num; i++) {
+      counter.Add((operation_counter_p + i)->data);
+    }
+    
+    return counter;
+  }
+  
+  /*
+   * SummarizeMemoryCounter() - Returns the sum of all memory counters
+   *
+   * Counters of other threads are read without synchronization, so the
+   * result is only exact if no other thread is modifying the tree
+   */
+  MemoryCounter SummarizeMemoryCounter() {
+    MemoryCounter counter{unowned_memory_counter};
+    
+    for(size_t i = 0; i < thread_num; i++) {
+      counter.Add((memory_counter_p + i)->data);
+    }
+    
+    return counter;
+  }
+  
+  /*
+   * SummarizeGCEpoch() - Returns the minimum epochs among the current epoch
+   *                      counters of all threads
+   *
+   * Note that if this is called then it must be true that there are at least
+   * one thread participating into the GC process
+   */
+  uint64_t SummarizeGCEpoch() {
+    assert(thread_num >= 1);
+    
+    // Use the first metadata's epoch as min and update it on the fly
+    uint64_t min_epoch = GetGCMetaData(0)->last_active_epoch;
+    
+    // This might not be executed if there is only one thread
+    for(int i = 1; i < static_cast<int>(thread_num); i++) {
+      // Note: std::min pass a const & of into the function. We need to first copy the shared GetGCMetaData(i)->last_active_epoch
+      // into a local variable before calling std::min. Otherwise we will have a Heisenbug where std::min first check which one is smaller,
+      // and before it returns, other thread modify the variable and we actually return the larger one.
+      auto ts = GetGCMetaData(i)->last_active_epoch;
+      min_epoch = std::min(ts, min_epoch);
+    }
+    
+    return min_epoch;
+  }
+};
+
+/*
+ * class BwTree - Lock-free BwTree index implementation
+ *
+ * Template Arguments:
+ *
+ * template <typename KeyType,
+ *           typename ValueType,
+ *           typename KeyComparator = std::less<KeyType>,
+ *           typename KeyEqualityChecker = std::equal_to<KeyType>,
+ *           typename KeyHashFunc = std::hash<KeyType>,
+ *           typename ValueEqualityChecker = std::equal_to<ValueType>,
+ *           typename ValueHashFunc = std::hash<ValueType>>
  *
  * Explanation:
  *
@@ -745,6 +1633,40 @@ class BwTree : public BwTreeBase {
       // First compare keys for relation
       return (*key_cmp_obj_p)(knp1.first, knp2.first);
     }
+
+    /*
+     * operator() - Compares a key NodeID pair with a bare key
+     *
+     * These two are used by std::lower_bound() and std::upper_bound() 
+     * respectively, such that searching does not require constructing 
+     * a pair (and thus copying the search key)
+     */
+    inline bool operator()(const KeyNodeIDPair &knp,
+                           const KeyType &key) const {
+      return (*key_cmp_obj_p)(knp.first, key);
+    }
+    
+    inline bool operator()(const KeyType &key,
+                           const KeyNodeIDPair &knp) const {
+      return (*key_cmp_obj_p)(key, knp.first);
+    }
+    
+    /*
+     * operator() - Compares a key NodeID pair with a key view
+     *
+     * These are only used with transparent comparators
+     */
+    template <typename SearchKeyType>
+    inline bool operator()(const KeyNodeIDPair &knp,
+                           const SearchKeyType &key) const {
+      return (*key_cmp_obj_p)(knp.first, key);
+    }
+    
+    template <typename SearchKeyType>
+    inline bool operator()(const SearchKeyType &key,
+                           const KeyNodeIDPair &knp) const {
+      return (*key_cmp_obj_p)(key, knp.first);
+    }
   };
 
   /*
@@ -844,6 +1766,39 @@ class BwTree : public BwTreeBase {
                            const KeyValuePair &kvp2) const {
       return (*key_cmp_obj_p)(kvp1.first, kvp2.first);
     }
+
+    /*
+     * operator() - Compares a key-value pair with a bare key
+     *
+     * This avoids constructing a key-value pair (which copies the key 
+     * and default constructs a value) when searching a leaf node
+     */
+    inline bool operator()(const KeyValuePair &kvp,
+                           const KeyType &key) const {
+      return (*key_cmp_obj_p)(kvp.first, key);
+    }
+    
+    inline bool operator()(const KeyType &key,
+                           const KeyValuePair &kvp) const {
+      return (*key_cmp_obj_p)(key, kvp.first);
+    }
+    
+    /*
+     * operator() - Compares a key-value pair with a key view
+     *
+     * These are only used with transparent comparators
+     */
+    template <typename SearchKeyType>
+    inline bool operator()(const KeyValuePair &kvp,
+                           const SearchKeyType &key) const {
+      return (*key_cmp_obj_p)(kvp.first, key);
+    }
+    
+    template <typename SearchKeyType>
+    inline bool operator()(const SearchKeyType &key,
+                           const KeyValuePair &kvp) const {
+      return (*key_cmp_obj_p)(key, kvp.first);
+    }
   };
 
   /*
@@ -971,6 +1926,36 @@ class BwTree : public BwTreeBase {
   inline bool KeyCmpLessEqual(const KeyType &key1, const KeyType &key2) const {
     return !KeyCmpGreater(key1, key2);
   }
+  
+  /*
+   * KeyCmpLess() - Compares a key with a key view for "less than" relation
+   *
+   * This and the following overloads are used by lookups with a key view
+   * (see LookupValues()), and either argument could be the view. They are
+   * only instantiated if the comparator is transparent, in which case the
+   * equality checker must also accept key views
+   */
+  template <typename KeyType1, typename KeyType2>
+  inline bool KeyCmpLess(const KeyType1 &key1, const KeyType2 &key2) const {
+    return key_cmp_obj(key1, key2);
+  }
+  
+  template <typename KeyType1, typename KeyType2>
+  inline bool KeyCmpEqual(const KeyType1 &key1, const KeyType2 &key2) const {
+    return key_eq_obj(key1, key2);
+  }
+  
+  template <typename KeyType1, typename KeyType2>
+  inline bool KeyCmpGreaterEqual(const KeyType1 &key1,
+                                 const KeyType2 &key2) const {
+    return !KeyCmpLess(key1, key2);
+  }
+  
+  template <typename KeyType1, typename KeyType2>
+  inline bool KeyCmpGreater(const KeyType1 &key1,
+                            const KeyType2 &key2) const {
+    return KeyCmpLess(key2, key1);
+  }
 
   ///////////////////////////////////////////////////////////////////
   // Value Comparison Member
@@ -984,17 +1969,27 @@ class BwTree : public BwTreeBase {
   }
 
   /*
-   * class Context - Stores per thread context data that is used during
-   *                 tree traversal
+   * class BasicContext - Stores per thread context data that is used during
+   *                      tree traversal
+   *
+   * SearchKeyType is KeyType for all operations except lookups with a key
+   * view (see LookupValues()), which only take read optimized traversals
    *
    * NOTE: For each thread there could be only 1 instance of this object
    * so we forbid copy construction and assignment and move
    */
-  class Context {
+  template <typename SearchKeyType>
+  class BasicContext {
    public:
-    // We choose to keep the search key as a member rather than pointer
-    // inside the context object
-    const KeyType search_key;
+    // We keep a reference to the search key rather than a copy, since for
+    // key types like std::string or Peloton's generic keys copying the key
+    // is a heap allocation, and it would otherwise be done for every
+    // operation and every retry inside Insert()/Delete()
+    //
+    // NOTE: This requires the key object passed to the constructor to
+    // outlive the context object. All callers construct the context from
+    // a function argument or a local variable in the enclosing scope
+    const SearchKeyType &search_key;
 
     // We only need to keep current snapshot and parent snapshot
     NodeSnapshot current_snapshot;
@@ -1020,21 +2015,25 @@ class BwTree : public BwTreeBase {
     // and other functions just return on seeing this flag
     bool abort_flag;
 
+    // Whether underfull leaves on the path are removed even if merges
+    // are deferred. This is set when processing deferred merges
+    bool merge_now;
+
+    // Whether this is a read optimized traversal, which does not keep the
+    // parent snapshot and therefore must not help along or post SMOs
+    bool read_optimized;
+
+    // Whether the traversal is for inserting the search key. Only then
+    // could a full leaf be split as receiving appended keys
+    bool is_insert;
+
     /*
      * Constructor - Initialize a context object into initial state
      */
-    inline Context(const KeyType &p_search_key) :
-      #ifdef BWTREE_PELOTON
-
-      // Because earlier versions of g++ does not support
-      // initializer list so must use () form
+    inline BasicContext(const SearchKeyType &p_search_key) :
+      // Always use () form here, since earlier versions of g++ bind a
+      // reference member initialized with {} to a temporary copy
       search_key(p_search_key),
-
-      #else
-
-      search_key{p_search_key},
-
-      #endif
       
       #ifdef BWTREE_DEBUG
       
@@ -1043,13 +2042,16 @@ class BwTree : public BwTreeBase {
       
       #endif
       
-      abort_flag{false}
+      abort_flag{false},
+      merge_now{false},
+      read_optimized{false},
+      is_insert{false}
     {}
 
     /*
      * Destructor - Cleanup
      */
-    ~Context() {}
+    ~BasicContext() {}
 
     /*
      * Copy constructor - deleted
@@ -1057,10 +2059,10 @@ class BwTree : public BwTreeBase {
      * Move constructor - deleted
      * Move assignment - deleted
      */
-    Context(const Context &p_context) = delete;
-    Context &operator=(const Context &p_context) = delete;
-    Context(Context &&p_context) = delete;
-    Context &operator=(Context &&p_context) = delete;
+    BasicContext(const BasicContext &p_context) = delete;
+    BasicContext &operator=(const BasicContext &p_context) = delete;
+    BasicContext(BasicContext &&p_context) = delete;
+    BasicContext &operator=(BasicContext &&p_context) = delete;
 
     #ifdef BWTREE_DEBUG
     
@@ -1089,6 +2091,9 @@ class BwTree : public BwTreeBase {
       return parent_snapshot.node_id == INVALID_NODE_ID;
     }
   };
+  
+  // Context of all operations that search with a KeyType
+  using Context = BasicContext<KeyType>;
 
   /*
    * class NodeMetaData - Holds node metadata in an object
@@ -1814,21 +2819,43 @@ class BwTree : public BwTreeBase {
   };
 
   /*
-   * class InnerAbortNode - Same as LeafAbortNode
+   * class InnerAbortNode - Blocks posting on an inner node while one of
+   *                        its children is being removed
+   *
+   * The abort node also describes the pending removal, such that any
+   * thread that observes it could finish the removal and unblock the
+   * parent, instead of failing CAS on the parent until the thread that
+   * posted the abort node makes progress. The removal is finished by the
+   * thread that sets removal_claimed
    */
   class InnerAbortNode : public DeltaNode {
    public:
+    // The child being removed, the node it was mapped to when the removal
+    // was decided, and the remove delta to install on top of that node
+    NodeID removed_id;
+    const BaseNode *removed_node_p;
+    const BaseNode *remove_node_p;
+
+    // Whether some thread has started finishing the removal
+    mutable std::atomic<bool> removal_claimed;
 
     /*
      * Constructor
      */
-    InnerAbortNode(const BaseNode *p_child_node_p) :
+    InnerAbortNode(const BaseNode *p_child_node_p,
+                   NodeID p_removed_id,
+                   const BaseNode *p_removed_node_p,
+                   const BaseNode *p_remove_node_p) :
       DeltaNode{NodeType::InnerAbortType,
                 p_child_node_p,
                 &p_child_node_p->GetLowKeyPair(),
                 &p_child_node_p->GetHighKeyPair(),
                 p_child_node_p->GetDepth(),
-                p_child_node_p->GetItemCount()}
+                p_child_node_p->GetItemCount()},
+      removed_id{p_removed_id},
+      removed_node_p{p_removed_node_p},
+      remove_node_p{p_remove_node_p},
+      removal_claimed{false}
     {}
   };
 
@@ -1958,9 +2985,12 @@ class BwTree : public BwTreeBase {
      * even under contention
      *
      * Whether or not this has succeded, always return the pointer to the next
-     * chunk such that the caller could retry on next chunk
+     * chunk such that the caller could retry on next chunk. *grown_p is set
+     * to true only if the chunk allocated by this call has been installed
      */
-    AllocationMeta *GrowChunk() {
+    AllocationMeta *GrowChunk(bool *grown_p) {
+      *grown_p = false;
+      
       // If we know there is a next chunk just return it to avoid
       // having too many failed CAS instruction
       AllocationMeta *meta_p = next.load();
@@ -1986,6 +3016,8 @@ class BwTree : public BwTreeBase {
       // a chunk that has already been installed here
       bool ret = next.compare_exchange_strong(expected, new_meta_base);
       if(ret == true) {
+        *grown_p = true;
+        
         return new_meta_base; 
       }
       
@@ -2008,8 +3040,10 @@ class BwTree : public BwTreeBase {
      *
      * Note that this must be called at the header node of the chain, since it
      * takes "this" pointer and iterate using the "next" field
+     *
+     * The number of chunks grown by this call is added to *grown_count_p
      */
-    void *Allocate(size_t size) {
+    void *Allocate(size_t size, int *grown_count_p) {
       AllocationMeta *meta_p = this;
       while(1) {
         // Allocate from the current chunk first
@@ -2021,8 +3055,13 @@ class BwTree : public BwTreeBase {
           // This will surely traverse the entire linked list
           // but since the linked list itself is supposed to be relatively short
           // even under contention, we do not worry about it right now
-          meta_p = meta_p->GrowChunk();
+          bool grown;
+          meta_p = meta_p->GrowChunk(&grown);
           assert(meta_p != nullptr); 
+          
+          if(grown == true) {
+            (*grown_count_p)++;
+          }
         } else {
           return p; 
         }
@@ -2032,6 +3071,23 @@ class BwTree : public BwTreeBase {
       return nullptr;
     }
     
+    /*
+     * GetChunkCount() - Returns the number of chunks in the linked list
+     *
+     * This must be called at the header node of the chain
+     */
+    size_t GetChunkCount() const {
+      size_t chunk_count = 0UL;
+      
+      const AllocationMeta *meta_p = this;
+      while(meta_p != nullptr) {
+        chunk_count++;
+        meta_p = meta_p->next.load();
+      }
+      
+      return chunk_count;
+    }
+    
     /*
      * Destroy() - Frees all chunks in the linked list
      *
@@ -2166,6 +3222,25 @@ class BwTree : public BwTreeBase {
       return;
     }
     
+    /*
+     * GetAllocationSize() - Returns the number of bytes allocated by Get(),
+     *                       including the embedded first chunk
+     */
+    inline size_t GetAllocationSize() const {
+      return sizeof(ElasticNode) + \
+             this->GetItemCount() * sizeof(ElementType) + \
+             AllocationMeta::CHUNK_SIZE;
+    }
+    
+    /*
+     * GetGrownChunkSize() - Returns the number of bytes of chunks grown after
+     *                       the node is allocated
+     */
+    inline size_t GetGrownChunkSize() const {
+      return (ElasticNode::GetAllocationHeader(this)->GetChunkCount() - 1) * \
+             AllocationMeta::CHUNK_SIZE;
+    }
+    
     /*
      * Begin() - Returns a begin iterator to its internal array
      */
@@ -2352,14 +3427,16 @@ class BwTree : public BwTreeBase {
      * so (1) it is static, and (2) it takes low key p which is universally
      * available for all node type (stored in NodeMetadata)
      */
-    static void *InlineAllocate(const KeyNodeIDPair *low_key_p, size_t size) {
+    static void *InlineAllocate(const KeyNodeIDPair *low_key_p, 
+                                size_t size,
+                                int *grown_count_p) {
       const ElasticNode *node_p = GetNodeHeader(low_key_p);
       assert(&node_p->low_key == low_key_p);
       
       // Jump over chunk content
       AllocationMeta *meta_p = GetAllocationHeader(node_p);
             
-      void *p = meta_p->Allocate(size);
+      void *p = meta_p->Allocate(size, grown_count_p);
       assert(p != nullptr);
       
       return p;
@@ -2543,6 +3620,46 @@ class BwTree : public BwTreeBase {
       return -1;
     }
 
+    /*
+     * FindAppendSplitPoint() - Find the split point for a leaf node that
+     *                          keys are being appended to
+     *
+     * With sequential keys the left node of a split never receives more
+     * keys, so we keep leaf_append_split_percent percent of items in the
+     * left node and leave the right node mostly empty for the following
+     * inserts. The right node must still be larger than the merge threshold
+     * or it would be merged back right away
+     *
+     * If a skewed split point does not exist (e.g. the split percentage is
+     * 50, or duplicate keys are around the point) then the result of
+     * FindSplitPoint() is returned
+     */
+    int FindAppendSplitPoint(const BwTree *t) const {
+      int size = this->GetSize();
+      int right_sibling_size = \
+        std::max(size * (100 - t->leaf_append_split_percent) / 100,
+                 static_cast<int>(t->leaf_merge_threshold) + 1);
+
+      int split_index = size - right_sibling_size;
+      if(split_index <= size / 2) {
+        return FindSplitPoint(t);
+      }
+
+      // Do not separate items of the same key; moving left only makes
+      // the right node larger
+      while((split_index > size / 2) && \
+            (t->KeyCmpEqual(this->At(split_index - 1).first,
+                            this->At(split_index).first) == true)) {
+        split_index--;
+      }
+
+      if(split_index <= size / 2) {
+        return FindSplitPoint(t);
+      }
+
+      return split_index;
+    }
+
     /*
      * GetSplitSibling() - Split the node into two halves
      *
@@ -2569,8 +3686,11 @@ class BwTree : public BwTreeBase {
      * NOTE 4: On failure of split (i.e. could not find a split key that evenly
      * or almost evenly divide the leaf node) then the return value of this
      * function is nullptr
+     *
+     * NOTE 5: If is_append is true then the split is skewed towards the
+     * right. See FindAppendSplitPoint()
      */
-    LeafNode *GetSplitSibling(const BwTree *t) const {
+    LeafNode *GetSplitSibling(const BwTree *t, bool is_append) const {
       // When we split a leaf node, it is certain that there is no delta
       // chain on top of it. As a result, the number of items must equal
       // the actual size of the data list
@@ -2579,7 +3699,8 @@ class BwTree : public BwTreeBase {
       // This is the index of the actual key-value pair in data_list
       // We need to substract this value from the prefix sum in the new
       // inner node
-      int split_item_index = FindSplitPoint(t);
+      int split_item_index = \
+        (is_append == true) ? FindAppendSplitPoint(t) : FindSplitPoint(t);
       
       // Could not split because we could not find a split point
       // and the caller is responsible for not spliting the node
@@ -2672,8 +3793,18 @@ class BwTree : public BwTreeBase {
       // NodeID counter
       next_unused_node_id{1},
 
-      // Initialize free NodeID stack
-      free_node_id_list{},
+      // Merge policy
+      leaf_merge_threshold{LEAF_NODE_SIZE_LOWER_THRESHOLD},
+      inner_merge_threshold{INNER_NODE_SIZE_LOWER_THRESHOLD},
+      defer_leaf_merge{false},
+      deferred_merge_interval{DEFERRED_MERGE_EPOCH_INTERVAL},
+      last_deferred_merge_epoch{0UL},
+      leaf_append_split_percent{90},
+      contention_split_threshold{LEAF_CONTENTION_SPLIT_THRESHOLD},
+      backoff_max_spin_count{BACKOFF_MAX_SPIN_COUNT},
+      frozen_layout_p{nullptr},
+      retired_layout_p{nullptr},
+      retired_layout_lock{},
 
       // Statistical information
       insert_op_count{0},
@@ -2689,6 +3820,7 @@ class BwTree : public BwTreeBase {
                "Setting up execution environment...\n");
 
     InitMappingTable();
+    InitContentionTable();
     InitNodeLayout();
 
     bwt_printf("sizeof(NodeMetaData) = %lu is the overhead for each node\n",
@@ -2723,6 +3855,9 @@ class BwTree : public BwTreeBase {
     // First of all it should set all last active epoch counter to -1
     ClearThreadLocalGarbage();
 
+    delete frozen_layout_p.load();
+    FreeRetiredLayout(true);
+
     // Free all nodes recursively
     size_t node_count = FreeNodeByNodeID(root_id.load());
 
@@ -2813,16 +3948,17 @@ class BwTree : public BwTreeBase {
    * this is necessary for destroying the tree since we want to avoid deleting
    * a removed node in InnerNode
    *
-   * NOTE: This function only works in a single-threaded environment such
-   * as epoch manager and destructor
+   * The NodeID is put into the magazine of the calling thread, which is
+   * the thread doing GC. It is reused by GetNextNodeID() of this thread or,
+   * after the magazine has been handed to the shared pool, of other threads
    *
-   * DO NOT call this in worker thread!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   * NOTE: This must only be called after the removed node could not be
+   * reached by any thread, i.e. when its epoch has been retired
    */
   inline void InvalidateNodeID(NodeID node_id) {
     mapping_table[node_id] = nullptr;
 
-    // Next time if we need a node ID we just push back from this
-    //free_node_id_list.SingleThreadPush(node_id);
+    RecycleNodeID(node_id);
 
     return;
   }
@@ -2905,7 +4041,7 @@ class BwTree : public BwTreeBase {
           ((LeafNode *)node_p)->~LeafNode();
           
           // Free the memory
-          ((LeafNode *)node_p)->Destroy();
+          DestroyElasticNode((LeafNode *)node_p);
           
           freed_count++;
 
@@ -2970,7 +4106,7 @@ class BwTree : public BwTreeBase {
           }
 
           inner_node_p->~InnerNode();
-          inner_node_p->Destroy();
+          DestroyElasticNode(inner_node_p);
           
           
           freed_count++;
@@ -3054,6 +4190,8 @@ class BwTree : public BwTreeBase {
 
     #endif
 
+    AccountNewNode(root_node_p);
+
     root_node_p->PushBack(first_sep);
 
     bwt_printf("root id = %lu; first leaf id = %lu\n",
@@ -3088,6 +4226,8 @@ class BwTree : public BwTreeBase {
 
     #endif
 
+    AccountNewNode(left_most_leaf);
+
     InstallNewNode(first_leaf_id, left_most_leaf);
 
     return;
@@ -3112,58 +4252,169 @@ class BwTree : public BwTreeBase {
   }
 
   /*
-   * GetNextNodeID() - Thread-safe lock free method to get next node ID
+   * ReserveNodeIDBlock() - Refills the fresh IDs of a NodeID cache
    *
-   * This function basically compiles to LOCK XADD instruction on x86
-   * which is guaranteed to execute atomically
+   * The mapping table is not initialized when the tree is created, so
+   * entries of the block are cleared here; otherwise IDs that are cached
+   * but never used would look like valid nodes to functions scanning the
+   * mapping table
    */
-  inline NodeID GetNextNodeID() {
-    // This is a std::pair<bool, NodeID>
-    // If the first element is true then the NodeID is a valid one
-    // If the first element is false then NodeID is invalid and the
-    // stack is either empty or being used (we cannot lock and wait)
-    auto ret_pair = free_node_id_list.Pop();
-
-    // If there is no free node id
-    if(ret_pair.first == false) {
-      // fetch_add() returns the old value and increase the atomic
-      // automatically
-      return next_unused_node_id.fetch_add(1);
-    } else {
-      return ret_pair.second;
+  void ReserveNodeIDBlock(NodeIDCache *cache_p) {
+    // fetch_add() returns the old value, which is the start of the block
+    cache_p->next_id = next_unused_node_id.fetch_add(NODE_ID_BLOCK_SIZE);
+    cache_p->end_id = cache_p->next_id + NODE_ID_BLOCK_SIZE;
+
+    assert(cache_p->end_id <= MAPPING_TABLE_SIZE);
+
+    for(NodeID node_id = cache_p->next_id;
+        node_id < cache_p->end_id;
+        node_id++) {
+      mapping_table[node_id].store(nullptr, std::memory_order_relaxed);
     }
+
+    return;
   }
 
   /*
-   * InstallNodeToReplace() - Install a node to replace a previous one
-   *
-   * If installation fails because CAS returned false, then return false
-   * This function does not retry
+   * InitContentionTable() - Clears all leaf contention counters
    */
-  inline bool InstallNodeToReplace(NodeID node_id,
-                                   const BaseNode *node_p,
-                                   const BaseNode *prev_p) {
-    // Make sure node id is valid and does not exceed maximum
-    assert(node_id != INVALID_NODE_ID);
-    assert(node_id < MAPPING_TABLE_SIZE);
-
-    // If idb is activated, then all operation will be blocked before
-    // they could call CAS and change the key
-    #ifdef INTERACTIVE_DEBUG
-    debug_stop_mutex.lock();
-    debug_stop_mutex.unlock();
-    #endif
+  void InitContentionTable() {
+    for(std::atomic<uint32_t> &counter : contention_table) {
+      counter.store(0, std::memory_order_relaxed);
+    }
 
-    return mapping_table[node_id].compare_exchange_strong(prev_p, node_p);
+    return;
   }
 
   /*
-   * InstallRootNode() - Replace the old root with a new one
+   * DecayContention() - Returns the count of a contention counter value
+   *                     halved once for each epoch since it was updated
    *
-   * There is change that this function would fail. In that case it returns
-   * false, which implies there are some other threads changing the root ID
+   * The upper 16 bits of a value are the low 16 bits of the epoch in which
+   * it was last updated and the lower 16 bits are the count. The stamp
+   * wraps around, which at worst revives the count of an idle counter
    */
-  inline bool InstallRootNode(NodeID old_root_node_id,
+  static inline uint32_t DecayContention(uint32_t value, uint16_t epoch) {
+    uint16_t elapsed = static_cast<uint16_t>(epoch - (value >> 16));
+    if(elapsed >= 16) {
+      return 0;
+    }
+
+    return (value & 0xFFFF) >> elapsed;
+  }
+
+  /*
+   * RecordLeafContention() - Counts a failed CAS on a leaf data delta
+   *
+   * This is only called after CAS has failed, so the cache line is
+   * not touched on the common path. Racing updates might lose a count,
+   * which is fine for a hint
+   */
+  inline void RecordLeafContention(NodeID node_id) {
+    std::atomic<uint32_t> &counter = \
+      contention_table[node_id % CONTENTION_TABLE_SIZE];
+
+    uint16_t epoch = static_cast<uint16_t>(GetGlobalEpoch());
+    uint32_t count = \
+      DecayContention(counter.load(std::memory_order_relaxed), epoch);
+
+    // Saturate instead of wrapping around to 0
+    if(count != UINT16_MAX) {
+      count++;
+    }
+
+    counter.store((static_cast<uint32_t>(epoch) << 16) | count,
+                  std::memory_order_relaxed);
+
+    return;
+  }
+
+  /*
+   * GetLeafContention() - Returns the decayed contention counter of a leaf
+   */
+  inline size_t GetLeafContention(NodeID node_id) {
+    return DecayContention(
+      contention_table[node_id % CONTENTION_TABLE_SIZE].load(
+        std::memory_order_relaxed),
+      static_cast<uint16_t>(GetGlobalEpoch()));
+  }
+
+  /*
+   * GetNextNodeID() - Thread-safe method to get next node ID
+   *
+   * IDs are taken from the current thread's NodeID cache in the following
+   * order: (1) recycled IDs; (2) fresh IDs of the reserved block;
+   * (3) a batch of recycled IDs from the shared pool; (4) a new block from
+   * the global counter. Only (3) and (4) need synchronization and they
+   * happen once per batch
+   *
+   * Threads without a GC ID (i.e. the constructor) take one ID at a time
+   * from the shared pool or the global counter
+   */
+  inline NodeID GetNextNodeID() {
+    NodeIDCache *cache_p = GetCurrentNodeIDCache();
+
+    if(cache_p == nullptr) {
+      NodeID node_id;
+      if(PopFreeNodeID(&node_id, 1) == 1UL) {
+        return node_id;
+      }
+
+      return next_unused_node_id.fetch_add(1);
+    }
+
+    if(cache_p->recycled_count == 0UL && \
+       cache_p->next_id == cache_p->end_id) {
+      cache_p->recycled_count = \
+        PopFreeNodeID(cache_p->recycled_list, node_id_magazine_size);
+
+      if(cache_p->recycled_count == 0UL) {
+        ReserveNodeIDBlock(cache_p);
+      }
+    }
+
+    if(cache_p->recycled_count != 0UL) {
+      cache_p->recycled_count--;
+
+      return cache_p->recycled_list[cache_p->recycled_count];
+    }
+
+    NodeID node_id = cache_p->next_id;
+    cache_p->next_id++;
+
+    return node_id;
+  }
+
+  /*
+   * InstallNodeToReplace() - Install a node to replace a previous one
+   *
+   * If installation fails because CAS returned false, then return false
+   * This function does not retry
+   */
+  inline bool InstallNodeToReplace(NodeID node_id,
+                                   const BaseNode *node_p,
+                                   const BaseNode *prev_p) {
+    // Make sure node id is valid and does not exceed maximum
+    assert(node_id != INVALID_NODE_ID);
+    assert(node_id < MAPPING_TABLE_SIZE);
+
+    // If idb is activated, then all operation will be blocked before
+    // they could call CAS and change the key
+    #ifdef INTERACTIVE_DEBUG
+    debug_stop_mutex.lock();
+    debug_stop_mutex.unlock();
+    #endif
+
+    return mapping_table[node_id].compare_exchange_strong(prev_p, node_p);
+  }
+
+  /*
+   * InstallRootNode() - Replace the old root with a new one
+   *
+   * There is change that this function would fail. In that case it returns
+   * false, which implies there are some other threads changing the root ID
+   */
+  inline bool InstallRootNode(NodeID old_root_node_id,
                               NodeID new_root_node_id) {
     return root_id.compare_exchange_strong(old_root_node_id,
                                            new_root_node_id);
@@ -3338,6 +4589,8 @@ retry_traverse:
     return found_pair_p;
 
 abort_traverse:
+    GetCurrentOperationCounter()->traverse_abort_count++;
+    
     #ifdef BWTREE_DEBUG
     
     assert(context_p->current_level >= 0);
@@ -3359,6 +4612,106 @@ abort_traverse:
     return nullptr;
   }
 
+  /*
+   * TraverseFromLeaf() - Restarts a traversal on the leaf of an earlier one
+   *
+   * This is called after a leaf data CAS failed on the leaf node_id, or
+   * with the leaf found by an asynchronous descent. If the failure was
+   * caused by another data delta on the same leaf, then the inner levels
+   * would lead to the same leaf again, so we reload the mapping table entry
+   * and only navigate the new delta chain. This is only done if:
+   *
+   *   (1) The new head is a base leaf or a data delta, i.e. there is no SMO
+   *       to help, which Traverse() would have to finish
+   *   (2) The search key is still in the range of the leaf. NodeIDs are
+   *       recycled, so the low key is also checked
+   *   (3) The delta chain is shorter than the consolidation threshold, such
+   *       that the leaf is still consolidated and split by Traverse()
+   *   (4) If the head is a base leaf, AdjustNodeSize() would neither split
+   *       nor remove it, since that needs the parent snapshot
+   *
+   * Otherwise it calls Traverse() to start from the root. Arguments and
+   * return value are the same as Traverse()
+   *
+   * NOTE: The parent snapshot in the context is not valid on the fast path.
+   * This is fine since the caller only installs a data delta on the leaf
+   */
+  const KeyValuePair *TraverseFromLeaf(Context *context_p,
+                                       NodeID node_id,
+                                       const ValueType *value_p,
+                                       std::pair<int, bool> *index_pair_p) {
+    const BaseNode *node_p = GetNode(node_id);
+    const KeyType &search_key = context_p->search_key;
+
+    bool in_range = false;
+    if((node_p != nullptr) &&
+       (node_p->IsOnLeafDeltaChain() == true) &&
+       (node_p->GetDepth() < LEAF_DELTA_CHAIN_LENGTH_THRESHOLD)) {
+      NodeType type = node_p->GetType();
+
+      if((type == NodeType::LeafType) ||
+         (type == NodeType::LeafInsertType) ||
+         (type == NodeType::LeafDeleteType)) {
+        in_range = \
+          ((node_p->GetLowKeyPair().second == INVALID_NODE_ID) ||
+           (KeyCmpGreaterEqual(search_key, node_p->GetLowKey()))) &&
+          ((node_p->GetNextNodeID() == INVALID_NODE_ID) ||
+           (KeyCmpLess(search_key, node_p->GetHighKey())));
+      }
+
+      if((in_range == true) &&
+         (type == NodeType::LeafType) &&
+         (LeafNeedsAdjustment(node_id,
+                              static_cast<const LeafNode *>(node_p)) == \
+            true)) {
+        in_range = false;
+      }
+    }
+
+    if(in_range == false) {
+      bwt_printf("Leaf %lu changed range, has SMO or needs size adjustment; "
+                 "retry from the root\n",
+                 node_id);
+
+      GetCurrentOperationCounter()->root_retry_count++;
+
+      return Traverse(context_p, value_p, index_pair_p);
+    }
+
+    bwt_printf("Retry on leaf %lu\n", node_id);
+
+    GetCurrentOperationCounter()->leaf_retry_count++;
+
+    #ifdef BWTREE_DEBUG
+
+    context_p->current_level++;
+
+    #endif
+
+    // This is TakeNodeSnapshot() except that it keeps the node we have
+    // checked rather than reading the mapping table again. The current
+    // snapshot of a new context has INVALID_NODE_ID, so the parent
+    // snapshot looks like that of a root
+    context_p->parent_snapshot = context_p->current_snapshot;
+    context_p->current_snapshot.node_p = node_p;
+    context_p->current_snapshot.node_id = node_id;
+
+    const KeyValuePair *found_pair_p = nullptr;
+
+    // Since the key is in range these do not go right and never abort
+    if(value_p == nullptr) {
+      assert(index_pair_p == nullptr);
+
+      NavigateSiblingChain(context_p);
+    } else {
+      found_pair_p = NavigateLeafNode(context_p, *value_p, index_pair_p);
+    }
+
+    assert(context_p->abort_flag == false);
+
+    return found_pair_p;
+  }
+
   ///////////////////////////////////////////////////////////////////
   // Data Storage Core
   ///////////////////////////////////////////////////////////////////
@@ -3382,7 +4735,8 @@ abort_traverse:
    * If the traverse aborts then this function returns with abort_flag
    * setting to true.
    */
-  void NavigateSiblingChain(Context *context_p) {
+  template <typename ContextType>
+  void NavigateSiblingChain(ContextType *context_p) {
     do {
       // These two will be updated everytime we switch to
       // a new node
@@ -3403,7 +4757,7 @@ abort_traverse:
                    "Go right.\n",
                    snapshot_p->node_id);
 
-        JumpToNodeID(node_p->GetNextNodeID(), context_p);
+        JumpToSiblingNodeID(node_p->GetNextNodeID(), context_p);
 
         if(context_p->abort_flag == true) {
           bwt_printf("JumpToNodeID aborts(). ABORT\n");
@@ -3459,7 +4813,8 @@ abort_traverse:
    * NOTE: This function ignores the first element in the sep list
    * since even if we know the low key of the first element
    */
-  inline NodeID LocateSeparatorByKey(const KeyType &search_key,
+  template <typename SearchKeyType>
+  inline NodeID LocateSeparatorByKey(const SearchKeyType &search_key,
                                      const InnerNode *inner_node_p,
                                      const KeyNodeIDPair *start_p,
                                      const KeyNodeIDPair *end_p) {
@@ -3469,7 +4824,7 @@ abort_traverse:
     // Hopefully std::upper_bound would use binary search here
     auto it = std::upper_bound(start_p,
                                end_p,
-                               std::make_pair(search_key, INVALID_NODE_ID),
+                               search_key,
                                key_node_id_pair_cmp_obj) - 1;
 #ifdef BWTREE_DEBUG
     //auto it2 = std::upper_bound(inner_node_p->Begin() + 1,
@@ -3501,7 +4856,7 @@ abort_traverse:
     assert(inner_node_p->GetSize() != 0UL);
     auto it = std::upper_bound(inner_node_p->Begin() + 1,
                                inner_node_p->End(),
-                               std::make_pair(search_key, INVALID_NODE_ID),
+                               search_key,
                                key_node_id_pair_cmp_obj) - 1;
 
     if(KeyCmpEqual(it->first, search_key) == true) {
@@ -3543,7 +4898,8 @@ abort_traverse:
    * and update path history. (Such jump may happen multiple times, so
    * do not make any assumption about how jump is performed)
    */
-  NodeID NavigateInnerNode(Context *context_p) {
+  template <typename ContextType>
+  NodeID NavigateInnerNode(ContextType *context_p) {
     // This will go to the right sibling until we have seen
     // a node whose range match the search key
     NavigateSiblingChain(context_p);
@@ -3558,7 +4914,7 @@ abort_traverse:
     /////////////////////////////////////////////////////////////////
     
     // This search key will not be changed during navigation
-    const KeyType &search_key = context_p->search_key;
+    const auto &search_key = context_p->search_key;
 
     // First get the snapshot from context
     NodeSnapshot *snapshot_p = GetLatestNodeSnapshot(context_p);
@@ -3774,8 +5130,13 @@ abort_traverse:
 
           const KeyNodeIDPair &insert_item = insert_node_p->item;
           const KeyNodeIDPair &next_item = insert_node_p->next_item;
+          // The range covered by the insert item is
+          // (insert_item.first, next_item.first] for backward iteration, 
+          // since we go left if the search key is a separator. If the 
+          // search key equals the next key we must still return here, 
+          // otherwise we could reach stale items below a delete node
           if((next_item.second == INVALID_NODE_ID) ||
-             (KeyCmpLess(search_key, next_item.first))) {
+             (KeyCmpLessEqual(search_key, next_item.first))) {
                
             // *********************************************
             // * NOTE: DO NOT PROCEED IF IT IS "==" RELATION
@@ -3806,8 +5167,9 @@ abort_traverse:
 
           if((delete_node_p->GetLowKeyNodeID() == prev_item.second) ||
              (KeyCmpGreater(search_key, prev_item.first))) {
+            // Same as above, the next key is included
             if((next_item.second == INVALID_NODE_ID) ||
-               (KeyCmpLess(search_key, next_item.first))) {
+               (KeyCmpLessEqual(search_key, next_item.first))) {
               bwt_printf("Find target ID = %lu in delete delta (BI)\n",
                          prev_item.second);
 
@@ -3915,6 +5277,8 @@ abort_traverse:
               node_p->GetLowKeyPair(),
               node_p->GetHighKeyPair()));
 
+    AccountNewNode(inner_node_p);
+
     // The first element is always the low key
     // since we know it will never be deleted
     // We do this because for an InnerNode, its first separator key is just
@@ -4221,9 +5585,17 @@ abort_traverse:
    * problems since now the snapshot has been changed, and we need to check
    * whether there is data in the map again to make sure there is no
    * map insert conflict
+   *
+   * NOTE 3: Values are not collected into a container by this function.
+   * Instead each value visible under the search key is passed to the
+   * callback exactly once, such that callers could decide whether to copy
+   * them into a vector, a fixed sized buffer, or not copy them at all. The
+   * callback is only invoked after sibling navigation succeeds, so an abort
+   * never causes a value to be reported twice
    */
-  void NavigateLeafNode(Context *context_p,
-                        std::vector<ValueType> &value_list) {
+  template <typename ContextType, typename ValueCallback>
+  void NavigateLeafNode(ContextType *context_p,
+                        ValueCallback &&value_callback) {
                           
     // This will go to the right sibling until we have seen
     // a node whose range match the search key
@@ -4245,7 +5617,7 @@ abort_traverse:
     assert(snapshot_p->IsLeaf() == true);
 
     // We only collect values for this key
-    const KeyType &search_key = context_p->search_key;
+    const auto &search_key = context_p->search_key;
 
     // The maximum size of present set and deleted set is just
     // the length of the delta chain. Since when we reached the leaf node
@@ -4295,7 +5667,7 @@ abort_traverse:
           auto copy_start_it = \
             std::lower_bound(start_it,
                              end_it,
-                             std::make_pair(search_key, ValueType{}),
+                             search_key,
                              key_value_pair_cmp_obj);
 
           // If there is something to copy
@@ -4312,7 +5684,7 @@ abort_traverse:
                 // definitely will not block the remaining values, since we
                 // know they do not duplicate inside the leaf node
 
-                value_list.push_back(copy_start_it->second);
+                value_callback(copy_start_it->second);
               }
             }
 
@@ -4333,7 +5705,7 @@ abort_traverse:
               if(present_set.Exists(insert_node_p->item.second) == false) {
                 present_set.Insert(insert_node_p->item.second);
 
-                value_list.push_back(insert_node_p->item.second);
+                value_callback(insert_node_p->item.second);
               }
             }
           } else if(KeyCmpGreater(search_key, insert_node_p->item.first)) {
@@ -4476,7 +5848,7 @@ abort_traverse:
           auto scan_start_it = \
             std::lower_bound(leaf_node_p->Begin(),
                              leaf_node_p->End(),
-                             std::make_pair(search_key, ValueType{}),
+                             search_key,
                              key_value_pair_cmp_obj);
 
           // Search all values with the search key
@@ -4626,7 +5998,7 @@ abort_traverse:
   NavigateLeafNode(Context *context_p,
                    const ValueType &value,
                    std::pair<int, bool> *index_pair_p,
-                   std::function<bool(const void *)> predicate,
+                   std::function<bool(const ValueType &)> predicate,
                    bool *predicate_satisfied) {
 
 
@@ -4669,7 +6041,7 @@ abort_traverse:
           auto copy_start_it = \
             std::lower_bound(leaf_node_p->Begin(),
                              leaf_node_p->End(),
-                             std::make_pair(search_key, ValueType{}),
+                             search_key,
                              key_value_pair_cmp_obj);
 
           while((copy_start_it != leaf_node_p->End()) && \
@@ -4828,6 +6200,9 @@ abort_traverse:
               node_p->GetItemCount(),
               node_p->GetLowKeyPair(),
               node_p->GetHighKeyPair()));
+
+      // Caller provided nodes are not part of the tree's memory
+      AccountNewNode(leaf_node_p);
     }
     
     assert(leaf_node_p != nullptr);
@@ -4956,8 +6331,8 @@ abort_traverse:
             copy_end_it = std::lower_bound(leaf_node_p->Begin(),
                                            leaf_node_p->End(),
                                            // It only compares key so we
-                                           // just use high key pair
-                                           std::make_pair(high_key_pair.first, ValueType{}),
+                                           // just use the high key
+                                           high_key_pair.first,
                                            key_value_pair_cmp_obj);
           }
           
@@ -5135,7 +6510,8 @@ abort_traverse:
    * the vector, since at that time the snapshot object will be destroyed
    * which also freed up the logical node object
    */
-  static inline NodeSnapshot *GetLatestNodeSnapshot(Context *context_p) {
+  template <typename ContextType>
+  static inline NodeSnapshot *GetLatestNodeSnapshot(ContextType *context_p) {
     assert(context_p->current_level >= 0);
 
     return &context_p->current_snapshot;
@@ -5340,8 +6716,9 @@ abort_traverse:
    * SINCE THIS FUNCTION RESETS ROOT IDENTITY
    * Call SwitchPhysicalPointer() instead
    */
+  template <typename ContextType>
   void UpdateNodeSnapshot(NodeID node_id,
-                          Context *context_p) {
+                          ContextType *context_p) {
     const BaseNode *node_p = GetNode(node_id);
 
     // We operate on the latest snapshot instead of creating a new one
@@ -5446,7 +6823,8 @@ abort_traverse:
    *
    * This function only delas with remove delta and abort node
    */
-  inline void FinishPartialSMOReadOptimized(Context *context_p) {
+  template <typename ContextType>
+  inline void FinishPartialSMOReadOptimized(ContextType *context_p) {
     // Note: If the top of the path list changes then this pointer
     // must also be updated
     NodeSnapshot *snapshot_p = GetLatestNodeSnapshot(context_p);
@@ -5490,8 +6868,9 @@ before_switch:
    * complete the job since remove delta will not be present if the thread
    * posting the remove delta finally proceeds to finish its job
    */
+  template <typename ContextType>
   inline void TakeNodeSnapshotReadOptimized(NodeID node_id,
-                                            Context *context_p) {
+                                            ContextType *context_p) {
     const BaseNode *node_p = GetNode(node_id);
 
     bwt_printf("Is leaf node (RO)? - %d\n", node_p->IsOnLeafDeltaChain());
@@ -5521,7 +6900,9 @@ before_switch:
    * down. However, jumping to left sibling has the possibility to fail
    * so we still need to check abort flag after this function returns
    */
-  inline void LoadNodeIDReadOptimized(NodeID node_id, Context *context_p) {
+  template <typename ContextType>
+  inline void LoadNodeIDReadOptimized(NodeID node_id,
+                                      ContextType *context_p) {
     bwt_printf("Loading NodeID (RO) = %lu\n", node_id);
 
     // This pushes a new snapshot into stack
@@ -5534,6 +6915,55 @@ before_switch:
     return;
   }
 
+  /*
+   * JumpToNodeIDReadOptimized() - Read optimized version of JumpToNodeID()
+   *
+   * Unlike JumpToNodeID() this neither consolidates the sibling nor adjusts
+   * its size, since SMOs might need the parent snapshot, which read
+   * optimized traversals do not keep
+   */
+  template <typename ContextType>
+  inline void JumpToNodeIDReadOptimized(NodeID node_id,
+                                        ContextType *context_p) {
+    bwt_printf("Jumping to node ID (RO) = %lu\n", node_id);
+
+    UpdateNodeSnapshot(node_id, context_p);
+
+    FinishPartialSMOReadOptimized(context_p);
+
+    // Do not need to check for abort flag here
+
+    return;
+  }
+  
+  /*
+   * JumpToSiblingNodeID() - Jumps to the right sibling in the way of the
+   *                         current traversal
+   */
+  inline void JumpToSiblingNodeID(NodeID node_id, Context *context_p) {
+    if(context_p->read_optimized == true) {
+      JumpToNodeIDReadOptimized(node_id, context_p);
+    } else {
+      JumpToNodeID(node_id, context_p);
+    }
+    
+    return;
+  }
+  
+  /*
+   * JumpToSiblingNodeID() - Jumps to the right sibling during a lookup with
+   *                         a key view, which is always read optimized
+   */
+  template <typename SearchKeyType>
+  inline void JumpToSiblingNodeID(NodeID node_id,
+                                  BasicContext<SearchKeyType> *context_p) {
+    assert(context_p->read_optimized == true);
+    
+    JumpToNodeIDReadOptimized(node_id, context_p);
+    
+    return;
+  }
+
   /*
    * TraverseBI() - Read optimized traversal for backward iteration
    *
@@ -5586,6 +7016,8 @@ retry_traverse:
     } //while(1)
 
 abort_traverse:
+    GetCurrentOperationCounter()->traverse_abort_count++;
+    
     #ifdef BWTREE_DEBUG
     assert(context_p->current_level >= 0);
     context_p->current_level = -1;
@@ -5601,8 +7033,18 @@ abort_traverse:
     return;
   }
   
-  void TraverseReadOptimized(Context *context_p,
-                             std::vector<ValueType> *value_list_p) {
+  /*
+   * TraverseReadOptimized() - Traverse down to the leaf without helping
+   *                           along SMOs, and report values of the search key
+   *
+   * Values are reported through the callback (see NavigateLeafNode()), which
+   * is called once for each value after the leaf has been located
+   */
+  template <typename ContextType, typename ValueCallback>
+  void TraverseReadOptimized(ContextType *context_p,
+                             ValueCallback &&value_callback) {
+    context_p->read_optimized = true;
+
 retry_traverse:
     assert(context_p->abort_flag == false);
     assert(context_p->current_level == -1);
@@ -5657,7 +7099,7 @@ retry_traverse:
       if(snapshot_p->IsLeaf() == true) {
         bwt_printf("The next node is a leaf (RO)\n");
 
-        NavigateLeafNode(context_p, *value_list_p);
+        NavigateLeafNode(context_p, value_callback);
 
         if(context_p->abort_flag == true) {
           bwt_printf("NavigateLeafNode aborts (RO). ABORT\n");
@@ -5682,6 +7124,8 @@ retry_traverse:
     } // while(1)
 
 abort_traverse:
+    GetCurrentOperationCounter()->traverse_abort_count++;
+    
     #ifdef BWTREE_DEBUG
     
     assert(context_p->current_level >= 0);
@@ -5701,2018 +7145,4509 @@ abort_traverse:
     assert(false);
     return;
   }
-
-  ///////////////////////////////////////////////////////////////////
-  ///////////////////////////////////////////////////////////////////
-  ///////////////////////////////////////////////////////////////////
-
+  
   /*
-   * PostInnerInsertNode() - Posts an InnerInsertNode on the parent node
+   * LookupValues() - Reports values of the search key on the frozen layout
+   *                  if there is one, or on the tree otherwise
    *
-   * This is used to finish the partial node split SMO as part of the help
-   * along protocol
+   * The search key is either a KeyType or a key view that the transparent
+   * comparator accepts. In the latter case the context refers to the view,
+   * and no KeyType is constructed on the way down
    *
-   * NOTE: This function may abort
+   * NOTE: This function must be called inside an epoch
    */
-  inline bool PostInnerInsertNode(Context *context_p,
-                                  const KeyNodeIDPair &insert_item,
-                                  const KeyNodeIDPair &next_item,
-                                  const KeyNodeIDPair *location) {
-    // We post on the parent node, after which we check for size and decide whether
-    // to consolidate and/or split the node
-    NodeSnapshot *parent_snapshot_p = GetLatestParentNodeSnapshot(context_p);
-
-    // Three arguments are: inserted key-node id pair
-    //                      next key-node id pair
-    //                      child node in delta chain
-    const InnerInsertNode *insert_node_p = \
-      InnerInlineAllocateOfType(InnerInsertNode,
-                                parent_snapshot_p->node_p,
-                                insert_item,
-                                next_item,
-                                parent_snapshot_p->node_p,
-                                location);
-
-    // CAS Index Term Insert Delta onto the parent node
-    bool ret = InstallNodeToReplace(parent_snapshot_p->node_id,
-                                    insert_node_p,
-                                    parent_snapshot_p->node_p);
-
-    if(ret == true) {
-      bwt_printf("Index term insert (from %lu to %lu) delta CAS succeeds\n",
-                 GetLatestNodeSnapshot(context_p)->node_id,
-                 insert_item.second);
-
-      // Update parent node pointer to reflect the fact that it has been
-      // updated
-      parent_snapshot_p->node_p = insert_node_p;
-
-      ConsolidateNode(GetLatestNodeSnapshot(context_p));
-
-      return true;
-    } else {
-      bwt_printf("Index term insert (from %lu to %lu) delta CAS failed. "
-                 "ABORT\n",
-                 GetLatestNodeSnapshot(context_p)->node_id,
-                 insert_item.second);
-
-      // Set abort, and remove the newly created node
-      context_p->abort_flag = true;
+  template <typename SearchKeyType, typename ValueCallback>
+  void LookupValues(const SearchKeyType &search_key,
+                    ValueCallback &&value_callback) {
+    const FrozenLayout *layout_p = frozen_layout_p.load();
+    if(layout_p != nullptr) {
+      GetCurrentOperationCounter()->frozen_read_count++;
       
-      // Call destructor but do not free memory
-      insert_node_p->~InnerInsertNode();
-
-      return false;
-    } // if CAS succeeds/fails
-
-    assert(false);
-    return false;
+      layout_p->ForEachValue(search_key, value_callback);
+      
+      return;
+    }
+    
+    BasicContext<SearchKeyType> context{search_key};
+    
+    TraverseReadOptimized(&context, value_callback);
+    
+    return;
   }
 
+  ///////////////////////////////////////////////////////////////////
+  ///////////////////////////////////////////////////////////////////
+  ///////////////////////////////////////////////////////////////////
+
   /*
-   * PostInnerDeleteNode() - Posts an InnerDeleteNode on the current parent node
-   *
-   * This function is called to complete node merges as part of the SMO help-along
-   * protocol. It posts an InnerDeleteNode on the parent node and returns the result
-   * of CAS instruction
-   *
-   * NOTE: This function may abort
+   * ScanLeafLevel() - Scans the leaf level starting from a given key, and
+   *                   calls the scan function on each key-value pair
+   *
+   * If start_key_p is nullptr then the scan starts from the first leaf node,
+   * and if high_key_p is nullptr then there is no upper bound. The scan stops
+   * after limit items have been passed to the function, or after the function
+   * returns false.
+   *
+   * We only traverse from the root once. After a leaf node is drained, we
+   * load its right sibling using the next node ID. Since NodeIDs could be
+   * recycled after a merge, the sibling is validated by checking that it
+   * is a leaf node whose low key equals the high key of the current node,
+   * and that it is not being removed. If any of these fails we traverse 
+   * again from the root using the high key, just like iterators do
    */
-  inline bool PostInnerDeleteNode(Context *context_p,
-                                  const KeyNodeIDPair &delete_item,
-                                  const KeyNodeIDPair &prev_item,
-                                  const KeyNodeIDPair &next_item,
-                                  const KeyNodeIDPair *location) {
-    NodeSnapshot *parent_snapshot_p = GetLatestParentNodeSnapshot(context_p);
-
-    // Arguments are:
-    // Deleted item; Prev item; next item (NodeID not used for next item)
-    // and delta chail child node
-    const InnerDeleteNode *delete_node_p = \
-      InnerInlineAllocateOfType(InnerDeleteNode,
-                                parent_snapshot_p->node_p,
-                                delete_item,
-                                prev_item,
-                                next_item,
-                                parent_snapshot_p->node_p,
-                                location);
-
-    // Assume parent has not changed, and CAS the index term delete delta
+  template <typename ScanFunc>
+  size_t ScanLeafLevel(const KeyType *start_key_p,
+                       bool start_inclusive,
+                       const KeyType *high_key_p,
+                       bool high_inclusive,
+                       size_t limit,
+                       ScanFunc &scan_func) {
+    GetCurrentOperationCounter()->scan_count++;
+    
+    // The epoch is held for the entire scan since resume_key_p points
+    // into the node being scanned
+    EpochNode *epoch_node_p = epoch_manager.JoinEpoch();
+    
+    size_t scan_count = 0UL;
+    
+    // A frozen tree is scanned on its packed leaves
+    const FrozenLayout *layout_p = frozen_layout_p.load();
+    if(layout_p != nullptr) {
+      GetCurrentOperationCounter()->frozen_read_count++;
+      
+      scan_count = layout_p->Scan(start_key_p,
+                                  start_inclusive,
+                                  high_key_p,
+                                  high_inclusive,
+                                  limit,
+                                  scan_func);
+      
+      epoch_manager.LeaveEpoch(epoch_node_p);
+      
+      return scan_count;
+    }
+    
+    // Keys >= (or >) this key will be passed to the scan function
+    // If this is nullptr then all keys will be passed
+    const KeyType *resume_key_p = start_key_p;
+    bool resume_inclusive = start_inclusive;
+    
+    // Current leaf node's NodeID and the head of its delta chain
+    NodeID node_id;
+    const BaseNode *node_p;
+    
+retry_traverse:
+    if(resume_key_p == nullptr) {
+      // The left most leaf node is never removed
+      node_id = FIRST_LEAF_NODE_ID;
+      node_p = GetNode(node_id);
+    } else {
+      Context context{*resume_key_p};
+      
+      // This stops on the leaf node without traversing the delta chain
+      Traverse(&context, nullptr, nullptr);
+      
+      NodeSnapshot *snapshot_p = GetLatestNodeSnapshot(&context);
+      node_id = snapshot_p->node_id;
+      node_p = snapshot_p->node_p;
+    }
+    
+    while(1) {
+      assert(node_p->IsOnLeafDeltaChain() == true);
+      
+      // If the node has deltas then we consolidate it into a temporary
+      // node which is freed after scanning
+      LeafNode *temp_node_p = nullptr;
+      const LeafNode *leaf_node_p;
+      
+      if(node_p->GetType() == NodeType::LeafType) {
+        leaf_node_p = static_cast<const LeafNode *>(node_p);
+      } else {
+        NodeSnapshot snapshot{node_id, node_p};
+        temp_node_p = CollectAllValuesOnLeaf(&snapshot);
+        leaf_node_p = temp_node_p;
+      }
+      
+      const KeyValuePair *kv_p = \
+        (resume_key_p == nullptr) ? \
+        leaf_node_p->Begin() : \
+        (resume_inclusive == true) ? \
+        std::lower_bound(leaf_node_p->Begin(),
+                         leaf_node_p->End(),
+                         *resume_key_p,
+                         key_value_pair_cmp_obj) : \
+        std::upper_bound(leaf_node_p->Begin(),
+                         leaf_node_p->End(),
+                         *resume_key_p,
+                         key_value_pair_cmp_obj);
+      
+      bool finished = false;
+      
+      while(kv_p != leaf_node_p->End()) {
+        if(high_key_p != nullptr) {
+          if(high_inclusive == true) {
+            finished = KeyCmpGreater(kv_p->first, *high_key_p);
+          } else {
+            finished = KeyCmpGreaterEqual(kv_p->first, *high_key_p);
+          }
+        }
+        
+        if((finished == true) || (scan_count == limit)) {
+          finished = true;
+          
+          break;
+        }
+        
+        scan_count++;
+        if(scan_func(kv_p->first, kv_p->second) == false) {
+          finished = true;
+          
+          break;
+        }
+        
+        kv_p++;
+      }
+      
+      if(temp_node_p != nullptr) {
+        temp_node_p->~LeafNode();
+        DestroyElasticNode(temp_node_p);
+      }
+      
+      // The next node only contains keys >= the high key of this node
+      // so we could also stop if it already goes beyond the upper bound
+      NodeID next_node_id = node_p->GetNextNodeID();
+      if((finished == false) && 
+         (next_node_id != INVALID_NODE_ID) &&
+         (high_key_p != nullptr)) {
+        const KeyType &node_high_key = node_p->GetHighKey();
+        
+        finished = (KeyCmpGreater(node_high_key, *high_key_p) || \
+                    ((high_inclusive == false) && \
+                     KeyCmpEqual(node_high_key, *high_key_p)));
+      }
+      
+      if((finished == true) || (next_node_id == INVALID_NODE_ID)) {
+        break;
+      }
+      
+      // All keys in the next node are >= this one
+      resume_key_p = &node_p->GetHighKey();
+      resume_inclusive = true;
+      
+      const BaseNode *next_node_p = GetNode(next_node_id);
+      
+      if((next_node_p == nullptr) ||
+         (next_node_p->IsOnLeafDeltaChain() == false) ||
+         (next_node_p->GetType() == NodeType::LeafRemoveType) ||
+         (next_node_p->GetLowKeyPair().second == INVALID_NODE_ID) ||
+         (KeyCmpEqual(next_node_p->GetLowKey(), *resume_key_p) == false)) {
+        bwt_printf("Sibling validation failed; traverse again\n");
+        
+        goto retry_traverse;
+      }
+      
+      node_id = next_node_id;
+      node_p = next_node_p;
+    } // while(1)
+    
+    epoch_manager.LeaveEpoch(epoch_node_p);
+    
+    return scan_count;
+  }
+
+  /*
+   * LocateLastLeaf() - Finds the right most leaf node by always going to
+   *                    the last child
+   *
+   * The NodeID and the head of the delta chain of the leaf node are returned
+   * through the first two arguments, and the NodeID of the inner node
+   * we came from is returned through the last one (INVALID_NODE_ID if the 
+   * root is a leaf node). If a node has a right sibling because of a split
+   * then we follow the sibling link, and if a node is being removed then we
+   * retry from the root
+   *
+   * NOTE: This function must be called inside an epoch
+   */
+  void LocateLastLeaf(NodeID *node_id_p,
+                      const BaseNode **node_p_p,
+                      NodeID *parent_node_id_p) {
+    NodeID node_id;
+    NodeID parent_node_id;
+    const BaseNode *node_p;
+    
+retry_traverse:
+    node_id = root_id.load();
+    parent_node_id = INVALID_NODE_ID;
+    
+    while(1) {
+      node_p = GetNode(node_id);
+      
+      // The NodeID might have been recycled
+      if(node_p == nullptr) {
+        goto retry_traverse;
+      }
+      
+      // Abort node does not change the content
+      while(node_p->GetType() == NodeType::InnerAbortType) {
+        node_p = (static_cast<const DeltaNode *>(node_p))->child_node_p;
+      }
+      
+      // We do not help along SMOs here, so if the last node is being
+      // removed, we do a normal traversal with its low key to finish the
+      // remove and merge before retrying. Otherwise the removed node
+      // could stay there if no other thread touches this part of the tree.
+      // Note that the left most node is never removed
+      if((node_p->GetType() == NodeType::LeafRemoveType) ||
+         (node_p->GetType() == NodeType::InnerRemoveType)) {
+        bwt_printf("Observed remove node; retry from the root\n");
+
+        Context context{node_p->GetLowKey()};
+        Traverse(&context, nullptr, nullptr);
+
+        goto retry_traverse;
+      }
+      
+      // Keys >= the high key are stored on the right sibling
+      if(node_p->GetNextNodeID() != INVALID_NODE_ID) {
+        node_id = node_p->GetNextNodeID();
+        
+        continue;
+      }
+      
+      if(node_p->IsOnLeafDeltaChain() == true) {
+        break;
+      }
+      
+      // Inner nodes without delta could be read in place
+      parent_node_id = node_id;
+      if(node_p->GetType() == NodeType::InnerType) {
+        const InnerNode *inner_node_p = static_cast<const InnerNode *>(node_p);
+        
+        node_id = (inner_node_p->End() - 1)->second;
+      } else {
+        NodeSnapshot snapshot{node_id, node_p};
+        InnerNode *inner_node_p = CollectAllSepsOnInner(&snapshot);
+        
+        node_id = (inner_node_p->End() - 1)->second;
+        
+        inner_node_p->~InnerNode();
+        DestroyElasticNode(inner_node_p);
+      }
+    } // while(1)
+    
+    *node_id_p = node_id;
+    *node_p_p = node_p;
+    *parent_node_id_p = parent_node_id;
+    
+    return;
+  }
+  
+  /*
+   * ScanLeafLevelReverse() - Scans the leaf level backward starting from a 
+   *                          given key, and calls the scan function on each
+   *                          key-value pair in descending key order
+   *
+   * If start_key_p is nullptr then the scan starts from the last leaf node,
+   * and if low_key_p is nullptr then there is no lower bound. The scan stops
+   * after limit items have been passed to the function, or after the function
+   * returns false.
+   *
+   * Leaf nodes do not have a left sibling link, so instead of traversing
+   * from the root for every leaf node (as ForwardIterator::MoveBackByOne()
+   * does), we cache a consolidated copy of the parent node of the current
+   * leaf. The left sibling is then the child before the current low key in
+   * the parent, and it is accepted only if it is a leaf node not being
+   * removed whose high key equals the low key of the current node. If the
+   * validation fails (e.g. we have reached the first child of the parent, 
+   * or there is an SMO), we call TraverseBI() with the low key and refresh
+   * the parent from the context. The parent is only consolidated when we
+   * actually need to cross a leaf boundary
+   */
+  template <typename ScanFunc>
+  size_t ScanLeafLevelReverse(const KeyType *start_key_p,
+                              bool start_inclusive,
+                              const KeyType *low_key_p,
+                              bool low_inclusive,
+                              size_t limit,
+                              ScanFunc &scan_func) {
+    GetCurrentOperationCounter()->scan_count++;
+    
+    // The epoch is held for the entire scan since resume_key_p points
+    // into the node being scanned
+    EpochNode *epoch_node_p = epoch_manager.JoinEpoch();
+    
+    size_t scan_count = 0UL;
+    
+    // A frozen tree is scanned backward on its packed leaves
+    const FrozenLayout *layout_p = frozen_layout_p.load();
+    if(layout_p != nullptr) {
+      GetCurrentOperationCounter()->frozen_read_count++;
+      
+      scan_count = layout_p->ScanReverse(start_key_p,
+                                         start_inclusive,
+                                         low_key_p,
+                                         low_inclusive,
+                                         limit,
+                                         scan_func);
+      
+      epoch_manager.LeaveEpoch(epoch_node_p);
+      
+      return scan_count;
+    }
+    
+    // Keys <= (or <) this key will be passed to the scan function
+    // If this is nullptr then all keys will be passed
+    const KeyType *resume_key_p = start_key_p;
+    bool resume_inclusive = start_inclusive;
+    
+    // Current leaf node's NodeID and the head of its delta chain
+    NodeID node_id;
+    const BaseNode *node_p;
+    
+    // The parent node of the current leaf node seen during the last
+    // traversal, and its consolidated copy which is created lazily
+    NodeID parent_node_id;
+    InnerNode *parent_node_p = nullptr;
+    
+    if(resume_key_p == nullptr) {
+      LocateLastLeaf(&node_id, &node_p, &parent_node_id);
+    } else {
+      Context context{*resume_key_p};
+      
+      // This stops on the leaf node without traversing the delta chain
+      Traverse(&context, nullptr, nullptr);
+      
+      NodeSnapshot *snapshot_p = GetLatestNodeSnapshot(&context);
+      node_id = snapshot_p->node_id;
+      node_p = snapshot_p->node_p;
+      
+      // For root node this is INVALID_NODE_ID
+      parent_node_id = context.parent_snapshot.node_id;
+    }
+    
+    while(1) {
+      assert(node_p->IsOnLeafDeltaChain() == true);
+      
+      // If the node has deltas then we consolidate it into a temporary
+      // node which is freed after scanning
+      LeafNode *temp_node_p = nullptr;
+      const LeafNode *leaf_node_p;
+      
+      if(node_p->GetType() == NodeType::LeafType) {
+        leaf_node_p = static_cast<const LeafNode *>(node_p);
+      } else {
+        NodeSnapshot snapshot{node_id, node_p};
+        temp_node_p = CollectAllValuesOnLeaf(&snapshot);
+        leaf_node_p = temp_node_p;
+      }
+      
+      // This points to the element after the first one to scan
+      const KeyValuePair *kv_p = \
+        (resume_key_p == nullptr) ? \
+        leaf_node_p->End() : \
+        (resume_inclusive == true) ? \
+        std::upper_bound(leaf_node_p->Begin(),
+                         leaf_node_p->End(),
+                         *resume_key_p,
+                         key_value_pair_cmp_obj) : \
+        std::lower_bound(leaf_node_p->Begin(),
+                         leaf_node_p->End(),
+                         *resume_key_p,
+                         key_value_pair_cmp_obj);
+      
+      bool finished = false;
+      
+      while(kv_p != leaf_node_p->Begin()) {
+        kv_p--;
+        
+        if(low_key_p != nullptr) {
+          if(low_inclusive == true) {
+            finished = KeyCmpLess(kv_p->first, *low_key_p);
+          } else {
+            finished = KeyCmpLessEqual(kv_p->first, *low_key_p);
+          }
+        }
+        
+        if((finished == true) || (scan_count == limit)) {
+          finished = true;
+          
+          break;
+        }
+        
+        scan_count++;
+        if(scan_func(kv_p->first, kv_p->second) == false) {
+          finished = true;
+          
+          break;
+        }
+      }
+      
+      if(temp_node_p != nullptr) {
+        temp_node_p->~LeafNode();
+        DestroyElasticNode(temp_node_p);
+      }
+      
+      // The left node only contains keys < the low key of this node
+      // so we could also stop if it is already below the lower bound
+      bool is_first_leaf = \
+        (node_p->GetLowKeyPair().second == INVALID_NODE_ID);
+      if((finished == false) && 
+         (is_first_leaf == false) &&
+         (low_key_p != nullptr)) {
+        finished = KeyCmpLessEqual(node_p->GetLowKey(), *low_key_p);
+      }
+      
+      if((finished == true) || (is_first_leaf == true)) {
+        break;
+      }
+      
+      // All keys in the left node are < this one
+      resume_key_p = &node_p->GetLowKey();
+      resume_inclusive = false;
+      
+      if((parent_node_p == nullptr) && (parent_node_id != INVALID_NODE_ID)) {
+        parent_node_p = GetConsolidatedInnerNode(parent_node_id);
+        
+        // Only try once for each traversal
+        parent_node_id = INVALID_NODE_ID;
+      }
+      
+      NodeID prev_node_id = INVALID_NODE_ID;
+      const BaseNode *prev_node_p = nullptr;
+      
+      if(parent_node_p != nullptr) {
+        // This is the last separator < the low key, and if the low key is
+        // not inside the parent then the validation below would fail
+        const KeyNodeIDPair *it = \
+          std::lower_bound(parent_node_p->Begin() + 1,
+                           parent_node_p->End(),
+                           *resume_key_p,
+                           key_node_id_pair_cmp_obj) - 1;
+        
+        prev_node_id = it->second;
+        prev_node_p = GetNode(prev_node_id);
+      }
+      
+      if((prev_node_p == nullptr) ||
+         (prev_node_p->IsOnLeafDeltaChain() == false) ||
+         (prev_node_p->GetType() == NodeType::LeafRemoveType) ||
+         (prev_node_p->GetNextNodeID() == INVALID_NODE_ID) ||
+         (KeyCmpEqual(prev_node_p->GetHighKey(), *resume_key_p) == false)) {
+        bwt_printf("Left sibling not found in parent; traverse again\n");
+        
+        if(parent_node_p != nullptr) {
+          parent_node_p->~InnerNode();
+          DestroyElasticNode(parent_node_p);
+          parent_node_p = nullptr;
+        }
+        
+        Context context{*resume_key_p};
+        
+        // This stops on a leaf node whose low key < the search key
+        TraverseBI(&context);
+        
+        NodeSnapshot *snapshot_p = GetLatestNodeSnapshot(&context);
+        prev_node_id = snapshot_p->node_id;
+        prev_node_p = snapshot_p->node_p;
+        
+        parent_node_id = context.parent_snapshot.node_id;
+      }
+      
+      node_id = prev_node_id;
+      node_p = prev_node_p;
+    } // while(1)
+    
+    if(parent_node_p != nullptr) {
+      parent_node_p->~InnerNode();
+      DestroyElasticNode(parent_node_p);
+    }
+    
+    epoch_manager.LeaveEpoch(epoch_node_p);
+    
+    return scan_count;
+  }
+  
+  /*
+   * GetConsolidatedInnerNode() - Returns a consolidated copy of an inner node
+   *                              given its NodeID
+   *
+   * If the NodeID is not mapped, or it maps to a leaf node or an inner node
+   * being removed, then nullptr is returned. Otherwise the caller is
+   * responsible for destroying the returned node
+   *
+   * NOTE: This function must be called inside an epoch
+   */
+  InnerNode *GetConsolidatedInnerNode(NodeID node_id) {
+    const BaseNode *node_p = GetNode(node_id);
+    if(node_p == nullptr) {
+      return nullptr;
+    }
+    
+    // Abort node only blocks other threads from posting on the node
+    // and it does not change the content
+    while(node_p->GetType() == NodeType::InnerAbortType) {
+      node_p = (static_cast<const DeltaNode *>(node_p))->child_node_p;
+    }
+    
+    if((node_p->IsOnLeafDeltaChain() == true) ||
+       (node_p->GetType() == NodeType::InnerRemoveType)) {
+      return nullptr;
+    }
+    
+    NodeSnapshot snapshot{node_id, node_p};
+    
+    return CollectAllSepsOnInner(&snapshot);
+  }
+  
+  /*
+   * GetScanPartitionKeys() - Returns at most (partition_num - 1) keys that
+   *                          cut a key range into partitions of roughly
+   *                          equal sizes
+   *
+   * Separators are taken from the root node, and if the root does not have
+   * enough of them, also from all inner nodes on the second level. Since
+   * the tree is balanced, each separator roughly covers the same number of
+   * items. Only separators inside (low_key, high_key) are used, and nullptr
+   * for either bound means there is no such bound
+   *
+   * The returned keys are sorted and unique. Since they are only hints for
+   * partitioning, concurrent SMOs do not affect the correctness of a scan
+   * using them
+   */
+  std::vector<KeyType> GetScanPartitionKeys(const KeyType *low_key_p,
+                                            const KeyType *high_key_p,
+                                            size_t partition_num) {
+    std::vector<KeyType> sep_list{};
+    if(partition_num <= 1UL) {
+      return sep_list;
+    }
+    
+    EpochNode *epoch_node_p = epoch_manager.JoinEpoch();
+    
+    InnerNode *root_node_p = GetConsolidatedInnerNode(root_id.load());
+    
+    // If the root is a leaf node then there is only one partition
+    if(root_node_p != nullptr) {
+      // This could be called for both the root and its children
+      // The first separator is the low key of the node which is either
+      // -Inf or a separator already in its parent
+      auto collect_seps = [this, 
+                           low_key_p, 
+                           high_key_p, 
+                           &sep_list](const InnerNode *inner_node_p) {
+        for(const KeyNodeIDPair *it = inner_node_p->Begin() + 1;
+            it != inner_node_p->End();
+            it++) {
+          if((low_key_p != nullptr) && 
+             (KeyCmpLessEqual(it->first, *low_key_p) == true)) {
+            continue;
+          } else if((high_key_p != nullptr) && 
+                    (KeyCmpGreaterEqual(it->first, *high_key_p) == true)) {
+            break;
+          }
+          
+          sep_list.push_back(it->first);
+        }
+      };
+      
+      collect_seps(root_node_p);
+      
+      if(sep_list.size() + 1UL < partition_num) {
+        for(const KeyNodeIDPair *it = root_node_p->Begin();
+            it != root_node_p->End();
+            it++) {
+          InnerNode *child_node_p = GetConsolidatedInnerNode(it->second);
+          
+          // The child could be removed concurrently, and in this case 
+          // we just do not use its separators
+          if(child_node_p != nullptr) {
+            collect_seps(child_node_p);
+            
+            child_node_p->~InnerNode();
+            DestroyElasticNode(child_node_p);
+          }
+        }
+      }
+      
+      root_node_p->~InnerNode();
+      DestroyElasticNode(root_node_p);
+    }
+    
+    epoch_manager.LeaveEpoch(epoch_node_p);
+    
+    // Separators on the second level are not necessarily ordered with those
+    // on the root since we read them at different time
+    std::sort(sep_list.begin(), sep_list.end(), key_cmp_obj);
+    sep_list.erase(std::unique(sep_list.begin(), sep_list.end(), key_eq_obj),
+                   sep_list.end());
+    
+    if(sep_list.size() < partition_num) {
+      return sep_list;
+    }
+    
+    // There are (sep_list.size() + 1) ranges, and we pick separators
+    // such that each partition has roughly the same number of ranges
+    std::vector<KeyType> partition_key_list{};
+    partition_key_list.reserve(partition_num - 1UL);
+    
+    for(size_t i = 1UL;i < partition_num;i++) {
+      partition_key_list.push_back(
+        sep_list[i * (sep_list.size() + 1UL) / partition_num - 1UL]);
+    }
+    
+    return partition_key_list;
+  }
+  
+  /*
+   * ParallelScanLeafLevel() - Scans a key range in parallel using tasks
+   *                           submitted to a thread pool
+   *
+   * The key range is cut into partitions using GetScanPartitionKeys(), and
+   * each partition is scanned by ScanLeafLevel() in a separate task, which
+   * joins its own epoch. This function returns after all tasks have finished
+   */
+  template <typename SubmitFunc, typename ScanFunc>
+  size_t ParallelScanLeafLevel(const KeyType *low_key_p,
+                               bool low_inclusive,
+                               const KeyType *high_key_p,
+                               bool high_inclusive,
+                               size_t partition_num,
+                               SubmitFunc &submit_func,
+                               ScanFunc &scan_func) {
+    const std::vector<KeyType> partition_key_list = \
+      GetScanPartitionKeys(low_key_p, high_key_p, partition_num);
+    
+    // There is always one more partition than partition keys
+    const size_t task_num = partition_key_list.size() + 1UL;
+    
+    std::atomic<size_t> finished_count{0UL};
+    std::atomic<size_t> scan_count{0UL};
+    
+    for(size_t i = 0UL;i < task_num;i++) {
+      // Partition i is [partition_key_list[i - 1], partition_key_list[i])
+      // except that the first and the last use the given bound
+      std::function<void()> task = \
+        [this, 
+         i, 
+         task_num,
+         low_key_p, 
+         low_inclusive, 
+         high_key_p, 
+         high_inclusive, 
+         &partition_key_list,
+         &scan_func,
+         &finished_count,
+         &scan_count]() {
+          const KeyType *start_key_p = low_key_p;
+          bool start_inclusive = low_inclusive;
+          const KeyType *end_key_p = high_key_p;
+          bool end_inclusive = high_inclusive;
+          
+          if(i != 0UL) {
+            start_key_p = &partition_key_list[i - 1];
+            start_inclusive = true;
+          }
+          
+          if(i != task_num - 1UL) {
+            end_key_p = &partition_key_list[i];
+            end_inclusive = false;
+          }
+          
+          auto partition_scan_func = \
+            [i, &scan_func](const KeyType &key, const ValueType &value) {
+              return scan_func(i, key, value);
+            };
+          
+          scan_count.fetch_add(ScanLeafLevel(start_key_p,
+                                             start_inclusive,
+                                             end_key_p,
+                                             end_inclusive,
+                                             static_cast<size_t>(-1),
+                                             partition_scan_func));
+          
+          finished_count.fetch_add(1UL);
+          
+          return;
+        };
+      
+      submit_func(std::move(task));
+    }
+    
+    // Tasks refer to local variables so we could not return before
+    // all of them have finished
+    while(finished_count.load() != task_num) {
+      std::this_thread::yield();
+    }
+    
+    return scan_count.load();
+  }
+
+  /*
+   * PostInnerInsertNode() - Posts an InnerInsertNode on the parent node
+   *
+   * This is used to finish the partial node split SMO as part of the help
+   * along protocol
+   *
+   * NOTE: This function may abort
+   */
+  inline bool PostInnerInsertNode(Context *context_p,
+                                  const KeyNodeIDPair &insert_item,
+                                  const KeyNodeIDPair &next_item,
+                                  const KeyNodeIDPair *location) {
+    // We post on the parent node, after which we check for size and decide whether
+    // to consolidate and/or split the node
+    NodeSnapshot *parent_snapshot_p = GetLatestParentNodeSnapshot(context_p);
+
+    // Three arguments are: inserted key-node id pair
+    //                      next key-node id pair
+    //                      child node in delta chain
+    const InnerInsertNode *insert_node_p = \
+      InnerInlineAllocateOfType(InnerInsertNode,
+                                parent_snapshot_p->node_p,
+                                insert_item,
+                                next_item,
+                                parent_snapshot_p->node_p,
+                                location);
+
+    // CAS Index Term Insert Delta onto the parent node
+    bool ret = InstallNodeToReplace(parent_snapshot_p->node_id,
+                                    insert_node_p,
+                                    parent_snapshot_p->node_p);
+
+    if(ret == true) {
+      bwt_printf("Index term insert (from %lu to %lu) delta CAS succeeds\n",
+                 GetLatestNodeSnapshot(context_p)->node_id,
+                 insert_item.second);
+
+      // Update parent node pointer to reflect the fact that it has been
+      // updated
+      parent_snapshot_p->node_p = insert_node_p;
+
+      ConsolidateNode(GetLatestNodeSnapshot(context_p));
+
+      return true;
+    } else {
+      bwt_printf("Index term insert (from %lu to %lu) delta CAS failed. "
+                 "ABORT\n",
+                 GetLatestNodeSnapshot(context_p)->node_id,
+                 insert_item.second);
+
+      GetCurrentOperationCounter()->CASFailed(CASSite::IndexTermInsert);
+
+      // Set abort, and remove the newly created node
+      context_p->abort_flag = true;
+      
+      // Call destructor but do not free memory
+      insert_node_p->~InnerInsertNode();
+
+      return false;
+    } // if CAS succeeds/fails
+
+    assert(false);
+    return false;
+  }
+
+  /*
+   * PostInnerDeleteNode() - Posts an InnerDeleteNode on the current parent node
+   *
+   * This function is called to complete node merges as part of the SMO help-along
+   * protocol. It posts an InnerDeleteNode on the parent node and returns the result
+   * of CAS instruction
+   *
+   * NOTE: This function may abort
+   */
+  inline bool PostInnerDeleteNode(Context *context_p,
+                                  const KeyNodeIDPair &delete_item,
+                                  const KeyNodeIDPair &prev_item,
+                                  const KeyNodeIDPair &next_item,
+                                  const KeyNodeIDPair *location) {
+    NodeSnapshot *parent_snapshot_p = GetLatestParentNodeSnapshot(context_p);
+
+    // Arguments are:
+    // Deleted item; Prev item; next item (NodeID not used for next item)
+    // and delta chail child node
+    const InnerDeleteNode *delete_node_p = \
+      InnerInlineAllocateOfType(InnerDeleteNode,
+                                parent_snapshot_p->node_p,
+                                delete_item,
+                                prev_item,
+                                next_item,
+                                parent_snapshot_p->node_p,
+                                location);
+
+    // Assume parent has not changed, and CAS the index term delete delta
     // If CAS failed then parent has changed, and we have no idea how it
     // could be modified. The safest way is just abort
     bool ret = InstallNodeToReplace(parent_snapshot_p->node_id,
                                     delete_node_p,
                                     parent_snapshot_p->node_p);
 
-    // If we installed the IndexTermDeleteDelta successfully the next
-    // step is to put the remove node into garbage chain
-    // and also recycle the deleted NodeID since now no new thread
-    // could access that NodeID until it is reused
-    if(ret == true) {
-      bwt_printf("Index term delete delta installed, ID = %lu; ABORT\n",
-                 parent_snapshot_p->node_id);
+    // If we installed the IndexTermDeleteDelta successfully the next
+    // step is to put the remove node into garbage chain
+    // and also recycle the deleted NodeID since now no new thread
+    // could access that NodeID until it is reused
+    if(ret == true) {
+      bwt_printf("Index term delete delta installed, ID = %lu; ABORT\n",
+                 parent_snapshot_p->node_id);
+
+      // The deleted node ID must resolve to a RemoveNode of either
+      // Inner or Leaf category
+      const BaseNode *garbage_node_p = GetNode(delete_item.second);
+      assert(garbage_node_p->IsRemoveNode());
+
+      // Put the remove node into garbage chain
+      // This will not remove the child node of the remove node, which
+      // should be removed together with the merge node above it
+      // Also, the remove node acts as a container for removed NodeID
+      // which will be recycled when the remove node is recycled
+      epoch_manager.AddGarbageNode(garbage_node_p);
+
+      // To avoid this entry being recycled during tree destruction
+      // Since the entry still remains in the old inner base node
+      // but we should have already deleted it
+      // NOTE: We could not do it here since some thread will fetch
+      // nullptr from the mapping table
+      // We should recycle the NodeID using EpochManager
+      // and requires that epoch manager finishes all epoches before
+      // the tree is destroyed
+      //mapping_table[deleted_node_id] = nullptr;
+
+      parent_snapshot_p->node_p = delete_node_p;
+
+      ConsolidateNode(GetLatestNodeSnapshot(context_p));
+
+      return true;
+    } else {
+      bwt_printf("Index term delete delta install failed. ABORT\n");
+
+      GetCurrentOperationCounter()->CASFailed(CASSite::IndexTermDelete);
+
+      // DO NOT FORGET TO DELETE THIS
+      delete_node_p->~InnerDeleteNode();
+
+      // The caller just returns after this function, so do not have
+      // to branch on abort_flag after this function returns
+      context_p->abort_flag = true;
+
+      return false;
+    }
+
+    assert(false);
+    return false;
+  }
+
+  /*
+   * FinishPartialSMO() - Finish partial completed SMO if there is one
+   *
+   * This function defines the help-along protocol, i.e. if we find
+   * a SMO on top of the delta chain, we should help-along that SMO before
+   * doing our own job. This might incur a recursive call of this function.
+   *
+   * If this function returns true, then a node consolidation on the current
+   * top snapshot is recommended, because we have seen and processed (or
+   * confirmed that it has been processed) a merge/split delta on current
+   * top snapshot. To prevent other threads from seeing them and taking
+   * a full snapshot of the parent snapshot everytime they are seen, we
+   * return true to inform caller to do a consolidation
+   *
+   * If we see a remove node, then the actual NodeID pushed into the path
+   * list stack may not equal the NodeID passed in this function. So when
+   * we need to read NodeID, always use the one stored in the NodeSnapshot
+   * vector instead of using a previously passed one
+   */
+  void FinishPartialSMO(Context *context_p) {
+    // Note: If the top of the path list changes then this pointer
+    // must also be updated
+    NodeSnapshot *snapshot_p = GetLatestNodeSnapshot(context_p);
+
+before_switch:
+    switch(snapshot_p->node_p->GetType()) {
+      case NodeType::InnerAbortType: {
+        bwt_printf("Observed Inner Abort Node; Help along\n");
+
+        const InnerAbortNode *abort_node_p = \
+          static_cast<const InnerAbortNode *>(snapshot_p->node_p);
+
+        // Finish the pending removal of the child, which also removes
+        // the abort node, such that posting on this node does not fail
+        // while the thread that posted the abort node is delayed
+        if(FinishRemoval(snapshot_p->node_id, abort_node_p) == true) {
+          GetCurrentOperationCounter()->removal_help_count++;
+        }
+
+        // We continue with the abort node's child. If the abort node is
+        // still there (i.e. another thread is finishing the removal) then
+        // CAS always fails on this node, which avoids posting on ABORT,
+        // especially posting split node
+        snapshot_p->node_p = abort_node_p->child_node_p;
+
+        goto before_switch;
+      }
+      case NodeType::LeafRemoveType:
+      case NodeType::InnerRemoveType: {
+        bwt_printf("Helping along remove node...\n");
+
+        // The right branch for merging is the child node under remove node
+        const BaseNode *merge_right_branch = \
+          (static_cast<const DeltaNode *>(snapshot_p->node_p))->child_node_p;
+
+        // This will also be recorded in merge delta such that when
+        // we finish merge delta we could recycle the node id as well
+        // as the RemoveNode
+        NodeID deleted_node_id = snapshot_p->node_id;
+
+        JumpToLeftSibling(context_p);
+
+        // If this aborts then we propagate this to the state machine driver
+        if(context_p->abort_flag == true) {
+          bwt_printf("Jump to left sibling in Remove help along ABORT\n");
+
+          // Here we are uncertain about the current status (it might have
+          // jumped and observed an inconsistent next node ID, or it has not
+          // jumped because of an inconsistent left child status)
+          return;
+        }
+
+        // That is the left sibling's snapshot
+        NodeSnapshot *left_snapshot_p = GetLatestNodeSnapshot(context_p);
+
+        // Update snapshot pointer if we fall through to posting
+        // index term delete delta for merge node
+        snapshot_p = left_snapshot_p;
+
+        // This serves as the merge key
+        // Note that the left sibling node must have a valid high key
+        const KeyType &merge_key = snapshot_p->node_p->GetHighKey();
+
+        // This holds the merge node if installation is successful
+        // Not changed (i.e.undefined) if CAS fails
+        const BaseNode *merge_node_p = nullptr;
+
+        bool ret;
+
+        // If we are currently on leaf, just post leaf merge delta
+        if(left_snapshot_p->IsLeaf() == true) {
+          ret = \
+            PostLeafMergeNode(left_snapshot_p,
+                              &merge_key,
+                              merge_right_branch,
+                              deleted_node_id,
+                              &merge_node_p);
+        } else {
+          ret = \
+            PostInnerMergeNode(left_snapshot_p,
+                               &merge_key,
+                               merge_right_branch,
+                               deleted_node_id,
+                               &merge_node_p);
+        }
+
+        // If CAS fails just abort and return
+        if(ret == true) {
+          bwt_printf("Merge delta CAS succeeds. "
+                     "Continue to finish merge SMO\n");
+
+          left_snapshot_p->node_p = merge_node_p;
+
+          // merge_node_p is set as the newest merge node above
+          // after this point
+          // Also snapshot_p has been to left_snapshot_p above
+        } else {
+          bwt_printf("Merge delta CAS fails. ABORT\n");
+
+          context_p->abort_flag = true;
+
+          return;
+        } // if ret == true
+
+        //
+        // FALL THROUGH IF POSTING MERGE DELTA SUCCEEDS
+        //
+
+      } // case Inner/LeafRemoveType
+      case NodeType::InnerMergeType:
+      case NodeType::LeafMergeType: {
+        bwt_printf("Helping along merge delta\n");
+
+        // First consolidate parent node and find the left/right
+        // sep pair plus left node ID
+        NodeSnapshot *parent_snapshot_p = \
+          GetLatestParentNodeSnapshot(context_p);
+
+        // This is necessary - make sure the parent node snapshot
+        // is always update to date such that we do not miss a
+        // late InnerInsertNode that actually posts the deleted item
+        // o.w. the thread will just continue and post on top of
+        // an unfinished merge delta
+        if(parent_snapshot_p->node_p != GetNode(parent_snapshot_p->node_id)) {
+          context_p->abort_flag = true;
+          
+          return;
+        }
+
+        // This is the item being deleted inside parent node
+        const KeyNodeIDPair *delete_item_p = nullptr;
+        const BaseNode *right_merge_p = nullptr;
+
+        // Type of the merge delta
+        // This is important since we might fall through
+        // from the LeafRemoveNode/InnerRemoveNode branch
+        NodeType type = snapshot_p->node_p->GetType();
+        
+        if(type == NodeType::InnerMergeType) {
+          const InnerMergeNode *merge_node_p = \
+            static_cast<const InnerMergeNode *>(snapshot_p->node_p);
+
+          delete_item_p = &merge_node_p->delete_item;
+          right_merge_p = merge_node_p->right_merge_p;
+        } else if(type == NodeType::LeafMergeType) {
+          const LeafMergeNode *merge_node_p = \
+            static_cast<const LeafMergeNode *>(snapshot_p->node_p);
+
+          delete_item_p = &merge_node_p->delete_item;
+          right_merge_p = merge_node_p->right_merge_p;
+        } else {
+          bwt_printf("ERROR: Illegal node type: %d\n",
+                     static_cast<int>(type));
+
+          assert(false);
+        } // If on type of merge node
+
+        const KeyNodeIDPair *location;
+
+        // Find the deleted item
+        const KeyNodeIDPair *found_pair_p = \
+          NavigateInnerNode(parent_snapshot_p, 
+                            delete_item_p->first, 
+                            &location);
+          
+        // If the item is found then next we post InnerDeleteNode
+        if(found_pair_p != nullptr) {
+          assert(found_pair_p->second == delete_item_p->second);
+        } else {
+          return;
+        }
+
+        // It will post an InnerDeleteNode on the parent node
+        // and the return value is the result of CAS
+        // Note: Even if this function aborts, since we return immediately
+        // so do not have to test abort_flag here
+        //
+        // There is a trick: The prev key is the low key of the node
+        // being merged into
+        // and the next key is the high key of the node being merged from
+        PostInnerDeleteNode(context_p,
+                            *delete_item_p,
+                            // Note that for leaf node the low key is not complete
+                            std::make_pair(snapshot_p->node_p->GetLowKey(), snapshot_p->node_id),
+                            // Also note that high key pair is valid for both leaf and inner
+                            right_merge_p->GetHighKeyPair(),
+                            // This is location on InnerNode
+                            location);
+
+        return;
+      } // case Inner/LeafMergeNode
+      case NodeType::InnerSplitType:
+      case NodeType::LeafSplitType: {
+        bwt_printf("Helping along split node\n");
+
+        // These two will be stored inside InnerInsertNode
+        // The insert item is just the split item inside InnerSplitNode
+        // but next item needs to be read from the parent node
+        const KeyNodeIDPair *insert_item_p;
+
+        // This is set to use the high key pair of the node under
+        // split delta
+        const KeyNodeIDPair *next_item_p;
+
+        NodeType type = snapshot_p->node_p->GetType();
+
+        // NOTE: depth should not be read here, since we
+        // need to know the depth on its parent node
+        if(type == NodeType::InnerSplitType) {
+          const InnerSplitNode *split_node_p = \
+            static_cast<const InnerSplitNode *>(snapshot_p->node_p);
+
+          insert_item_p = &split_node_p->insert_item;
+          next_item_p = &split_node_p->child_node_p->GetHighKeyPair();
+        } else {
+          const LeafSplitNode *split_node_p = \
+            static_cast<const LeafSplitNode *>(snapshot_p->node_p);
+
+          insert_item_p = &split_node_p->insert_item;
+          next_item_p = &split_node_p->child_node_p->GetHighKeyPair();
+        }
+
+        assert(context_p->current_level >= 0);
+
+        // If the parent snapshot has an invalid node ID then it must be the
+        // root node. 
+        if(context_p->IsOnRootNode() == true) {
+          /***********************************************************
+           * Root splits (don't have to consolidate parent node)
+           ***********************************************************/
+          bwt_printf("Root splits!\n");
+
+          // Allocate a new node ID for the newly created node
+          // If CAS fails we need to free the root ID
+          NodeID new_root_id = GetNextNodeID();
+
+          // InnerNode requires high key pair which is +Inf, INVALID NODE ID
+          // low key pair will be set inside the constructor to be pointing
+          // to the first element in the sep list
+          // NOTE: Storage will be automatically reserved inside the
+          // constructor
+          #ifdef BWTREE_PELOTON
+
+          // This is the first item of the newly created InnerNode
+          // and also the low key for the newly created InnerNode
+          const KeyNodeIDPair first_item = std::make_pair(KeyType(),
+                                                          snapshot_p->node_id);
+
+          // Allocate an InnerNode with KeyNodeIDPair embedded
+          InnerNode *inner_node_p = \
+            reinterpret_cast<InnerNode *>( \
+              ElasticNode<KeyNodeIDPair>::\
+                Get(2, 
+                    NodeType::InnerType, 
+                    0,
+                    2,
+                    first_item,
+                    std::make_pair(KeyType(), INVALID_NODE_ID)));
+
+          #else
+
+          // This is the first item of the newly created InnerNode
+          // and also the low key for the InnerNode
+          const KeyNodeIDPair first_item = std::make_pair(KeyType{},
+                                                          snapshot_p->node_id);
+
+          // Allocate an InnerNode with KeyNodeIDPair embedded
+          InnerNode *inner_node_p = \
+            reinterpret_cast<InnerNode *>( \
+              ElasticNode<KeyNodeIDPair>::\
+                Get(2, 
+                NodeType::InnerType, 
+                0,
+                2,
+                first_item,
+                std::make_pair(KeyType{}, INVALID_NODE_ID)));
+                               
+          #endif
+
+          AccountNewNode(inner_node_p);
+
+          // Add new element - one points to the current node (new second level
+          // left most inner node), another points to its split sibling
+          inner_node_p->PushBack(first_item);
+          inner_node_p->PushBack(*insert_item_p);
+
+          // First we need to install the new node with NodeID
+          // This makes it visible
+          InstallNewNode(new_root_id, inner_node_p);
+          bool ret = InstallRootNode(snapshot_p->node_id,
+                                     new_root_id);
+
+          if(ret == true) {
+            bwt_printf("Install root CAS succeeds\n");
+
+            // After installing new root we abort in order to load
+            // the new root
+            context_p->abort_flag = true;
+
+            return;
+          } else {
+            bwt_printf("Install root CAS failed. ABORT\n");
+
+            GetCurrentOperationCounter()->CASFailed(CASSite::Root);
+
+            // We need to make a new remove node and send it into EpochManager
+            // for recycling the NodeID
+            // Note that the remove node must not be created on inner_node_p
+            // since inner_node_p might be destroyed before remove node is 
+            // destroyed since they are both put into the GC chain
+            const InnerRemoveNode *fake_remove_node_p = \
+              new InnerRemoveNode{new_root_id, 
+                                  inner_node_p};
+
+            GetCurrentMemoryCounter()->delta_size += sizeof(InnerRemoveNode);
+
+            // Put the remove node into garbage chain, because
+            // we cannot call InvalidateNodeID() here
+            epoch_manager.AddGarbageNode(fake_remove_node_p);
+            epoch_manager.AddGarbageNode(inner_node_p);
+
+            context_p->abort_flag = true;
+
+            return;
+          } // if CAS succeeds/fails
+        } else {
+          /***********************************************************
+           * Index term insert for non-root nodes
+           ***********************************************************/
+
+          // First consolidate parent node and find the right sep
+          NodeSnapshot *parent_snapshot_p = \
+            GetLatestParentNodeSnapshot(context_p);
+
+          // If the split key is out of range then just ignore
+          // we do not worry that through split sibling link
+          // we would traverse to the child of a different parent node
+          // than the current one, since we always guarantee that after
+          // NavigateInnerNode() returns if it does not abort, then we
+          // are on the correct node for the current key
+
+          // This happens when the parent splits on the newly inserted index term
+          // and the split delta has not been consolidated yet, so that a thread
+          // sees the split delta and traverses to its right sibling which is on
+          // another parent node (the right sibling of the current parent node)
+          // In this case we do not have to insert since we know the index term has
+          // already been inserted
+          if((parent_snapshot_p->node_p->GetNextNodeID() != INVALID_NODE_ID) &&
+             (KeyCmpGreaterEqual(insert_item_p->first,
+                                 parent_snapshot_p->node_p->GetHighKey()))) {
+            bwt_printf("Bounds check failed on parent node"
+                       " - item key >= high key\n");
+
+            return;
+          }
+          
+          // This is used to hold index information for InnerInsertNode
+          const KeyNodeIDPair *location;
+
+          // Find the split item that we intend to insert in the parent node
+          // This function returns a pointer to the item if found, or
+          // nullptr if not found
+          const KeyNodeIDPair *found_item_p = \
+            NavigateInnerNode(parent_snapshot_p, 
+                              insert_item_p->first, 
+                              &location);
+
+          // If the item has been found then we do not post
+          // InnerInsertNode onto the parent
+          if(found_item_p != nullptr) {
+            
+            // Check whether there is an item in the parent
+            // node that has the same key but different NodeID
+            // This is totally legal
+            if(found_item_p->second != insert_item_p->second) {
+              
+              #ifdef BWTREE_DEBUG
+              
+              // If this happens then it must be the case that the node with
+              // the same split key but different node ID was removed and then
+              // merged into the current node and then it is splited again
+              //
+              // We are now on the way of completing the second split SMO
+              // but since the parent has changed (we must have missed an
+              // InnerInsertNode) we need to abort and restart traversing
+              const BaseNode *node_p = GetNode(found_item_p->second);
+              
+              assert(node_p->GetType() == NodeType::InnerRemoveType ||
+                     node_p->GetType() == NodeType::LeafRemoveType);
+              
+              #endif
+              
+              context_p->abort_flag = true;
+            }
+            
+            return;
+          }
+
+          // Post InnerInsertNode on the parent node.
+          // Also if this returns true then we have successfully completed split SMO
+          // which means the SMO could be removed by a consolidation to avoid
+          // consolidating the parent node again and again
+          // Note: Even if this function aborts, since we return immediately
+          // so do not have to test abort_flag here
+          PostInnerInsertNode(context_p, 
+                              *insert_item_p, 
+                              *next_item_p, 
+                              location);
+
+          return;
+        } // if split root / else not split root
+      } // case split node
+      default: {
+        return;
+        // By default we do not do anything special
+        break;
+      }
+    } // switch
+
+    assert(false);
+    return;
+  }
+  
+  /*
+   * ConsolidateLeafNode() - Consolidates a leaf delta chian unconditionally
+   *
+   * This function does not check delta chain size
+   */
+  inline void ConsolidateLeafNode(NodeSnapshot *snapshot_p) {
+    assert(snapshot_p->node_p->IsOnLeafDeltaChain() == true);
+    
+    LeafNode *leaf_node_p = CollectAllValuesOnLeaf(snapshot_p);
+
+    bool ret = InstallNodeToReplace(snapshot_p->node_id,
+                                    leaf_node_p,
+                                    snapshot_p->node_p);
+
+    if(ret == true) {
+      epoch_manager.AddGarbageNode(snapshot_p->node_p);
+
+      snapshot_p->node_p = leaf_node_p;
+      
+      GetCurrentOperationCounter()->consolidate_count++;
+    } else {
+      GetCurrentOperationCounter()->CASFailed(CASSite::Consolidate);
+      
+      epoch_manager.AddGarbageNode(leaf_node_p);
+    }
+    
+    return;
+  }
+  
+  /*
+   * ConsolidateInnerNode() - Consolidates inner node unconditionally
+   *
+   * This function does not check for inner delta chain length
+   */
+  inline void ConsolidateInnerNode(NodeSnapshot *snapshot_p) {
+    assert(snapshot_p->node_p->IsOnLeafDeltaChain() == false);
+    
+    InnerNode *inner_node_p = CollectAllSepsOnInner(snapshot_p);
+
+    bool ret = InstallNodeToReplace(snapshot_p->node_id,
+                                    inner_node_p,
+                                    snapshot_p->node_p);
+
+    if(ret == true) {
+      epoch_manager.AddGarbageNode(snapshot_p->node_p);
+
+      snapshot_p->node_p = inner_node_p;
+      
+      GetCurrentOperationCounter()->consolidate_count++;
+    } else {
+      GetCurrentOperationCounter()->CASFailed(CASSite::Consolidate);
+      
+      epoch_manager.AddGarbageNode(inner_node_p);
+    }
+    
+    return;
+  }
+
+  /*
+   * ConsolidateNode() - Consolidates current node unconditionally
+   *
+   * This function is called after finishing split/merge SMO, since we
+   * want to prevent other threads from seeing the finished SMO and
+   * do an useless consolidation on the parent node
+   *
+   * NOTE: This function does not return any value reflecting the status
+   * of CAS operation, since consolidation is an optional operation, and it
+   * would not have any effect even if it fails
+   */
+  void ConsolidateNode(NodeSnapshot *snapshot_p) {
+    if(snapshot_p->node_p->IsOnLeafDeltaChain() == true) {
+      ConsolidateLeafNode(snapshot_p);
+    } else {
+      ConsolidateInnerNode(snapshot_p);
+    } // if on leaf/inner node
+
+    return;
+  }
+
+  /*
+   * TryConsolidateNode() - Consolidate current node if its length exceeds the
+   *                        threshold value
+   *
+   * If the length of delta chain does not exceed the threshold then this
+   * function does nothing
+   *
+   * If function returns true then we have successfully consolidated a node
+   * Otherwise no consolidation happens. The return value might be used
+   * as a hint for deciding whether to adjust node size or not
+   *
+   * NOTE: If consolidation fails then this function does not do anything
+   * and will just continue with its own job. There is no chance of abort
+   *
+   * TODO: If strict mode is on, then whenever consolidation fails we should
+   * always abort and start from the beginning, to keep delta chain length
+   * upper bound intact
+   */
+  void TryConsolidateNode(Context *context_p) {
+    NodeSnapshot *snapshot_p = GetLatestNodeSnapshot(context_p);
+
+    // Do not overwrite this pointer since we will use this
+    // to locate garbage delta chain
+    const BaseNode *node_p = snapshot_p->node_p;
+
+    // We could only perform consolidation on delta node
+    // because we want to see depth field
+    if(node_p->IsDeltaNode() == false) {
+      // The depth of base node may not be 0
+      // since if we consolidate parent node to finish the partial SMO,
+      // then parent node will have non-0 depth in order to avoid being too
+      // large (see FindSplitNextKey() and FindMergePrevNextKey() and
+      // JumpToLeftSibling())
+      // assert(node_p->metadata.depth == 0);
+
+      return;
+    }
+
+    // If depth does not exceed threshold then we check recommendation flag
+    int depth = node_p->GetDepth();
+
+    if(snapshot_p->IsLeaf() == true) {
+      if(depth < LEAF_DELTA_CHAIN_LENGTH_THRESHOLD) {
+        return;
+      }
+    } else {
+      if(depth < INNER_DELTA_CHAIN_LENGTH_THRESHOLD) {
+        return;
+      }
+    }
+
+    // After this point we decide to consolidate node
+
+    ConsolidateNode(snapshot_p);
+
+    return;
+  }
+
+  /*
+   * IsHotLeaf() - Returns whether a leaf is split because of contention
+   *
+   * A leaf on which many CAS fail is split to spread writers over two
+   * NodeIDs, as long as both halves stay above merge threshold
+   */
+  inline bool IsHotLeaf(NodeID node_id, size_t node_size) {
+    return (contention_split_threshold != 0) && \
+           (node_size >= 2 * (leaf_merge_threshold + 1)) && \
+           (GetLeafContention(node_id) >= contention_split_threshold);
+  }
+
+  /*
+   * LeafNeedsAdjustment() - Returns whether AdjustNodeSize() would split
+   *                         or remove a base leaf
+   *
+   * The left most leaf is never removed. Other left most children are not
+   * known without the parent, so they might give a false positive
+   */
+  inline bool LeafNeedsAdjustment(NodeID node_id,
+                                  const LeafNode *leaf_node_p) {
+    size_t node_size = leaf_node_p->GetItemCount();
+
+    if((node_size <= leaf_merge_threshold) && (node_id != first_leaf_id)) {
+      return true;
+    }
+
+    return (node_size >= LEAF_NODE_SIZE_UPPER_THRESHOLD) || \
+           (IsHotLeaf(node_id, node_size) == true);
+  }
+
+  /*
+   * AdjustNodeSize() - Post split or merge delta if a node becomes overflow
+   *                    or underflow
+   *
+   * For leftmost children nodes and for root node (which has is_leftmost
+   * flag set) we never post remove delta, the merge of which would change
+   * its parent node's low key
+   *
+   * NOTE: This function will abort after installing a node remove delta,
+   * in order not to have to call LoadNodeID recursively
+   *
+   * TODO: In the future we might want to change this
+   */
+  void AdjustNodeSize(Context *context_p) {
+    NodeSnapshot *snapshot_p = GetLatestNodeSnapshot(context_p);
+    const BaseNode *node_p = snapshot_p->node_p;
+
+    // We do not adjust size for delta nodes
+    if(node_p->IsDeltaNode() == true) {
+      // TODO: If we want to strictly enforce the size of any node
+      // then we should aggressively consolidate here and always
+      // Though it brings huge overhead because now we are consolidating
+      // every node on the path
+
+      return;
+    }
+
+    NodeID node_id = snapshot_p->node_id;
+
+    if(snapshot_p->IsLeaf() == true) {
+      const LeafNode *leaf_node_p = \
+        static_cast<const LeafNode *>(node_p);
+
+      // NOTE: We use key number as the size of the node
+      // because using item count might result in a very unstable
+      // split, in a sense that we could not always split the node
+      // evenly, and in the worst case if there is one key in the
+      // node the node could not be splited while having a large
+      // item count
+      size_t node_size = leaf_node_p->GetItemCount();
+
+      bool is_hot = IsHotLeaf(node_id, node_size);
+
+      // Perform corresponding action based on node size
+      if((node_size >= LEAF_NODE_SIZE_UPPER_THRESHOLD) || (is_hot == true)) {
+        bwt_printf("Node size >= leaf upper threshold or node is hot. "
+                   "Split\n");
+
+        // If the key we are going to insert is greater than all keys in
+        // the leaf then keys are likely appended in increasing order, in
+        // which case the left node will not receive more keys after split
+        // Hot leaves, and leaves split by other operations, are always
+        // split evenly
+        const KeyValuePair &last_item = \
+          leaf_node_p->At(leaf_node_p->GetSize() - 1);
+        bool is_append = \
+          (is_hot == false) && \
+          (context_p->is_insert == true) && \
+          (KeyCmpGreater(context_p->search_key, last_item.first) == true);
+
+        // Note: This function takes this as argument since it will
+        // do key comparison
+        const LeafNode *new_leaf_node_p = \
+          leaf_node_p->GetSplitSibling(this, is_append);
+
+        // If the new leaf node pointer is nullptr then it means the
+        // although the size of the leaf node exceeds split threshold
+        // but we could not find a spliting point that evenly or almost
+        // evenly divides the key space into two siblings whose sizes
+        // are both larger than the merge threshold (o.w. the node will
+        // be immediately merged)
+        // NOTE: This is a potential problem if a leaf becomes very unbalanced
+        // since all threads will try to split the leaf node when traversing
+        // to it (not for reader threads)
+        if(new_leaf_node_p == nullptr) {
+          bwt_printf("LeafNode size exceeds overhead, "
+                     "but could not find split point\n");
+
+          return;
+        }
+
+        AccountNewNode(new_leaf_node_p);
+
+        // Since we would like to access its first element to get the low key
+        assert(new_leaf_node_p->GetSize() > 0);
+
+        // The split key must be a valid key
+        // Note that the lowkey for leaf node is not defined, so in the
+        // case that it is required we must manually goto its data list
+        // and find the low key in its leftmost element
+        const KeyType &split_key = new_leaf_node_p->At(0).first;
+
+        // If leaf split fails this should be recyced using a fake remove node
+        NodeID new_node_id = GetNextNodeID();
+
+        // Note that although split node only stores the new node ID
+        // we still need its pointer to compute item_count
+        const LeafSplitNode *split_node_p = \
+          LeafInlineAllocateOfType(LeafSplitNode, 
+                                   node_p, 
+                                   std::make_pair(split_key, new_node_id),
+                                   node_p,
+                                   new_leaf_node_p);
+
+        //  First install the NodeID -> split sibling mapping
+        // If CAS fails we also need to recycle the node ID allocated here
+        InstallNewNode(new_node_id, new_leaf_node_p);
+
+        // Then CAS split delta into current node's NodeID
+        bool ret = InstallNodeToReplace(node_id, split_node_p, node_p);
+
+        if(ret == true) {
+          bwt_printf("Leaf split delta (from %lu to %lu) CAS succeeds. ABORT\n",
+                     node_id,
+                     new_node_id);
+
+          GetCurrentOperationCounter()->split_count++;
+          if(is_append == true) {
+            GetCurrentOperationCounter()->append_split_count++;
+          }
+
+          if(is_hot == true) {
+            GetCurrentOperationCounter()->contention_split_count++;
+          }
+
+          // Both halves start with no contention; the new NodeID might be
+          // recycled and have the counter of a freed leaf
+          contention_table[node_id % CONTENTION_TABLE_SIZE].store(
+            0, std::memory_order_relaxed);
+          contention_table[new_node_id % CONTENTION_TABLE_SIZE].store(
+            0, std::memory_order_relaxed);
+
+          // TODO: WE ABORT HERE TO AVOID THIS THREAD POSTING ANYTHING
+          // ON TOP OF IT WITHOUT HELPING ALONG AND ALSO BLOCKING OTHER
+          // THREAD TO HELP ALONG
+          context_p->abort_flag = true;
+
+          return;
+        } else {
+          bwt_printf("Leaf split delta CAS fails\n");
+
+          GetCurrentOperationCounter()->CASFailed(CASSite::Split);
+
+          // Need to use the epoch manager to recycle NodeID
+          // Note that this node must not be created on new_leaf_node_p
+          // since they are both put into the GC chain, it is possible
+          // for new_leaf_node_p to be deleted first and then remove node
+          // is deleted
+          const LeafRemoveNode *fake_remove_node_p = \
+            new LeafRemoveNode{new_node_id, 
+                               new_leaf_node_p};
+
+          GetCurrentMemoryCounter()->delta_size += sizeof(LeafRemoveNode);
+
+          // Must put both of them into GC chain since RemoveNode
+          // will not be followed by GC thread
+          epoch_manager.AddGarbageNode(fake_remove_node_p);
+          epoch_manager.AddGarbageNode(new_leaf_node_p);
+
+          // We have two nodes to delete here
+          split_node_p->~LeafSplitNode();
+
+          return;
+        }
+
+      } else if(node_size <= leaf_merge_threshold) {
+        // This might yield a false positive of left child
+        // but correctness is not affected - sometimes the merge is delayed
+        if(IsOnLeftMostChild(context_p) == true) {
+          bwt_printf("Left most leaf node cannot be removed\n");
+
+          return;
+        }
+
+        // The leaf is removed later by MergeDeferredNodes() if it is still
+        // underfull by then
+        if((defer_leaf_merge == true) &&
+           (context_p->merge_now == false) &&
+           (DeferMerge(node_id) == true)) {
+          bwt_printf("Leaf merge deferred\n");
+
+          return;
+        }
+
+        // After this point we decide to remove leaf node
+
+        bwt_printf("Node size <= leaf lower threshold. Remove\n");
+
+        const LeafRemoveNode *remove_node_p = \
+          new LeafRemoveNode{node_id, 
+                             node_p};
+
+        GetCurrentMemoryCounter()->delta_size += sizeof(LeafRemoveNode);
+
+        // Install an abort node describing the removal on parent
+        const InnerAbortNode *abort_node_p;
+        NodeID parent_node_id;
+
+        bool abort_node_ret = \
+          PostAbortOnParent(context_p,
+                            node_id,
+                            node_p,
+                            remove_node_p,
+                            &parent_node_id,
+                            &abort_node_p);
+
+        // If we could not block the parent then the parent has changed
+        // (splitted, etc.)
+        if(abort_node_ret == true) {
+          bwt_printf("Blocked parent node (current node is leaf)\n");
+        } else {
+          bwt_printf("Unable to block parent node "
+                     "(current node is leaf). ABORT\n");
+
+          delete remove_node_p;
+          GetCurrentMemoryCounter()->delta_size -= sizeof(LeafRemoveNode);
+
+          // ABORT and return
+          context_p->abort_flag = true;
+
+          return;
+        }
+
+        // This might be done by another thread that has observed the
+        // abort node in the meantime, in which case it returns false
+        FinishRemoval(parent_node_id, abort_node_p);
+
+        // Abort whether or not the remove delta is installed, since
+        // the current node has changed anyway
+        context_p->abort_flag = true;
+
+        return;
+      }
+    } else {   // If this is an inner node
+      const InnerNode *inner_node_p = static_cast<const InnerNode *>(node_p);
+
+      size_t node_size = inner_node_p->GetSize();
+
+      if(node_size >= INNER_NODE_SIZE_UPPER_THRESHOLD) {
+        bwt_printf("Node size >= inner upper threshold. Split\n");
+
+        const InnerNode *new_inner_node_p = inner_node_p->GetSplitSibling();
+
+        AccountNewNode(new_inner_node_p);
+
+        // Since this is a split sibling, the low key must be a valid key
+        // NOTE: Only for InnerNodes could we call GetLowKey()
+        const KeyType &split_key = new_inner_node_p->GetLowKey();
+
+        // New node has at least one item (this is the basic requirement)
+        assert(new_inner_node_p->GetSize() > 0);
+
+        const KeyNodeIDPair &first_item = new_inner_node_p->At(0);
+        
+        // This points to the left most node on the right split sibling
+        // If this node is being removed then we abort
+        NodeID split_key_child_node_id = first_item.second;
+
+        // This must be the split key
+        assert(KeyCmpEqual(first_item.first, split_key));
+
+        // NOTE: WE FETCH THE POINTER WITHOUT HELP ALONG SINCE WE ARE
+        // NOW ON ITS PARENT
+        const BaseNode *split_key_child_node_p = \
+          GetNode(split_key_child_node_id);
+
+        // If the type is remove then we just continue without abort
+        // If we abort then it might introduce deadlock
+        if(split_key_child_node_p->IsRemoveNode()) {
+          bwt_printf("Found a removed node on split key child. CONTINUE \n");
+
+          // Put the new inner node into GC chain
+          // Although it is not entirely necessary it is good for us to
+          // make is so to avoid redundant code here
+          epoch_manager.AddGarbageNode(new_inner_node_p);
+
+          return;
+        }
+
+        NodeID new_node_id = GetNextNodeID();
+
+        const InnerSplitNode *split_node_p = \
+          InnerInlineAllocateOfType(InnerSplitNode,
+                                    node_p,
+                                    std::make_pair(split_key, new_node_id),
+                                    node_p,
+                                    new_inner_node_p);
+
+        //  First install the NodeID -> split sibling mapping
+        InstallNewNode(new_node_id, new_inner_node_p);
+
+        // Then CAS split delta into current node's NodeID
+        bool ret = InstallNodeToReplace(node_id, split_node_p, node_p);
+
+        if(ret == true) {
+          bwt_printf("Inner split delta (from %lu to %lu) CAS succeeds."
+                     " ABORT\n", node_id, new_node_id);
+
+          GetCurrentOperationCounter()->split_count++;
+
+          // Same reason as in leaf node
+          context_p->abort_flag = true;
+
+          return;
+        } else {
+          bwt_printf("Inner split delta CAS fails\n");
+
+          GetCurrentOperationCounter()->CASFailed(CASSite::Split);
 
-      // The deleted node ID must resolve to a RemoveNode of either
-      // Inner or Leaf category
-      const BaseNode *garbage_node_p = GetNode(delete_item.second);
-      assert(garbage_node_p->IsRemoveNode());
+          // Use the epoch manager to recycle NodeID in single threaded
+          // environment
+          // Note that this remove node should be created on existing node
+          // rather than on new_inner_node_p, since new_inner_node_p may
+          // be destroyed before fake_remove_node_p is destroyed
+          const InnerRemoveNode *fake_remove_node_p = \
+            new InnerRemoveNode{new_node_id, 
+                                new_inner_node_p};
 
-      // Put the remove node into garbage chain
-      // This will not remove the child node of the remove node, which
-      // should be removed together with the merge node above it
-      // Also, the remove node acts as a container for removed NodeID
-      // which will be recycled when the remove node is recycled
-      epoch_manager.AddGarbageNode(garbage_node_p);
+          GetCurrentMemoryCounter()->delta_size += sizeof(InnerRemoveNode);
 
-      // To avoid this entry being recycled during tree destruction
-      // Since the entry still remains in the old inner base node
-      // but we should have already deleted it
-      // NOTE: We could not do it here since some thread will fetch
-      // nullptr from the mapping table
-      // We should recycle the NodeID using EpochManager
-      // and requires that epoch manager finishes all epoches before
-      // the tree is destroyed
-      //mapping_table[deleted_node_id] = nullptr;
+          epoch_manager.AddGarbageNode(fake_remove_node_p);
+          epoch_manager.AddGarbageNode(new_inner_node_p);
 
-      parent_snapshot_p->node_p = delete_node_p;
+          // Call destructor since it is allocated from the base InnerNode
+          split_node_p->~InnerSplitNode();
 
-      ConsolidateNode(GetLatestNodeSnapshot(context_p));
+          return;
+        } // if CAS fails
+      } else if(node_size <= inner_merge_threshold) {
+        if(context_p->IsOnRootNode() == true) {
+          bwt_printf("Root underflow - let it be\n");
 
-      return true;
-    } else {
-      bwt_printf("Index term delete delta install failed. ABORT\n");
+          return;
+        }
 
-      // DO NOT FORGET TO DELETE THIS
-      delete_node_p->~InnerDeleteNode();
+        // NOTE: If the parent node has changed (e.g. split on the current
+        // node's low key) we will not be able to catch it. But we will
+        // find it later by posting an InnerAbortNode on parent which would
+        // result in CAS failing and aborting
 
-      // The caller just returns after this function, so do not have
-      // to branch on abort_flag after this function returns
-      context_p->abort_flag = true;
+        // We could not remove leftmost node
+        if(IsOnLeftMostChild(context_p) == true) {
+          bwt_printf("Left most inner node cannot be removed\n");
 
-      return false;
+          return;
+        }
+
+        // After this point we decide to remove
+
+        bwt_printf("Node size <= inner lower threshold. Remove\n");
+
+        const InnerRemoveNode *remove_node_p = \
+          new InnerRemoveNode{node_id, 
+                              node_p};
+
+        GetCurrentMemoryCounter()->delta_size += sizeof(InnerRemoveNode);
+
+        // Then we abort its parent node with an abort node that also
+        // describes the removal
+        const InnerAbortNode *abort_node_p;
+        NodeID parent_node_id;
+
+        bool abort_node_ret = \
+          PostAbortOnParent(context_p,
+                            node_id,
+                            node_p,
+                            remove_node_p,
+                            &parent_node_id,
+                            &abort_node_p);
+
+        // If we could not block the parent then the parent has changed
+        // (splitted, etc.)
+        if(abort_node_ret == true) {
+          bwt_printf("Blocked parent node (current node is inner)\n");
+        } else {
+          bwt_printf("Unable to block parent node "
+                     "(current node is inner). ABORT\n");
+
+          delete remove_node_p;
+          GetCurrentMemoryCounter()->delta_size -= sizeof(InnerRemoveNode);
+
+          // ABORT and return
+          context_p->abort_flag = true;
+
+          return;
+        }
+
+        // Same as leaf node; the removal might be finished by another
+        // thread
+        FinishRemoval(parent_node_id, abort_node_p);
+
+        // We must abort here since otherwise it might cause
+        // merge nodes to underflow if the remove delta is not installed
+        context_p->abort_flag = true;
+
+        return;
+      } // if split/remove
     }
 
-    assert(false);
-    return false;
+    return;
   }
 
   /*
-   * FinishPartialSMO() - Finish partial completed SMO if there is one
-   *
-   * This function defines the help-along protocol, i.e. if we find
-   * a SMO on top of the delta chain, we should help-along that SMO before
-   * doing our own job. This might incur a recursive call of this function.
-   *
-   * If this function returns true, then a node consolidation on the current
-   * top snapshot is recommended, because we have seen and processed (or
-   * confirmed that it has been processed) a merge/split delta on current
-   * top snapshot. To prevent other threads from seeing them and taking
-   * a full snapshot of the parent snapshot everytime they are seen, we
-   * return true to inform caller to do a consolidation
-   *
-   * If we see a remove node, then the actual NodeID pushed into the path
-   * list stack may not equal the NodeID passed in this function. So when
-   * we need to read NodeID, always use the one stored in the NodeSnapshot
-   * vector instead of using a previously passed one
+   * FinishRemoval() - Installs the remove delta described by an abort node
+   *                   and then removes the abort node from the parent
+   *
+   * Any thread that observes the abort node could call this function. Only
+   * the first thread claims the removal and returns true; other threads
+   * return false immediately. If the child has changed since the removal
+   * was decided then the remove delta could not be installed, and it is
+   * discarded, i.e. the removal is rolled back. The parent is unblocked
+   * in both cases
+   *
+   * Since the parent is blocked until the claiming thread removes the abort
+   * node, the remove delta is never installed after the parent has changed
    */
-  void FinishPartialSMO(Context *context_p) {
-    // Note: If the top of the path list changes then this pointer
-    // must also be updated
-    NodeSnapshot *snapshot_p = GetLatestNodeSnapshot(context_p);
+  bool FinishRemoval(NodeID parent_node_id,
+                     const InnerAbortNode *abort_node_p) {
+    // Check first to avoid invalidating the cache line of the abort node
+    if((abort_node_p->removal_claimed.load() == true) ||
+       (abort_node_p->removal_claimed.exchange(true) == true)) {
+      return false;
+    }
 
-before_switch:
-    switch(snapshot_p->node_p->GetType()) {
-      case NodeType::InnerAbortType: {
-        bwt_printf("Observed Inner Abort Node; ABORT\n");
+    const BaseNode *remove_node_p = abort_node_p->remove_node_p;
 
-        // This is an optimization - when seeing an ABORT
-        // node, we continue but set the physical pointer to be ABORT's
-        // child, to make CAS always fail on this node to avoid
-        // posting on ABORT, especially posting split node
-        snapshot_p->node_p = \
-          (static_cast<const DeltaNode *>(snapshot_p->node_p))->child_node_p;
+    bool ret = InstallNodeToReplace(abort_node_p->removed_id,
+                                    remove_node_p,
+                                    abort_node_p->removed_node_p);
+    if(ret == true) {
+      bwt_printf("Remove node CAS succeeds\n");
+    } else {
+      bwt_printf("Remove node CAS failed\n");
 
-        goto before_switch;
+      GetCurrentOperationCounter()->CASFailed(CASSite::Remove);
+
+      // The remove node has never been visible to other threads
+      if(remove_node_p->GetType() == NodeType::LeafRemoveType) {
+        delete static_cast<const LeafRemoveNode *>(remove_node_p);
+        GetCurrentMemoryCounter()->delta_size -= sizeof(LeafRemoveNode);
+      } else {
+        assert(remove_node_p->GetType() == NodeType::InnerRemoveType);
+
+        delete static_cast<const InnerRemoveNode *>(remove_node_p);
+        GetCurrentMemoryCounter()->delta_size -= sizeof(InnerRemoveNode);
       }
-      case NodeType::LeafRemoveType:
-      case NodeType::InnerRemoveType: {
-        bwt_printf("Helping along remove node...\n");
+    }
 
-        // The right branch for merging is the child node under remove node
-        const BaseNode *merge_right_branch = \
-          (static_cast<const DeltaNode *>(snapshot_p->node_p))->child_node_p;
+    // Even if we success we need to remove the abort on the parent, and
+    // let parent split thread to detect the remove delta on child
+    RemoveAbortOnParent(parent_node_id, abort_node_p);
 
-        // This will also be recorded in merge delta such that when
-        // we finish merge delta we could recycle the node id as well
-        // as the RemoveNode
-        NodeID deleted_node_id = snapshot_p->node_id;
+    return true;
+  }
 
-        JumpToLeftSibling(context_p);
+  /*
+   * RemoveAbortOnParent() - Removes the abort node on the parent
+   *
+   * This operation must succeeds since only the thread that claimed
+   * the removal could remove the abort node
+   */
+  void RemoveAbortOnParent(NodeID parent_node_id,
+                           const InnerAbortNode *abort_node_p) {
+    bwt_printf("Remove abort on parent node\n");
 
-        // If this aborts then we propagate this to the state machine driver
-        if(context_p->abort_flag == true) {
-          bwt_printf("Jump to left sibling in Remove help along ABORT\n");
+    // We switch back to the child node (so it is the target)
+    bool ret = InstallNodeToReplace(parent_node_id,
+                                    abort_node_p->child_node_p,
+                                    abort_node_p);
 
-          // Here we are uncertain about the current status (it might have
-          // jumped and observed an inconsistent next node ID, or it has not
-          // jumped because of an inconsistent left child status)
-          return;
-        }
+    // This CAS must succeed since nobody except this thread could remove
+    // the ABORT delta on parent node
+    assert(ret == true);
+    (void)ret;
 
-        // That is the left sibling's snapshot
-        NodeSnapshot *left_snapshot_p = GetLatestNodeSnapshot(context_p);
+    // NOTE: DO NOT FORGET TO REMOVE THE ABORT AFTER
+    // UNINSTALLING IT FROM THE PARENT NODE
+    // NOTE 2: WE COULD NOT DIRECTLY DELETE THIS NODE
+    // SINCE SOME OTHER NODES MIGHT HAVE TAKEN A SNAPSHOT
+    // AND IF ABORT NODE WAS REMOVED, THE TYPE INFORMATION
+    // CANNOT BE PRESERVED AND IT DOES NOT ABORT; INSTEAD
+    // IT WILL TRY TO CALL CONSOLIDATE ON ABORT
+    // NODE, CAUSING TYPE ERROR
+    //delete (InnerAbortNode *)abort_node_p;
 
-        // Update snapshot pointer if we fall through to posting
-        // index term delete delta for merge node
-        snapshot_p = left_snapshot_p;
+    // This delays the deletion of abort node until all threads has exited
+    // so that existing pointers to ABORT node remain valid
+    // GC does not follow the delta chain of ABORT node
+    epoch_manager.AddGarbageNode(abort_node_p);
 
-        // This serves as the merge key
-        // Note that the left sibling node must have a valid high key
-        const KeyType &merge_key = snapshot_p->node_p->GetHighKey();
+    return;
+  }
 
-        // This holds the merge node if installation is successful
-        // Not changed (i.e.undefined) if CAS fails
-        const BaseNode *merge_node_p = nullptr;
+  /*
+   * PostAbortOnParent() - Posts an inner abort node on the parent
+   *
+   * This function blocks all accesses to the parent node, and blocks
+   * all CAS efforts for threads that took snapshots before the CAS
+   * in this function.
+   *
+   * The abort node records the removal of node_p (mapped by node_id) with
+   * remove_node_p, which is later finished by FinishRemoval()
+   *
+   * Return false if CAS failed. In that case the memory of the abort node
+   * is freed by this function, and the caller should free remove_node_p
+   *
+   * This function DOES NOT ABORT. Do not have to check for abort flag. But
+   * if CAS fails then returns false, and caller needs to abort after
+   * checking the return value.
+   */
+  bool PostAbortOnParent(Context *context_p,
+                         NodeID node_id,
+                         const BaseNode *node_p,
+                         const BaseNode *remove_node_p,
+                         NodeID *parent_node_id_p,
+                         const InnerAbortNode **abort_node_p_p) {
+    // This will make sure the path list has length >= 2
+    NodeSnapshot *parent_snapshot_p = \
+      GetLatestParentNodeSnapshot(context_p);
 
-        bool ret;
+    const BaseNode *parent_node_p = parent_snapshot_p->node_p;
+    NodeID parent_node_id = parent_snapshot_p->node_id;
 
-        // If we are currently on leaf, just post leaf merge delta
-        if(left_snapshot_p->IsLeaf() == true) {
-          ret = \
-            PostLeafMergeNode(left_snapshot_p,
-                              &merge_key,
-                              merge_right_branch,
-                              deleted_node_id,
-                              &merge_node_p);
-        } else {
-          ret = \
-            PostInnerMergeNode(left_snapshot_p,
-                               &merge_key,
-                               merge_right_branch,
-                               deleted_node_id,
-                               &merge_node_p);
-        }
+    *parent_node_id_p = parent_node_id;
 
-        // If CAS fails just abort and return
-        if(ret == true) {
-          bwt_printf("Merge delta CAS succeeds. "
-                     "Continue to finish merge SMO\n");
+    InnerAbortNode *abort_node_p = \
+      new InnerAbortNode{parent_node_p, node_id, node_p, remove_node_p};
 
-          left_snapshot_p->node_p = merge_node_p;
+    GetCurrentMemoryCounter()->delta_size += sizeof(InnerAbortNode);
 
-          // merge_node_p is set as the newest merge node above
-          // after this point
-          // Also snapshot_p has been to left_snapshot_p above
-        } else {
-          bwt_printf("Merge delta CAS fails. ABORT\n");
+    bool ret = InstallNodeToReplace(parent_node_id,
+                                    abort_node_p,
+                                    parent_node_p);
+
+    if(ret == true) {
+      bwt_printf("Inner Abort node CAS succeeds\n");
+
+      // Copy the new node to caller since after posting remove delta we will
+      // remove this abort node to enable accessing again
+      *abort_node_p_p = abort_node_p;
+    } else {
+      bwt_printf("Inner Abort node CAS failed\n");
 
-          context_p->abort_flag = true;
+      GetCurrentOperationCounter()->CASFailed(CASSite::Abort);
 
-          return;
-        } // if ret == true
+      delete abort_node_p;
+      GetCurrentMemoryCounter()->delta_size -= sizeof(InnerAbortNode);
+    }
 
-        //
-        // FALL THROUGH IF POSTING MERGE DELTA SUCCEEDS
-        //
+    return ret;
+  }
 
-      } // case Inner/LeafRemoveType
-      case NodeType::InnerMergeType:
-      case NodeType::LeafMergeType: {
-        bwt_printf("Helping along merge delta\n");
+  /*
+   * NavigateInnerNode() - Given a parent snapshot and a key, return the item
+   *                       with the same key if that item exists
+   *
+   * This function checks whether a given key exists in the current
+   * inner node delta chain. If it exists then return a pointer to the
+   * item, otherwise return nullptr.
+   *
+   * This function is called when completing both split SMO and merge SMO
+   * For split SMO we need to check, key range and key existance, and
+   * NodeID value, to avoid mssing a few InnerDeleteNode on the parent node.
+   * However, for merge SMO, we only check key existence.
+   *
+   * Note: This function does not abort. Any extra checking (e.g. whether
+   * NodeIDs match, whether key is inside range) should be done by the caller
+   *
+   * Note 2: index_pair_p always reflects the relative position of the search
+   * key inside this InnerNode, no matter nullptr or non-null pointer is 
+   * returned, the integer inside the pair is always the index for all keys
+   * >= the search key. Currently the secong component is not set and not
+   * used
+   */
+  const KeyNodeIDPair *NavigateInnerNode(NodeSnapshot *snapshot_p,
+                                         const KeyType &search_key,
+                                         const KeyNodeIDPair **location) {
+    // Save some keystrokes
+    const BaseNode *node_p = snapshot_p->node_p;
+    
+     // This is used to recognize the leftmost branch if there is
+     // a merge node
+     const KeyNodeIDPair &low_key_pair = node_p->GetLowKeyPair();
+    
+    // The caller must make sure this is true
+    assert(node_p->GetNextNodeID() == INVALID_NODE_ID ||
+           KeyCmpLess(search_key, node_p->GetHighKey()));
 
-        // First consolidate parent node and find the left/right
-        // sep pair plus left node ID
-        NodeSnapshot *parent_snapshot_p = \
-          GetLatestParentNodeSnapshot(context_p);
+    while(1) {
+      switch(node_p->GetType()) {
+      case NodeType::InnerInsertType: {
+        const KeyNodeIDPair &insert_item = \
+          static_cast<const InnerInsertNode *>(node_p)->item;
 
-        // This is necessary - make sure the parent node snapshot
-        // is always update to date such that we do not miss a
-        // late InnerInsertNode that actually posts the deleted item
-        // o.w. the thread will just continue and post on top of
-        // an unfinished merge delta
-        if(parent_snapshot_p->node_p != GetNode(parent_snapshot_p->node_id)) {
-          context_p->abort_flag = true;
+        if(KeyCmpEqual(insert_item.first, search_key) == true) {
+          // Same key, same index
+          *location = static_cast<const InnerInsertNode *>(node_p)->location;
           
-          return;
+          return &insert_item;
         }
 
-        // This is the item being deleted inside parent node
-        const KeyNodeIDPair *delete_item_p = nullptr;
-        const BaseNode *right_merge_p = nullptr;
+        node_p = \
+          static_cast<const InnerInsertNode *>(node_p)->child_node_p;
 
-        // Type of the merge delta
-        // This is important since we might fall through
-        // from the LeafRemoveNode/InnerRemoveNode branch
-        NodeType type = snapshot_p->node_p->GetType();
-        
-        if(type == NodeType::InnerMergeType) {
-          const InnerMergeNode *merge_node_p = \
-            static_cast<const InnerMergeNode *>(snapshot_p->node_p);
+        break;
+      } // InnerInsertNode
+      case NodeType::InnerDeleteType: {
+        const KeyNodeIDPair &delete_item = \
+          static_cast<const InnerDeleteNode *>(node_p)->item;
 
-          delete_item_p = &merge_node_p->delete_item;
-          right_merge_p = merge_node_p->right_merge_p;
-        } else if(type == NodeType::LeafMergeType) {
-          const LeafMergeNode *merge_node_p = \
-            static_cast<const LeafMergeNode *>(snapshot_p->node_p);
+        if(KeyCmpEqual(delete_item.first, search_key) == true) {
+          *location = static_cast<const InnerDeleteNode *>(node_p)->location;
+          
+          return nullptr;
+        }
 
-          delete_item_p = &merge_node_p->delete_item;
-          right_merge_p = merge_node_p->right_merge_p;
-        } else {
-          bwt_printf("ERROR: Illegal node type: %d\n",
-                     static_cast<int>(type));
+        node_p = \
+          static_cast<const InnerDeleteNode *>(node_p)->child_node_p;
 
-          assert(false);
-        } // If on type of merge node
+        break;
+      } // InnerDeleteNode
+      case NodeType::InnerType: {
+        const InnerNode *inner_node_p = static_cast<const InnerNode *>(node_p);
 
-        const KeyNodeIDPair *location;
+        // DO NOT REMOVE THIS!!!!!!
+        // Unlike a NavigateInnerNode(Context *) which searches for child
+        // node ID, this function needs to cover all possible separators
+        // in the merged InnerNode (right branch)
+        const KeyNodeIDPair *start_it = inner_node_p->Begin();
 
-        // Find the deleted item
-        const KeyNodeIDPair *found_pair_p = \
-          NavigateInnerNode(parent_snapshot_p, 
-                            delete_item_p->first, 
-                            &location);
-          
-        // If the item is found then next we post InnerDeleteNode
-        if(found_pair_p != nullptr) {
-          assert(found_pair_p->second == delete_item_p->second);
-        } else {
-          return;
+        // If we are on the leftmost branch of the inner node delta chain
+        // if there is a merge delta, then we should start searching from
+        // the second element. Otherwise always start search from the first
+        // element
+        if(low_key_pair.second == inner_node_p->At(0).second) {
+          start_it++;
         }
 
-        // It will post an InnerDeleteNode on the parent node
-        // and the return value is the result of CAS
-        // Note: Even if this function aborts, since we return immediately
-        // so do not have to test abort_flag here
-        //
-        // There is a trick: The prev key is the low key of the node
-        // being merged into
-        // and the next key is the high key of the node being merged from
-        PostInnerDeleteNode(context_p,
-                            *delete_item_p,
-                            // Note that for leaf node the low key is not complete
-                            std::make_pair(snapshot_p->node_p->GetLowKey(), snapshot_p->node_id),
-                            // Also note that high key pair is valid for both leaf and inner
-                            right_merge_p->GetHighKeyPair(),
-                            // This is location on InnerNode
-                            location);
-
-        return;
-      } // case Inner/LeafMergeNode
-      case NodeType::InnerSplitType:
-      case NodeType::LeafSplitType: {
-        bwt_printf("Helping along split node\n");
+        const KeyNodeIDPair *it = \
+          std::lower_bound(start_it,
+                           inner_node_p->End(),
+                           search_key,
+                           key_node_id_pair_cmp_obj);
 
-        // These two will be stored inside InnerInsertNode
-        // The insert item is just the split item inside InnerSplitNode
-        // but next item needs to be read from the parent node
-        const KeyNodeIDPair *insert_item_p;
+        // Just give the location information by assigning to location
+        *location = it;
 
-        // This is set to use the high key pair of the node under
-        // split delta
-        const KeyNodeIDPair *next_item_p;
+        if(it == inner_node_p->End()) {
+          // This is special case since we could not compare the iterator
+          // If the key does not exist then return nullptr
+          return nullptr;
+        } else if(KeyCmpEqual(it->first, search_key) == false) {
+          // If found the lower bound but keys are different
+          // then also return nullptr
+          return nullptr;
+        } else {
+          // If found the lower bound and the key matches
+          // return the key
+          return it;
+        }
 
-        NodeType type = snapshot_p->node_p->GetType();
+        assert(false);
+        return nullptr;
+      } // InnerNode
+      case NodeType::InnerSplitType: {
+        // We must guarantee that the key must be inside the range
+        // of this function
+        // For split SMO this is true by extra checking
+        // For merge SMO this is implicitly true sunce the merge key
+        // should not be in another node, o.w. the high key has changed
+        node_p = \
+          static_cast<const InnerSplitNode *>(node_p)->child_node_p;
 
-        // NOTE: depth should not be read here, since we
-        // need to know the depth on its parent node
-        if(type == NodeType::InnerSplitType) {
-          const InnerSplitNode *split_node_p = \
-            static_cast<const InnerSplitNode *>(snapshot_p->node_p);
+        break;
+      } // InnerSplitType
+      case NodeType::InnerMergeType: {
+        const KeyNodeIDPair &delete_item = \
+          static_cast<const InnerMergeNode *>(node_p)->delete_item;
 
-          insert_item_p = &split_node_p->insert_item;
-          next_item_p = &split_node_p->child_node_p->GetHighKeyPair();
+        // If the split key >= merge key then just go to the right branch
+        if(KeyCmpGreaterEqual(search_key, delete_item.first) == true) {
+          node_p = static_cast<const InnerMergeNode *>(node_p)->right_merge_p;
         } else {
-          const LeafSplitNode *split_node_p = \
-            static_cast<const LeafSplitNode *>(snapshot_p->node_p);
-
-          insert_item_p = &split_node_p->insert_item;
-          next_item_p = &split_node_p->child_node_p->GetHighKeyPair();
+          node_p = static_cast<const InnerMergeNode *>(node_p)->child_node_p;
         }
 
-        assert(context_p->current_level >= 0);
+        break;
+      } // InnerMergeNode
+      default: {
+        bwt_printf("Unknown InnerNode type: %d", (int)node_p->GetType());
+
+        assert(false);
+        return nullptr;
+      } // default
+      } // switch
+    } // while(1)
+
+    assert(false);
+    return nullptr;
+  }
+  
+  /*
+   * FindLeftSibling() - Finds the left sibling of the current child node
+   *                     specified by a search key
+   *
+   * This function works in a way similar to how inner node delta chains
+   * are consolidated: We replay the log using sorted small set on all keys
+   * less than or equal to the search key, and then choose the second key
+   * in key order from high to low, after combing the content of InnerNode
+   * and the delta chain nodes
+   *
+   * NOTE: search_key is the low key of the current node for which we are
+   * find the left sibling, not the search key of the current operation.
+   * These two might differ in the case of cascading remove node delta
+   *
+   * NOTE 2: This function could not deal with InnerMergeNode since the merge
+   * node imposes a non-consecutive storage for adjacent keys. As an alternative
+   * way of finding left sibling, whenever an InnerMergeNode is observed,
+   * the node will be consolidated and we use the plain InnerNode to
+   * continue searching
+   */
+  inline NodeID FindLeftSibling(const KeyType &search_key,
+                                NodeSnapshot *snapshot_p) {
+
+    // This will be changed during the traversal
+    const BaseNode *node_p = snapshot_p->node_p;
+    
+    // First check that the node is always in the range of the inner node
+    assert(node_p->GetNextNodeID() == INVALID_NODE_ID || \
+           KeyCmpLess(search_key, node_p->GetHighKey()));
+    
+    // We can only search for left sibling on inner delta chain
+    assert(node_p->IsOnLeafDeltaChain() == false);
+    
+    const InnerDataNode *data_node_list[node_p->GetDepth()];
 
-        // If the parent snapshot has an invalid node ID then it must be the
-        // root node. 
-        if(context_p->IsOnRootNode() == true) {
-          /***********************************************************
-           * Root splits (don't have to consolidate parent node)
-           ***********************************************************/
-          bwt_printf("Root splits!\n");
+    // These two are used to compare InnerDataNode for < and == relation
 
-          // Allocate a new node ID for the newly created node
-          // If CAS fails we need to free the root ID
-          NodeID new_root_id = GetNextNodeID();
+    // NOTE: For this function we reverse the direction of comparison,
+    // i.e. the order is big-to-small to make iteration a little bit easier
+    auto f1 = [this](const InnerDataNode *idn_1, const InnerDataNode *idn_2) {
+                      return this->KeyCmpLess(idn_2->item.first, idn_1->item.first);
+                      //                          ^ <-------------> ^
+                    };
 
-          // InnerNode requires high key pair which is +Inf, INVALID NODE ID
-          // low key pair will be set inside the constructor to be pointing
-          // to the first element in the sep list
-          // NOTE: Storage will be automatically reserved inside the
-          // constructor
-          #ifdef BWTREE_PELOTON
+    auto f2 = [this](const InnerDataNode *idn_1, const InnerDataNode *idn_2) {
+                      return this->KeyCmpEqual(idn_1->item.first, idn_2->item.first);
+                    };
 
-          // This is the first item of the newly created InnerNode
-          // and also the low key for the newly created InnerNode
-          const KeyNodeIDPair first_item = std::make_pair(KeyType(),
-                                                          snapshot_p->node_id);
+    SortedSmallSet<const InnerDataNode *, decltype(f1), decltype(f2)> \
+      sss{data_node_list, f1, f2};
 
-          // Allocate an InnerNode with KeyNodeIDPair embedded
-          InnerNode *inner_node_p = \
-            reinterpret_cast<InnerNode *>( \
-              ElasticNode<KeyNodeIDPair>::\
-                Get(2, 
-                    NodeType::InnerType, 
-                    0,
-                    2,
-                    first_item,
-                    std::make_pair(KeyType(), INVALID_NODE_ID)));
+    while(1) {
+      NodeType type = node_p->GetType();
 
-          #else
+      switch(type) {
+        case NodeType::InnerType: {
+          const InnerNode *inner_node_p = \
+            static_cast<const InnerNode *>(node_p);
+            
+          ///////////////////////////////////////////////////////////
+          // First find the nearest sep key <= search key on InnerNode
+          ///////////////////////////////////////////////////////////
 
-          // This is the first item of the newly created InnerNode
-          // and also the low key for the InnerNode
-          const KeyNodeIDPair first_item = std::make_pair(KeyType{},
-                                                          snapshot_p->node_id);
+          // This is the logical end of the array
+          const KeyNodeIDPair *end_it = inner_node_p->End();
 
-          // Allocate an InnerNode with KeyNodeIDPair embedded
-          InnerNode *inner_node_p = \
-            reinterpret_cast<InnerNode *>( \
-              ElasticNode<KeyNodeIDPair>::\
-                Get(2, 
-                NodeType::InnerType, 
-                0,
-                2,
-                first_item,
-                std::make_pair(KeyType{}, INVALID_NODE_ID)));
-                               
-          #endif
+          // Since we know the search key must be one of the key inside
+          // the inner node, lower bound is sufficient
+          auto it1 = std::upper_bound(inner_node_p->Begin() + 1,
+                                      end_it,
+                                      search_key,
+                                      key_node_id_pair_cmp_obj) - 1;
 
-          // Add new element - one points to the current node (new second level
-          // left most inner node), another points to its split sibling
-          inner_node_p->PushBack(first_item);
-          inner_node_p->PushBack(*insert_item_p);
+          // Note that it is possible for it1 to be begin()
+          // since it is not the real current node if the node id
+          // is actually found on the delta chain
+          
+          ///////////////////////////////////////////////////////////
+          // After this point, it is guaranteed:
+          //   1. it1 points to an element <= removed node's low key
+          //   2. sss.GetBegin() points to an element <= removed node's low key
+          //      * OR *
+          //      sss.GetBegin() == sss.GetEnd()
+          ///////////////////////////////////////////////////////////
+          
+          // We need to pop out 2 items
+          const KeyNodeIDPair *left_item_p = nullptr;
+          
+          int counter = 0;
+          
+          // Loop twice. Hope compiler expands this loop
+          while(counter < 2) {
+            if(sss.GetBegin() == sss.GetEnd()) {
+              left_item_p = &(*it1);
+              
+              it1--;
+              counter++;
+              
+              continue;
+            } else if(it1 == inner_node_p->Begin()) {
+              // We know the sss is not empty, so could always pop from it
+              if(sss.GetFront()->GetType() == NodeType::InnerInsertType) {
+                left_item_p = &(sss.GetFront()->item);
 
-          // First we need to install the new node with NodeID
-          // This makes it visible
-          InstallNewNode(new_root_id, inner_node_p);
-          bool ret = InstallRootNode(snapshot_p->node_id,
-                                     new_root_id);
+                counter++;
+              }
+              
+              // This has to be done anyway
+              sss.PopFront();
+              
+              continue;
+            }
+            
+            // After this point it1-- is always valid since it is not begin()
+            
+            // If the two items are same
+            if(KeyCmpEqual(sss.GetFront()->item.first, it1->first)) {
+              // If a delete node and a sep item has the same key
+              if(sss.GetFront()->GetType() == NodeType::InnerDeleteType) {
+                it1--;
+              } else {
+                // Otherwise an insert node overrides existing key
+                left_item_p = &(sss.GetFront()->item);
+                
+                it1--;
+                
+                counter++;
+              }
+              
+              // This is common
+              sss.PopFront();
+            } else if(KeyCmpLess(sss.GetFront()->item.first, it1->first)) {
+              // If the inner node has larger sep item
+              // Otherwise an insert node overrides existing key
+              left_item_p = &(*it1);
 
-          if(ret == true) {
-            bwt_printf("Install root CAS succeeds\n");
+              it1--;
 
-            // After installing new root we abort in order to load
-            // the new root
-            context_p->abort_flag = true;
+              counter++;
+            } else {
+              if(sss.GetFront()->GetType() == NodeType::InnerInsertType) {
+                // If the delta node has larger item then set left item p
+                // to delta item
+                left_item_p = &(sss.GetFront()->item);
 
-            return;
-          } else {
-            bwt_printf("Install root CAS failed. ABORT\n");
+                counter++;
+              } 
+              
+              // This is common
+              sss.PopFront();
+            }
+          } // while counter < 2
+          
+          // This is the NodeID of the left sibling
+          return left_item_p->second;
+        } 
+        case NodeType::InnerInsertType: {
+          const InnerInsertNode *insert_node_p = \
+            static_cast<const InnerInsertNode *>(node_p);
 
-            // We need to make a new remove node and send it into EpochManager
-            // for recycling the NodeID
-            // Note that the remove node must not be created on inner_node_p
-            // since inner_node_p might be destroyed before remove node is 
-            // destroyed since they are both put into the GC chain
-            const InnerRemoveNode *fake_remove_node_p = \
-              new InnerRemoveNode{new_root_id, 
-                                  inner_node_p};
+          const KeyNodeIDPair &insert_item = insert_node_p->item;
 
-            // Put the remove node into garbage chain, because
-            // we cannot call InvalidateNodeID() here
-            epoch_manager.AddGarbageNode(fake_remove_node_p);
-            epoch_manager.AddGarbageNode(inner_node_p);
+          if(KeyCmpLessEqual(insert_item.first, search_key)) {
+            sss.Insert(insert_node_p);
+          }
 
-            context_p->abort_flag = true;
+          node_p = insert_node_p->child_node_p;
 
-            return;
-          } // if CAS succeeds/fails
-        } else {
-          /***********************************************************
-           * Index term insert for non-root nodes
-           ***********************************************************/
+          break;
+        } // InnerInsertType
+        case NodeType::InnerDeleteType: {
+          const InnerDeleteNode *delete_node_p = \
+            static_cast<const InnerDeleteNode *>(node_p);
+            
+          const KeyNodeIDPair &delete_item = delete_node_p->item;
 
-          // First consolidate parent node and find the right sep
-          NodeSnapshot *parent_snapshot_p = \
-            GetLatestParentNodeSnapshot(context_p);
+          if(KeyCmpLessEqual(delete_item.first, search_key)) {
+            sss.Insert(delete_node_p);
+          }
+          
+          node_p = delete_node_p->child_node_p;
 
-          // If the split key is out of range then just ignore
-          // we do not worry that through split sibling link
-          // we would traverse to the child of a different parent node
-          // than the current one, since we always guarantee that after
-          // NavigateInnerNode() returns if it does not abort, then we
-          // are on the correct node for the current key
+          break;
+        } // InnerDeleteType
+        case NodeType::InnerSplitType: {
+          const InnerSplitNode *split_node_p = \
+            static_cast<const InnerSplitNode *>(node_p);
 
-          // This happens when the parent splits on the newly inserted index term
-          // and the split delta has not been consolidated yet, so that a thread
-          // sees the split delta and traverses to its right sibling which is on
-          // another parent node (the right sibling of the current parent node)
-          // In this case we do not have to insert since we know the index term has
-          // already been inserted
-          if((parent_snapshot_p->node_p->GetNextNodeID() != INVALID_NODE_ID) &&
-             (KeyCmpGreaterEqual(insert_item_p->first,
-                                 parent_snapshot_p->node_p->GetHighKey()))) {
-            bwt_printf("Bounds check failed on parent node"
-                       " - item key >= high key\n");
+          node_p = split_node_p->child_node_p;
+
+          break;
+        } // case InnerSplitType
+        case NodeType::InnerMergeType: {
+          bwt_printf("Found merge node. "
+                     "Need consolidation to find left sibling\n");
 
-            return;
-          }
-          
-          // This is used to hold index information for InnerInsertNode
-          const KeyNodeIDPair *location;
+          // Since we could not deal with merge delta, if there is
+          // a merge delta on the path, the only solution is to
+          // consolidate the inner node, and try to install it
+          //
+          // Even if installation fails, we need to prevserve the content
+          // of the consolidated node, so need to add it to the GC instead
+          // of directly releasing its memory
 
-          // Find the split item that we intend to insert in the parent node
-          // This function returns a pointer to the item if found, or
-          // nullptr if not found
-          const KeyNodeIDPair *found_item_p = \
-            NavigateInnerNode(parent_snapshot_p, 
-                              insert_item_p->first, 
-                              &location);
+          InnerNode *inner_node_p = \
+            CollectAllSepsOnInner(snapshot_p,
+                                  // Must +1 to avoid looping on the same depth
+                                  // without any consolidation
+                                  snapshot_p->node_p->GetDepth() + 1);
 
-          // If the item has been found then we do not post
-          // InnerInsertNode onto the parent
-          if(found_item_p != nullptr) {
+          bool ret = InstallNodeToReplace(snapshot_p->node_id,
+                                          inner_node_p,
+                                          snapshot_p->node_p);
+                                          
+          if(ret == true) {
+            epoch_manager.AddGarbageNode(snapshot_p->node_p);
             
-            // Check whether there is an item in the parent
-            // node that has the same key but different NodeID
-            // This is totally legal
-            if(found_item_p->second != insert_item_p->second) {
-              
-              #ifdef BWTREE_DEBUG
-              
-              // If this happens then it must be the case that the node with
-              // the same split key but different node ID was removed and then
-              // merged into the current node and then it is splited again
-              //
-              // We are now on the way of completing the second split SMO
-              // but since the parent has changed (we must have missed an
-              // InnerInsertNode) we need to abort and restart traversing
-              const BaseNode *node_p = GetNode(found_item_p->second);
-              
-              assert(node_p->GetType() == NodeType::InnerRemoveType ||
-                     node_p->GetType() == NodeType::LeafRemoveType);
-              
-              #endif
-              
-              context_p->abort_flag = true;
-            }
+            snapshot_p->node_p = inner_node_p;
             
-            return;
+            GetCurrentOperationCounter()->consolidate_count++;
+          } else {
+            GetCurrentOperationCounter()->CASFailed(CASSite::Consolidate);
+            
+            // This is necessary to preserve the content of the inner node
+            // while avoid memory leaks
+            epoch_manager.AddGarbageNode(inner_node_p);
           }
+          
+          // Next iteration will go directly into inner node we have
+          // just consolidated
+          node_p = inner_node_p;
+            
+          // This is important - since we just changed the entire node,
+          // the sss should be empty
+          sss.Invalidate();
+          
+          break;
+        } // InnerMergeType
+        default: {
+          bwt_printf("ERROR: Unknown node type = %d",
+                     static_cast<int>(type));
 
-          // Post InnerInsertNode on the parent node.
-          // Also if this returns true then we have successfully completed split SMO
-          // which means the SMO could be removed by a consolidation to avoid
-          // consolidating the parent node again and again
-          // Note: Even if this function aborts, since we return immediately
-          // so do not have to test abort_flag here
-          PostInnerInsertNode(context_p, 
-                              *insert_item_p, 
-                              *next_item_p, 
-                              location);
-
-          return;
-        } // if split root / else not split root
-      } // case split node
-      default: {
-        return;
-        // By default we do not do anything special
-        break;
-      }
-    } // switch
+          assert(false);
+        }
+      } // switch type
+    } // while 1
 
+    // Should not reach here
     assert(false);
-    return;
+    return INVALID_NODE_ID;
   }
-  
-  /*
-   * ConsolidateLeafNode() - Consolidates a leaf delta chian unconditionally
-   *
-   * This function does not check delta chain size
-   */
-  inline void ConsolidateLeafNode(NodeSnapshot *snapshot_p) {
-    assert(snapshot_p->node_p->IsOnLeafDeltaChain() == true);
-    
-    LeafNode *leaf_node_p = CollectAllValuesOnLeaf(snapshot_p);
-
-    bool ret = InstallNodeToReplace(snapshot_p->node_id,
-                                    leaf_node_p,
-                                    snapshot_p->node_p);
-
-    if(ret == true) {
-      epoch_manager.AddGarbageNode(snapshot_p->node_p);
 
-      snapshot_p->node_p = leaf_node_p;
-    } else {
-      epoch_manager.AddGarbageNode(leaf_node_p);
-    }
-    
-    return;
-  }
-  
   /*
-   * ConsolidateInnerNode() - Consolidates inner node unconditionally
-   *
-   * This function does not check for inner delta chain length
+   * PostInnerMergeNode() - Post an inner merge node
    */
-  inline void ConsolidateInnerNode(NodeSnapshot *snapshot_p) {
-    assert(snapshot_p->node_p->IsOnLeafDeltaChain() == false);
-    
-    InnerNode *inner_node_p = CollectAllSepsOnInner(snapshot_p);
+  bool PostInnerMergeNode(const NodeSnapshot *snapshot_p,
+                          const KeyType *merge_key_p,
+                          const BaseNode *merge_branch_p,
+                          NodeID deleted_node_id,
+                          const BaseNode **node_p_p) {
+    // This is the child node of merge delta
+    const BaseNode *node_p = snapshot_p->node_p;
+    NodeID node_id = snapshot_p->node_id;
 
-    bool ret = InstallNodeToReplace(snapshot_p->node_id,
-                                    inner_node_p,
-                                    snapshot_p->node_p);
+    // Note that we allocate from merge_banch_p since node_p is deallocated
+    // first and then merge_branch_p, so if we allocate the merge node
+    // on node_p's base node it will be invalid for the second recursive call
+    const InnerMergeNode *merge_node_p = \
+      InnerInlineAllocateOfType(InnerMergeNode, 
+                                merge_branch_p,
+                                *merge_key_p,
+                                merge_branch_p,
+                                deleted_node_id,
+                                node_p);
 
-    if(ret == true) {
-      epoch_manager.AddGarbageNode(snapshot_p->node_p);
+    // Compare and Swap!
+    bool ret = InstallNodeToReplace(node_id, merge_node_p, node_p);
 
-      snapshot_p->node_p = inner_node_p;
+    // If CAS fails we delete the node and return false
+    if(ret == false) {
+      GetCurrentOperationCounter()->CASFailed(CASSite::Merge);
+      
+      merge_node_p->~InnerMergeNode();
     } else {
-      epoch_manager.AddGarbageNode(inner_node_p);
+      GetCurrentOperationCounter()->merge_count++;
+      
+      *node_p_p = merge_node_p;
     }
-    
-    return;
-  }
-
-  /*
-   * ConsolidateNode() - Consolidates current node unconditionally
-   *
-   * This function is called after finishing split/merge SMO, since we
-   * want to prevent other threads from seeing the finished SMO and
-   * do an useless consolidation on the parent node
-   *
-   * NOTE: This function does not return any value reflecting the status
-   * of CAS operation, since consolidation is an optional operation, and it
-   * would not have any effect even if it fails
-   */
-  void ConsolidateNode(NodeSnapshot *snapshot_p) {
-    if(snapshot_p->node_p->IsOnLeafDeltaChain() == true) {
-      ConsolidateLeafNode(snapshot_p);
-    } else {
-      ConsolidateInnerNode(snapshot_p);
-    } // if on leaf/inner node
 
-    return;
+    return ret;
   }
+  
 
   /*
-   * TryConsolidateNode() - Consolidate current node if its length exceeds the
-   *                        threshold value
-   *
-   * If the length of delta chain does not exceed the threshold then this
-   * function does nothing
-   *
-   * If function returns true then we have successfully consolidated a node
-   * Otherwise no consolidation happens. The return value might be used
-   * as a hint for deciding whether to adjust node size or not
-   *
-   * NOTE: If consolidation fails then this function does not do anything
-   * and will just continue with its own job. There is no chance of abort
-   *
-   * TODO: If strict mode is on, then whenever consolidation fails we should
-   * always abort and start from the beginning, to keep delta chain length
-   * upper bound intact
+   * PostLeafMergeNode() - Post an inner merge node
    */
-  void TryConsolidateNode(Context *context_p) {
-    NodeSnapshot *snapshot_p = GetLatestNodeSnapshot(context_p);
-
-    // Do not overwrite this pointer since we will use this
-    // to locate garbage delta chain
+  bool PostLeafMergeNode(const NodeSnapshot *snapshot_p,
+                         const KeyType *merge_key_p,
+                         const BaseNode *merge_branch_p,
+                         NodeID deleted_node_id,
+                         const BaseNode **node_p_p) {
+    // This is the child node of merge delta
     const BaseNode *node_p = snapshot_p->node_p;
+    NodeID node_id = snapshot_p->node_id;
 
-    // We could only perform consolidation on delta node
-    // because we want to see depth field
-    if(node_p->IsDeltaNode() == false) {
-      // The depth of base node may not be 0
-      // since if we consolidate parent node to finish the partial SMO,
-      // then parent node will have non-0 depth in order to avoid being too
-      // large (see FindSplitNextKey() and FindMergePrevNextKey() and
-      // JumpToLeftSibling())
-      // assert(node_p->metadata.depth == 0);
-
-      return;
-    }
-
-    // If depth does not exceed threshold then we check recommendation flag
-    int depth = node_p->GetDepth();
-
-    if(snapshot_p->IsLeaf() == true) {
-      if(depth < LEAF_DELTA_CHAIN_LENGTH_THRESHOLD) {
-        return;
-      }
-    } else {
-      if(depth < INNER_DELTA_CHAIN_LENGTH_THRESHOLD) {
-        return;
-      }
-    }
+    // Must allocate on merge_branch_p, otherwise when recycle this
+    // delta chain, node_p is reclaimed first and then merge_branch_p,
+    // so if we allocate it on node_p, we will get an invalid reference
+    // for the second recursive call
+    const LeafMergeNode *merge_node_p = \
+      InnerInlineAllocateOfType(LeafMergeNode, 
+                                merge_branch_p,
+                                *merge_key_p,
+                                merge_branch_p,
+                                deleted_node_id,
+                                node_p);
 
-    // After this point we decide to consolidate node
+    // Compare and Swap!
+    bool ret = InstallNodeToReplace(node_id, merge_node_p, node_p);
 
-    ConsolidateNode(snapshot_p);
+    // If CAS fails we delete the node and return false
+    if(ret == false) {
+      GetCurrentOperationCounter()->CASFailed(CASSite::Merge);
+      
+      merge_node_p->~LeafMergeNode();
+    } else {
+      GetCurrentOperationCounter()->merge_count++;
+      
+      *node_p_p = merge_node_p;
+    }
 
-    return;
+    return ret;
   }
 
   /*
-   * AdjustNodeSize() - Post split or merge delta if a node becomes overflow
-   *                    or underflow
-   *
-   * For leftmost children nodes and for root node (which has is_leftmost
-   * flag set) we never post remove delta, the merge of which would change
-   * its parent node's low key
-   *
-   * NOTE: This function will abort after installing a node remove delta,
-   * in order not to have to call LoadNodeID recursively
+   * Insert() - Insert a key-value pair
    *
-   * TODO: In the future we might want to change this
+   * This function returns false if value already exists
+   * If CAS fails this function retries until it succeeds
    */
-  void AdjustNodeSize(Context *context_p) {
-    NodeSnapshot *snapshot_p = GetLatestNodeSnapshot(context_p);
-    const BaseNode *node_p = snapshot_p->node_p;
+  bool Insert(const KeyType &key, const ValueType &value) {
+    return InsertFromLeaf(key, value, INVALID_NODE_ID);
+  }
 
-    // We do not adjust size for delta nodes
-    if(node_p->IsDeltaNode() == true) {
-      // TODO: If we want to strictly enforce the size of any node
-      // then we should aggressively consolidate here and always
-      // Though it brings huge overhead because now we are consolidating
-      // every node on the path
+  /*
+   * InsertFromLeaf() - Insert a key-value pair starting on a leaf
+   *
+   * leaf_node_id is the leaf which the key was in recently, and the
+   * traversal restarts from the root if it no longer is (see
+   * TraverseFromLeaf()). INVALID_NODE_ID starts from the root
+   */
+  bool InsertFromLeaf(const KeyType &key,
+                      const ValueType &value,
+                      NodeID leaf_node_id) {
+    bwt_printf("Insert called\n");
 
-      return;
-    }
+    GetCurrentOperationCounter()->insert_count++;
 
-    NodeID node_id = snapshot_p->node_id;
+    ThawIfFrozen();
+    TryMergeDeferredNodes();
 
-    if(snapshot_p->IsLeaf() == true) {
-      const LeafNode *leaf_node_p = \
-        static_cast<const LeafNode *>(node_p);
+    #ifdef BWTREE_DEBUG
+    insert_op_count.fetch_add(1);
+    #endif
 
-      // NOTE: We use key number as the size of the node
-      // because using item count might result in a very unstable
-      // split, in a sense that we could not always split the node
-      // evenly, and in the worst case if there is one key in the
-      // node the node could not be splited while having a large
-      // item count
-      size_t node_size = leaf_node_p->GetItemCount();
+    EpochNode *epoch_node_p = epoch_manager.JoinEpoch();
+    bwt_printf("JoinEpoch called\n");
 
-      // Perform corresponding action based on node size
-      if(node_size >= LEAF_NODE_SIZE_UPPER_THRESHOLD) {
-        bwt_printf("Node size >= leaf upper threshold. Split\n");
+    Backoff backoff{backoff_max_spin_count};
 
-        // Note: This function takes this as argument since it will
-        // do key comparison
-        const LeafNode *new_leaf_node_p = leaf_node_p->GetSplitSibling(this);
+    // The leaf to start from; after a CAS failure the leaf it failed on
+    NodeID retry_node_id = leaf_node_id;
 
-        // If the new leaf node pointer is nullptr then it means the
-        // although the size of the leaf node exceeds split threshold
-        // but we could not find a spliting point that evenly or almost
-        // evenly divides the key space into two siblings whose sizes
-        // are both larger than the merge threshold (o.w. the node will
-        // be immediately merged)
-        // NOTE: This is a potential problem if a leaf becomes very unbalanced
-        // since all threads will try to split the leaf node when traversing
-        // to it (not for reader threads)
-        if(new_leaf_node_p == nullptr) {
-          bwt_printf("LeafNode size exceeds overhead, "
-                     "but could not find split point\n");
+    while(1) {
+      Context context{key};
+      context.is_insert = true;
+      std::pair<int, bool> index_pair;
 
-          return;
-        }
+      // Check whether the key-value pair exists
+      // Also if the key previously exists in the delta chain
+      // then return the position of the node using next_key_p
+      // if there is none then return nullptr
+      const KeyValuePair *item_p = nullptr;
+      if(retry_node_id == INVALID_NODE_ID) {
+        item_p = Traverse(&context, &value, &index_pair);
+      } else {
+        item_p = TraverseFromLeaf(&context, retry_node_id, &value, &index_pair);
+      }
 
-        // Since we would like to access its first element to get the low key
-        assert(new_leaf_node_p->GetSize() > 0);
+      // If the key-value pair already exists then return false
+      if (item_p != nullptr) {
+        epoch_manager.LeaveEpoch(epoch_node_p);
 
-        // The split key must be a valid key
-        // Note that the lowkey for leaf node is not defined, so in the
-        // case that it is required we must manually goto its data list
-        // and find the low key in its leftmost element
-        const KeyType &split_key = new_leaf_node_p->At(0).first;
+        return false;
+      }
 
-        // If leaf split fails this should be recyced using a fake remove node
-        NodeID new_node_id = GetNextNodeID();
+      NodeSnapshot *snapshot_p = GetLatestNodeSnapshot(&context);
 
-        // Note that although split node only stores the new node ID
-        // we still need its pointer to compute item_count
-        const LeafSplitNode *split_node_p = \
-          LeafInlineAllocateOfType(LeafSplitNode, 
-                                   node_p, 
-                                   std::make_pair(split_key, new_node_id),
-                                   node_p,
-                                   new_leaf_node_p);
+      // We will CAS on top of this
+      const BaseNode *node_p = snapshot_p->node_p;
+      NodeID node_id = snapshot_p->node_id;
 
-        //  First install the NodeID -> split sibling mapping
-        // If CAS fails we also need to recycle the node ID allocated here
-        InstallNewNode(new_node_id, new_leaf_node_p);
+      const LeafInsertNode *insert_node_p = \
+        LeafInlineAllocateOfType(LeafInsertNode, 
+                                 node_p, 
+                                 key, 
+                                 value, 
+                                 node_p, 
+                                 index_pair);
 
-        // Then CAS split delta into current node's NodeID
-        bool ret = InstallNodeToReplace(node_id, split_node_p, node_p);
+      bool ret = InstallNodeToReplace(node_id,
+                                      insert_node_p,
+                                      node_p);
+      if(ret == true) {
+        bwt_printf("Leaf Insert delta CAS succeed\n");
 
-        if(ret == true) {
-          bwt_printf("Leaf split delta (from %lu to %lu) CAS succeeds. ABORT\n",
-                     node_id,
-                     new_node_id);
+        // If install is a success then just break from the loop
+        // and return
+        break;
+      } else {
+        bwt_printf("Leaf insert delta CAS failed\n");
 
-          // TODO: WE ABORT HERE TO AVOID THIS THREAD POSTING ANYTHING
-          // ON TOP OF IT WITHOUT HELPING ALONG AND ALSO BLOCKING OTHER
-          // THREAD TO HELP ALONG
-          context_p->abort_flag = true;
+        GetCurrentOperationCounter()->CASFailed(CASSite::LeafData);
+        RecordLeafContention(node_id);
 
-          return;
-        } else {
-          bwt_printf("Leaf split delta CAS fails\n");
+        #ifdef BWTREE_DEBUG
 
-          // Need to use the epoch manager to recycle NodeID
-          // Note that this node must not be created on new_leaf_node_p
-          // since they are both put into the GC chain, it is possible
-          // for new_leaf_node_p to be deleted first and then remove node
-          // is deleted
-          const LeafRemoveNode *fake_remove_node_p = \
-            new LeafRemoveNode{new_node_id, 
-                               new_leaf_node_p};
+        context.abort_counter++;
+        
+        #endif
 
-          // Must put both of them into GC chain since RemoveNode
-          // will not be followed by GC thread
-          epoch_manager.AddGarbageNode(fake_remove_node_p);
-          epoch_manager.AddGarbageNode(new_leaf_node_p);
+        insert_node_p->~LeafInsertNode();
 
-          // We have two nodes to delete here
-          split_node_p->~LeafSplitNode();
+        backoff.Wait(GetCurrentOperationCounter());
 
-          return;
-        }
+        retry_node_id = node_id;
+      }
 
-      } else if(node_size <= LEAF_NODE_SIZE_LOWER_THRESHOLD) {
-        // This might yield a false positive of left child
-        // but correctness is not affected - sometimes the merge is delayed
-        if(IsOnLeftMostChild(context_p) == true) {
-          bwt_printf("Left most leaf node cannot be removed\n");
+      #ifdef BWTREE_DEBUG
+      
+      // Update abort counter
+      // NOTE 1: We could not do this before return since the context
+      // object is cleared at the end of loop
+      // NOTE 2: Since Traverse() might abort due to other CAS failures
+      // context.abort_counter might be larger than 1 when
+      // LeafInsertNode installation fails
+      insert_abort_count.fetch_add(context.abort_counter);
+      
+      #endif
 
-          return;
-        }
+      // We reach here only because CAS failed
+      bwt_printf("Retry installing leaf insert delta\n");
+    }
 
-        // After this point we decide to remove leaf node
+    epoch_manager.LeaveEpoch(epoch_node_p);
 
-        bwt_printf("Node size <= leaf lower threshold. Remove\n");
+    return true;
+  }
 
-        // Install an abort node on parent
-        const BaseNode *abort_node_p;
-        const BaseNode *abort_child_node_p;
-        NodeID parent_node_id;
+#ifdef BWTREE_PELOTON
 
-        bool abort_node_ret = \
-          PostAbortOnParent(context_p,
-                            &parent_node_id,
-                            &abort_node_p,
-                            &abort_child_node_p);
+  /*
+   * ConditionalInsert() - Insert a key-value pair only if a given
+   *                       predicate fails for all values with a key
+   *
+   * If return true then the value has been inserted
+   * If return false then the value is not inserted. The reason could be
+   * predicates returning true for one of the values of a given key
+   * or because the value is already in the index
+   *
+   * NOTE: We first test the predicate, and then test for duplicated values
+   * so predicate test result is always available
+   */
+  bool ConditionalInsert(const KeyType &key,
+                         const ValueType &value,
+                         std::function<bool(const ValueType &)> predicate,
+                         bool *predicate_satisfied) {
+    bwt_printf("Insert (cond.) called\n");
 
-        // If we could not block the parent then the parent has changed
-        // (splitted, etc.)
-        if(abort_node_ret == true) {
-          bwt_printf("Blocked parent node (current node is leaf)\n");
-        } else {
-          bwt_printf("Unable to block parent node "
-                     "(current node is leaf). ABORT\n");
+    GetCurrentOperationCounter()->insert_count++;
 
-          // ABORT and return
-          context_p->abort_flag = true;
+    ThawIfFrozen();
+    TryMergeDeferredNodes();
 
-          return;
-        }
+    #ifdef BWTREE_DEBUG
+    insert_op_count.fetch_add(1);
+    #endif
 
-        const LeafRemoveNode *remove_node_p = \
-          new LeafRemoveNode{node_id, 
-                             node_p};
+    EpochNode *epoch_node_p = epoch_manager.JoinEpoch();
 
-        bool ret = InstallNodeToReplace(node_id, remove_node_p, node_p);
-        if(ret == true) {
-          bwt_printf("LeafRemoveNode CAS succeeds. ABORT.\n");
+    Backoff backoff{backoff_max_spin_count};
 
-          context_p->abort_flag = true;
+    // The leaf on which the last CAS failed
+    NodeID retry_node_id = INVALID_NODE_ID;
 
-          RemoveAbortOnParent(parent_node_id,
-                              abort_node_p,
-                              abort_child_node_p);
+    while(1) {
+      Context context{key};
+      context.is_insert = true;
 
-          return;
-        } else {
-          bwt_printf("LeafRemoveNode CAS failed\n");
+      // This will just stop on the correct leaf page
+      // without traversing into it. Next we manually traverse
+      if(retry_node_id == INVALID_NODE_ID) {
+        Traverse(&context, nullptr, nullptr);
+      } else {
+        TraverseFromLeaf(&context, retry_node_id, nullptr, nullptr);
+      }
 
-          delete remove_node_p;
+      *predicate_satisfied = false;
+      
+      // This is used to hold the index for which this delta will
+      // be applied to
+      std::pair<int, bool> index_pair;
 
-          context_p->abort_flag = true;
+      // Call navigate leaf node to test predicate and to test duplicates
+      const KeyValuePair *item_p = \
+        NavigateLeafNode(&context,
+                         value,
+                         &index_pair,
+                         predicate,
+                         predicate_satisfied);
+      
+      // We do not insert anything if predicate is satisfied
+      if(*predicate_satisfied == true) {
+        epoch_manager.LeaveEpoch(epoch_node_p);
+        
+        return false;
+      } else if(item_p != nullptr) {
+        epoch_manager.LeaveEpoch(epoch_node_p);
+        
+        return false;
+      }
 
-          RemoveAbortOnParent(parent_node_id,
-                              abort_node_p,
-                              abort_child_node_p);
+      // This retrieves the most up-to-date snapshot (which does not change)
+      NodeSnapshot *snapshot_p = GetLatestNodeSnapshot(&context);
 
-          return;
-        }
-      }
-    } else {   // If this is an inner node
-      const InnerNode *inner_node_p = static_cast<const InnerNode *>(node_p);
+      // We will CAS on top of this
+      const BaseNode *node_p = snapshot_p->node_p;
+      NodeID node_id = snapshot_p->node_id;
 
-      size_t node_size = inner_node_p->GetSize();
+      // Here since we could not know which is the next key node
+      // just use child node as a cpnservative way of inserting
+      const LeafInsertNode *insert_node_p = \
+        LeafInlineAllocateOfType(LeafInsertNode, 
+                                 node_p, 
+                                 key, 
+                                 value, 
+                                 node_p, 
+                                 index_pair);
 
-      if(node_size >= INNER_NODE_SIZE_UPPER_THRESHOLD) {
-        bwt_printf("Node size >= inner upper threshold. Split\n");
+      bool ret = InstallNodeToReplace(node_id,
+                                      insert_node_p,
+                                      node_p);
+      if(ret == true) {
+        bwt_printf("Leaf Insert (cond.) delta CAS succeed\n");
 
-        const InnerNode *new_inner_node_p = inner_node_p->GetSplitSibling();
+        // If install is a success then just break from the loop
+        // and return
+        break;
+      } else {
+        bwt_printf("Leaf insert (cond.) delta CAS failed\n");
 
-        // Since this is a split sibling, the low key must be a valid key
-        // NOTE: Only for InnerNodes could we call GetLowKey()
-        const KeyType &split_key = new_inner_node_p->GetLowKey();
+        GetCurrentOperationCounter()->CASFailed(CASSite::LeafData);
+        RecordLeafContention(node_id);
 
-        // New node has at least one item (this is the basic requirement)
-        assert(new_inner_node_p->GetSize() > 0);
+        #ifdef BWTREE_DEBUG
 
-        const KeyNodeIDPair &first_item = new_inner_node_p->At(0);
+        context.abort_counter++;
         
-        // This points to the left most node on the right split sibling
-        // If this node is being removed then we abort
-        NodeID split_key_child_node_id = first_item.second;
+        #endif
 
-        // This must be the split key
-        assert(KeyCmpEqual(first_item.first, split_key));
+        insert_node_p->~LeafInsertNode();
 
-        // NOTE: WE FETCH THE POINTER WITHOUT HELP ALONG SINCE WE ARE
-        // NOW ON ITS PARENT
-        const BaseNode *split_key_child_node_p = \
-          GetNode(split_key_child_node_id);
+        backoff.Wait(GetCurrentOperationCounter());
 
-        // If the type is remove then we just continue without abort
-        // If we abort then it might introduce deadlock
-        if(split_key_child_node_p->IsRemoveNode()) {
-          bwt_printf("Found a removed node on split key child. CONTINUE \n");
+        retry_node_id = node_id;
+      }
 
-          // Put the new inner node into GC chain
-          // Although it is not entirely necessary it is good for us to
-          // make is so to avoid redundant code here
-          epoch_manager.AddGarbageNode(new_inner_node_p);
+      #ifdef BWTREE_DEBUG
 
-          return;
-        }
+      insert_abort_count.fetch_add(context.abort_counter);
+      
+      #endif
 
-        NodeID new_node_id = GetNextNodeID();
+      bwt_printf("Retry installing leaf insert (cond.) delta\n");
+    }
 
-        const InnerSplitNode *split_node_p = \
-          InnerInlineAllocateOfType(InnerSplitNode,
-                                    node_p,
-                                    std::make_pair(split_key, new_node_id),
-                                    node_p,
-                                    new_inner_node_p);
+    epoch_manager.LeaveEpoch(epoch_node_p);
 
-        //  First install the NodeID -> split sibling mapping
-        InstallNewNode(new_node_id, new_inner_node_p);
+    return true;
+  }
 
-        // Then CAS split delta into current node's NodeID
-        bool ret = InstallNodeToReplace(node_id, split_node_p, node_p);
+#endif
 
-        if(ret == true) {
-          bwt_printf("Inner split delta (from %lu to %lu) CAS succeeds."
-                     " ABORT\n", node_id, new_node_id);
 
-          // Same reason as in leaf node
-          context_p->abort_flag = true;
+  /*
+   * Delete() - Remove a key-value pair from the tree
+   *
+   * This function returns false if the key and value pair does not
+   * exist. Return true if delete succeeds
+   *
+   * This functions shares a same structure with the Insert() one
+   */
+  bool Delete(const KeyType &key, const ValueType &value) {
+    return DeleteFromLeaf(key, value, INVALID_NODE_ID);
+  }
 
-          return;
-        } else {
-          bwt_printf("Inner split delta CAS fails\n");
+  /*
+   * DeleteFromLeaf() - Remove a key-value pair starting on a leaf
+   *
+   * See InsertFromLeaf() for leaf_node_id
+   */
+  bool DeleteFromLeaf(const KeyType &key,
+                      const ValueType &value,
+                      NodeID leaf_node_id) {
+    bwt_printf("Delete called\n");
 
-          // Use the epoch manager to recycle NodeID in single threaded
-          // environment
-          // Note that this remove node should be created on existing node
-          // rather than on new_inner_node_p, since new_inner_node_p may
-          // be destroyed before fake_remove_node_p is destroyed
-          const InnerRemoveNode *fake_remove_node_p = \
-            new InnerRemoveNode{new_node_id, 
-                                new_inner_node_p};
+    GetCurrentOperationCounter()->delete_count++;
 
-          epoch_manager.AddGarbageNode(fake_remove_node_p);
-          epoch_manager.AddGarbageNode(new_inner_node_p);
+    ThawIfFrozen();
+    TryMergeDeferredNodes();
 
-          // Call destructor since it is allocated from the base InnerNode
-          split_node_p->~InnerSplitNode();
+    #ifdef BWTREE_DEBUG
+    delete_op_count.fetch_add(1);
+    #endif
 
-          return;
-        } // if CAS fails
-      } else if(node_size <= INNER_NODE_SIZE_LOWER_THRESHOLD) {
-        if(context_p->IsOnRootNode() == true) {
-          bwt_printf("Root underflow - let it be\n");
+    EpochNode *epoch_node_p = epoch_manager.JoinEpoch();
 
-          return;
-        }
+    Backoff backoff{backoff_max_spin_count};
 
-        // NOTE: If the parent node has changed (e.g. split on the current
-        // node's low key) we will not be able to catch it. But we will
-        // find it later by posting an InnerAbortNode on parent which would
-        // result in CAS failing and aborting
+    // The leaf to start from; after a CAS failure the leaf it failed on
+    NodeID retry_node_id = leaf_node_id;
 
-        // We could not remove leftmost node
-        if(IsOnLeftMostChild(context_p) == true) {
-          bwt_printf("Left most inner node cannot be removed\n");
+    while(1) {
+      Context context{key};
+      std::pair<int, bool> index_pair;
 
-          return;
-        }
+      // Navigate leaf nodes to check whether the key-value
+      // pair exists
+      const KeyValuePair *item_p = nullptr;
+      if(retry_node_id == INVALID_NODE_ID) {
+        item_p = Traverse(&context, &value, &index_pair);
+      } else {
+        item_p = TraverseFromLeaf(&context, retry_node_id, &value, &index_pair);
+      }
 
-        // After this point we decide to remove
+      if(item_p == nullptr) {
+        epoch_manager.LeaveEpoch(epoch_node_p);
 
-        bwt_printf("Node size <= inner lower threshold. Remove\n");
+        return false;
+      }
 
-        // Then we abort its parent node
-        // These two are used to hold abort node and its previous child
-        const BaseNode *abort_node_p;
-        const BaseNode *abort_child_node_p;
-        NodeID parent_node_id;
+      NodeSnapshot *snapshot_p = GetLatestNodeSnapshot(&context);
 
-        bool abort_node_ret = \
-          PostAbortOnParent(context_p,
-                            &parent_node_id,
-                            &abort_node_p,
-                            &abort_child_node_p);
+      // We will CAS on top of this
+      const BaseNode *node_p = snapshot_p->node_p;
+      NodeID node_id = snapshot_p->node_id;
 
-        // If we could not block the parent then the parent has changed
-        // (splitted, etc.)
-        if(abort_node_ret == true) {
-          bwt_printf("Blocked parent node (current node is inner)\n");
-        } else {
-          bwt_printf("Unable to block parent node "
-                     "(current node is inner). ABORT\n");
+      const LeafDeleteNode *delete_node_p = \
+        LeafInlineAllocateOfType(LeafDeleteNode, 
+                                 node_p, 
+                                 key, 
+                                 value, 
+                                 node_p, 
+                                 index_pair);
 
-          // ABORT and return
-          context_p->abort_flag = true;
+      bool ret = InstallNodeToReplace(node_id,
+                                      delete_node_p,
+                                      node_p);
+      if(ret == true) {
+        bwt_printf("Leaf Delete delta CAS succeed\n");
 
-          return;
-        }
+        // If install is a success then just break from the loop
+        // and return
+        break;
+      } else {
+        bwt_printf("Leaf Delete delta CAS failed\n");
 
-        const InnerRemoveNode *remove_node_p = \
-          new InnerRemoveNode{node_id, 
-                              node_p};
+        GetCurrentOperationCounter()->CASFailed(CASSite::LeafData);
+        RecordLeafContention(node_id);
 
-        bool ret = InstallNodeToReplace(node_id, remove_node_p, node_p);
-        if(ret == true) {
-          bwt_printf("InnerRemoveNode CAS succeeds. ABORT\n");
+        delete_node_p->~LeafDeleteNode();
 
-          // We abort after installing a node remove delta
-          context_p->abort_flag = true;
+        backoff.Wait(GetCurrentOperationCounter());
 
-          // Even if we success we need to remove the abort
-          // on the parent, and let parent split thread to detect the remove
-          // delta on child
-          RemoveAbortOnParent(parent_node_id,
-                              abort_node_p,
-                              abort_child_node_p);
+        retry_node_id = node_id;
 
-          return;
-        } else {
-          bwt_printf("InnerRemoveNode CAS failed\n");
+        #ifdef BWTREE_DEBUG
 
-          delete remove_node_p;
+        context.abort_counter++;
+        
+        #endif
+      }
 
-          // We must abort here since otherwise it might cause
-          // merge nodes to underflow
-          context_p->abort_flag = true;
+      #ifdef BWTREE_DEBUG
 
-          // Same as above
-          RemoveAbortOnParent(parent_node_id,
-                              abort_node_p,
-                              abort_child_node_p);
+      delete_abort_count.fetch_add(context.abort_counter);
+      
+      #endif
 
-          return;
-        }
-      } // if split/remove
+      // We reach here only because CAS failed
+      bwt_printf("Retry installing leaf delete delta\n");
     }
 
-    return;
+    epoch_manager.LeaveEpoch(epoch_node_p);
+
+    return true;
   }
 
   /*
-   * RemoveAbortOnParent() - Removes the abort node on the parent
+   * GetValue() - Fill a value list with values stored
+   *
+   * This function accepts a value list as argument,
+   * and will copy all values into the list
    *
-   * This operation must succeeds since only the thread that installed
-   * the abort node could remove it
+   * The return value is used to indicate whether the value set
+   * is empty or not
    */
-  void RemoveAbortOnParent(NodeID parent_node_id,
-                           const BaseNode *abort_node_p,
-                           const BaseNode *abort_child_node_p) {
-    bwt_printf("Remove abort on parent node\n");
+  void GetValue(const KeyType &search_key,
+                std::vector<ValueType> &value_list) {
+    bwt_printf("GetValue()\n");
 
-    // We switch back to the child node (so it is the target)
-    bool ret = \
-      InstallNodeToReplace(parent_node_id, abort_child_node_p, abort_node_p);
+    GetCurrentOperationCounter()->read_count++;
 
-    // This CAS must succeed since nobody except this thread could remove
-    // the ABORT delta on parent node
-    assert(ret == true);
-    (void)ret;
+    EpochNode *epoch_node_p = epoch_manager.JoinEpoch();
 
-    // NOTE: DO NOT FORGET TO REMOVE THE ABORT AFTER
-    // UNINSTALLING IT FROM THE PARENT NODE
-    // NOTE 2: WE COULD NOT DIRECTLY DELETE THIS NODE
-    // SINCE SOME OTHER NODES MIGHT HAVE TAKEN A SNAPSHOT
-    // AND IF ABORT NODE WAS REMOVED, THE TYPE INFORMATION
-    // CANNOT BE PRESERVED AND IT DOES NOT ABORT; INSTEAD
-    // IT WILL TRY TO CALL CONSOLIDATE ON ABORT
-    // NODE, CAUSING TYPE ERROR
-    //delete (InnerAbortNode *)abort_node_p;
+    LookupValues(search_key,
+                 [&value_list](const ValueType &value) {
+                   value_list.push_back(value);
+                 });
 
-    // This delays the deletion of abort node until all threads has exited
-    // so that existing pointers to ABORT node remain valid
-    // GC does not follow the delta chain of ABORT node
-    epoch_manager.AddGarbageNode(abort_node_p);
+    epoch_manager.LeaveEpoch(epoch_node_p);
 
     return;
   }
-
+  
   /*
-   * PostAbortOnParent() - Posts an inner abort node on the parent
-   *
-   * This function blocks all accesses to the parent node, and blocks
-   * all CAS efforts for threads that took snapshots before the CAS
-   * in this function.
+   * ForEachValue() - Call a function on every value of the search key
    *
-   * Return false if CAS failed. In that case the memory is freed
-   * by this function
+   * The function is called with a const ValueType & argument once for each
+   * value currently associated with the key. This path never touches the
+   * heap, so it is the preferred way of doing point lookups on the hot path.
    *
-   * This function DOES NOT ABORT. Do not have to check for abort flag. But
-   * if CAS fails then returns false, and caller needs to abort after
-   * checking the return value.
+   * NOTE: The function is called while the thread is inside an epoch, so
+   * it should be short and must not call back into the tree. The reference
+   * passed to it is only valid during the call
    */
-  bool PostAbortOnParent(Context *context_p,
-                         NodeID *parent_node_id_p,
-                         const BaseNode **abort_node_p_p,
-                         const BaseNode **abort_child_node_p_p) {
-    // This will make sure the path list has length >= 2
-    NodeSnapshot *parent_snapshot_p = \
-      GetLatestParentNodeSnapshot(context_p);
-
-    const BaseNode *parent_node_p = parent_snapshot_p->node_p;
-    NodeID parent_node_id = parent_snapshot_p->node_id;
-
-    // Save original node pointer
-    *abort_child_node_p_p = parent_node_p;
-    *parent_node_id_p = parent_node_id;
+  template <typename ValueFunc>
+  void ForEachValue(const KeyType &search_key, ValueFunc &&value_func) {
+    bwt_printf("ForEachValue()\n");
 
-    InnerAbortNode *abort_node_p = \
-      new InnerAbortNode{parent_node_p};
-
-    bool ret = InstallNodeToReplace(parent_node_id,
-                                    abort_node_p,
-                                    parent_node_p);
+    GetCurrentOperationCounter()->read_count++;
 
-    if(ret == true) {
-      bwt_printf("Inner Abort node CAS succeeds\n");
+    EpochNode *epoch_node_p = epoch_manager.JoinEpoch();
 
-      // Copy the new node to caller since after posting remove delta we will
-      // remove this abort node to enable accessing again
-      *abort_node_p_p = abort_node_p;
-    } else {
-      bwt_printf("Inner Abort node CAS failed\n");
+    LookupValues(search_key, value_func);
 
-      delete abort_node_p;
-    }
+    epoch_manager.LeaveEpoch(epoch_node_p);
 
-    return ret;
+    return;
   }
-
+  
   /*
-   * NavigateInnerNode() - Given a parent snapshot and a key, return the item
-   *                       with the same key if that item exists
-   *
-   * This function checks whether a given key exists in the current
-   * inner node delta chain. If it exists then return a pointer to the
-   * item, otherwise return nullptr.
-   *
-   * This function is called when completing both split SMO and merge SMO
-   * For split SMO we need to check, key range and key existance, and
-   * NodeID value, to avoid mssing a few InnerDeleteNode on the parent node.
-   * However, for merge SMO, we only check key existence.
+   * ForEachValue() - Call a function on every value of a key view
    *
-   * Note: This function does not abort. Any extra checking (e.g. whether
-   * NodeIDs match, whether key is inside range) should be done by the caller
+   * The search key could be of any type that the comparator and the
+   * equality checker compare with KeyType in both argument orders, e.g. a
+   * pointer and a length into a string key. Lookups then do not construct
+   * a KeyType, which for string keys saves a heap allocation per call
    *
-   * Note 2: index_pair_p always reflects the relative position of the search
-   * key inside this InnerNode, no matter nullptr or non-null pointer is 
-   * returned, the integer inside the pair is always the index for all keys
-   * >= the search key. Currently the secong component is not set and not
-   * used
+   * NOTE: This is only available if KeyComparator has a member type
+   * is_transparent (see IsTransparentComparator)
    */
-  const KeyNodeIDPair *NavigateInnerNode(NodeSnapshot *snapshot_p,
-                                         const KeyType &search_key,
-                                         const KeyNodeIDPair **location) {
-    // Save some keystrokes
-    const BaseNode *node_p = snapshot_p->node_p;
-    
-     // This is used to recognize the leftmost branch if there is
-     // a merge node
-     const KeyNodeIDPair &low_key_pair = node_p->GetLowKeyPair();
-    
-    // The caller must make sure this is true
-    assert(node_p->GetNextNodeID() == INVALID_NODE_ID ||
-           KeyCmpLess(search_key, node_p->GetHighKey()));
-
-    while(1) {
-      switch(node_p->GetType()) {
-      case NodeType::InnerInsertType: {
-        const KeyNodeIDPair &insert_item = \
-          static_cast<const InnerInsertNode *>(node_p)->item;
-
-        if(KeyCmpEqual(insert_item.first, search_key) == true) {
-          // Same key, same index
-          *location = static_cast<const InnerInsertNode *>(node_p)->location;
-          
-          return &insert_item;
-        }
+  template <typename SearchKeyType,
+            typename ValueFunc,
+            typename std::enable_if<
+              IsTransparentComparator<KeyComparator>::value && \
+              !std::is_same<SearchKeyType, KeyType>::value, int>::type = 0>
+  void ForEachValue(const SearchKeyType &search_key, ValueFunc &&value_func) {
+    bwt_printf("ForEachValue() (key view)\n");
 
-        node_p = \
-          static_cast<const InnerInsertNode *>(node_p)->child_node_p;
+    GetCurrentOperationCounter()->read_count++;
 
-        break;
-      } // InnerInsertNode
-      case NodeType::InnerDeleteType: {
-        const KeyNodeIDPair &delete_item = \
-          static_cast<const InnerDeleteNode *>(node_p)->item;
+    EpochNode *epoch_node_p = epoch_manager.JoinEpoch();
 
-        if(KeyCmpEqual(delete_item.first, search_key) == true) {
-          *location = static_cast<const InnerDeleteNode *>(node_p)->location;
-          
-          return nullptr;
-        }
+    LookupValues(search_key, value_func);
 
-        node_p = \
-          static_cast<const InnerDeleteNode *>(node_p)->child_node_p;
+    epoch_manager.LeaveEpoch(epoch_node_p);
 
-        break;
-      } // InnerDeleteNode
-      case NodeType::InnerType: {
-        const InnerNode *inner_node_p = static_cast<const InnerNode *>(node_p);
+    return;
+  }
+  
+  /*
+   * GetValue() - Fill a value list with values of a key view
+   *
+   * See ForEachValue() for the requirements on the key view
+   */
+  template <typename SearchKeyType,
+            typename std::enable_if<
+              IsTransparentComparator<KeyComparator>::value && \
+              !std::is_same<SearchKeyType, KeyType>::value, int>::type = 0>
+  void GetValue(const SearchKeyType &search_key,
+                std::vector<ValueType> &value_list) {
+    ForEachValue(search_key,
+                 [&value_list](const ValueType &value) {
+                   value_list.push_back(value);
+                 });
 
-        // DO NOT REMOVE THIS!!!!!!
-        // Unlike a NavigateInnerNode(Context *) which searches for child
-        // node ID, this function needs to cover all possible separators
-        // in the merged InnerNode (right branch)
-        const KeyNodeIDPair *start_it = inner_node_p->Begin();
+    return;
+  }
+  
+  /*
+   * GetValue() - Copy values into a caller provided buffer
+   *
+   * At most buffer_size values are copied into value_buffer_p. The return
+   * value is the total number of values associated with the key, which could
+   * be larger than buffer_size, in which case the caller knows the buffer
+   * was not large enough and could retry with a larger one
+   *
+   * This function does not allocate any heap memory
+   */
+  size_t GetValue(const KeyType &search_key,
+                  ValueType *value_buffer_p,
+                  size_t buffer_size) {
+    bwt_printf("GetValue() (buffer)\n");
+
+    size_t value_count = 0;
+    
+    ForEachValue(search_key, 
+                 [value_buffer_p, 
+                  buffer_size, 
+                  &value_count](const ValueType &value) {
+                   if(value_count < buffer_size) {
+                     value_buffer_p[value_count] = value;
+                   }
+                   
+                   value_count++;
+                 });
+
+    return value_count;
+  }
 
-        // If we are on the leftmost branch of the inner node delta chain
-        // if there is a merge delta, then we should start searching from
-        // the second element. Otherwise always start search from the first
-        // element
-        if(low_key_pair.second == inner_node_p->At(0).second) {
-          start_it++;
-        }
+  /*
+   * GetValue() - Return value in a ValueSet object
+   *
+   * This is used for verification in the benchmark test suite. Do not
+   * remove this method
+   */
+  ValueSet GetValue(const KeyType &search_key) {
+    bwt_printf("GetValue()\n");
 
-        const KeyNodeIDPair *it = \
-          std::lower_bound(start_it,
-                           inner_node_p->End(),
-                           std::make_pair(search_key, INVALID_NODE_ID),
-                           key_node_id_pair_cmp_obj);
+    GetCurrentOperationCounter()->read_count++;
 
-        // Just give the location information by assigning to location
-        *location = it;
+    EpochNode *epoch_node_p = epoch_manager.JoinEpoch();
 
-        if(it == inner_node_p->End()) {
-          // This is special case since we could not compare the iterator
-          // If the key does not exist then return nullptr
-          return nullptr;
-        } else if(KeyCmpEqual(it->first, search_key) == false) {
-          // If found the lower bound but keys are different
-          // then also return nullptr
-          return nullptr;
-        } else {
-          // If found the lower bound and the key matches
-          // return the key
-          return it;
-        }
+    std::vector<ValueType> value_list{};
+    LookupValues(search_key,
+                 [&value_list](const ValueType &value) {
+                   value_list.push_back(value);
+                 });
 
-        assert(false);
-        return nullptr;
-      } // InnerNode
-      case NodeType::InnerSplitType: {
-        // We must guarantee that the key must be inside the range
-        // of this function
-        // For split SMO this is true by extra checking
-        // For merge SMO this is implicitly true sunce the merge key
-        // should not be in another node, o.w. the high key has changed
-        node_p = \
-          static_cast<const InnerSplitNode *>(node_p)->child_node_p;
+    epoch_manager.LeaveEpoch(epoch_node_p);
 
-        break;
-      } // InnerSplitType
-      case NodeType::InnerMergeType: {
-        const KeyNodeIDPair &delete_item = \
-          static_cast<const InnerMergeNode *>(node_p)->delete_item;
+    ValueSet value_set{value_list.begin(),
+                       value_list.end(),
+                       10,
+                       value_hash_obj,
+                       value_eq_obj};
 
-        // If the split key >= merge key then just go to the right branch
-        if(KeyCmpGreaterEqual(search_key, delete_item.first) == true) {
-          node_p = static_cast<const InnerMergeNode *>(node_p)->right_merge_p;
-        } else {
-          node_p = static_cast<const InnerMergeNode *>(node_p)->child_node_p;
-        }
+    return value_set;
+  }
+  
+  /*
+   * ScanRange() - Calls a function on all key-value pairs inside a key range
+   *
+   * The range is [low_key, high_key], and whether each bound is inclusive is
+   * decided by the two flags. The function is called as 
+   * scan_func(const KeyType &, const ValueType &) in key order, and should
+   * return true to continue scanning, or false to stop early.
+   *
+   * Unlike iterators, this function traverses the tree only once and then
+   * follows sibling pointers on the leaf level, streaming leaf contents to
+   * the function directly without creating any IteratorContext. Base leaf
+   * nodes are read in place and only leaf nodes with delta chains are
+   * consolidated into a temporary node
+   *
+   * The return value is the number of key-value pairs passed to the function
+   *
+   * NOTE: The function is called inside an epoch which is held for the
+   * entire scan, so it must not call back into the tree. References
+   * passed to it are only valid during the call
+   */
+  template <typename ScanFunc>
+  size_t ScanRange(const KeyType &low_key,
+                   const KeyType &high_key,
+                   bool low_inclusive,
+                   bool high_inclusive,
+                   ScanFunc &&scan_func) {
+    bwt_printf("ScanRange()\n");
+    
+    return ScanLeafLevel(&low_key,
+                         low_inclusive,
+                         &high_key,
+                         high_inclusive,
+                         static_cast<size_t>(-1),
+                         scan_func);
+  }
+  
+  /*
+   * ScanRangeLimit() - Calls a function on at most limit key-value pairs
+   *                    whose key is >= low_key
+   *
+   * See ScanRange() for more information on the scan function and the
+   * return value
+   */
+  template <typename ScanFunc>
+  size_t ScanRangeLimit(const KeyType &low_key,
+                        size_t limit,
+                        ScanFunc &&scan_func) {
+    bwt_printf("ScanRangeLimit()\n");
+    
+    return ScanLeafLevel(&low_key,
+                         true,
+                         nullptr,
+                         false,
+                         limit,
+                         scan_func);
+  }
+  
+  /*
+   * ReverseScanRange() - Calls a function on all key-value pairs inside a
+   *                      key range in descending key order
+   *
+   * This is the reverse version of ScanRange(), and the arguments have the
+   * same meaning. Scanning starts from the high key, and after a leaf node
+   * is drained we locate its left sibling using a cached copy of the parent 
+   * node instead of traversing from the root 
+   */
+  template <typename ScanFunc>
+  size_t ReverseScanRange(const KeyType &low_key,
+                          const KeyType &high_key,
+                          bool low_inclusive,
+                          bool high_inclusive,
+                          ScanFunc &&scan_func) {
+    bwt_printf("ReverseScanRange()\n");
+    
+    return ScanLeafLevelReverse(&high_key,
+                                high_inclusive,
+                                &low_key,
+                                low_inclusive,
+                                static_cast<size_t>(-1),
+                                scan_func);
+  }
+  
+  /*
+   * ReverseScanRangeLimit() - Calls a function on at most limit key-value 
+   *                           pairs whose key is <= high_key in descending 
+   *                           key order
+   */
+  template <typename ScanFunc>
+  size_t ReverseScanRangeLimit(const KeyType &high_key,
+                               size_t limit,
+                               ScanFunc &&scan_func) {
+    bwt_printf("ReverseScanRangeLimit()\n");
+    
+    return ScanLeafLevelReverse(&high_key,
+                                true,
+                                nullptr,
+                                false,
+                                limit,
+                                scan_func);
+  }
+  
+  /*
+   * ReverseScanAll() - Calls a function on all key-value pairs in 
+   *                    descending key order starting from the last key
+   *
+   * Returning false from the function stops the scan
+   */
+  template <typename ScanFunc>
+  size_t ReverseScanAll(ScanFunc &&scan_func) {
+    bwt_printf("ReverseScanAll()\n");
+    
+    return ScanLeafLevelReverse(nullptr,
+                                true,
+                                nullptr,
+                                false,
+                                static_cast<size_t>(-1),
+                                scan_func);
+  }
+  
+  /*
+   * ParallelScanRange() - Calls a function on all key-value pairs inside a
+   *                       key range using multiple threads
+   *
+   * The key range [low_key, high_key] (whether each bound is inclusive is 
+   * decided by the two flags) is cut into at most partition_num partitions
+   * of roughly equal sizes using separators on the top two levels of the 
+   * tree. Partitions are numbered from 0 in key order, and each partition is
+   * scanned in a task submitted to a caller-provided thread pool by calling
+   * submit_func(std::function<void()> &&task). 
+   *
+   * The scan function is called as 
+   * scan_func(size_t partition_id, const KeyType &, const ValueType &) and 
+   * key-value pairs inside a partition are passed in key order. Returning 
+   * false stops scanning the current partition only. Since partitions are
+   * scanned concurrently the scan function must be thread-safe, and one
+   * way to assemble an ordered result is to use one buffer per partition 
+   * and concatenate them afterwards
+   *
+   * This function returns after all tasks have finished, and the return
+   * value is the number of key-value pairs passed to the function
+   *
+   * NOTE: Each task joins its own epoch, so threads in the pool must have
+   * been assigned a GC ID just like any other worker thread. The same
+   * restrictions on the scan function as ScanRange() also apply
+   */
+  template <typename SubmitFunc, typename ScanFunc>
+  size_t ParallelScanRange(const KeyType &low_key,
+                           const KeyType &high_key,
+                           bool low_inclusive,
+                           bool high_inclusive,
+                           size_t partition_num,
+                           SubmitFunc &&submit_func,
+                           ScanFunc &&scan_func) {
+    bwt_printf("ParallelScanRange()\n");
+    
+    return ParallelScanLeafLevel(&low_key,
+                                 low_inclusive,
+                                 &high_key,
+                                 high_inclusive,
+                                 partition_num,
+                                 submit_func,
+                                 scan_func);
+  }
+  
+  /*
+   * ParallelScan() - Calls a function on all key-value pairs in the tree
+   *                  using multiple threads
+   *
+   * See ParallelScanRange() for more information
+   */
+  template <typename SubmitFunc, typename ScanFunc>
+  size_t ParallelScan(size_t partition_num,
+                      SubmitFunc &&submit_func,
+                      ScanFunc &&scan_func) {
+    bwt_printf("ParallelScan()\n");
+    
+    return ParallelScanLeafLevel(nullptr,
+                                 true,
+                                 nullptr,
+                                 false,
+                                 partition_num,
+                                 submit_func,
+                                 scan_func);
+  }
+  
+  ///////////////////////////////////////////////////////////////////
+  // Garbage Collection Interface
+  ///////////////////////////////////////////////////////////////////
+  
+  /*
+   * NeedGarbageCollection() - Whether the tree needs garbage collection
+   *
+   * Ideally, if there is no modification workload on BwTree from the last
+   * time GC was called, then GC is unnecessary since read operation does not
+   * modify any data structure
+   *
+   * Currently we just leave the interface as a placeholder, which returns true
+   * everytime to force GC thred to at least take a look into the epoch
+   * counter.
+   */
+  //bool NeedGarbageCollection() {
+  //  return true;
+  //}
+  
+  /*
+   * PerformGarbageCollection() - Interface function for external users to
+   *                              force a garbage collection
+   *
+   * This function is a wrapper to the internal GC thread function. Since
+   * users could choose whether to let BwTree handle GC by itself or to
+   * control GC using external threads. This function is left as a convenient
+   * interface for external threads to do garbage collection.
+   */
+  //void PerformGarbageCollection() {
+    // This function creates a new epoch node, and then checks
+    // epoch counter for exiatsing nodes.
+  //  epoch_manager.PerformGarbageCollection();
 
-        break;
-      } // InnerMergeNode
-      default: {
-        bwt_printf("Unknown InnerNode type: %d", (int)node_p->GetType());
+  //  return;
+  //}
 
-        assert(false);
-        return nullptr;
-      } // default
-      } // switch
-    } // while(1)
+  /*
+   * class MemoryUsage - Snapshot of memory used by the tree in bytes
+   */
+  class MemoryUsage {
+   public:
+    // Base nodes including the delta chunk embedded in each of them
+    size_t base_node_size;
+    
+    // Delta chunks grown after base node allocation, and remove/abort
+    // delta records which are allocated separately
+    size_t delta_size;
+    
+    // Unlinked nodes pending reclamation; they are also counted in the
+    // two above since they have not been freed yet
+    size_t garbage_size;
+    
+    // The number of garbage nodes in all threads' GC lists
+    size_t garbage_node_count;
+    
+    // Mapping table and free NodeID list
+    size_t mapping_table_size;
+    
+    // The tree object except the mapping table, and thread local arrays
+    size_t metadata_size;
+    
+    // The frozen layout and thawed layouts not yet freed
+    size_t frozen_layout_size;
+    
+    /*
+     * GetTotalSize() - Returns the total number of bytes used by the tree
+     */
+    size_t GetTotalSize() const {
+      return base_node_size + \
+             delta_size + \
+             garbage_node_count * sizeof(GarbageNode) + \
+             mapping_table_size + \
+             metadata_size + \
+             frozen_layout_size;
+    }
+  };
+  
+  /*
+   * GetMemoryUsage() - Returns the memory used by the tree
+   *
+   * Node memory is maintained in per-thread counters which are summed here.
+   * Since other threads' counters are read without synchronization, the
+   * result is only exact if no other thread is modifying the tree
+   */
+  MemoryUsage GetMemoryUsage() {
+    MemoryCounter counter = SummarizeMemoryCounter();
+    
+    size_t garbage_node_count = 0UL;
+    for(size_t i = 0; i < GetThreadNum(); i++) {
+      garbage_node_count += GetGCMetaData(i)->node_count;
+    }
+    
+    MemoryUsage usage;
+    
+    // Individual counters might be observed in the middle of an update
+    // by another thread, so clamp them to 0
+    usage.base_node_size = \
+      static_cast<size_t>(std::max(counter.base_node_size, int64_t{0}));
+    usage.delta_size = \
+      static_cast<size_t>(std::max(counter.delta_size, int64_t{0}));
+    usage.garbage_size = \
+      static_cast<size_t>(std::max(counter.garbage_size, int64_t{0}));
+    usage.garbage_node_count = garbage_node_count;
+    usage.mapping_table_size = sizeof(mapping_table);
+    usage.metadata_size = \
+      sizeof(*this) - usage.mapping_table_size + \
+      THREAD_LOCAL_SIZE * GetThreadNum() + CACHE_LINE_SIZE + \
+      free_node_id_count.load() * sizeof(NodeID);
+    
+    usage.frozen_layout_size = 0UL;
+    
+    const FrozenLayout *layout_p = frozen_layout_p.load();
+    if(layout_p != nullptr) {
+      usage.frozen_layout_size += layout_p->GetAllocationSize();
+    }
+    
+    std::lock_guard<std::mutex> guard{retired_layout_lock};
+    
+    for(layout_p = retired_layout_p.load();
+        layout_p != nullptr;
+        layout_p = layout_p->next_p) {
+      usage.frozen_layout_size += layout_p->GetAllocationSize();
+    }
+    
+    return usage;
+  }
+  
+  /*
+   * GetMemoryFootprint() - Returns the total number of bytes used by the tree
+   */
+  size_t GetMemoryFootprint() {
+    return GetMemoryUsage().GetTotalSize();
+  }
+  
+  // Sites are used as argument of Stats::GetCASFailureCount()
+  using CASSite = BwTreeBase::CASSite;
 
-    assert(false);
-    return nullptr;
+  // Used by Insert() and Delete() after leaf data CAS failures
+  using Backoff = BwTreeBase::Backoff;
+  
+  /*
+   * class Stats - Snapshot of operation statistics of the tree
+   */
+  class Stats : public OperationCounter {
+   public:
+    // Bytes ever handed to the garbage collector and ever freed by it
+    size_t retired_size;
+    size_t freed_size;
+    
+    /*
+     * Default constructor
+     */
+    Stats() :
+      OperationCounter{},
+      retired_size{0UL},
+      freed_size{0UL}
+    {}
+    
+    /*
+     * GetCASFailureCount() - Returns the number of CAS failures at a site
+     */
+    uint64_t GetCASFailureCount(CASSite site) const {
+      return cas_failure_count[static_cast<int>(site)];
+    }
+    
+    /*
+     * GetTotalCASFailureCount() - Returns CAS failures of all sites
+     */
+    uint64_t GetTotalCASFailureCount() const {
+      uint64_t total = 0UL;
+      for(int i = 0;i < CAS_SITE_COUNT;i++) {
+        total += cas_failure_count[i];
+      }
+      
+      return total;
+    }
+  };
+  
+  /*
+   * GetStats() - Returns operation statistics summed over all threads
+   *
+   * Counters are always maintained, and cost one increment of a thread
+   * local cache line per event. They are only summed when this function
+   * is called, and since other threads' counters are read without
+   * synchronization, the result might lag behind slightly if the tree
+   * is being modified
+   */
+  Stats GetStats() {
+    Stats stats;
+    
+    static_cast<OperationCounter &>(stats) = SummarizeOperationCounter();
+    
+    MemoryCounter counter = SummarizeMemoryCounter();
+    stats.retired_size = static_cast<size_t>(counter.retired_size);
+    stats.freed_size = static_cast<size_t>(counter.freed_size);
+    
+    return stats;
   }
   
   /*
-   * FindLeftSibling() - Finds the left sibling of the current child node
-   *                     specified by a search key
+   * ConsolidateDataDeltaChain() - Consolidates a delta chain if it only
+   *                               consists of data deltas
    *
-   * This function works in a way similar to how inner node delta chains
-   * are consolidated: We replay the log using sorted small set on all keys
-   * less than or equal to the search key, and then choose the second key
-   * in key order from high to low, after combing the content of InnerNode
-   * and the delta chain nodes
+   * Chains with an unfinished SMO are not consolidated. Returns true if
+   * the consolidated node is installed
    *
-   * NOTE: search_key is the low key of the current node for which we are
-   * find the left sibling, not the search key of the current operation.
-   * These two might differ in the case of cascading remove node delta
+   * NOTE: This function must be called inside an epoch
+   */
+  bool ConsolidateDataDeltaChain(NodeID node_id, const BaseNode *node_p) {
+    const BaseNode *delta_node_p = node_p;
+    while(delta_node_p->IsDeltaNode() == true) {
+      NodeType type = delta_node_p->GetType();
+      if((type != NodeType::LeafInsertType) &&
+         (type != NodeType::LeafDeleteType) &&
+         (type != NodeType::InnerInsertType) &&
+         (type != NodeType::InnerDeleteType)) {
+        return false;
+      }
+      
+      delta_node_p = \
+        static_cast<const DeltaNode *>(delta_node_p)->child_node_p;
+    }
+    
+    // Already a base node
+    if(delta_node_p == node_p) {
+      return false;
+    }
+    
+    NodeSnapshot snapshot{node_id, node_p};
+    ConsolidateNode(&snapshot);
+    
+    // If CAS fails then the snapshot still points to the old chain
+    return snapshot.node_p != node_p;
+  }
+  
+  /*
+   * Cleanup() - Consolidates delta chains and then performs GC
    *
-   * NOTE 2: This function could not deal with InnerMergeNode since the merge
-   * node imposes a non-consecutive storage for adjacent keys. As an alternative
-   * way of finding left sibling, whenever an InnerMergeNode is observed,
-   * the node will be consolidated and we use the plain InnerNode to
-   * continue searching
+   * All delta chains with at least min_depth delta records are consolidated.
+   * Chains with an unfinished SMO are skipped, since they are consolidated
+   * by the thread completing the SMO. After that the epoch is advanced and
+   * garbage of the current thread is collected; garbage of other threads
+   * is collected by themselves as usual
+   *
+   * This could be called concurrently with other operations, but is meant
+   * for maintenance since it scans the whole mapping table. The return
+   * value is the number of nodes consolidated
    */
-  inline NodeID FindLeftSibling(const KeyType &search_key,
-                                NodeSnapshot *snapshot_p) {
-
-    // This will be changed during the traversal
-    const BaseNode *node_p = snapshot_p->node_p;
+  size_t Cleanup(int min_depth = 1) {
+    bwt_printf("Cleanup()\n");
     
-    // First check that the node is always in the range of the inner node
-    assert(node_p->GetNextNodeID() == INVALID_NODE_ID || \
-           KeyCmpLess(search_key, node_p->GetHighKey()));
+    // This is usually called when the tree is not busy, which is when
+    // deferred merges should be done
+    MergeDeferredNodes();
     
-    // We can only search for left sibling on inner delta chain
-    assert(node_p->IsOnLeafDeltaChain() == false);
+    EpochNode *epoch_node_p = epoch_manager.JoinEpoch();
     
-    const InnerDataNode *data_node_list[node_p->GetDepth()];
-
-    // These two are used to compare InnerDataNode for < and == relation
-
-    // NOTE: For this function we reverse the direction of comparison,
-    // i.e. the order is big-to-small to make iteration a little bit easier
-    auto f1 = [this](const InnerDataNode *idn_1, const InnerDataNode *idn_2) {
-                      return this->KeyCmpLess(idn_2->item.first, idn_1->item.first);
-                      //                          ^ <-------------> ^
-                    };
-
-    auto f2 = [this](const InnerDataNode *idn_1, const InnerDataNode *idn_2) {
-                      return this->KeyCmpEqual(idn_1->item.first, idn_2->item.first);
-                    };
-
-    SortedSmallSet<const InnerDataNode *, decltype(f1), decltype(f2)> \
-      sss{data_node_list, f1, f2};
-
-    while(1) {
-      NodeType type = node_p->GetType();
-
-      switch(type) {
-        case NodeType::InnerType: {
-          const InnerNode *inner_node_p = \
-            static_cast<const InnerNode *>(node_p);
-            
-          ///////////////////////////////////////////////////////////
-          // First find the nearest sep key <= search key on InnerNode
-          ///////////////////////////////////////////////////////////
-
-          // This is the logical end of the array
-          const KeyNodeIDPair *end_it = inner_node_p->End();
-
-          // Since we know the search key must be one of the key inside
-          // the inner node, lower bound is sufficient
-          auto it1 = std::upper_bound(inner_node_p->Begin() + 1,
-                                      end_it,
-                                      std::make_pair(search_key, INVALID_NODE_ID),
-                                      key_node_id_pair_cmp_obj) - 1;
-
-          // Note that it is possible for it1 to be begin()
-          // since it is not the real current node if the node id
-          // is actually found on the delta chain
-          
-          ///////////////////////////////////////////////////////////
-          // After this point, it is guaranteed:
-          //   1. it1 points to an element <= removed node's low key
-          //   2. sss.GetBegin() points to an element <= removed node's low key
-          //      * OR *
-          //      sss.GetBegin() == sss.GetEnd()
-          ///////////////////////////////////////////////////////////
-          
-          // We need to pop out 2 items
-          const KeyNodeIDPair *left_item_p = nullptr;
-          
-          int counter = 0;
-          
-          // Loop twice. Hope compiler expands this loop
-          while(counter < 2) {
-            if(sss.GetBegin() == sss.GetEnd()) {
-              left_item_p = &(*it1);
-              
-              it1--;
-              counter++;
-              
-              continue;
-            } else if(it1 == inner_node_p->Begin()) {
-              // We know the sss is not empty, so could always pop from it
-              if(sss.GetFront()->GetType() == NodeType::InnerInsertType) {
-                left_item_p = &(sss.GetFront()->item);
-
-                counter++;
-              }
-              
-              // This has to be done anyway
-              sss.PopFront();
-              
-              continue;
-            }
-            
-            // After this point it1-- is always valid since it is not begin()
-            
-            // If the two items are same
-            if(KeyCmpEqual(sss.GetFront()->item.first, it1->first)) {
-              // If a delete node and a sep item has the same key
-              if(sss.GetFront()->GetType() == NodeType::InnerDeleteType) {
-                it1--;
-              } else {
-                // Otherwise an insert node overrides existing key
-                left_item_p = &(sss.GetFront()->item);
-                
-                it1--;
-                
-                counter++;
-              }
-              
-              // This is common
-              sss.PopFront();
-            } else if(KeyCmpLess(sss.GetFront()->item.first, it1->first)) {
-              // If the inner node has larger sep item
-              // Otherwise an insert node overrides existing key
-              left_item_p = &(*it1);
-
-              it1--;
-
-              counter++;
-            } else {
-              if(sss.GetFront()->GetType() == NodeType::InnerInsertType) {
-                // If the delta node has larger item then set left item p
-                // to delta item
-                left_item_p = &(sss.GetFront()->item);
-
-                counter++;
-              } 
-              
-              // This is common
-              sss.PopFront();
-            }
-          } // while counter < 2
-          
-          // This is the NodeID of the left sibling
-          return left_item_p->second;
-        } 
-        case NodeType::InnerInsertType: {
-          const InnerInsertNode *insert_node_p = \
-            static_cast<const InnerInsertNode *>(node_p);
-
-          const KeyNodeIDPair &insert_item = insert_node_p->item;
-
-          if(KeyCmpLessEqual(insert_item.first, search_key)) {
-            sss.Insert(insert_node_p);
-          }
+    size_t consolidated_count = 0UL;
+    NodeID node_id_end = next_unused_node_id.load();
+    
+    for(NodeID node_id = 1; node_id < node_id_end; node_id++) {
+      const BaseNode *node_p = GetNode(node_id);
+      if((node_p == nullptr) || 
+         (node_p->IsDeltaNode() == false) ||
+         (node_p->GetDepth() < min_depth)) {
+        continue;
+      }
+      
+      if(ConsolidateDataDeltaChain(node_id, node_p) == true) {
+        consolidated_count++;
+      }
+    }
+    
+    epoch_manager.LeaveEpoch(epoch_node_p);
+    
+    // Nodes unlinked above become reclaimable in the next epoch
+    IncreaseEpoch();
 
-          node_p = insert_node_p->child_node_p;
+    // Threads without a valid GC ID have no GC metadata to update
+    if((gc_id < 0) || (gc_id >= static_cast<int>(thread_num))) {
+      return consolidated_count;
+    }
 
-          break;
-        } // InnerInsertType
-        case NodeType::InnerDeleteType: {
-          const InnerDeleteNode *delete_node_p = \
-            static_cast<const InnerDeleteNode *>(node_p);
-            
-          const KeyNodeIDPair &delete_item = delete_node_p->item;
+    UpdateLastActiveEpoch();
+    PerformGC(gc_id);
 
-          if(KeyCmpLessEqual(delete_item.first, search_key)) {
-            sss.Insert(delete_node_p);
+    return consolidated_count;
+  }
+  
+  /*
+   * class FrozenLayout - Read-only copy of the tree in a static layout
+   *
+   * All key-value pairs are stored in one array in key order, and every
+   * FROZEN_LEAF_NODE_SIZE consecutive pairs form a leaf. The first key of
+   * each leaf except the first one is a separator. Separators are stored
+   * in Eytzinger order, i.e. the BFS order of a complete binary search tree
+   * where the children of slot k are 2k and 2k + 1, such that a lookup
+   * walks down one array whose top levels share a few cache lines, and the
+   * cache line holding the descendants a few levels below could be
+   * prefetched on each step. The layout has no pointers or NodeIDs, and
+   * both arrays start on a cache line
+   *
+   * The layout is immutable; the tree replaces it rather than changing it
+   */
+  class FrozenLayout {
+   public:
+    // Number of separators in one cache line; the descendants of slot k
+    // this many levels down start at slot k * SEPARATOR_PER_CACHE_LINE
+    static constexpr size_t SEPARATOR_PER_CACHE_LINE = \
+      (sizeof(KeyType) >= CACHE_LINE_SIZE) ? \
+      1UL : \
+      (CACHE_LINE_SIZE / sizeof(KeyType));
+    
+    // See Thaw()
+    uint64_t delete_epoch;
+    FrozenLayout *next_p;
+    
+    /*
+     * Constructor - Builds the layout from pairs sorted by key
+     */
+    FrozenLayout(const BwTree *p_tree_p,
+                 const std::vector<KeyValuePair> &item_list) :
+      delete_epoch{0UL},
+      next_p{nullptr},
+      tree_p{p_tree_p},
+      item_count{item_list.size()},
+      leaf_count{(item_list.size() + FROZEN_LEAF_NODE_SIZE - 1) / \
+                 FROZEN_LEAF_NODE_SIZE},
+      separator_count{(leaf_count == 0UL) ? 0UL : (leaf_count - 1)} {
+      assert(separator_count < static_cast<size_t>(UINT32_MAX));
+      
+      // Slot 0 of the separator array is not used by the search
+      size_t item_size = RoundUp(item_count * sizeof(KeyValuePair));
+      size_t separator_size = \
+        RoundUp((separator_count + 1) * sizeof(KeyType));
+      size_t rank_size = (separator_count + 1) * sizeof(uint32_t);
+      
+      allocation_size = item_size + separator_size + rank_size + \
+                        CACHE_LINE_SIZE;
+      buffer_p = static_cast<char *>(malloc(allocation_size));
+      assert(buffer_p != nullptr);
+      
+      char *aligned_p = reinterpret_cast<char *>(
+        (reinterpret_cast<size_t>(buffer_p) + CACHE_LINE_SIZE - 1) & \
+        CACHE_LINE_MASK);
+      
+      item_list_p = reinterpret_cast<KeyValuePair *>(aligned_p);
+      separator_list_p = \
+        reinterpret_cast<KeyType *>(aligned_p + item_size);
+      rank_list_p = \
+        reinterpret_cast<uint32_t *>(aligned_p + item_size + separator_size);
+      
+      for(size_t i = 0;i < item_count;i++) {
+        new (item_list_p + i) KeyValuePair{item_list[i]};
+      }
+      
+      if(separator_count != 0UL) {
+        BuildSeparator(1UL, 0UL);
+        
+        new (separator_list_p) KeyType{separator_list_p[1]};
+        rank_list_p[0] = 0;
+      }
+      
+      return;
+    }
+    
+    /*
+     * Destructor
+     */
+    ~FrozenLayout() {
+      for(size_t i = 0;i < item_count;i++) {
+        item_list_p[i].~KeyValuePair();
+      }
+      
+      if(separator_count != 0UL) {
+        for(size_t i = 0;i <= separator_count;i++) {
+          separator_list_p[i].~KeyType();
+        }
+      }
+      
+      free(buffer_p);
+      
+      return;
+    }
+    
+    FrozenLayout(const FrozenLayout &) = delete;
+    FrozenLayout &operator=(const FrozenLayout &) = delete;
+    
+    /*
+     * LowerBound() - Returns the first pair whose key >= search key
+     */
+    template <typename SearchKeyType>
+    const KeyValuePair *LowerBound(const SearchKeyType &search_key) const {
+      // Descend without branching on the comparison result
+      size_t k = 1UL;
+      while(k <= separator_count) {
+        __builtin_prefetch(separator_list_p + k * SEPARATOR_PER_CACHE_LINE);
+        
+        k = 2 * k + \
+            (tree_p->KeyCmpLess(separator_list_p[k], search_key) ? 1 : 0);
+      }
+      
+      // Undo the right turns after the last left turn, which was taken on
+      // the first separator >= search key; k is 0 if there is none
+      k >>= __builtin_ffsl(static_cast<long>(~k));
+      
+      // The number of separators < search key is also the leaf whose
+      // range contains the search key
+      size_t leaf_index = (k == 0UL) ? separator_count : rank_list_p[k];
+      
+      size_t begin_index = leaf_index * FROZEN_LEAF_NODE_SIZE;
+      size_t end_index = std::min(begin_index + FROZEN_LEAF_NODE_SIZE,
+                                  item_count);
+      
+      
+      // If all keys in the leaf are smaller then the first pair of the
+      // next leaf is returned, since leaves are contiguous
+      return std::lower_bound(item_list_p + begin_index,
+                              item_list_p + end_index,
+                              search_key,
+                              tree_p->key_value_pair_cmp_obj);
+    }
+    
+    /*
+     * ForEachValue() - Calls a function on every value of the search key
+     */
+    template <typename SearchKeyType, typename ValueCallback>
+    void ForEachValue(const SearchKeyType &search_key,
+                      ValueCallback &&value_callback) const {
+      for(const KeyValuePair *kv_p = LowerBound(search_key);
+          (kv_p != End()) && (tree_p->KeyCmpEqual(kv_p->first, search_key));
+          kv_p++) {
+        value_callback(kv_p->second);
+      }
+      
+      return;
+    }
+    
+    /*
+     * Scan() - Scans the pairs as ScanLeafLevel() does
+     */
+    template <typename ScanFunc>
+    size_t Scan(const KeyType *start_key_p,
+                bool start_inclusive,
+                const KeyType *high_key_p,
+                bool high_inclusive,
+                size_t limit,
+                ScanFunc &scan_func) const {
+      const KeyValuePair *kv_p = item_list_p;
+      if(start_key_p != nullptr) {
+        kv_p = LowerBound(*start_key_p);
+        
+        if(start_inclusive == false) {
+          while((kv_p != End()) &&
+                (tree_p->KeyCmpEqual(kv_p->first, *start_key_p) == true)) {
+            kv_p++;
           }
-          
-          node_p = delete_node_p->child_node_p;
-
-          break;
-        } // InnerDeleteType
-        case NodeType::InnerSplitType: {
-          const InnerSplitNode *split_node_p = \
-            static_cast<const InnerSplitNode *>(node_p);
-
-          node_p = split_node_p->child_node_p;
-
+        }
+      }
+      
+      size_t scan_count = 0UL;
+      
+      while((kv_p != End()) && (scan_count < limit)) {
+        if(high_key_p != nullptr) {
+          if((high_inclusive == true) && 
+             (tree_p->KeyCmpGreater(kv_p->first, *high_key_p) == true)) {
+            break;
+          } else if((high_inclusive == false) &&
+                    (tree_p->KeyCmpGreaterEqual(kv_p->first,
+                                                *high_key_p) == true)) {
+            break;
+          }
+        }
+        
+        scan_count++;
+        if(scan_func(kv_p->first, kv_p->second) == false) {
           break;
-        } // case InnerSplitType
-        case NodeType::InnerMergeType: {
-          bwt_printf("Found merge node. "
-                     "Need consolidation to find left sibling\n");
-
-          // Since we could not deal with merge delta, if there is
-          // a merge delta on the path, the only solution is to
-          // consolidate the inner node, and try to install it
-          //
-          // Even if installation fails, we need to prevserve the content
-          // of the consolidated node, so need to add it to the GC instead
-          // of directly releasing its memory
-
-          InnerNode *inner_node_p = \
-            CollectAllSepsOnInner(snapshot_p,
-                                  // Must +1 to avoid looping on the same depth
-                                  // without any consolidation
-                                  snapshot_p->node_p->GetDepth() + 1);
-
-          bool ret = InstallNodeToReplace(snapshot_p->node_id,
-                                          inner_node_p,
-                                          snapshot_p->node_p);
-                                          
-          if(ret == true) {
-            epoch_manager.AddGarbageNode(snapshot_p->node_p);
-            
-            snapshot_p->node_p = inner_node_p;
-          } else {
-            // This is necessary to preserve the content of the inner node
-            // while avoid memory leaks
-            epoch_manager.AddGarbageNode(inner_node_p);
+        }
+        
+        kv_p++;
+      }
+      
+      return scan_count;
+    }
+    
+    /*
+     * ScanReverse() - Scans the pairs as ScanLeafLevelReverse() does
+     */
+    template <typename ScanFunc>
+    size_t ScanReverse(const KeyType *start_key_p,
+                       bool start_inclusive,
+                       const KeyType *low_key_p,
+                       bool low_inclusive,
+                       size_t limit,
+                       ScanFunc &scan_func) const {
+      // Pairs before this one are scanned
+      const KeyValuePair *kv_p = End();
+      if(start_key_p != nullptr) {
+        kv_p = LowerBound(*start_key_p);
+        
+        if(start_inclusive == true) {
+          while((kv_p != End()) &&
+                (tree_p->KeyCmpEqual(kv_p->first, *start_key_p) == true)) {
+            kv_p++;
           }
-          
-          // Next iteration will go directly into inner node we have
-          // just consolidated
-          node_p = inner_node_p;
-            
-          // This is important - since we just changed the entire node,
-          // the sss should be empty
-          sss.Invalidate();
-          
+        }
+      }
+      
+      size_t scan_count = 0UL;
+      
+      while((kv_p != item_list_p) && (scan_count < limit)) {
+        kv_p--;
+        
+        if(low_key_p != nullptr) {
+          if((low_inclusive == true) && 
+             (tree_p->KeyCmpLess(kv_p->first, *low_key_p) == true)) {
+            break;
+          } else if((low_inclusive == false) &&
+                    (tree_p->KeyCmpLessEqual(kv_p->first,
+                                             *low_key_p) == true)) {
+            break;
+          }
+        }
+        
+        scan_count++;
+        if(scan_func(kv_p->first, kv_p->second) == false) {
           break;
-        } // InnerMergeType
-        default: {
-          bwt_printf("ERROR: Unknown node type = %d",
-                     static_cast<int>(type));
-
-          assert(false);
         }
-      } // switch type
-    } // while 1
-
-    // Should not reach here
-    assert(false);
-    return INVALID_NODE_ID;
+      }
+      
+      return scan_count;
+    }
+    
+    inline const KeyValuePair *End() const {
+      return item_list_p + item_count;
+    }
+    
+    /*
+     * GetItemCount() - Returns the number of key-value pairs
+     */
+    inline size_t GetItemCount() const {
+      return item_count;
+    }
+    
+    /*
+     * GetLeafCount() - Returns the number of packed leaves
+     */
+    inline size_t GetLeafCount() const {
+      return leaf_count;
+    }
+    
+    /*
+     * GetAllocationSize() - Returns the number of bytes of the layout
+     */
+    inline size_t GetAllocationSize() const {
+      return sizeof(FrozenLayout) + allocation_size;
+    }
+    
+   private:
+    
+    /*
+     * RoundUp() - Rounds a size up to a multiple of the cache line size
+     */
+    static inline size_t RoundUp(size_t size) {
+      return (size + CACHE_LINE_SIZE - 1) & CACHE_LINE_MASK;
+    }
+    
+    /*
+     * BuildSeparator() - Fills the subtree rooted at slot k with separators
+     *                    in order, starting from the given sorted index
+     *
+     * Returns the next sorted index after the subtree. Separator i is the
+     * first key of leaf i + 1
+     */
+    size_t BuildSeparator(size_t k, size_t sorted_index) {
+      if(k > separator_count) {
+        return sorted_index;
+      }
+      
+      sorted_index = BuildSeparator(2 * k, sorted_index);
+      
+      new (separator_list_p + k) KeyType{
+        item_list_p[(sorted_index + 1) * FROZEN_LEAF_NODE_SIZE].first};
+      rank_list_p[k] = static_cast<uint32_t>(sorted_index);
+      
+      return BuildSeparator(2 * k + 1, sorted_index + 1);
+    }
+    
+    const BwTree *tree_p;
+    
+    size_t item_count;
+    size_t leaf_count;
+    size_t separator_count;
+    
+    // All arrays are in one allocation
+    char *buffer_p;
+    size_t allocation_size;
+    
+    KeyValuePair *item_list_p;
+    KeyType *separator_list_p;
+    
+    // Sorted index of the separator in each slot
+    uint32_t *rank_list_p;
+  };
+  
+  /*
+   * Freeze() - Compacts the tree into a static layout for reads
+   *
+   * All delta chains are consolidated first, and then all key-value pairs
+   * are copied into a FrozenLayout. After this point lookups and leaf level
+   * scans in both directions (GetValue(), ForEachValue(), ScanRange() and
+   * ReverseScanRange() etc.) search the layout instead of going through
+   * the mapping table. The tree itself is
+   * kept, so the first write after Freeze() only thaws the tree (see
+   * Thaw()) and then proceeds as usual. Iterators always use the tree
+   *
+   * The return value is the number of pairs in the layout. If the tree is
+   * already frozen then nothing is done
+   *
+   * NOTE: This must not be called concurrently with writes or other calls
+   * to Freeze(), while reads could run concurrently
+   */
+  size_t Freeze() {
+    bwt_printf("Freeze()\n");
+    
+    const FrozenLayout *current_layout_p = frozen_layout_p.load();
+    if(current_layout_p != nullptr) {
+      return current_layout_p->GetItemCount();
+    }
+    
+    Cleanup();
+    FreeRetiredLayout(false);
+    
+    std::vector<KeyValuePair> item_list{};
+    auto scan_func = [&item_list](const KeyType &key,
+                                  const ValueType &value) {
+      item_list.push_back(std::make_pair(key, value));
+      
+      return true;
+    };
+    
+    ScanLeafLevel(nullptr,
+                  true,
+                  nullptr,
+                  false,
+                  static_cast<size_t>(-1),
+                  scan_func);
+    
+    FrozenLayout *layout_p = new FrozenLayout{this, item_list};
+    frozen_layout_p.store(layout_p);
+    
+    return item_list.size();
   }
-
+  
   /*
-   * PostInnerMergeNode() - Post an inner merge node
+   * Thaw() - Switches reads back to the tree
+   *
+   * Threads that are reading the layout might still use it after this
+   * returns, so the layout is retired with the current epoch and only
+   * freed after all threads have passed the epoch, by PerformGC() of any
+   * thread or by a later Freeze(), or when the tree is destroyed
    */
-  bool PostInnerMergeNode(const NodeSnapshot *snapshot_p,
-                          const KeyType *merge_key_p,
-                          const BaseNode *merge_branch_p,
-                          NodeID deleted_node_id,
-                          const BaseNode **node_p_p) {
-    // This is the child node of merge delta
-    const BaseNode *node_p = snapshot_p->node_p;
-    NodeID node_id = snapshot_p->node_id;
-
-    // Note that we allocate from merge_banch_p since node_p is deallocated
-    // first and then merge_branch_p, so if we allocate the merge node
-    // on node_p's base node it will be invalid for the second recursive call
-    const InnerMergeNode *merge_node_p = \
-      InnerInlineAllocateOfType(InnerMergeNode, 
-                                merge_branch_p,
-                                *merge_key_p,
-                                merge_branch_p,
-                                deleted_node_id,
-                                node_p);
-
-    // Compare and Swap!
-    bool ret = InstallNodeToReplace(node_id, merge_node_p, node_p);
-
-    // If CAS fails we delete the node and return false
-    if(ret == false) {
-      merge_node_p->~InnerMergeNode();
-    } else {
-      *node_p_p = merge_node_p;
+  void Thaw() {
+    FrozenLayout *layout_p = frozen_layout_p.exchange(nullptr);
+    if(layout_p == nullptr) {
+      return;
     }
-
-    return ret;
+    
+    bwt_printf("Thaw()\n");
+    
+    GetCurrentOperationCounter()->thaw_count++;
+    
+    // Only the thread taking the layout out gets here, so the lock is
+    // only contended by GC threads freeing older layouts
+    std::lock_guard<std::mutex> guard{retired_layout_lock};
+    
+    layout_p->delete_epoch = GetGlobalEpoch();
+    layout_p->next_p = retired_layout_p.load();
+    retired_layout_p.store(layout_p);
+    
+    return;
   }
   
-
   /*
-   * PostLeafMergeNode() - Post an inner merge node
+   * IsFrozen() - Whether reads are served by the frozen layout
    */
-  bool PostLeafMergeNode(const NodeSnapshot *snapshot_p,
-                         const KeyType *merge_key_p,
-                         const BaseNode *merge_branch_p,
-                         NodeID deleted_node_id,
-                         const BaseNode **node_p_p) {
-    // This is the child node of merge delta
-    const BaseNode *node_p = snapshot_p->node_p;
-    NodeID node_id = snapshot_p->node_id;
-
-    // Must allocate on merge_branch_p, otherwise when recycle this
-    // delta chain, node_p is reclaimed first and then merge_branch_p,
-    // so if we allocate it on node_p, we will get an invalid reference
-    // for the second recursive call
-    const LeafMergeNode *merge_node_p = \
-      InnerInlineAllocateOfType(LeafMergeNode, 
-                                merge_branch_p,
-                                *merge_key_p,
-                                merge_branch_p,
-                                deleted_node_id,
-                                node_p);
-
-    // Compare and Swap!
-    bool ret = InstallNodeToReplace(node_id, merge_node_p, node_p);
-
-    // If CAS fails we delete the node and return false
-    if(ret == false) {
-      merge_node_p->~LeafMergeNode();
-    } else {
-      *node_p_p = merge_node_p;
+  inline bool IsFrozen() {
+    return frozen_layout_p.load() != nullptr;
+  }
+  
+  /*
+   * ThawIfFrozen() - Thaws the tree before it is modified
+   *
+   * This is called by all writers, and only costs one load of a shared
+   * cache line that does not change while the tree is not frozen
+   */
+  inline void ThawIfFrozen() {
+    if(frozen_layout_p.load() != nullptr) {
+      Thaw();
     }
-
-    return ret;
+    
+    return;
   }
-
+  
   /*
-   * Insert() - Insert a key-value pair
+   * FreeRetiredLayout() - Frees thawed layouts that are no longer read
    *
-   * This function returns false if value already exists
-   * If CAS fails this function retries until it succeeds
+   * If force is true then all of them are freed, which is only safe when
+   * no other thread uses the tree
    */
-  bool Insert(const KeyType &key, const ValueType &value) {
-    bwt_printf("Insert called\n");
-
-    #ifdef BWTREE_DEBUG
-    insert_op_count.fetch_add(1);
-    #endif
-
-    EpochNode *epoch_node_p = epoch_manager.JoinEpoch();
-    bwt_printf("JoinEpoch called\n");
-
-    while(1) {
-      Context context{key};
-      std::pair<int, bool> index_pair;
-
-      // Check whether the key-value pair exists
-      // Also if the key previously exists in the delta chain
-      // then return the position of the node using next_key_p
-      // if there is none then return nullptr
-      const KeyValuePair *item_p = Traverse(&context, &value, &index_pair);
-
-      // If the key-value pair already exists then return false
-      if (item_p != nullptr) {
-        epoch_manager.LeaveEpoch(epoch_node_p);
-
-        return false;
-      }
-
-      NodeSnapshot *snapshot_p = GetLatestNodeSnapshot(&context);
-
-      // We will CAS on top of this
-      const BaseNode *node_p = snapshot_p->node_p;
-      NodeID node_id = snapshot_p->node_id;
-
-      const LeafInsertNode *insert_node_p = \
-        LeafInlineAllocateOfType(LeafInsertNode, 
-                                 node_p, 
-                                 key, 
-                                 value, 
-                                 node_p, 
-                                 index_pair);
-
-      bool ret = InstallNodeToReplace(node_id,
-                                      insert_node_p,
-                                      node_p);
-      if(ret == true) {
-        bwt_printf("Leaf Insert delta CAS succeed\n");
-
-        // If install is a success then just break from the loop
-        // and return
-        break;
-      } else {
-        bwt_printf("Leaf insert delta CAS failed\n");
-
-        #ifdef BWTREE_DEBUG
-
-        context.abort_counter++;
+  void FreeRetiredLayout(bool force) {
+    std::lock_guard<std::mutex> guard{retired_layout_lock};
+    
+    uint64_t min_epoch = SummarizeGCEpoch();
+    
+    FrozenLayout *head_p = retired_layout_p.load();
+    FrozenLayout **prev_p_p = &head_p;
+    while(*prev_p_p != nullptr) {
+      FrozenLayout *layout_p = *prev_p_p;
+      
+      if((force == true) || (layout_p->delete_epoch < min_epoch)) {
+        *prev_p_p = layout_p->next_p;
         
-        #endif
-
-        insert_node_p->~LeafInsertNode();
+        delete layout_p;
+      } else {
+        prev_p_p = &layout_p->next_p;
       }
-
-      #ifdef BWTREE_DEBUG
-      
-      // Update abort counter
-      // NOTE 1: We could not do this before return since the context
-      // object is cleared at the end of loop
-      // NOTE 2: Since Traverse() might abort due to other CAS failures
-      // context.abort_counter might be larger than 1 when
-      // LeafInsertNode installation fails
-      insert_abort_count.fetch_add(context.abort_counter);
-      
-      #endif
-
-      // We reach here only because CAS failed
-      bwt_printf("Retry installing leaf insert delta from the root\n");
     }
-
-    epoch_manager.LeaveEpoch(epoch_node_p);
-
-    return true;
+    
+    retired_layout_p.store(head_p);
+    
+    return;
   }
-
-#ifdef BWTREE_PELOTON
-
+  
   /*
-   * ConditionalInsert() - Insert a key-value pair only if a given
-   *                       predicate fails for all values with a key
+   * SetMergeThreshold() - Sets the sizes at or below which leaf and inner
+   *                       nodes are merged into their left siblings
    *
-   * If return true then the value has been inserted
-   * If return false then the value is not inserted. The reason could be
-   * predicates returning true for one of the values of a given key
-   * or because the value is already in the index
+   * Merged nodes have roughly the size of both nodes, so if the threshold
+   * is close to half of the split threshold then a few inserts after a
+   * merge split the node again. A lower threshold widens the gap between
+   * merge and split, at the cost of keeping more underfull nodes
    *
-   * NOTE: We first test the predicate, and then test for duplicated values
-   * so predicate test result is always available
+   * Both halves of a split node must stay above the merge threshold,
+   * otherwise a split could be followed by a merge right away. If either
+   * threshold does not leave that gap then nothing is changed and false
+   * is returned
+   *
+   * NOTE: This should be called before the tree is shared by threads
    */
-  bool ConditionalInsert(const KeyType &key,
-                         const ValueType &value,
-                         std::function<bool(const void *)> predicate,
-                         bool *predicate_satisfied) {
-    bwt_printf("Insert (cond.) called\n");
-
-    #ifdef BWTREE_DEBUG
-    insert_op_count.fetch_add(1);
-    #endif
-
-    EpochNode *epoch_node_p = epoch_manager.JoinEpoch();
-
-    while(1) {
-      Context context{key};
-
-      // This will just stop on the correct leaf page
-      // without traversing into it. Next we manually traverse
-      Traverse(&context, nullptr, nullptr);
-
-      *predicate_satisfied = false;
-      
-      // This is used to hold the index for which this delta will
-      // be applied to
-      std::pair<int, bool> index_pair;
-
-      // Call navigate leaf node to test predicate and to test duplicates
-      const KeyValuePair *item_p = \
-        NavigateLeafNode(&context,
-                         value,
-                         &index_pair,
-                         predicate,
-                         predicate_satisfied);
-      
-      // We do not insert anything if predicate is satisfied
-      if(*predicate_satisfied == true) {
-        epoch_manager.LeaveEpoch(epoch_node_p);
-        
-        return false;
-      } else if(item_p != nullptr) {
-        epoch_manager.LeaveEpoch(epoch_node_p);
-        
-        return false;
-      }
-
-      // This retrieves the most up-to-date snapshot (which does not change)
-      NodeSnapshot *snapshot_p = GetLatestNodeSnapshot(&context);
+  bool SetMergeThreshold(size_t leaf_threshold, size_t inner_threshold) {
+    if((2 * (leaf_threshold + 1) > (size_t)LEAF_NODE_SIZE_UPPER_THRESHOLD) ||
+       (2 * (inner_threshold + 1) > (size_t)INNER_NODE_SIZE_UPPER_THRESHOLD)) {
+      bwt_printf("Merge threshold (%lu, %lu) is too close to split threshold\n",
+                 leaf_threshold,
+                 inner_threshold);
 
-      // We will CAS on top of this
-      const BaseNode *node_p = snapshot_p->node_p;
-      NodeID node_id = snapshot_p->node_id;
+      return false;
+    }
 
-      // Here since we could not know which is the next key node
-      // just use child node as a cpnservative way of inserting
-      const LeafInsertNode *insert_node_p = \
-        LeafInlineAllocateOfType(LeafInsertNode, 
-                                 node_p, 
-                                 key, 
-                                 value, 
-                                 node_p, 
-                                 index_pair);
+    leaf_merge_threshold = leaf_threshold;
+    inner_merge_threshold = inner_threshold;
 
-      bool ret = InstallNodeToReplace(node_id,
-                                      insert_node_p,
-                                      node_p);
-      if(ret == true) {
-        bwt_printf("Leaf Insert (cond.) delta CAS succeed\n");
+    return true;
+  }
 
-        // If install is a success then just break from the loop
-        // and return
-        break;
-      } else {
-        bwt_printf("Leaf insert (cond.) delta CAS failed\n");
+  /*
+   * SetDeferLeafMerge() - Sets whether merges of underfull leaves are
+   *                       deferred
+   *
+   * In workloads that delete old keys and insert new ones, underfull leaves
+   * are often refilled soon, and merging them right away only leads to
+   * another split. Deferred leaves are remembered by the thread that saw
+   * them underfull and are merged in key order when the queues of all
+   * threads are processed, such that adjacent underfull leaves are merged into the
+   * same left sibling one after another. This is done by MergeDeferredNodes()
+   * and Cleanup(), and by writers as the epoch advances (see
+   * SetDeferredMergeInterval())
+   *
+   * NOTE: This should be called before the tree is shared by threads
+   */
+  void SetDeferLeafMerge(bool p_defer_leaf_merge) {
+    defer_leaf_merge = p_defer_leaf_merge;
 
-        #ifdef BWTREE_DEBUG
+    return;
+  }
 
-        context.abort_counter++;
-        
-        #endif
+  /*
+   * SetDeferredMergeInterval() - Sets the number of epochs after which
+   *                              deferred merges are processed by the
+   *                              next write operation
+   *
+   * Epochs are advanced by the GC thread, so with the default interval
+   * underfull leaves are merged a few hundred milliseconds after they are
+   * queued. 0 leaves it to MergeDeferredNodes() and Cleanup()
+   *
+   * NOTE: This should be called before the tree is shared by threads
+   */
+  void SetDeferredMergeInterval(uint64_t epoch_count) {
+    deferred_merge_interval = epoch_count;
 
-        insert_node_p->~LeafInsertNode();
-      }
+    return;
+  }
 
-      #ifdef BWTREE_DEBUG
+  /*
+   * SetAppendSplitPercent() - Sets the percentage of items kept in the
+   *                           left node when a leaf is split while keys
+   *                           are appended to it
+   *
+   * A leaf is split this way if the key being inserted is greater than
+   * all keys in the leaf, which is always the case for sequential keys
+   * such as timestamps. Leaves then stay mostly full instead of half full,
+   * and there are fewer splits. 50 disables skewed splits
+   *
+   * NOTE: This should be called before the tree is shared by threads
+   */
+  void SetAppendSplitPercent(int percent) {
+    assert((percent >= 50) && (percent < 100));
 
-      insert_abort_count.fetch_add(context.abort_counter);
-      
-      #endif
+    leaf_append_split_percent = percent;
 
-      bwt_printf("Retry installing leaf insert (cond.) delta from the root\n");
-    }
+    return;
+  }
 
-    epoch_manager.LeaveEpoch(epoch_node_p);
+  /*
+   * SetContentionSplitThreshold() - Sets the decayed number of CAS failures
+   *                                 at which a leaf is split
+   *
+   * A few hot leaves might take most CAS failures of leaf updates without
+   * growing over the split threshold. Splitting them puts their writers on
+   * two mapping table entries. Counts are halved on every epoch, so the
+   * threshold is a rate of failures rather than a total. A leaf is only
+   * split this way if both halves stay above the merge threshold. 0
+   * disables contention splits
+   *
+   * NOTE: This should be called before the tree is shared by threads
+   */
+  void SetContentionSplitThreshold(size_t threshold) {
+    contention_split_threshold = threshold;
 
-    return true;
+    return;
   }
 
-#endif
+  /*
+   * SetBackoffLimit() - Sets the longest spin after a failed leaf data CAS
+   *
+   * Retries after a failure spin from BACKOFF_MIN_SPIN_COUNT up to this
+   * number of pauses, doubling each time, and then only yield. 0 disables
+   * backoff, i.e. retries start immediately
+   *
+   * NOTE: This should be called before the tree is shared by threads
+   */
+  void SetBackoffLimit(size_t max_spin_count) {
+    backoff_max_spin_count = max_spin_count;
 
+    return;
+  }
 
   /*
-   * Delete() - Remove a key-value pair from the tree
+   * MergeDeferredNodes() - Merges leaves queued by all threads, including
+   *                        threads that have been unregistered
    *
-   * This function returns false if the key and value pair does not
-   * exist. Return true if delete succeeds
+   * Leaves that are no longer underfull, or have been removed or recycled,
+   * are skipped. The former are counted as avoided merges. Returns the
+   * number of leaves for which a merge is attempted
    *
-   * This functions shares a same structure with the Insert() one
+   * NOTE: The calling thread must have a GC ID as for all other operations
    */
-  bool Delete(const KeyType &key, const ValueType &value) {
-    bwt_printf("Delete called\n");
+  size_t MergeDeferredNodes() {
+    last_deferred_merge_epoch.store(GetGlobalEpoch());
 
-    #ifdef BWTREE_DEBUG
-    delete_op_count.fetch_add(1);
-    #endif
+    DeferredMergeSet merge_set{};
+    TakeDeferredMergeSet(&merge_set);
 
-    EpochNode *epoch_node_p = epoch_manager.JoinEpoch();
+    if(merge_set.empty() == true) {
+      return 0UL;
+    }
 
-    while(1) {
-      Context context{key};
-      std::pair<int, bool> index_pair;
+    // Low keys are copied since nodes might be freed after we leave
+    // the epoch
+    std::vector<std::pair<KeyType, NodeID>> candidate_list{};
 
-      // Navigate leaf nodes to check whether the key-value
-      // pair exists
-      const KeyValuePair *item_p = Traverse(&context, &value, &index_pair);
+    EpochNode *epoch_node_p = epoch_manager.JoinEpoch();
 
-      if(item_p == nullptr) {
-        epoch_manager.LeaveEpoch(epoch_node_p);
+    for(NodeID node_id : merge_set) {
+      const BaseNode *node_p = GetNode(node_id);
 
-        return false;
+      // The left most leaf is never removed and does not have a low key
+      if((node_p == nullptr) ||
+         (node_id == first_leaf_id) ||
+         (node_p->IsOnLeafDeltaChain() == false) ||
+         (node_p->GetType() == NodeType::LeafRemoveType)) {
+        continue;
       }
 
-      NodeSnapshot *snapshot_p = GetLatestNodeSnapshot(&context);
-
-      // We will CAS on top of this
-      const BaseNode *node_p = snapshot_p->node_p;
-      NodeID node_id = snapshot_p->node_id;
-
-      const LeafDeleteNode *delete_node_p = \
-        LeafInlineAllocateOfType(LeafDeleteNode, 
-                                 node_p, 
-                                 key, 
-                                 value, 
-                                 node_p, 
-                                 index_pair);
-
-      bool ret = InstallNodeToReplace(node_id,
-                                      delete_node_p,
-                                      node_p);
-      if(ret == true) {
-        bwt_printf("Leaf Delete delta CAS succeed\n");
-
-        // If install is a success then just break from the loop
-        // and return
-        break;
-      } else {
-        bwt_printf("Leaf Delete delta CAS failed\n");
+      if(static_cast<size_t>(node_p->GetItemCount()) > leaf_merge_threshold) {
+        GetCurrentOperationCounter()->avoided_merge_count++;
 
-        delete_node_p->~LeafDeleteNode();
+        continue;
+      }
 
-        #ifdef BWTREE_DEBUG
+      // Sizes are only adjusted on base nodes
+      ConsolidateDataDeltaChain(node_id, node_p);
 
-        context.abort_counter++;
-        
-        #endif
-      }
+      candidate_list.push_back(std::make_pair(node_p->GetLowKey(), node_id));
+    }
 
-      #ifdef BWTREE_DEBUG
+    // Merge from left to right, such that a run of adjacent underfull
+    // leaves is merged into the same left sibling
+    std::sort(candidate_list.begin(),
+              candidate_list.end(),
+              [this](const std::pair<KeyType, NodeID> &a,
+                     const std::pair<KeyType, NodeID> &b) {
+                return KeyCmpLess(a.first, b.first);
+              });
 
-      delete_abort_count.fetch_add(context.abort_counter);
-      
-      #endif
+    for(const std::pair<KeyType, NodeID> &candidate : candidate_list) {
+      // This traversal removes the leaf holding the low key if it is
+      // still underfull, and helps along the merge after it aborts
+      Context context{candidate.first};
+      context.merge_now = true;
 
-      // We reach here only because CAS failed
-      bwt_printf("Retry installing leaf delete delta from the root\n");
+      Traverse(&context, nullptr, nullptr);
     }
 
     epoch_manager.LeaveEpoch(epoch_node_p);
 
-    return true;
+    return candidate_list.size();
   }
 
   /*
-   * GetValue() - Fill a value list with values stored
-   *
-   * This function accepts a value list as argument,
-   * and will copy all values into the list
+   * TryMergeDeferredNodes() - Processes deferred merges if the epoch has
+   *                           advanced enough since they were last
+   *                           processed
    *
-   * The return value is used to indicate whether the value set
-   * is empty or not
+   * This is called by write operations before they join the epoch, since
+   * merges are done by traversals of their own. Only one thread processes
+   * deferred merges for each interval
    */
-  void GetValue(const KeyType &search_key,
-                std::vector<ValueType> &value_list) {
-    bwt_printf("GetValue()\n");
+  void TryMergeDeferredNodes() {
+    if((defer_leaf_merge == false) || (deferred_merge_interval == 0UL)) {
+      return;
+    }
 
-    EpochNode *epoch_node_p = epoch_manager.JoinEpoch();
+    uint64_t current_epoch = GetGlobalEpoch();
+    uint64_t last_epoch = last_deferred_merge_epoch.load();
+    if(current_epoch - last_epoch < deferred_merge_interval) {
+      return;
+    }
 
-    Context context{search_key};
+    // Threads without a GC ID could not do traversals that remove nodes
+    if((gc_id < 0) || (gc_id >= static_cast<int>(thread_num))) {
+      return;
+    }
 
-    TraverseReadOptimized(&context, &value_list);
+    // The thread failing the CAS leaves it to the one that succeeded
+    if(last_deferred_merge_epoch.compare_exchange_strong(last_epoch,
+                                                         current_epoch) == \
+       false) {
+      return;
+    }
 
-    epoch_manager.LeaveEpoch(epoch_node_p);
+    MergeDeferredNodes();
 
     return;
   }
 
+  ///////////////////////////////////////////////////////////////////
+  // Tree Introspection Interface
+  ///////////////////////////////////////////////////////////////////
+  
+  // Number of buckets in fill factor and fanout histograms; bucket i
+  // covers [i / N, (i + 1) / N) of the split threshold, and the last
+  // bucket also holds nodes at or above the threshold
+  static constexpr int FILL_HISTOGRAM_BUCKET_COUNT = 10;
+  
+  // AnalyzeTree() leaves and rejoins the epoch after visiting this many
+  // mapping table entries, such that a long walk does not block GC
+  static constexpr NodeID ANALYZE_EPOCH_INTERVAL = 4096;
+  
   /*
-   * GetValue() - Return value in a ValueSet object
+   * class TreeAnalysis - Shape of the tree returned by AnalyzeTree()
    *
-   * This is used for verification in the benchmark test suite. Do not
-   * remove this method
+   * If a sample stride larger than 1 is used then all node counts and
+   * histograms only cover sampled NodeIDs, and should be multiplied by
+   * sample_stride to estimate the whole tree. Height and NodeID counters
+   * are always exact
    */
-  ValueSet GetValue(const KeyType &search_key) {
-    bwt_printf("GetValue()\n");
-
-    EpochNode *epoch_node_p = epoch_manager.JoinEpoch();
-
-    Context context{search_key};
-
-    std::vector<ValueType> value_list{};
-    TraverseReadOptimized(&context, &value_list);
-
-    epoch_manager.LeaveEpoch(epoch_node_p);
-
-    ValueSet value_set{value_list.begin(),
-                       value_list.end(),
-                       10,
-                       value_hash_obj,
-                       value_eq_obj};
-
-    return value_set;
-  }
+  class TreeAnalysis {
+   public:
+    // Number of levels including the leaf level
+    int height;
+    
+    // Only every sample_stride-th NodeID is visited
+    size_t sample_stride;
+    
+    // Live inner and leaf nodes (i.e. not removed) visited
+    size_t inner_node_count;
+    size_t leaf_node_count;
+    
+    // Separators on inner nodes and key-value pairs on leaf nodes
+    size_t inner_item_count;
+    size_t leaf_item_count;
+    
+    // Histogram of inner node fanout and leaf node fill factor relative
+    // to INNER_NODE_SIZE_UPPER_THRESHOLD and LEAF_NODE_SIZE_UPPER_THRESHOLD
+    size_t inner_fanout_histogram[FILL_HISTOGRAM_BUCKET_COUNT];
+    size_t leaf_fill_histogram[FILL_HISTOGRAM_BUCKET_COUNT];
+    
+    // Element i is the number of nodes whose delta chain has i records
+    std::vector<size_t> delta_depth_histogram;
+    
+    // Nodes having SMO delta records on their delta chain
+    size_t split_delta_count;
+    size_t merge_delta_count;
+    size_t abort_delta_count;
+    
+    // Nodes that have been removed but not yet merged into the left sibling
+    size_t remove_delta_count;
+    
+    // NodeIDs handed out so far, mapping table entries that are not empty,
+    // and the capacity of the mapping table
+    size_t allocated_node_id_count;
+    size_t mapped_node_count;
+    size_t mapping_table_capacity;
+    
+    // NodeIDs reserved or recycled but not yet handed out; these are
+    // included in allocated_node_id_count
+    size_t free_node_id_count;
+    
+    /*
+     * Default constructor
+     */
+    TreeAnalysis() :
+      height{0},
+      sample_stride{1UL},
+      inner_node_count{0UL},
+      leaf_node_count{0UL},
+      inner_item_count{0UL},
+      leaf_item_count{0UL},
+      inner_fanout_histogram{},
+      leaf_fill_histogram{},
+      delta_depth_histogram{},
+      split_delta_count{0UL},
+      merge_delta_count{0UL},
+      abort_delta_count{0UL},
+      remove_delta_count{0UL},
+      allocated_node_id_count{0UL},
+      mapped_node_count{0UL},
+      mapping_table_capacity{0UL},
+      free_node_id_count{0UL}
+    {}
+    
+    /*
+     * GetAverageLeafFill() - Returns average items per leaf over the
+     *                        split threshold
+     */
+    double GetAverageLeafFill() const {
+      if(leaf_node_count == 0UL) {
+        return 0.0;
+      }
+      
+      return static_cast<double>(leaf_item_count) / \
+             static_cast<double>(leaf_node_count) / \
+             static_cast<double>(LEAF_NODE_SIZE_UPPER_THRESHOLD);
+    }
+    
+    /*
+     * GetAverageFanout() - Returns average children per inner node
+     */
+    double GetAverageFanout() const {
+      if(inner_node_count == 0UL) {
+        return 0.0;
+      }
+      
+      return static_cast<double>(inner_item_count) / \
+             static_cast<double>(inner_node_count);
+    }
+  };
   
-  ///////////////////////////////////////////////////////////////////
-  // Garbage Collection Interface
-  ///////////////////////////////////////////////////////////////////
+  /*
+   * GetFillHistogramBucket() - Returns the histogram bucket of a node size
+   */
+  static int GetFillHistogramBucket(int item_count, int threshold) {
+    int bucket = item_count * FILL_HISTOGRAM_BUCKET_COUNT / threshold;
+    
+    if(bucket >= FILL_HISTOGRAM_BUCKET_COUNT) {
+      return FILL_HISTOGRAM_BUCKET_COUNT - 1;
+    } else if(bucket < 0) {
+      return 0;
+    }
+    
+    return bucket;
+  }
   
   /*
-   * NeedGarbageCollection() - Whether the tree needs garbage collection
+   * GetTreeHeight() - Returns the number of levels by going down the left
+   *                   most path
    *
-   * Ideally, if there is no modification workload on BwTree from the last
-   * time GC was called, then GC is unnecessary since read operation does not
-   * modify any data structure
+   * The left most child of an inner node never changes, since the left
+   * most node on each level could not be removed. So the left most child
+   * could be read from the base node without consolidating the chain
    *
-   * Currently we just leave the interface as a placeholder, which returns true
-   * everytime to force GC thred to at least take a look into the epoch
-   * counter.
+   * This must be called inside an epoch
    */
-  //bool NeedGarbageCollection() {
-  //  return true;
-  //}
+  int GetTreeHeight() {
+    int height = 1;
+    const BaseNode *node_p = GetNode(root_id.load());
+    
+    while(1) {
+      while(node_p->IsDeltaNode() == true) {
+        node_p = static_cast<const DeltaNode *>(node_p)->child_node_p;
+      }
+      
+      if(node_p->GetType() == NodeType::LeafType) {
+        break;
+      }
+      
+      const InnerNode *inner_node_p = static_cast<const InnerNode *>(node_p);
+      
+      node_p = GetNode(inner_node_p->At(0).second);
+      height++;
+    }
+    
+    return height;
+  }
   
   /*
-   * PerformGarbageCollection() - Interface function for external users to
-   *                              force a garbage collection
+   * AnalyzeTree() - Returns tree height, node size and delta chain
+   *                 statistics
    *
-   * This function is a wrapper to the internal GC thread function. Since
-   * users could choose whether to let BwTree handle GC by itself or to
-   * control GC using external threads. This function is left as a convenient
-   * interface for external threads to do garbage collection.
+   * This function scans the mapping table and reads each node without
+   * modifying anything; no help-along or consolidation is done. The
+   * epoch is rejoined periodically, so it could be run by a monitoring
+   * thread concurrently with worker threads. Since nodes are changing in
+   * the meantime the result is not a consistent snapshot
+   *
+   * For very large trees a sample_stride larger than 1 could be passed,
+   * in which case only NodeIDs 1, 1 + stride, 1 + 2 * stride, ... are 
+   * visited. See class TreeAnalysis for how to interpret the result
+   *
+   * NOTE: The calling thread must have a GC ID as for all other operations
    */
-  //void PerformGarbageCollection() {
-    // This function creates a new epoch node, and then checks
-    // epoch counter for exiatsing nodes.
-  //  epoch_manager.PerformGarbageCollection();
-
-  //  return;
-  //}
+  TreeAnalysis AnalyzeTree(size_t sample_stride = 1UL) {
+    bwt_printf("AnalyzeTree()\n");
+    
+    TreeAnalysis analysis{};
+    
+    if(sample_stride == 0UL) {
+      sample_stride = 1UL;
+    }
+    
+    NodeID node_id_end = next_unused_node_id.load();
+    
+    analysis.sample_stride = sample_stride;
+    analysis.allocated_node_id_count = node_id_end - 1;
+    analysis.mapping_table_capacity = MAPPING_TABLE_SIZE;
+    analysis.free_node_id_count = SummarizeFreeNodeID();
+    
+    EpochNode *epoch_node_p = epoch_manager.JoinEpoch();
+    
+    analysis.height = GetTreeHeight();
+    
+    NodeID visited_count = 0;
+    for(NodeID node_id = 1; 
+        node_id < node_id_end; 
+        node_id += sample_stride) {
+      visited_count++;
+      if((visited_count % ANALYZE_EPOCH_INTERVAL) == 0) {
+        epoch_manager.LeaveEpoch(epoch_node_p);
+        epoch_node_p = epoch_manager.JoinEpoch();
+      }
+      
+      const BaseNode *node_p = GetNode(node_id);
+      if(node_p == nullptr) {
+        continue;
+      }
+      
+      analysis.mapped_node_count++;
+      
+      // Removed nodes are no longer part of the tree, and their size
+      // is counted on the left sibling after the merge
+      if(node_p->IsRemoveNode() == true) {
+        analysis.remove_delta_count++;
+        
+        continue;
+      }
+      
+      size_t depth = static_cast<size_t>(node_p->GetDepth());
+      if(depth >= analysis.delta_depth_histogram.size()) {
+        analysis.delta_depth_histogram.resize(depth + 1, 0UL);
+      }
+      
+      analysis.delta_depth_histogram[depth]++;
+      
+      // The item count on top of the chain is the logical size of the node
+      int item_count = node_p->GetItemCount();
+      if(node_p->IsOnLeafDeltaChain() == true) {
+        analysis.leaf_node_count++;
+        analysis.leaf_item_count += item_count;
+        analysis.leaf_fill_histogram[
+          GetFillHistogramBucket(item_count, 
+                                 LEAF_NODE_SIZE_UPPER_THRESHOLD)]++;
+      } else {
+        analysis.inner_node_count++;
+        analysis.inner_item_count += item_count;
+        analysis.inner_fanout_histogram[
+          GetFillHistogramBucket(item_count, 
+                                 INNER_NODE_SIZE_UPPER_THRESHOLD)]++;
+      }
+      
+      // Each kind of SMO is counted at most once for a node
+      bool has_split = false;
+      bool has_merge = false;
+      bool has_abort = false;
+      while(node_p->IsDeltaNode() == true) {
+        switch(node_p->GetType()) {
+          case NodeType::LeafSplitType:
+          case NodeType::InnerSplitType:
+            has_split = true;
+            break;
+          case NodeType::LeafMergeType:
+          case NodeType::InnerMergeType:
+            has_merge = true;
+            break;
+          case NodeType::InnerAbortType:
+            has_abort = true;
+            break;
+          default:
+            break;
+        }
+        
+        node_p = static_cast<const DeltaNode *>(node_p)->child_node_p;
+      }
+      
+      analysis.split_delta_count += (has_split == true) ? 1 : 0;
+      analysis.merge_delta_count += (has_merge == true) ? 1 : 0;
+      analysis.abort_delta_count += (has_abort == true) ? 1 : 0;
+    }
+    
+    epoch_manager.LeaveEpoch(epoch_node_p);
+    
+    return analysis;
+  }
 
  /*
   * Private Method Implementation
@@ -7765,9 +11700,46 @@ before_switch:
   std::atomic<NodeID> next_unused_node_id;
   std::array<std::atomic<const BaseNode *>, MAPPING_TABLE_SIZE> mapping_table;
 
-  // This list holds free NodeID which was removed by remove delta
-  // We recycle NodeID in epoch manager
-  AtomicStack<NodeID, MAPPING_TABLE_SIZE> free_node_id_list;
+  // Nodes at or below these sizes are removed and merged into the left
+  // sibling. See SetMergeThreshold()
+  size_t leaf_merge_threshold;
+  size_t inner_merge_threshold;
+
+  // Whether underfull leaves are queued rather than removed immediately
+  bool defer_leaf_merge;
+
+  // See SetDeferredMergeInterval()
+  uint64_t deferred_merge_interval;
+
+  // Epoch at which deferred merges were last processed by a writer. The
+  // thread that advances it processes them
+  std::atomic<uint64_t> last_deferred_merge_epoch;
+
+  // Percentage of items kept in the left node when splitting a leaf that
+  // keys are appended to. See SetAppendSplitPercent()
+  int leaf_append_split_percent;
+
+  // CAS failures of leaf data deltas hashed by NodeID. Counters are halved
+  // on every epoch (see DecayContention()), so they measure recent
+  // contention rather than the lifetime of the leaf, and consolidation
+  // does not affect them. Different leaves might share a counter, so it is
+  // only a hint for splitting hot leaves
+  std::array<std::atomic<uint32_t>, CONTENTION_TABLE_SIZE> contention_table;
+
+  // See SetContentionSplitThreshold()
+  size_t contention_split_threshold;
+
+  // See SetBackoffLimit()
+  size_t backoff_max_spin_count;
+
+  // Reads are served by this if it is not nullptr. See Freeze()
+  std::atomic<FrozenLayout *> frozen_layout_p;
+
+  // Thawed layouts that might still be read. See Thaw(). The list is
+  // only changed while holding the lock, and PerformGC() checks whether
+  // it is empty without the lock
+  std::atomic<FrozenLayout *> retired_layout_p;
+  std::mutex retired_layout_lock;
 
   std::atomic<uint64_t> insert_op_count;
   std::atomic<uint64_t> insert_abort_count;
@@ -8134,6 +12106,35 @@ try_join_again:
       return;
     }
     
+    /*
+     * PinEpoch() - Join the epoch and keep it until UnpinEpoch() is called
+     *
+     * With the old epoch scheme this is identical to JoinEpoch(), since
+     * the epoch node is protected as long as its counter is not zero
+     */
+    inline EpochNode *PinEpoch() {
+      return JoinEpoch();
+    }
+    
+    /*
+     * UnpinEpoch() - Releases an epoch returned by PinEpoch()
+     */
+    inline void UnpinEpoch(EpochNode *epoch_p) {
+      LeaveEpoch(epoch_p);
+      
+      return;
+    }
+    
+    /*
+     * AdvancePinnedEpoch() - Each pin has its own epoch node with the old
+     *                        scheme, so there is nothing to advance
+     */
+    inline void AdvancePinnedEpoch(uint64_t p_epoch) {
+      (void)p_epoch;
+      
+      return;
+    }
+    
     /*
      * PerformGarbageCollection() - Actual job of GC is done here
      *
@@ -8159,19 +12160,56 @@ try_join_again:
       return;
     }
     
-    inline EpochNode *JoinEpoch() {
+    inline EpochNode *JoinEpoch() {
+      tree_p->UpdateLastActiveEpoch();
+      
+      return nullptr;
+    }
+    
+    inline void LeaveEpoch(EpochNode *epoch_p) {
+      tree_p->UpdateLastActiveEpoch();
+      
+      (void)epoch_p;
+      return;
+    }
+    
+    /*
+     * PinEpoch() - Refreshes the thread local epoch and then freezes it
+     *              until UnpinEpoch() is called
+     *
+     * Unlike JoinEpoch()/LeaveEpoch(), which could be interleaved with
+     * other operations on the tree, a pinned epoch keeps all nodes observed
+     * after this call alive even if the thread performs other operations,
+     * as long as they are done on the same thread
+     */
+    inline EpochNode *PinEpoch() {
       tree_p->UpdateLastActiveEpoch();
+      tree_p->PinLastActiveEpoch();
       
       return nullptr;
     }
     
-    inline void LeaveEpoch(EpochNode *epoch_p) {
+    /*
+     * UnpinEpoch() - Releases a pin and refreshes the thread local epoch
+     */
+    inline void UnpinEpoch(EpochNode *epoch_p) {
+      tree_p->UnpinLastActiveEpoch();
       tree_p->UpdateLastActiveEpoch();
       
       (void)epoch_p;
       return;
     }
     
+    /*
+     * AdvancePinnedEpoch() - Moves a pinned thread local epoch forward when
+     *                        no reference older than the epoch is held
+     */
+    inline void AdvancePinnedEpoch(uint64_t p_epoch) {
+      tree_p->AdvancePinnedEpoch(p_epoch);
+      
+      return;
+    }
+    
     inline void PerformGarbageCollection() {
       tree_p->IncreaseEpoch();
       
@@ -8250,6 +12288,8 @@ try_join_again:
             tree_p->InvalidateNodeID(((LeafRemoveNode *)node_p)->removed_id);
 
             delete ((LeafRemoveNode *)node_p);
+            tree_p->GetCurrentMemoryCounter()->delta_size -= \
+              sizeof(LeafRemoveNode);
 
             #ifdef BWTREE_DEBUG
             freed_count++;
@@ -8262,7 +12302,7 @@ try_join_again:
             return;
           case NodeType::LeafType:
             ((LeafNode *)node_p)->~LeafNode();
-            ((LeafNode *)node_p)->Destroy();
+            tree_p->DestroyElasticNode((LeafNode *)node_p);
 
             #ifdef BWTREE_DEBUG
             freed_count++;
@@ -8319,6 +12359,8 @@ try_join_again:
             tree_p->InvalidateNodeID(((InnerRemoveNode *)node_p)->removed_id);
 
             delete ((InnerRemoveNode *)node_p);
+            tree_p->GetCurrentMemoryCounter()->delta_size -= \
+              sizeof(InnerRemoveNode);
 
             #ifdef BWTREE_DEBUG
             freed_count++;
@@ -8329,7 +12371,7 @@ try_join_again:
             return;
           case NodeType::InnerType:
             ((InnerNode *)node_p)->~InnerNode();
-            ((InnerNode *)node_p)->Destroy();
+            tree_p->DestroyElasticNode((InnerNode *)node_p);
 
             #ifdef BWTREE_DEBUG
             freed_count++;
@@ -8343,6 +12385,8 @@ try_join_again:
             // list (if we delete it directly then this will be
             // a problem)
             delete ((InnerAbortNode *)node_p);
+            tree_p->GetCurrentMemoryCounter()->delta_size -= \
+              sizeof(InnerAbortNode);
 
             #ifdef BWTREE_DEBUG
             freed_count++;
@@ -8458,42 +12502,550 @@ try_join_again:
     }
 
     /*
-     * ThreadFunc() - The cleaner thread executes this every GC_INTERVAL ms
-     *
-     * This function exits when exit flag is set to true
+     * ThreadFunc() - The cleaner thread executes this every GC_INTERVAL ms
+     *
+     * This function exits when exit flag is set to true
+     */
+    void ThreadFunc() {
+      // While the parent is still running
+      // We do not worry about race condition here
+      // since even if we missed one we could always
+      // hit the correct value on next try
+      while(exited_flag.load() == false) {
+        //printf("Start new epoch cycle\n");
+        PerformGarbageCollection();
+
+        // Sleep for 50 ms
+        std::chrono::milliseconds duration(GC_INTERVAL);
+        std::this_thread::sleep_for(duration);
+      }
+
+      bwt_printf("exit flag is true; thread return\n");
+
+      return;
+    }
+
+    /*
+     * StartThread() - Start cleaner thread for garbage collection
+     *
+     * NOTE: This is not called in the constructor, and needs to be
+     * called manually
+     */
+    void StartThread() {
+      thread_p = new std::thread{[this](){this->ThreadFunc();}};
+
+      return;
+    }
+
+  }; // Epoch manager
+
+  ///////////////////////////////////////////////////////////////////
+  // Asynchronous Interface
+  ///////////////////////////////////////////////////////////////////
+
+  /*
+   * enum class AsyncOpType - Operations that could be run by AsyncExecutor
+   */
+  enum class AsyncOpType {
+    Read = 0,
+    Insert,
+    Delete,
+  };
+
+  class AsyncExecutor;
+
+  /*
+   * class AsyncOperation - A point operation that could be suspended on
+   *                        memory accesses
+   *
+   * A traversal mostly waits on two cache misses per level: the mapping
+   * table entry of the next NodeID and the node it points to. This class
+   * runs the read optimized traversal as a state machine, which issues a
+   * prefetch for the next of the two and then returns from Resume(), such
+   * that one thread could interleave many operations and overlap their
+   * cache misses. The epoch is pinned from the start of an operation to
+   * its end (see PinEpoch()), since a plain JoinEpoch() or LeaveEpoch() of
+   * any other operation on this thread would advance the epoch of the
+   * thread while this one still holds node pointers. Each operation also
+   * remembers the epoch it started in, and AsyncExecutor moves the pinned
+   * epoch to the oldest one of running operations, such that garbage is
+   * still freed while slots are kept busy
+   *
+   * Writes descend the same way to find the leaf, and then finish
+   * synchronously starting on that leaf (see InsertFromLeaf()), since
+   * helping along SMOs does not need to be interleaved
+   *
+   * NOTE: The context refers to the key stored in this object, so objects
+   * could neither be copied nor moved. KeyType and ValueType must be
+   * default constructible
+   */
+  class AsyncOperation {
+    friend class AsyncExecutor;
+    
+   public:
+    
+    /*
+     * enum class State - Where the next Resume() continues
+     */
+    enum class State {
+      // No operation is assigned
+      Idle = 0,
+      
+      // The operation is assigned but has not started
+      Start,
+      
+      // The mapping table entry of next_node_id has been prefetched
+      LoadMapping,
+      
+      // The node mapped by next_node_id has been prefetched
+      LoadNode,
+      
+      // The result is available
+      Done,
+    };
+    
+   private:
+    BwTree *tree_p;
+    
+    AsyncOpType type;
+    State state;
+    
+    KeyType key;
+    ValueType value;
+    
+    // The node that the traversal is loading
+    NodeID next_node_id;
+    
+    EpochNode *epoch_node_p;
+    
+    // Global epoch after the epoch is pinned. No node observed by this
+    // operation was unlinked before it
+    uint64_t start_epoch;
+    
+    // The context is constructed when the operation starts, since it
+    // refers to the key
+    alignas(Context) unsigned char context_buffer[sizeof(Context)];
+    
+    // For reads this is whether there is any value, and for writes this
+    // is the return value of Insert() or Delete()
+    bool result;
+    
+    // Values of the key found by a read. The vector is reused by all
+    // operations on this object
+    std::vector<ValueType> value_list;
+    
+   public:
+    
+    /*
+     * Default Constructor - The operation is idle until started
+     */
+    AsyncOperation() :
+      tree_p{nullptr},
+      type{AsyncOpType::Read},
+      state{State::Idle},
+      key{},
+      value{},
+      next_node_id{INVALID_NODE_ID},
+      epoch_node_p{nullptr},
+      start_epoch{0UL},
+      result{false},
+      value_list{}
+    {}
+    
+    /*
+     * Destructor - Operations must not be destroyed while they are running
+     */
+    ~AsyncOperation() {
+      assert((state == State::Idle) || (state == State::Done));
+    }
+    
+    AsyncOperation(const AsyncOperation &) = delete;
+    AsyncOperation &operator=(const AsyncOperation &) = delete;
+    AsyncOperation(AsyncOperation &&) = delete;
+    AsyncOperation &operator=(AsyncOperation &&) = delete;
+    
+    /*
+     * StartRead() - Assigns a lookup of all values of a key
+     */
+    void StartRead(BwTree *p_tree_p, const KeyType &p_key) {
+      Assign(p_tree_p, AsyncOpType::Read, p_key);
+      
+      return;
+    }
+    
+    /*
+     * StartInsert() - Assigns an insert of a key-value pair
+     */
+    void StartInsert(BwTree *p_tree_p,
+                     const KeyType &p_key,
+                     const ValueType &p_value) {
+      Assign(p_tree_p, AsyncOpType::Insert, p_key);
+      value = p_value;
+      
+      return;
+    }
+    
+    /*
+     * StartDelete() - Assigns a delete of a key-value pair
+     */
+    void StartDelete(BwTree *p_tree_p,
+                     const KeyType &p_key,
+                     const ValueType &p_value) {
+      Assign(p_tree_p, AsyncOpType::Delete, p_key);
+      value = p_value;
+      
+      return;
+    }
+    
+    /*
+     * Resume() - Runs the operation until the next prefetch
+     *
+     * Returns true if the operation has finished, after which the result
+     * could be read until the next operation is assigned
+     */
+    bool Resume() {
+      switch(state) {
+        case State::Start: {
+          epoch_node_p = tree_p->epoch_manager.PinEpoch();
+          start_epoch = tree_p->GetGlobalEpoch();
+          
+          new (context_buffer) Context{key};
+          GetContext()->read_optimized = true;
+          
+          if(type == AsyncOpType::Read) {
+            tree_p->GetCurrentOperationCounter()->read_count++;
+          }
+          
+          StartDescent();
+          
+          return false;
+        }
+        case State::LoadMapping: {
+          __builtin_prefetch(tree_p->GetNode(next_node_id));
+          
+          state = State::LoadNode;
+          
+          return false;
+        }
+        case State::LoadNode: {
+          VisitNode();
+          
+          return state == State::Done;
+        }
+        default: {
+          bwt_printf("Resume() on an idle or finished operation\n");
+          
+          assert(false);
+        }
+      }
+      
+      return true;
+    }
+    
+    /*
+     * GetType() - Returns the type of the current operation
+     */
+    inline AsyncOpType GetType() const {
+      return type;
+    }
+    
+    /*
+     * GetKey() - Returns the key of the current operation
+     */
+    inline const KeyType &GetKey() const {
+      return key;
+    }
+    
+    /*
+     * GetValue() - Returns the value of an insert or delete
+     */
+    inline const ValueType &GetValue() const {
+      return value;
+    }
+    
+    /*
+     * GetResult() - Returns whether a read found any value, or the
+     *               result of an insert or delete
+     */
+    inline bool GetResult() const {
+      assert(state == State::Done);
+      
+      return result;
+    }
+    
+    /*
+     * GetValueList() - Returns values found by a read
+     */
+    inline const std::vector<ValueType> &GetValueList() const {
+      assert(state == State::Done);
+      
+      return value_list;
+    }
+    
+    /*
+     * IsIdle() - Returns whether a new operation could be assigned
+     */
+    inline bool IsIdle() const {
+      return (state == State::Idle) || (state == State::Done);
+    }
+    
+   private:
+    
+    /*
+     * Assign() - Sets up a new operation
+     */
+    void Assign(BwTree *p_tree_p, AsyncOpType p_type, const KeyType &p_key) {
+      assert(IsIdle() == true);
+      
+      tree_p = p_tree_p;
+      type = p_type;
+      state = State::Start;
+      key = p_key;
+      result = false;
+      value_list.clear();
+      
+      return;
+    }
+    
+    /*
+     * GetContext() - Returns the context constructed in the buffer
+     */
+    inline Context *GetContext() {
+      return reinterpret_cast<Context *>(context_buffer);
+    }
+    
+    /*
+     * Prefetch() - Prefetches the mapping table entry of the next node
+     */
+    inline void Prefetch(NodeID node_id) {
+      next_node_id = node_id;
+      
+      __builtin_prefetch(&tree_p->mapping_table[node_id]);
+      
+      state = State::LoadMapping;
+      
+      return;
+    }
+    
+    /*
+     * StartDescent() - Starts the traversal from the root
+     */
+    void StartDescent() {
+      Prefetch(tree_p->root_id.load());
+      
+      return;
+    }
+    
+    /*
+     * Restart() - Resets the context after an abort and starts again
+     *
+     * This is the abort path of TraverseReadOptimized()
+     */
+    void Restart() {
+      Context *context_p = GetContext();
+      
+      tree_p->GetCurrentOperationCounter()->traverse_abort_count++;
+      
+      #ifdef BWTREE_DEBUG
+      
+      context_p->current_level = -1;
+      
+      context_p->abort_counter++;
+      
+      #endif
+      
+      context_p->current_snapshot.node_id = INVALID_NODE_ID;
+      
+      context_p->abort_flag = false;
+      
+      StartDescent();
+      
+      return;
+    }
+    
+    /*
+     * Finish() - Destroys the context and releases the pinned epoch
+     */
+    void Finish() {
+      GetContext()->~Context();
+      
+      tree_p->epoch_manager.UnpinEpoch(epoch_node_p);
+      epoch_node_p = nullptr;
+      
+      state = State::Done;
+      
+      return;
+    }
+    
+    /*
+     * VisitNode() - Loads the prefetched node and either prefetches the
+     *               next one or finishes the operation on the leaf
+     */
+    void VisitNode() {
+      Context *context_p = GetContext();
+      
+      tree_p->LoadNodeIDReadOptimized(next_node_id, context_p);
+      
+      if(context_p->abort_flag == true) {
+        Restart();
+        
+        return;
+      }
+      
+      NodeSnapshot *snapshot_p = tree_p->GetLatestNodeSnapshot(context_p);
+      
+      if(snapshot_p->IsLeaf() == false) {
+        NodeID child_node_id = tree_p->NavigateInnerNode(context_p);
+        
+        if(context_p->abort_flag == true) {
+          Restart();
+        } else {
+          Prefetch(child_node_id);
+        }
+        
+        return;
+      }
+      
+      if(type == AsyncOpType::Read) {
+        std::vector<ValueType> &list = value_list;
+        tree_p->NavigateLeafNode(context_p,
+                                 [&list](const ValueType &v) {
+                                   list.push_back(v);
+                                 });
+        
+        if(context_p->abort_flag == true) {
+          Restart();
+          
+          return;
+        }
+        
+        result = (value_list.size() != 0UL);
+        
+        Finish();
+        
+        return;
+      }
+      
+      // This is only a hint, so the epoch is not needed after this
+      NodeID leaf_node_id = snapshot_p->node_id;
+      
+      Finish();
+      
+      if(type == AsyncOpType::Insert) {
+        result = tree_p->InsertFromLeaf(key, value, leaf_node_id);
+      } else {
+        result = tree_p->DeleteFromLeaf(key, value, leaf_node_id);
+      }
+      
+      return;
+    }
+  };
+
+  /*
+   * class AsyncExecutor - Round robin scheduler of asynchronous operations
+   *
+   * The executor owns a fixed number of operation slots. Each round it
+   * resumes all running operations once, and assigns new operations to
+   * idle slots, until there is no more work. All operations run on the
+   * thread calling Run()
+   *
+   * After each round the pinned epoch of the thread is moved to the
+   * oldest start epoch of running operations, since the pin alone would
+   * keep it at the epoch of the first operation as long as any slot is
+   * busy, and no garbage of any thread could be freed until Run() returns
+   */
+  class AsyncExecutor {
+   private:
+    BwTree *tree_p;
+    
+    std::vector<AsyncOperation> slot_list;
+    
+   public:
+    
+    /*
+     * Constructor
      */
-    void ThreadFunc() {
-      // While the parent is still running
-      // We do not worry about race condition here
-      // since even if we missed one we could always
-      // hit the correct value on next try
-      while(exited_flag.load() == false) {
-        //printf("Start new epoch cycle\n");
-        PerformGarbageCollection();
-
-        // Sleep for 50 ms
-        std::chrono::milliseconds duration(GC_INTERVAL);
-        std::this_thread::sleep_for(duration);
-      }
-
-      bwt_printf("exit flag is true; thread return\n");
-
-      return;
+    AsyncExecutor(BwTree *p_tree_p, size_t slot_count) :
+      tree_p{p_tree_p},
+      slot_list(slot_count)
+    {
+      assert(slot_count > 0UL);
     }
-
+    
     /*
-     * StartThread() - Start cleaner thread for garbage collection
+     * Run() - Runs operations until submit_func runs out of work
      *
-     * NOTE: This is not called in the constructor, and needs to be
-     * called manually
+     * submit_func is called as submit_func(AsyncOperation *) for an idle
+     * slot, and should either call one of the Start...() functions on it
+     * and return true, or return false if there is no more operation.
+     * complete_func is called as complete_func(const AsyncOperation &) once
+     * for every finished operation. Both are called on this thread.
+     * Returns the number of finished operations
+     */
+    template <typename SubmitFunc, typename CompleteFunc>
+    size_t Run(SubmitFunc &&submit_func, CompleteFunc &&complete_func) {
+      size_t running_count = 0UL;
+      size_t finished_count = 0UL;
+      bool has_more = true;
+      
+      while((has_more == true) || (running_count != 0UL)) {
+        for(AsyncOperation &op : slot_list) {
+          if(op.IsIdle() == true) {
+            if(has_more == false) {
+              continue;
+            }
+            
+            has_more = submit_func(&op);
+            if(has_more == false) {
+              continue;
+            }
+            
+            assert(op.state == AsyncOperation::State::Start);
+            
+            running_count++;
+          }
+          
+          if(op.Resume() == true) {
+            complete_func(static_cast<const AsyncOperation &>(op));
+            
+            running_count--;
+            finished_count++;
+          }
+        }
+        
+        // All operations that are not idle have pinned the epoch of
+        // the tree they run on
+        uint64_t min_epoch = UINT64_MAX;
+        for(const AsyncOperation &op : slot_list) {
+          if((op.IsIdle() == false) &&
+             (op.tree_p == tree_p) &&
+             (op.start_epoch < min_epoch)) {
+            min_epoch = op.start_epoch;
+          }
+        }
+        
+        if(min_epoch != UINT64_MAX) {
+          tree_p->epoch_manager.AdvancePinnedEpoch(min_epoch);
+        }
+      }
+      
+      return finished_count;
+    }
+    
+    /*
+     * GetSlotCount() - Returns the number of interleaved operations
      */
-    void StartThread() {
-      thread_p = new std::thread{[this](){this->ThreadFunc();}};
-
-      return;
+    inline size_t GetSlotCount() const {
+      return slot_list.size();
     }
-
-  }; // Epoch manager
+    
+    /*
+     * GetTree() - Returns the tree operations are submitted to
+     */
+    inline BwTree *GetTree() const {
+      return tree_p;
+    }
+  };
 
   /*
    * Iterator Interface
@@ -8522,6 +13074,34 @@ try_join_again:
     return ForwardIterator{this, start_key};
   }
 
+  /*
+   * PinnedBegin() - Return an iterator that reads leaf nodes in place
+   *
+   * The iterator pins the epoch of the calling thread, and if a leaf node 
+   * has no delta chain it iterates directly on the base node without 
+   * allocating an IteratorContext and copying its content. Leaf nodes with
+   * delta chains are still consolidated into a private copy.
+   *
+   * This is designed for full table scans where most leaves are consolidated.
+   * Since garbage nodes could not be recycled while the pin is held, the 
+   * iterator should be destroyed as soon as the scan finishes. The iterator
+   * (and all its copies) must be used and destroyed by the thread that 
+   * created it. Please use prefix ++ to advance the iterator, since
+   * postfix ++ shares the leaf with a temporary copy which prevents reuse
+   */
+  ForwardIterator PinnedBegin() {
+    return ForwardIterator{this, true};
+  }
+  
+  /*
+   * PinnedBegin() - Return a pinned iterator using a given key
+   *
+   * See PinnedBegin() and Begin(const KeyType &) for more information
+   */
+  ForwardIterator PinnedBegin(const KeyType &start_key) {
+    return ForwardIterator{this, start_key, true};
+  }
+
   /*
    * NullIterator() - Returns an empty iterator that cannot do anything
    *
@@ -8551,6 +13131,11 @@ try_join_again:
    * threaded environment. This is a valid assumption since different threads
    * could always start their own iterators
    *
+   * As an exception, pinned iterators (see PinnedBegin()) may refer to a
+   * base LeafNode in the tree directly if the leaf has no delta chain. In
+   * that case the object only holds the header part, and an epoch pin which
+   * keeps the LeafNode alive until the object is destroyed
+   *
    * Since the instance of this class is created as char[], with a class 
    * ElasticNode<KeyValuePair> embedded, when destroy the instance we must
    * manually call destructor first, and then call member Destroy() to free
@@ -8566,6 +13151,15 @@ try_join_again:
     // then we could not recycle it even if the ref count has droped to 0
     size_t ref_count;
     
+    // This points to the leaf node being iterated on. It is either the
+    // embedded leaf node below, or a base LeafNode inside the tree if the
+    // context is pinned
+    const LeafNode *current_leaf_node_p;
+    
+    // The epoch pinned by this context. Only meaningful if the context
+    // refers to a node inside the tree
+    EpochNode *epoch_node_p;
+    
     // This is a stub that points to class LeafNode which is used to
     // receive consolidated key value pairs from a leaf delta chain
     LeafNode leaf_node_p[0];
@@ -8577,7 +13171,25 @@ try_join_again:
      */
     IteratorContext(BwTree *p_tree_p) :
       tree_p{p_tree_p},
-      ref_count{0UL} 
+      ref_count{0UL},
+      current_leaf_node_p{&leaf_node_p[0]},
+      epoch_node_p{nullptr}
+    {}
+    
+    /*
+     * Constructor - Initialize a pinned IteratorContext
+     *
+     * The object does not have an embedded leaf node, and the caller must
+     * have pinned the epoch before reading p_leaf_node_p. The pin is 
+     * released when this object is destroyed
+     */
+    IteratorContext(BwTree *p_tree_p,
+                    const LeafNode *p_leaf_node_p,
+                    EpochNode *p_epoch_node_p) :
+      tree_p{p_tree_p},
+      ref_count{0UL},
+      current_leaf_node_p{p_leaf_node_p},
+      epoch_node_p{p_epoch_node_p}
     {}
     
     /*
@@ -8589,6 +13201,14 @@ try_join_again:
      * class IteratorContext instance
      */
     ~IteratorContext() {
+      // For pinned context the leaf node belongs to the tree, so we only
+      // release the epoch
+      if(IsPinned() == true) {
+        tree_p->epoch_manager.UnpinEpoch(epoch_node_p);
+        
+        return;
+      }
+      
       // Call destructor to destruct all KeyValuePairs stored in its array
       GetLeafNode()->~ElasticNode<KeyValuePair>();
       
@@ -8605,6 +13225,40 @@ try_join_again:
       return &leaf_node_p[0];
     }
     
+    /*
+     * GetCurrentLeafNode() - Returns the leaf node being iterated on
+     *
+     * This is the embedded leaf node for normal contexts, and the base 
+     * LeafNode in the tree for pinned contexts
+     */
+    inline const LeafNode *GetCurrentLeafNode() const {
+      return current_leaf_node_p;
+    }
+    
+    /*
+     * IsPinned() - Whether the context refers to a leaf node in the tree
+     */
+    inline bool IsPinned() const {
+      return current_leaf_node_p != &leaf_node_p[0];
+    }
+    
+    /*
+     * SetPinnedLeafNode() - Switches a pinned context to another base leaf
+     *
+     * This is used to avoid allocating a new context for every leaf node
+     * during a scan. The new leaf node must have been read while the 
+     * epoch of this context is still pinned, which is always true since
+     * a pin protects all nodes unlinked after it is taken
+     */
+    inline void SetPinnedLeafNode(const LeafNode *p_leaf_node_p) {
+      assert(IsPinned() == true);
+      assert(ref_count == 1UL);
+      
+      current_leaf_node_p = p_leaf_node_p;
+      
+      return;
+    }
+    
     /*
      * GetTree() - Returns a tree instance 
      */
@@ -8652,16 +13306,32 @@ try_join_again:
       
       ref_count--;
       if(ref_count == 0UL) {
-        // 1. calls d'tor of class IteratorContext which calls d'tor
-        //    for class ElasticNode
-        this->~IteratorContext();
-        // 2. Frees memory as char[]
-        this->Destroy();
+        Release(this);
       }
       
       return;
     }
     
+    /*
+     * Release() - Destroys a context whose ref count has dropped to zero
+     *
+     * This is kept out of line, such that after inlining DecRef() into an
+     * iterator that still holds another reference (e.g. the copy made by
+     * postfix operator++), the compiler does not see the context being
+     * freed on a path that later reads its ref count. It also keeps the
+     * rare path out of the iteration loop
+     */
+    __attribute__((noinline))
+    static void Release(IteratorContext *ic_p) {
+      // 1. calls d'tor of class IteratorContext which calls d'tor
+      //    for class ElasticNode
+      ic_p->~IteratorContext();
+      // 2. Frees memory as char[]
+      ic_p->Destroy();
+      
+      return;
+    }
+    
     /*
      * GetRefCount() - Returns the current reference counter
      */
@@ -8714,6 +13384,28 @@ try_join_again:
       return ic_p;
     }
     
+    /*
+     * GetPinned() - Constructs a pinned iterator context object
+     *
+     * Only the header is allocated since the leaf node is read in place. The
+     * epoch node should be returned by PinEpoch(), and the ownership is
+     * transferred to the new object
+     */
+    inline static IteratorContext *GetPinned(BwTree *p_tree_p,
+                                             const LeafNode *p_leaf_node_p,
+                                             EpochNode *p_epoch_node_p) {
+      IteratorContext *ic_p = \
+        reinterpret_cast<IteratorContext *>(new char[sizeof(IteratorContext)]);
+      assert(ic_p != nullptr);
+      
+      new (ic_p) IteratorContext{p_tree_p, p_leaf_node_p, p_epoch_node_p};
+      
+      ic_p->IncRef();
+      assert(ic_p->GetRefCount() == 1UL);
+      
+      return ic_p;
+    }
+    
     /*
      * Destroy() - Manually frees memory as char[]
      *
@@ -8749,7 +13441,11 @@ try_join_again:
    private:
     // This points to the iterator context that holds the LeafNode object
     IteratorContext *ic_p;
-    KeyValuePair *kv_p;
+    const KeyValuePair *kv_p;
+    
+    // Whether the iterator reads base leaf nodes in place under a pinned
+    // epoch instead of copying them (see PinnedBegin())
+    bool pin_epoch;
     
    public:
     /*
@@ -8763,7 +13459,8 @@ try_join_again:
      */
     ForwardIterator() :
       ic_p{nullptr},
-      kv_p{nullptr}
+      kv_p{nullptr},
+      pin_epoch{false}
     {}
 
     /*
@@ -8772,31 +13469,29 @@ try_join_again:
      * NOTE: We load the first leaf page using FIRST_LEAF_NODE_ID since we
      * know it is there
      */
-    ForwardIterator(BwTree *p_tree_p) {
+    ForwardIterator(BwTree *p_tree_p, bool p_pin_epoch=false) :
+      ic_p{nullptr},
+      kv_p{nullptr},
+      pin_epoch{p_pin_epoch} {
       // This also needs to be protected by epoch since we do access internal
       // node that is possible to be reclaimed
-      EpochNode *epoch_node_p = p_tree_p->epoch_manager.JoinEpoch();
+      EpochNode *epoch_node_p = EnterEpoch(p_tree_p);
         
       // Load the first leaf page
       const BaseNode *node_p = p_tree_p->GetNode(FIRST_LEAF_NODE_ID);
       assert(node_p != nullptr);
       assert(node_p->IsOnLeafDeltaChain() == true);
 
-      // Allocate space for IteratorContext + LeafNode Metadata + LeafNode data
-      ic_p = IteratorContext::Get(p_tree_p, node_p);
-      // This does not change after CollectAllValuesOnLeaf() is called
-      kv_p = ic_p->GetLeafNode()->Begin();
-      assert(ic_p->GetRefCount() == 1UL);
-
       // Use this to collect all values
       NodeSnapshot snapshot{FIRST_LEAF_NODE_ID, node_p};
 
-      // Consolidate the current node. Note that we pass in the leaf node
-      // object embedded inside the IteratorContext object
-      p_tree_p->CollectAllValuesOnLeaf(&snapshot, ic_p->GetLeafNode());
+      // Either consolidates the node into a new IteratorContext or refers
+      // to the node in place. This also releases the epoch
+      LoadLeafNode(p_tree_p, &snapshot, epoch_node_p);
       
-      // Leave epoch
-      p_tree_p->epoch_manager.LeaveEpoch(epoch_node_p);
+      // This does not change after the leaf node is loaded
+      kv_p = ic_p->GetCurrentLeafNode()->Begin();
+      assert(ic_p->GetRefCount() == 1UL);
 
       return;
     }
@@ -8809,9 +13504,11 @@ try_join_again:
      * a starting key could be derived according to conditions
      */
     ForwardIterator(BwTree *p_tree_p,
-                    const KeyType &start_key) :
+                    const KeyType &start_key,
+                    bool p_pin_epoch=false) :
       ic_p{nullptr},
-      kv_p{nullptr} {
+      kv_p{nullptr},
+      pin_epoch{p_pin_epoch} {
       
       // Load the corresponding page using the given key and store all its
       // data into the iterator's embedded leaf page
@@ -8829,7 +13526,8 @@ try_join_again:
      */
     ForwardIterator(const ForwardIterator &other) :
       ic_p{other.ic_p},
-      kv_p{other.kv_p} {
+      kv_p{other.kv_p},
+      pin_epoch{other.pin_epoch} {
       // Increase its reference count since now two iterators
       // share one IteratorContext object
       other.ic_p->IncRef();
@@ -8862,6 +13560,7 @@ try_join_again:
       // Add a reference to the IteratorContext
       ic_p = other.ic_p;
       kv_p = other.kv_p;
+      pin_epoch = other.pin_epoch;
       other.ic_p->IncRef();
 
       return *this;
@@ -8892,6 +13591,7 @@ try_join_again:
       // Add a reference to the IteratorContext
       ic_p = other.ic_p;
       kv_p = other.kv_p;
+      pin_epoch = other.pin_epoch;
       // Nullify it to avoid from being used
       other.ic_p = nullptr;
       other.kv_p = nullptr;
@@ -8929,8 +13629,8 @@ try_join_again:
       
       // 1. Next node ID is INVALID_NODE_ID
       // 2. Current iterator pointer equals end_p stored in leaf node
-      return (ic_p->GetLeafNode()->GetNextNodeID() == INVALID_NODE_ID) && \
-             (ic_p->GetLeafNode()->End() == kv_p);
+      return (ic_p->GetCurrentLeafNode()->GetNextNodeID() == INVALID_NODE_ID) && \
+             (ic_p->GetCurrentLeafNode()->End() == kv_p);
     }
     
     /*
@@ -8949,8 +13649,8 @@ try_join_again:
         return true; 
       }
       
-      return (ic_p->GetLeafNode()->GetLowKeyPair().second == INVALID_NODE_ID) && \
-             (ic_p->GetLeafNode()->Begin() == kv_p);
+      return (ic_p->GetCurrentLeafNode()->GetLowKeyPair().second == INVALID_NODE_ID) && \
+             (ic_p->GetCurrentLeafNode()->Begin() == kv_p);
     }
     
     /*
@@ -8970,8 +13670,8 @@ try_join_again:
       }
       
       // Note that it is leaf node's Begin() - 1
-      return (ic_p->GetLeafNode()->GetLowKeyPair().second == INVALID_NODE_ID) && \
-             ((ic_p->GetLeafNode()->Begin() - 1) == kv_p);
+      return (ic_p->GetCurrentLeafNode()->GetLowKeyPair().second == INVALID_NODE_ID) && \
+             ((ic_p->GetCurrentLeafNode()->Begin() - 1) == kv_p);
     }
 
     /*
@@ -9182,7 +13882,7 @@ try_join_again:
       while(1) {  
         // First join the epoch to prevent physical nodes being deallocated
         // too early
-        EpochNode *epoch_node_p = p_tree_p->epoch_manager.JoinEpoch();
+        EpochNode *epoch_node_p = EnterEpoch(p_tree_p);
         
         // This traversal has the following characteristics:
         //   1. It stops at the leaf level without traversing leaf with the key
@@ -9192,28 +13892,16 @@ try_join_again:
         p_tree_p->Traverse(&context, nullptr, nullptr);
 
         NodeSnapshot *snapshot_p = BwTree::GetLatestNodeSnapshot(&context);
-        const BaseNode *node_p = snapshot_p->node_p;
-        assert(node_p->IsOnLeafDeltaChain() == true);
+        assert(snapshot_p->node_p->IsOnLeafDeltaChain() == true);
 
         // After this point, start_key_p from the last page becomes invalid
 
-        // We are releasing the IteratorContext object currently held 
-        // because we are now going to the next page after it
-        if(ic_p != nullptr) {
-          ic_p->DecRef();
-        }
-        
-        // Refresh the IteratorContext object and also refresh kv_p
-        ic_p = IteratorContext::Get(p_tree_p, node_p);
+        // This releases the IteratorContext object currently held because 
+        // we are now going to the next page after it, and then refreshes
+        // the IteratorContext object. The epoch is also released
+        LoadLeafNode(p_tree_p, snapshot_p, epoch_node_p);
         assert(ic_p->GetRefCount() == 1UL);
 
-        // Consolidate the current node and store all key value pairs
-        // to the embedded leaf node 
-        p_tree_p->CollectAllValuesOnLeaf(snapshot_p, ic_p->GetLeafNode());
-
-        // Leave the epoch, since we have already had all information
-        p_tree_p->epoch_manager.LeaveEpoch(epoch_node_p);
-
         // Find the lower bound of the current start search key
         // NOTE: Do not use start_key_p since the target it points to
         // might have been destroyed because we already released the reference
@@ -9226,21 +13914,21 @@ try_join_again:
         //   3. kv_p points to End() of the leaf node but next node ID
         //      is a valid one: Try next page since the current page might have
         //      been merged
-        kv_p = std::lower_bound(ic_p->GetLeafNode()->Begin(),
-                                ic_p->GetLeafNode()->End(),
-                                std::make_pair(start_key, ValueType{}),
+        kv_p = std::lower_bound(ic_p->GetCurrentLeafNode()->Begin(),
+                                ic_p->GetCurrentLeafNode()->End(),
+                                start_key,
                                 p_tree_p->key_value_pair_cmp_obj);
 
         // All keys in the leaf page are < start key. Switch the next key until
         // we have found the key or until we have reached end of tree
-        if(kv_p != ic_p->GetLeafNode()->End()) {
+        if(kv_p != ic_p->GetCurrentLeafNode()->End()) {
           break;
         } else if(IsEnd() == true) {
           break;
         } else {
           // Must do a value copy since the current ic_p will be 
           // destroyed before this variable is used
-          start_key = ic_p->GetLeafNode()->GetHighKeyPair().first;
+          start_key = ic_p->GetCurrentLeafNode()->GetHighKeyPair().first;
         }
       } // while(1)
 
@@ -9265,7 +13953,7 @@ try_join_again:
       assert(IsREnd() == false);
       
       // This is an invalid state
-      assert(kv_p != ic_p->GetLeafNode()->REnd());
+      assert(kv_p != ic_p->GetCurrentLeafNode()->REnd());
       
       // This will be used to call BwTree functions
       BwTree *tree_p = ic_p->GetTree();
@@ -9274,21 +13962,21 @@ try_join_again:
       // If there is no nodes to the left of the current node
       if(IsREnd() == true) {
         return; 
-      } else if(kv_p != ic_p->GetLeafNode()->REnd()) {
+      } else if(kv_p != ic_p->GetCurrentLeafNode()->REnd()) {
         return; 
       }
       
       while(1) {
         // Saves the low key such that even if we release the reference to
         // the IteratorContext object, it is still valid key
-        KeyType low_key = ic_p->GetLeafNode()->GetLowKey();
+        KeyType low_key = ic_p->GetCurrentLeafNode()->GetLowKey();
         
         // Traverse backward using the low key. This function will
         // try its best to reach the exact left page whose high key
         // <= current low key
         Context context{low_key};
         
-        EpochNode *epoch_node_p = tree_p->epoch_manager.JoinEpoch();
+        EpochNode *epoch_node_p = EnterEpoch(tree_p);
         
         // This function stops and does not traverse LeafNode after adjusting
         // itself by traversing sibling chain
@@ -9302,14 +13990,10 @@ try_join_again:
         assert((node_p->GetLowKeyPair().second == INVALID_NODE_ID) ||
                (tree_p->KeyCmpLess(node_p->GetLowKey(), low_key) == true));
         
-        // Release the current leaf page, and 
-        ic_p->DecRef();
-        ic_p = IteratorContext::Get(tree_p, node_p);
+        // Release the current leaf page, and load the new one. This also
+        // releases the epoch
+        LoadLeafNode(tree_p, snapshot_p, epoch_node_p);
         assert(ic_p->GetRefCount() == 1UL);
-        tree_p->CollectAllValuesOnLeaf(snapshot_p, ic_p->GetLeafNode());
-        
-        // Now we could safely release the reference
-        tree_p->epoch_manager.LeaveEpoch(epoch_node_p);
         
         // There are several possibilities:
         //    (1) kv_p stops at a key == low_key; kv_p--
@@ -9323,19 +14007,22 @@ try_join_again:
         //        need to take the current low key and retry
         //    (6) If the leaf node itself is empty then kv_p == End() == Begin()
         //        and kv_p-- is REnd()
-        kv_p = std::lower_bound(ic_p->GetLeafNode()->Begin(),
-                                ic_p->GetLeafNode()->End(),
-                                std::make_pair(low_key, ValueType{}),
+        kv_p = std::lower_bound(ic_p->GetCurrentLeafNode()->Begin(),
+                                ic_p->GetCurrentLeafNode()->End(),
+                                low_key,
                                 tree_p->key_value_pair_cmp_obj) - 1;
          
         // If after decreament the kv_p points to the element before Begin()
         // then we know we should try again                       
-        if(kv_p == ic_p->GetLeafNode()->REnd()) {
+        if(kv_p == ic_p->GetCurrentLeafNode()->REnd()) {
           // If there is no low key (-Inf) then that's it
-          if(node_p->GetLowKeyPair().second == INVALID_NODE_ID) {
+          // Note that node_p should not be used here since we have left
+          // the epoch
+          if(ic_p->GetCurrentLeafNode()->GetLowKeyPair().second == \
+             INVALID_NODE_ID) {
             return; 
           } else {
-            low_key = ic_p->GetLeafNode()->GetLowKey(); 
+            low_key = ic_p->GetCurrentLeafNode()->GetLowKey(); 
           }
         } else {
           return; 
@@ -9345,6 +14032,95 @@ try_join_again:
       return;
     }
 
+    /*
+     * EnterEpoch() - Joins or pins the epoch depending on the iterator mode
+     */
+    inline EpochNode *EnterEpoch(BwTree *p_tree_p) {
+      if(pin_epoch == true) {
+        return p_tree_p->epoch_manager.PinEpoch();
+      }
+      
+      return p_tree_p->epoch_manager.JoinEpoch();
+    }
+    
+    /*
+     * ExitEpoch() - Releases an epoch returned by EnterEpoch()
+     */
+    inline void ExitEpoch(BwTree *p_tree_p, EpochNode *epoch_node_p) {
+      if(pin_epoch == true) {
+        p_tree_p->epoch_manager.UnpinEpoch(epoch_node_p);
+      } else {
+        p_tree_p->epoch_manager.LeaveEpoch(epoch_node_p);
+      }
+      
+      return;
+    }
+    
+    /*
+     * LoadLeafNode() - Replaces the current IteratorContext with one holding 
+     *                  the logical leaf node of the given snapshot
+     *
+     * If the iterator is pinned and the snapshot is a bare LeafNode without
+     * any delta then we do not copy anything, and just refer to the node
+     * in place. If the current IteratorContext is also pinned and not shared
+     * with other iterators then it is reused, and no allocation happens at
+     * all. Otherwise the delta chain is consolidated into a new
+     * IteratorContext just like in the normal mode
+     *
+     * epoch_node_p must be returned by EnterEpoch(), and it is either
+     * released or transferred to the new IteratorContext by this function.
+     * Note that we only release the old IteratorContext while still holding
+     * the new epoch, such that releasing a pin does not expose the node
+     * being loaded to GC
+     */
+    void LoadLeafNode(BwTree *p_tree_p,
+                      NodeSnapshot *snapshot_p,
+                      EpochNode *epoch_node_p) {
+      const BaseNode *node_p = snapshot_p->node_p;
+      assert(node_p->IsOnLeafDeltaChain() == true);
+      
+      if((pin_epoch == true) && 
+         (node_p->GetType() == NodeType::LeafType)) {
+        const LeafNode *leaf_node_p = static_cast<const LeafNode *>(node_p);
+        
+        if((ic_p != nullptr) && 
+           (ic_p->IsPinned() == true) && 
+           (ic_p->GetRefCount() == 1UL)) {
+          ic_p->SetPinnedLeafNode(leaf_node_p);
+          
+          // The pin held by the context is older than the one we just took
+          // so it also protects the new node
+          p_tree_p->epoch_manager.UnpinEpoch(epoch_node_p);
+        } else {
+          if(ic_p != nullptr) {
+            ic_p->DecRef();
+          }
+          
+          ic_p = IteratorContext::GetPinned(p_tree_p, 
+                                            leaf_node_p, 
+                                            epoch_node_p);
+        }
+        
+        return;
+      }
+      
+      if(ic_p != nullptr) {
+        ic_p->DecRef();
+      }
+      
+      // Allocate space for IteratorContext + LeafNode Metadata + LeafNode data
+      ic_p = IteratorContext::Get(p_tree_p, node_p);
+      
+      // Consolidate the current node. Note that we pass in the leaf node
+      // object embedded inside the IteratorContext object
+      p_tree_p->CollectAllValuesOnLeaf(snapshot_p, ic_p->GetLeafNode());
+      
+      // Leave the epoch, since we have already had all information
+      ExitEpoch(p_tree_p, epoch_node_p);
+      
+      return;
+    }
+
     /*
      * MoveAheadByOne() - Move the iterator ahead by one
      *
@@ -9365,7 +14141,7 @@ try_join_again:
 
       // If we have drained the current page, just use its high key to 
       // go to the next page that contains the high key
-      if(kv_p == ic_p->GetLeafNode()->End()) {
+      if(kv_p == ic_p->GetCurrentLeafNode()->End()) {
         // If the current status after increment is End() then just exit and 
         // does not go to the next page
         if(IsEnd() == true) {
@@ -9375,13 +14151,128 @@ try_join_again:
         // This will replace the current ic_p with a new one
         // all references to the ic_p will be invalidated
         LowerBound(ic_p->GetTree(),
-                   &ic_p->GetLeafNode()->GetHighKeyPair().first);
+                   &ic_p->GetCurrentLeafNode()->GetHighKeyPair().first);
       }
 
       return;
     }
   }; // ForwardIterator
   
+  /*
+   * AccountNewNode() - Adds a base node allocated by ElasticNode::Get() to
+   *                    the memory counter of the current thread
+   */
+  template <typename ElementType>
+  inline void AccountNewNode(const ElasticNode<ElementType> *node_p) {
+    GetCurrentMemoryCounter()->base_node_size += node_p->GetAllocationSize();
+    
+    return;
+  }
+  
+  /*
+   * DestroyElasticNode() - Frees all memory of a base node and removes it
+   *                        from the memory counter of the current thread
+   *
+   * The destructor of the node must be called before this function
+   */
+  template <typename ElementType>
+  inline void DestroyElasticNode(const ElasticNode<ElementType> *node_p) {
+    MemoryCounter *counter_p = GetCurrentMemoryCounter();
+    
+    counter_p->base_node_size -= node_p->GetAllocationSize();
+    counter_p->delta_size -= node_p->GetGrownChunkSize();
+    
+    node_p->Destroy();
+    
+    return;
+  }
+  
+  /*
+   * InlineAllocateDelta() - Allocates a delta record from the chunks of
+   *                         a base node
+   *
+   * This is called by InnerInlineAllocateOfType() and
+   * LeafInlineAllocateOfType(). The counter is only touched when a new
+   * chunk has to be grown, which happens once every few delta records
+   */
+  template <typename ElementType>
+  inline void *InlineAllocateDelta(const KeyNodeIDPair *low_key_p, 
+                                   size_t size) {
+    int grown_count = 0;
+    void *p = ElasticNode<ElementType>::InlineAllocate(low_key_p, 
+                                                       size, 
+                                                       &grown_count);
+    
+    if(grown_count != 0) {
+      GetCurrentMemoryCounter()->delta_size += \
+        grown_count * AllocationMeta::CHUNK_SIZE;
+    }
+    
+    return p;
+  }
+  
+  /*
+   * GetGarbageMemorySize() - Returns the number of bytes that will be freed
+   *                          when a garbage node is freed
+   *
+   * This follows the same path as EpochManager::FreeEpochDeltaChain() such
+   * that the memory counted here is exactly the memory freed there. Delta
+   * records allocated from chunks are included in the base node's size
+   */
+  size_t GetGarbageMemorySize(const BaseNode *node_p) {
+    while(1) {
+      switch(node_p->GetType()) {
+        case NodeType::LeafInsertType:
+        case NodeType::LeafDeleteType:
+        case NodeType::LeafSplitType:
+        case NodeType::InnerInsertType:
+        case NodeType::InnerDeleteType:
+        case NodeType::InnerSplitType:
+          node_p = static_cast<const DeltaNode *>(node_p)->child_node_p;
+          
+          break;
+        case NodeType::LeafMergeType:
+          return \
+            GetGarbageMemorySize(
+              static_cast<const LeafMergeNode *>(node_p)->child_node_p) + \
+            GetGarbageMemorySize(
+              static_cast<const LeafMergeNode *>(node_p)->right_merge_p);
+        case NodeType::InnerMergeType:
+          return \
+            GetGarbageMemorySize(
+              static_cast<const InnerMergeNode *>(node_p)->child_node_p) + \
+            GetGarbageMemorySize(
+              static_cast<const InnerMergeNode *>(node_p)->right_merge_p);
+        case NodeType::LeafRemoveType:
+          return sizeof(LeafRemoveNode);
+        case NodeType::InnerRemoveType:
+          return sizeof(InnerRemoveNode);
+        case NodeType::InnerAbortType:
+          return sizeof(InnerAbortNode);
+        case NodeType::LeafType: {
+          const LeafNode *leaf_node_p = static_cast<const LeafNode *>(node_p);
+          
+          return leaf_node_p->GetAllocationSize() + \
+                 leaf_node_p->GetGrownChunkSize();
+        }
+        case NodeType::InnerType: {
+          const InnerNode *inner_node_p = \
+            static_cast<const InnerNode *>(node_p);
+          
+          return inner_node_p->GetAllocationSize() + \
+                 inner_node_p->GetGrownChunkSize();
+        }
+        default:
+          assert(false);
+          
+          return 0UL;
+      } // switch
+    } // while(1)
+    
+    assert(false);
+    return 0UL;
+  }
+  
   /*
    * AddGarbageNode() - Adds a garbage node into the thread-local GC context
    *
@@ -9392,10 +14283,15 @@ try_join_again:
    * do not have to worry about thread identity issues
    */
   void AddGarbageNode(const BaseNode *node_p) {
+    size_t memory_size = GetGarbageMemorySize(node_p);
+    
     GarbageNode *garbage_node_p = \
-      new GarbageNode{GetGlobalEpoch(), (void *)(node_p)};
+      new GarbageNode{GetGlobalEpoch(), (void *)(node_p), memory_size};
     assert(garbage_node_p != nullptr);
     
+    GetCurrentMemoryCounter()->garbage_size += memory_size;
+    GetCurrentMemoryCounter()->retired_size += memory_size;
+    
     // Link this new node to the end of the linked list
     // and then update last_p
     GetCurrentGCMetaData()->last_p->next_p = garbage_node_p;
@@ -9448,6 +14344,9 @@ try_join_again:
       // Then free memory
       epoch_manager.FreeEpochDeltaChain((const BaseNode *)first_p->node_p);
       
+      GetCurrentMemoryCounter()->garbage_size -= first_p->memory_size;
+      GetCurrentMemoryCounter()->freed_size += first_p->memory_size;
+      
       delete first_p;
       assert(GetGCMetaData(thread_id)->node_count != 0UL);
       GetGCMetaData(thread_id)->node_count--;
@@ -9461,6 +14360,12 @@ try_join_again:
       GetGCMetaData(thread_id)->last_p = header_p;
     }
     
+    // Thawed layouts are not on any garbage chain since they are not
+    // nodes, and they are rare, so usually this is only one load
+    if(retired_layout_p.load() != nullptr) {
+      FreeRetiredLayout(false);
+    }
+    
     return;
   }
 
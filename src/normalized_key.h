@@ -0,0 +1,339 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+/*
+ * class NormalizedKey - Fixed size multi-column key whose byte string
+ *                       compares in the same order as the column values
+ *
+ * Columns are appended one by one in index key order. Each column is
+ * encoded such that an unsigned lexicographical comparison of the
+ * encoded bytes gives the same result as comparing the values column
+ * by column:
+ *
+ *   1. Signed integers are stored big-endian with the sign bit flipped
+ *   2. Unsigned integers are stored big-endian
+ *   3. Doubles are stored big-endian with the sign bit flipped for
+ *      positive numbers and all bits flipped for negative numbers
+ *   4. Strings are stored with 0x00 escaped as 0x00 0xFF and terminated
+ *      by 0x00 0x00, such that a shorter prefix sorts first
+ *
+ * Since all keys of an index share the same column types the encoding
+ * of a key never is a proper prefix of another key, and unused bytes
+ * are zero filled. Two keys could therefore be compared on the full
+ * array, 8 bytes at a time, without knowing the schema
+ *
+ * NOTE: The caller must make sure KeySize is large enough to hold all
+ * columns. Append functions return false if the column does not fit,
+ * in which case the key is left unchanged
+ */
+template <size_t KeySize>
+class NormalizedKey {
+  static_assert(KeySize % sizeof(uint64_t) == 0,
+                "NormalizedKey size must be a multiple of 8 bytes");
+
+ public:
+  // Number of 64 bit words in the key
+  static constexpr size_t WORD_COUNT = KeySize / sizeof(uint64_t);
+
+  unsigned char data[KeySize];
+
+  // Number of bytes already used by appended columns
+  size_t size;
+
+ public:
+
+  /*
+   * Default Constructor - Initializes an empty key
+   */
+  NormalizedKey() {
+    Clear();
+
+    return;
+  }
+
+  /*
+   * Clear() - Removes all columns and zero fills the key
+   */
+  inline void Clear() {
+    memset(data, 0x00, KeySize);
+    size = 0;
+
+    return;
+  }
+
+  /*
+   * AppendUnsigned() - Appends an unsigned integer as big-endian
+   */
+  template <typename IntType>
+  inline bool AppendUnsigned(IntType value) {
+    if(size + sizeof(IntType) > KeySize) {
+      return false;
+    }
+
+    for(size_t i = 0;i < sizeof(IntType);i++) {
+      data[size + sizeof(IntType) - 1 - i] = \
+        static_cast<unsigned char>(value & 0xFF);
+      value = static_cast<IntType>(value >> 8);
+    }
+
+    size += sizeof(IntType);
+
+    return true;
+  }
+
+  /*
+   * AppendInteger() - Appends a signed integer
+   *
+   * Flipping the sign bit maps the most negative value to all zeros and
+   * the most positive value to all ones, which then preserves order
+   * under unsigned comparison
+   */
+  inline bool AppendInteger(int8_t value) {
+    return AppendUnsigned(static_cast<uint8_t>(
+      static_cast<uint8_t>(value) ^ 0x80U));
+  }
+
+  inline bool AppendInteger(int16_t value) {
+    return AppendUnsigned(static_cast<uint16_t>(
+      static_cast<uint16_t>(value) ^ 0x8000U));
+  }
+
+  inline bool AppendInteger(int32_t value) {
+    return AppendUnsigned(static_cast<uint32_t>(value) ^ 0x80000000U);
+  }
+
+  inline bool AppendInteger(int64_t value) {
+    return AppendUnsigned(static_cast<uint64_t>(value) ^ 0x8000000000000000UL);
+  }
+
+  /*
+   * AppendDouble() - Appends a double precision floating point number
+   *
+   * -0.0 sorts before +0.0 and NaN is not supported
+   */
+  inline bool AppendDouble(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    if((bits & 0x8000000000000000UL) != 0) {
+      bits = ~bits;
+    } else {
+      bits ^= 0x8000000000000000UL;
+    }
+
+    return AppendUnsigned(bits);
+  }
+
+  /*
+   * AppendString() - Appends a byte string of given length
+   *
+   * Each 0x00 inside the string takes two bytes plus there are two bytes
+   * for the terminator
+   */
+  inline bool AppendString(const char *str_p, size_t length) {
+    size_t encoded_size = length + 2;
+    for(size_t i = 0;i < length;i++) {
+      if(str_p[i] == '\0') {
+        encoded_size++;
+      }
+    }
+
+    if(size + encoded_size > KeySize) {
+      return false;
+    }
+
+    for(size_t i = 0;i < length;i++) {
+      data[size++] = static_cast<unsigned char>(str_p[i]);
+
+      if(str_p[i] == '\0') {
+        data[size++] = 0xFF;
+      }
+    }
+
+    // The terminator sorts before any escaped or non-zero byte
+    data[size++] = 0x00;
+    data[size++] = 0x00;
+
+    return true;
+  }
+
+  inline bool AppendString(const std::string &str) {
+    return AppendString(str.data(), str.size());
+  }
+
+  /*
+   * GetUnsigned() - Decodes an unsigned integer at the given offset
+   *
+   * The offset is advanced past the column
+   */
+  template <typename IntType>
+  inline IntType GetUnsigned(size_t *offset_p) const {
+    assert(*offset_p + sizeof(IntType) <= size);
+
+    IntType value = 0;
+    for(size_t i = 0;i < sizeof(IntType);i++) {
+      value = static_cast<IntType>((value << 8) | data[*offset_p + i]);
+    }
+
+    *offset_p += sizeof(IntType);
+
+    return value;
+  }
+
+  /*
+   * GetInteger() - Decodes a signed integer at the given offset
+   */
+  template <typename IntType>
+  inline IntType GetInteger(size_t *offset_p) const {
+    using UnsignedType = typename std::make_unsigned<IntType>::type;
+    constexpr UnsignedType SIGN_BIT = \
+      static_cast<UnsignedType>(UnsignedType{1} << (sizeof(IntType) * 8 - 1));
+
+    UnsignedType value = GetUnsigned<UnsignedType>(offset_p);
+
+    return static_cast<IntType>(static_cast<UnsignedType>(value ^ SIGN_BIT));
+  }
+
+  /*
+   * GetDouble() - Decodes a double at the given offset
+   */
+  inline double GetDouble(size_t *offset_p) const {
+    uint64_t bits = GetUnsigned<uint64_t>(offset_p);
+
+    if((bits & 0x8000000000000000UL) != 0) {
+      bits ^= 0x8000000000000000UL;
+    } else {
+      bits = ~bits;
+    }
+
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+
+    return value;
+  }
+
+  /*
+   * GetString() - Decodes a string at the given offset
+   */
+  inline std::string GetString(size_t *offset_p) const {
+    std::string ret{};
+    size_t offset = *offset_p;
+
+    while(offset + 1 < size) {
+      if(data[offset] != 0x00) {
+        ret.push_back(static_cast<char>(data[offset]));
+        offset++;
+      } else if(data[offset + 1] == 0xFF) {
+        ret.push_back('\0');
+        offset += 2;
+      } else {
+        // Terminator
+        offset += 2;
+
+        break;
+      }
+    }
+
+    *offset_p = offset;
+
+    return ret;
+  }
+
+  /*
+   * LoadWord() - Loads the i-th 64 bit word such that integer comparison
+   *              agrees with byte comparison
+   */
+  inline uint64_t LoadWord(size_t index) const {
+    uint64_t word;
+    memcpy(&word, data + index * sizeof(uint64_t), sizeof(word));
+
+    #if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    word = __builtin_bswap64(word);
+    #endif
+
+    return word;
+  }
+
+  /*
+   * Compare() - Returns negative, zero or positive number if this key is
+   *             less than, equal to or greater than the other key
+   *
+   * Bytes are compared one word at a time; the first differing word
+   * decides the result
+   */
+  inline int Compare(const NormalizedKey &other) const {
+    for(size_t i = 0;i < WORD_COUNT;i++) {
+      uint64_t word_1 = LoadWord(i);
+      uint64_t word_2 = other.LoadWord(i);
+
+      if(word_1 != word_2) {
+        return (word_1 < word_2) ? -1 : 1;
+      }
+    }
+
+    return 0;
+  }
+
+  /*
+   * Equals() - Whether two keys have identical bytes
+   */
+  inline bool Equals(const NormalizedKey &other) const {
+    return memcmp(data, other.data, KeySize) == 0;
+  }
+
+  /*
+   * Hash() - Hashes all words of the key
+   */
+  inline size_t Hash() const {
+    uint64_t hash = 0xCBF29CE484222325UL;
+
+    for(size_t i = 0;i < WORD_COUNT;i++) {
+      uint64_t word;
+      memcpy(&word, data + i * sizeof(uint64_t), sizeof(word));
+
+      hash = (hash ^ word) * 0x100000001B3UL;
+      hash ^= (hash >> 29);
+    }
+
+    return static_cast<size_t>(hash);
+  }
+};
+
+/*
+ * class NormalizedKeyComparator - Less than relation of normalized keys
+ */
+template <size_t KeySize>
+class NormalizedKeyComparator {
+ public:
+  inline bool operator()(const NormalizedKey<KeySize> &k1,
+                         const NormalizedKey<KeySize> &k2) const {
+    return k1.Compare(k2) < 0;
+  }
+};
+
+/*
+ * class NormalizedKeyEqualityChecker - Equality relation of normalized keys
+ */
+template <size_t KeySize>
+class NormalizedKeyEqualityChecker {
+ public:
+  inline bool operator()(const NormalizedKey<KeySize> &k1,
+                         const NormalizedKey<KeySize> &k2) const {
+    return k1.Equals(k2);
+  }
+};
+
+/*
+ * class NormalizedKeyHashFunc - Hash function of normalized keys
+ */
+template <size_t KeySize>
+class NormalizedKeyHashFunc {
+ public:
+  inline size_t operator()(const NormalizedKey<KeySize> &key) const {
+    return key.Hash();
+  }
+};
@@ -0,0 +1,1124 @@
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "bwtree.h"
+
+// A partition is split by rebalancing if its memory footprint is larger
+// than this many times the mean footprint of all partitions...
+#define PARTITION_REBALANCE_FACTOR ((size_t)2)
+
+// ...and also larger than this
+#define PARTITION_MIN_SPLIT_SIZE ((size_t)(32 * 1024 * 1024))
+
+// Each thread asks for a check whether a partition should be split after
+// this number of its writes
+#define PARTITION_REBALANCE_CHECK_INTERVAL ((uint64_t)(1 << 16))
+
+// The rebalance thread looks for requests every this many milliseconds
+#define PARTITION_REBALANCE_POLL_INTERVAL ((int)10)
+
+#ifdef BWTREE_PELOTON
+namespace peloton {
+namespace index {
+#else
+namespace wangziqi2013 {
+namespace bwtree {
+#endif
+
+/*
+ * class PartitionedBwTree - A forest of BwTrees over disjoint key ranges
+ *
+ * With a single tree the root and the top inner levels are shared by all
+ * threads, and every SMO near the top writes cache lines that all other
+ * threads read. This class holds N independent trees, each responsible for
+ * a key range, such that SMOs of different ranges do not interfere.
+ *
+ * Operations are routed by a small split table which is never modified
+ * once published. Each thread writes the version of the table it operates
+ * under into its own padded slot, which works like a tiny epoch: a table is
+ * freed only after no slot refers to it, and a partition is only changed
+ * after all operations that could have seen the previous table are gone.
+ *
+ * When a partition grows much larger than the others it is split online:
+ *
+ *   (1) A table where the partition is frozen is published. Writers of
+ *       that partition wait, and all other operations continue
+ *   (2) Keys in the upper half are copied into a new tree
+ *   (3) A table with the new partition is published, which unfreezes both
+ *   (4) Copied keys are deleted from the old tree. No operation is routed
+ *       to them any more, and scans of the old partition stop at its new
+ *       upper bound
+ *
+ * Splits are done by a background thread of the forest when writers ask
+ * for it, such that no writer copies a partition. Threads must be
+ * registered on the forest rather than on the trees (see
+ * UpdateThreadLocal() and AssignGCID()). Trees are only created and never
+ * destroyed until the forest is, such that tree pointers held by
+ * iterators stay valid
+ */
+template <typename KeyType,
+          typename ValueType,
+          typename KeyComparator = std::less<KeyType>,
+          typename KeyEqualityChecker = std::equal_to<KeyType>,
+          typename KeyHashFunc = std::hash<KeyType>,
+          typename ValueEqualityChecker = std::equal_to<ValueType>,
+          typename ValueHashFunc = std::hash<ValueType>>
+class PartitionedBwTree {
+ public:
+  using TreeType = BwTree<KeyType,
+                          ValueType,
+                          KeyComparator,
+                          KeyEqualityChecker,
+                          KeyHashFunc,
+                          ValueEqualityChecker,
+                          ValueHashFunc>;
+
+  using KeyValuePair = typename TreeType::KeyValuePair;
+
+  static constexpr size_t CACHE_LINE_SIZE = 64;
+
+ private:
+
+  /*
+   * class Partition - A key range and the tree that holds it
+   */
+  class Partition {
+   public:
+    TreeType *tree_p;
+
+    // Writers of the partition wait while this is set
+    bool frozen;
+  };
+
+  /*
+   * class SplitTable - Routes keys to partitions
+   *
+   * Partition i holds keys in [split_key_list[i - 1], split_key_list[i]),
+   * where the first partition has no lower bound and the last partition
+   * has no upper bound
+   */
+  class SplitTable {
+   public:
+    // Versions start from 1; 0 in a thread slot means it is idle
+    uint64_t version;
+
+    std::vector<KeyType> split_key_list;
+    std::vector<Partition> partition_list;
+
+    /*
+     * Route() - Returns the index of the partition of a key
+     */
+    inline size_t Route(const KeyType &key,
+                        const KeyComparator &key_cmp_obj) const {
+      return std::upper_bound(split_key_list.begin(),
+                              split_key_list.end(),
+                              key,
+                              key_cmp_obj) - split_key_list.begin();
+    }
+
+    /*
+     * GetHighKey() - Returns the upper bound of a partition, or nullptr
+     *                for the last partition
+     */
+    inline const KeyType *GetHighKey(size_t index) const {
+      if(index == split_key_list.size()) {
+        return nullptr;
+      }
+
+      return &split_key_list[index];
+    }
+  };
+
+  /*
+   * class ThreadSlot - Per-thread state padded to a cache line
+   */
+  class ThreadSlot {
+   public:
+    // Version of the table the thread is operating under, or 0
+    std::atomic<uint64_t> version;
+
+    // Writes done by the thread, used to check for rebalancing
+    uint64_t write_count;
+
+    char padding[CACHE_LINE_SIZE - \
+                 sizeof(std::atomic<uint64_t>) - \
+                 sizeof(uint64_t)];
+
+    /*
+     * Default constructor
+     */
+    ThreadSlot() :
+      version{0UL},
+      write_count{0UL}
+    {}
+  };
+
+  static_assert(sizeof(ThreadSlot) == CACHE_LINE_SIZE,
+                "class ThreadSlot size does not conform to the alignment!");
+
+ public:
+
+  /*
+   * Constructor - Creates one partition more than the number of split keys
+   *
+   * Split keys must be sorted and distinct. The remaining arguments are
+   * passed to the constructor of each tree
+   */
+  PartitionedBwTree(const std::vector<KeyType> &p_split_key_list,
+                    bool p_start_gc_thread = true,
+                    KeyComparator p_key_cmp_obj = KeyComparator{},
+                    KeyEqualityChecker p_key_eq_obj = KeyEqualityChecker{},
+                    KeyHashFunc p_key_hash_obj = KeyHashFunc{},
+                    ValueEqualityChecker p_value_eq_obj = \
+                      ValueEqualityChecker{},
+                    ValueHashFunc p_value_hash_obj = ValueHashFunc{}) :
+    key_cmp_obj{p_key_cmp_obj},
+    key_eq_obj{p_key_eq_obj},
+    key_hash_obj{p_key_hash_obj},
+    value_eq_obj{p_value_eq_obj},
+    value_hash_obj{p_value_hash_obj},
+    start_gc_thread{p_start_gc_thread},
+    table_p{nullptr},
+    current_version{0UL},
+    next_version{1UL},
+    tree_list{},
+    rebalance_lock{},
+    thread_num{0UL},
+    slot_buffer_p{nullptr},
+    slot_list_p{nullptr},
+    unowned_count{0UL},
+    rebalance_factor{PARTITION_REBALANCE_FACTOR},
+    min_split_size{PARTITION_MIN_SPLIT_SIZE},
+    rebalance_check_interval{PARTITION_REBALANCE_CHECK_INTERVAL},
+    rebalance_count{0UL},
+    rebalance_thread_p{nullptr},
+    rebalance_exit_flag{false},
+    rebalance_requested{false} {
+    SplitTable *new_table_p = new SplitTable{};
+    new_table_p->version = next_version++;
+    new_table_p->split_key_list = p_split_key_list;
+
+    for(size_t i = 0;i <= p_split_key_list.size();i++) {
+      if((i > 0) && (i < p_split_key_list.size())) {
+        assert(key_cmp_obj(p_split_key_list[i - 1], p_split_key_list[i]));
+      }
+
+      new_table_p->partition_list.push_back(Partition{CreateTree(), false});
+    }
+
+    table_p.store(new_table_p);
+    current_version.store(new_table_p->version);
+
+    // Serve the current thread by default, which is also what trees do
+    UpdateThreadLocal(1);
+
+    return;
+  }
+
+  /*
+   * Destructor - Frees all trees and the current table
+   *
+   * This must be called when no other thread is using the forest
+   */
+  ~PartitionedBwTree() {
+    StopRebalanceThread();
+
+    for(TreeType *tree_p : tree_list) {
+      delete tree_p;
+    }
+
+    delete table_p.load();
+
+    FreeThreadSlot();
+
+    return;
+  }
+
+  PartitionedBwTree(const PartitionedBwTree &) = delete;
+  PartitionedBwTree &operator=(const PartitionedBwTree &) = delete;
+
+  /*
+   * UpdateThreadLocal() - Sets the number of threads of all trees and the
+   *                       forest itself
+   *
+   * One more GC ID than requested is set up, which is used by the
+   * rebalance thread. The thread is restarted with the new ID
+   *
+   * This must be called when no other thread is using the forest
+   */
+  void UpdateThreadLocal(size_t p_thread_num) {
+    StopRebalanceThread();
+
+    for(TreeType *tree_p : tree_list) {
+      tree_p->UpdateThreadLocal(p_thread_num + 1);
+    }
+
+    FreeThreadSlot();
+
+    thread_num = p_thread_num;
+
+    // Slots are aligned to cache lines manually as BwTreeBase does
+    slot_buffer_p = static_cast<char *>(
+      malloc(sizeof(ThreadSlot) * GetSlotCount() + CACHE_LINE_SIZE));
+    slot_list_p = reinterpret_cast<ThreadSlot *>(
+      (reinterpret_cast<size_t>(slot_buffer_p) + CACHE_LINE_SIZE - 1) & \
+      ~(CACHE_LINE_SIZE - 1));
+
+    for(size_t i = 0;i < GetSlotCount();i++) {
+      new (slot_list_p + i) ThreadSlot{};
+    }
+
+    StartRebalanceThread();
+
+    return;
+  }
+
+  /*
+   * AssignGCID() - Assigns the ID of the calling thread on all trees
+   *
+   * gc_id is a static thread_local member of BwTreeBase, which is shared
+   * by all trees, so assigning it through one tree is enough
+   */
+  inline void AssignGCID(int p_gc_id) {
+    tree_list[0]->AssignGCID(p_gc_id);
+
+    return;
+  }
+
+  /*
+   * UnregisterThread() - Unregisters a thread from GC of all trees
+   */
+  void UnregisterThread(int p_gc_id) {
+    std::lock_guard<std::mutex> guard{rebalance_lock};
+
+    for(TreeType *tree_p : tree_list) {
+      tree_p->UnregisterThread(p_gc_id);
+    }
+
+    return;
+  }
+
+  /*
+   * SetRebalancePolicy() - Sets when a partition is split
+   *
+   * A partition is split if its footprint is larger than both factor times
+   * the mean and min_size bytes. Threads ask the rebalance thread to check
+   * this every check_interval writes, and 0 disables automatic checks
+   *
+   * NOTE: This should be called before the forest is shared by threads
+   */
+  void SetRebalancePolicy(size_t factor,
+                          size_t min_size,
+                          uint64_t check_interval) {
+    rebalance_factor = factor;
+    min_split_size = min_size;
+    rebalance_check_interval = check_interval;
+
+    return;
+  }
+
+  /*
+   * Insert() - Inserts a key-value pair into the partition of the key
+   *
+   * Returns false if the pair already exists
+   */
+  bool Insert(const KeyType &key, const ValueType &value) {
+    TreeType *tree_p = EnterForWrite(key);
+    bool ret = tree_p->Insert(key, value);
+    Leave();
+
+    CountWrite();
+
+    return ret;
+  }
+
+  /*
+   * Delete() - Deletes a key-value pair from the partition of the key
+   *
+   * Returns false if the pair does not exist
+   */
+  bool Delete(const KeyType &key, const ValueType &value) {
+    TreeType *tree_p = EnterForWrite(key);
+    bool ret = tree_p->Delete(key, value);
+    Leave();
+
+    CountWrite();
+
+    return ret;
+  }
+
+  /*
+   * ForEachValue() - Calls a function on every value of the search key
+   *
+   * See BwTree::ForEachValue()
+   */
+  template <typename ValueFunc>
+  void ForEachValue(const KeyType &search_key, ValueFunc &&value_func) {
+    const SplitTable *table_p = Enter();
+    size_t index = table_p->Route(search_key, key_cmp_obj);
+
+    // Partitions being split are not modified, so reads need not wait
+    table_p->partition_list[index].tree_p->ForEachValue(search_key,
+                                                        value_func);
+    Leave();
+
+    return;
+  }
+
+  /*
+   * GetValue() - Fills a value list with values of the search key
+   */
+  void GetValue(const KeyType &search_key,
+                std::vector<ValueType> &value_list) {
+    ForEachValue(search_key,
+                 [&value_list](const ValueType &value) {
+                   value_list.push_back(value);
+                 });
+
+    return;
+  }
+
+  /*
+   * ScanRange() - Calls a function on all key-value pairs inside a key
+   *               range across partitions
+   *
+   * Arguments and the return value are the same as BwTree::ScanRange().
+   * Keys are reported in order, since partitions are scanned from left
+   * to right, and each partition is only scanned up to its upper bound
+   *
+   * NOTE: The table is held for the entire scan, so a split that waits
+   * for the scan is delayed. Long scans should be done with iterators
+   */
+  template <typename ScanFunc>
+  size_t ScanRange(const KeyType &low_key,
+                   const KeyType &high_key,
+                   bool low_inclusive,
+                   bool high_inclusive,
+                   ScanFunc &&scan_func) {
+    const SplitTable *table_p = Enter();
+
+    size_t first_index = table_p->Route(low_key, key_cmp_obj);
+    size_t last_index = table_p->Route(high_key, key_cmp_obj);
+
+    size_t scan_count = 0UL;
+    bool stopped = false;
+
+    // Only used to tell whether the scan function stopped the scan
+    auto partition_scan_func = [&stopped,
+                                &scan_func](const KeyType &key,
+                                            const ValueType &value) {
+      if(scan_func(key, value) == false) {
+        stopped = true;
+
+        return false;
+      }
+
+      return true;
+    };
+
+    for(size_t i = first_index;(i <= last_index) && (stopped == false);i++) {
+      TreeType *tree_p = table_p->partition_list[i].tree_p;
+
+      // Keys copied to the right partition might still be in the left one,
+      // so each partition is scanned up to its upper bound
+      const KeyType *scan_low_key_p = &low_key;
+      bool scan_low_inclusive = low_inclusive;
+      if(i != first_index) {
+        scan_low_key_p = &table_p->split_key_list[i - 1];
+        scan_low_inclusive = true;
+      }
+
+      const KeyType *scan_high_key_p = &high_key;
+      bool scan_high_inclusive = high_inclusive;
+      if(i != last_index) {
+        scan_high_key_p = table_p->GetHighKey(i);
+        scan_high_inclusive = false;
+      }
+
+      scan_count += tree_p->ScanLeafLevel(scan_low_key_p,
+                                          scan_low_inclusive,
+                                          scan_high_key_p,
+                                          scan_high_inclusive,
+                                          static_cast<size_t>(-1),
+                                          partition_scan_func);
+    }
+
+    Leave();
+
+    return scan_count;
+  }
+
+  /*
+   * Rebalance() - Splits the largest partition if it is too large
+   *
+   * Returns true if a partition has been split. If another thread is
+   * rebalancing then this function returns false immediately
+   *
+   * NOTE: The calling thread must not be inside an operation on the forest
+   */
+  bool Rebalance() {
+    std::unique_lock<std::mutex> guard{rebalance_lock, std::try_to_lock};
+    if(guard.owns_lock() == false) {
+      return false;
+    }
+
+    const SplitTable *current_table_p = table_p.load();
+    size_t partition_num = current_table_p->partition_list.size();
+
+    size_t total_size = 0UL;
+    size_t max_size = 0UL;
+    size_t max_index = 0UL;
+    for(size_t i = 0;i < partition_num;i++) {
+      size_t size = \
+        current_table_p->partition_list[i].tree_p->GetMemoryFootprint();
+
+      total_size += size;
+      if(size > max_size) {
+        max_size = size;
+        max_index = i;
+      }
+    }
+
+    if((max_size <= min_split_size) ||
+       (max_size * partition_num <= total_size * rebalance_factor)) {
+      return false;
+    }
+
+    return SplitPartition(max_index);
+  }
+
+  /*
+   * SplitPartition() - Splits a partition at its median key
+   *
+   * Returns false if the partition does not have two distinct keys
+   *
+   * NOTE: The calling thread must hold the rebalance lock
+   */
+  bool SplitPartition(size_t index) {
+    SplitTable *old_table_p = table_p.load();
+    TreeType *old_tree_p = old_table_p->partition_list[index].tree_p;
+
+    // The old table is freed after freezing, so the high key is copied
+    const KeyType *high_key_p = old_table_p->GetHighKey(index);
+    bool has_high_key = (high_key_p != nullptr);
+    KeyType high_key{};
+    if(has_high_key == true) {
+      high_key = *high_key_p;
+    }
+
+    // Collect keys of the partition; we do not need the table for this
+    // since the rebalance lock is held and only we change partitions
+    std::vector<KeyValuePair> item_list{};
+    ScanPartition(old_table_p, index, &item_list);
+
+    if(item_list.size() < 2UL) {
+      return false;
+    }
+
+    // All values of the median key move to the new partition
+    size_t split_index = item_list.size() / 2;
+    while((split_index > 0UL) &&
+          (key_eq_obj(item_list[split_index - 1].first,
+                      item_list[split_index].first) == true)) {
+      split_index--;
+    }
+
+    if(split_index == 0UL) {
+      return false;
+    }
+
+    KeyType split_key = item_list[split_index].first;
+
+    bwt_printf("Splitting partition %lu of %lu items\n",
+               index,
+               item_list.size());
+
+    // 1. Freeze writers of the partition
+    SplitTable *frozen_table_p = new SplitTable{*old_table_p};
+    frozen_table_p->version = next_version++;
+    frozen_table_p->partition_list[index].frozen = true;
+
+    Publish(frozen_table_p);
+    delete old_table_p;
+
+    // 2. Writers might have changed the partition after the first scan
+    item_list.clear();
+    ScanPartition(frozen_table_p, index, &item_list);
+
+    TreeType *new_tree_p = CreateTree();
+    new_tree_p->UpdateThreadLocal(GetSlotCount());
+
+    auto split_it = \
+      std::lower_bound(item_list.begin(),
+                       item_list.end(),
+                       split_key,
+                       [this](const KeyValuePair &item, const KeyType &key) {
+                         return key_cmp_obj(item.first, key);
+                       });
+
+    for(auto it = split_it;it != item_list.end();it++) {
+      assert((has_high_key == false) ||
+             (key_cmp_obj(it->first, high_key) == true));
+
+      new_tree_p->Insert(it->first, it->second);
+    }
+
+    // 3. Route the upper half to the new tree
+    SplitTable *split_table_p = new SplitTable{};
+    split_table_p->version = next_version++;
+    split_table_p->split_key_list = frozen_table_p->split_key_list;
+    split_table_p->split_key_list.insert(
+      split_table_p->split_key_list.begin() + index,
+      split_key);
+    split_table_p->partition_list = frozen_table_p->partition_list;
+    split_table_p->partition_list[index].frozen = false;
+    split_table_p->partition_list.insert(
+      split_table_p->partition_list.begin() + index + 1,
+      Partition{new_tree_p, false});
+
+    Publish(split_table_p);
+    delete frozen_table_p;
+
+    // 4. Remove copies from the old tree
+    for(auto it = split_it;it != item_list.end();it++) {
+      old_tree_p->Delete(it->first, it->second);
+    }
+
+    rebalance_count.fetch_add(1UL);
+
+    return true;
+  }
+
+  /*
+   * GetPartitionCount() - Returns the current number of partitions
+   */
+  size_t GetPartitionCount() {
+    const SplitTable *table_p = Enter();
+    size_t partition_num = table_p->partition_list.size();
+    Leave();
+
+    return partition_num;
+  }
+
+  /*
+   * GetPartitionFootprint() - Returns the memory footprint of each partition
+   */
+  std::vector<size_t> GetPartitionFootprint() {
+    std::vector<size_t> size_list{};
+
+    const SplitTable *table_p = Enter();
+    for(const Partition &partition : table_p->partition_list) {
+      size_list.push_back(partition.tree_p->GetMemoryFootprint());
+    }
+    Leave();
+
+    return size_list;
+  }
+
+  /*
+   * GetRebalanceCount() - Returns the number of partition splits
+   */
+  inline uint64_t GetRebalanceCount() const {
+    return rebalance_count.load();
+  }
+
+  /*
+   * class ForwardIterator - Iterates over all partitions in key order
+   *
+   * The iterator uses the iterator of one tree at a time. When that runs
+   * out, or passes the upper bound the partition had when the iterator
+   * entered it, the last key returned is routed again using the current
+   * table and iteration continues after it. A split done meanwhile might
+   * have moved the rest of the partition into a new tree, which is found
+   * this way. Like BwTree iterators it does not hold any snapshot, and
+   * pairs modified while iterating might or might not be observed
+   */
+  class ForwardIterator {
+   public:
+
+    /*
+     * Constructor - Iterates from the first key
+     */
+    ForwardIterator(PartitionedBwTree *p_forest_p) :
+      forest_p{p_forest_p},
+      it{},
+      has_high_key{false},
+      high_key{} {
+      Seek(nullptr, true);
+    }
+
+    /*
+     * Constructor - Iterates from the first key >= start_key
+     */
+    ForwardIterator(PartitionedBwTree *p_forest_p,
+                    const KeyType &start_key) :
+      forest_p{p_forest_p},
+      it{},
+      has_high_key{false},
+      high_key{} {
+      Seek(&start_key, true);
+    }
+
+    /*
+     * IsEnd() - Whether all partitions have been iterated
+     */
+    inline bool IsEnd() const {
+      return it.IsEnd();
+    }
+
+    inline const KeyValuePair &operator*() {
+      return *it;
+    }
+
+    inline const KeyValuePair *operator->() {
+      return &*it;
+    }
+
+    /*
+     * Prefix operator++ - Moves to the next pair
+     */
+    inline ForwardIterator &operator++() {
+      // The key is copied since the tree iterator might release the leaf
+      // it is on
+      KeyType last_key = it->first;
+
+      ++it;
+
+      if(IsInPartition() == false) {
+        Seek(&last_key, false);
+      }
+
+      return *this;
+    }
+
+   private:
+
+    /*
+     * IsInPartition() - Whether the tree iterator is on a pair below the
+     *                   upper bound of the current partition
+     */
+    inline bool IsInPartition() {
+      return (it.IsEnd() == false) &&
+             ((has_high_key == false) ||
+              (forest_p->key_cmp_obj(it->first, high_key) == true));
+    }
+
+    /*
+     * Seek() - Positions the iterator on the first pair >= key (or > key
+     *          if inclusive is false), or the first pair if key_p is nullptr
+     *
+     * The key is routed with the current table. If the partition has no
+     * such pair then the search continues from its upper bound in the
+     * next partition. If the table changed while a partition looked empty,
+     * it might be because a split moved the pairs, so the key is routed
+     * again
+     */
+    void Seek(const KeyType *key_p, bool inclusive) {
+      // Upper bound of a partition that has been passed
+      KeyType bound_key{};
+
+      while(1) {
+        const SplitTable *table_p = forest_p->Enter();
+        uint64_t version = table_p->version;
+
+        size_t index = 0UL;
+        if(key_p != nullptr) {
+          index = table_p->Route(*key_p, forest_p->key_cmp_obj);
+        }
+
+        TreeType *tree_p = table_p->partition_list[index].tree_p;
+        const KeyType *high_key_p = table_p->GetHighKey(index);
+        has_high_key = (high_key_p != nullptr);
+        if(has_high_key == true) {
+          high_key = *high_key_p;
+        }
+
+        forest_p->Leave();
+
+        if(key_p != nullptr) {
+          it = tree_p->Begin(*key_p);
+
+          while((inclusive == false) &&
+                (it.IsEnd() == false) &&
+                (forest_p->key_cmp_obj(*key_p, it->first) == false)) {
+            ++it;
+          }
+        } else {
+          it = tree_p->Begin();
+        }
+
+        if(IsInPartition() == true) {
+          return;
+        }
+
+        if(forest_p->current_version.load() != version) {
+          continue;
+        }
+
+        // The last partition has been iterated
+        if(has_high_key == false) {
+          return;
+        }
+
+        bound_key = high_key;
+        key_p = &bound_key;
+        inclusive = true;
+      }
+
+      assert(false);
+      return;
+    }
+
+    PartitionedBwTree *forest_p;
+
+    typename TreeType::ForwardIterator it;
+
+    // Upper bound of the current partition when it was entered
+    bool has_high_key;
+    KeyType high_key;
+  };
+
+  /*
+   * Begin() - Returns an iterator on the first pair of the forest
+   */
+  ForwardIterator Begin() {
+    return ForwardIterator{this};
+  }
+
+  /*
+   * Begin() - Returns an iterator on the first pair whose key >= start_key
+   */
+  ForwardIterator Begin(const KeyType &start_key) {
+    return ForwardIterator{this, start_key};
+  }
+
+ private:
+
+  /*
+   * CreateTree() - Creates an empty tree with the arguments of the forest
+   */
+  TreeType *CreateTree() {
+    TreeType *tree_p = new TreeType{start_gc_thread,
+                                    key_cmp_obj,
+                                    key_eq_obj,
+                                    key_hash_obj,
+                                    value_eq_obj,
+                                    value_hash_obj};
+
+    tree_list.push_back(tree_p);
+
+    return tree_p;
+  }
+
+  /*
+   * FreeThreadSlot() - Destroys all thread slots
+   */
+  void FreeThreadSlot() {
+    if(slot_buffer_p == nullptr) {
+      return;
+    }
+
+    for(size_t i = 0;i < GetSlotCount();i++) {
+      assert(slot_list_p[i].version.load() == 0UL);
+
+      slot_list_p[i].~ThreadSlot();
+    }
+
+    free(slot_buffer_p);
+
+    slot_buffer_p = nullptr;
+    slot_list_p = nullptr;
+
+    return;
+  }
+
+  /*
+   * GetSlotCount() - Returns the number of thread slots, which is one more
+   *                  than the number of threads for the rebalance thread
+   */
+  inline size_t GetSlotCount() const {
+    return thread_num + 1;
+  }
+
+  /*
+   * GetCurrentSlot() - Returns the slot of the calling thread, or nullptr
+   *                    if the thread is not registered
+   */
+  inline ThreadSlot *GetCurrentSlot() {
+    int gc_id = TreeType::GetGCID();
+    if((gc_id < 0) || (gc_id >= static_cast<int>(GetSlotCount()))) {
+      return nullptr;
+    }
+
+    return slot_list_p + gc_id;
+  }
+
+  /*
+   * Enter() - Returns the current table and announces that the calling
+   *           thread is using it
+   *
+   * Unregistered threads are counted in a shared counter instead
+   */
+  const SplitTable *Enter() {
+    ThreadSlot *slot_p = GetCurrentSlot();
+
+    while(1) {
+      // The table is not dereferenced before it is announced, since it
+      // could be freed in between. The version is read instead, and the
+      // table loaded after it is the one of that version or a newer one
+      uint64_t version = current_version.load();
+
+      if(slot_p != nullptr) {
+        slot_p->version.store(version);
+      } else {
+        unowned_count.fetch_add(1UL);
+      }
+
+      SplitTable *current_table_p = table_p.load();
+
+      // If the version is still current after we announced it then any
+      // thread switching the table would wait for us, otherwise we retry
+      if(current_version.load() == version) {
+        return current_table_p;
+      }
+
+      Leave();
+    }
+
+    assert(false);
+    return nullptr;
+  }
+
+  /*
+   * Leave() - Announces that the calling thread no longer uses a table
+   */
+  inline void Leave() {
+    ThreadSlot *slot_p = GetCurrentSlot();
+
+    if(slot_p != nullptr) {
+      slot_p->version.store(0UL);
+    } else {
+      unowned_count.fetch_sub(1UL);
+    }
+
+    return;
+  }
+
+  /*
+   * EnterForWrite() - Enters the current table and returns the tree of
+   *                   the key after its partition is no longer frozen
+   */
+  TreeType *EnterForWrite(const KeyType &key) {
+    while(1) {
+      const SplitTable *current_table_p = Enter();
+      const Partition &partition = \
+        current_table_p->partition_list[current_table_p->Route(key,
+                                                               key_cmp_obj)];
+
+      if(partition.frozen == false) {
+        return partition.tree_p;
+      }
+
+      Leave();
+
+      std::this_thread::yield();
+    }
+
+    assert(false);
+    return nullptr;
+  }
+
+  /*
+   * CountWrite() - Counts a write of the calling thread and asks for
+   *                rebalancing every rebalance_check_interval writes
+   *
+   * The check and the split are done by the rebalance thread, since a
+   * split copies half of a partition, which could be many megabytes
+   */
+  void CountWrite() {
+    ThreadSlot *slot_p = GetCurrentSlot();
+    if((slot_p == nullptr) || (rebalance_check_interval == 0UL)) {
+      return;
+    }
+
+    slot_p->write_count++;
+    if(((slot_p->write_count % rebalance_check_interval) == 0UL) &&
+       (rebalance_requested.load() == false)) {
+      rebalance_requested.store(true);
+    }
+
+    return;
+  }
+
+  /*
+   * RebalanceThreadFunc() - Checks for rebalancing when writers ask for it
+   *                         until the exit flag is set
+   */
+  void RebalanceThreadFunc() {
+    int gc_id = static_cast<int>(thread_num);
+
+    // The ID after those of all other threads is reserved for us. It is
+    // unregistered while the thread is idle, such that it does not hold
+    // back GC of the trees
+    AssignGCID(gc_id);
+    UnregisterThread(gc_id);
+
+    while(rebalance_exit_flag.load() == false) {
+      if(rebalance_requested.exchange(false) == true) {
+        Rebalance();
+        UnregisterThread(gc_id);
+      }
+
+      std::chrono::milliseconds duration(PARTITION_REBALANCE_POLL_INTERVAL);
+      std::this_thread::sleep_for(duration);
+    }
+
+    return;
+  }
+
+  /*
+   * StartRebalanceThread() - Starts the rebalance thread
+   */
+  void StartRebalanceThread() {
+    assert(rebalance_thread_p == nullptr);
+
+    rebalance_exit_flag.store(false);
+    rebalance_thread_p = \
+      new std::thread{[this](){this->RebalanceThreadFunc();}};
+
+    return;
+  }
+
+  /*
+   * StopRebalanceThread() - Stops the rebalance thread if it is running
+   *
+   * A pending request is kept and handled after the thread is restarted
+   */
+  void StopRebalanceThread() {
+    if(rebalance_thread_p == nullptr) {
+      return;
+    }
+
+    rebalance_exit_flag.store(true);
+    rebalance_thread_p->join();
+
+    delete rebalance_thread_p;
+    rebalance_thread_p = nullptr;
+
+    return;
+  }
+
+  /*
+   * Publish() - Switches to a new table and waits until no thread uses
+   *             older ones
+   */
+  void Publish(SplitTable *new_table_p) {
+    // The pointer goes first, such that a thread that has read the new
+    // version could only load the new table (see Enter())
+    table_p.store(new_table_p);
+    current_version.store(new_table_p->version);
+
+    for(size_t i = 0;i < GetSlotCount();i++) {
+      while(1) {
+        uint64_t version = slot_list_p[i].version.load();
+        if((version == 0UL) || (version >= new_table_p->version)) {
+          break;
+        }
+
+        std::this_thread::yield();
+      }
+    }
+
+    // Unregistered threads do not tell which table they use
+    while(unowned_count.load() != 0UL) {
+      std::this_thread::yield();
+    }
+
+    return;
+  }
+
+  /*
+   * ScanPartition() - Copies all pairs in range of a partition
+   */
+  void ScanPartition(const SplitTable *scan_table_p,
+                     size_t index,
+                     std::vector<KeyValuePair> *item_list_p) {
+    TreeType *tree_p = scan_table_p->partition_list[index].tree_p;
+
+    const KeyType *low_key_p = nullptr;
+    if(index > 0UL) {
+      low_key_p = &scan_table_p->split_key_list[index - 1];
+    }
+
+    auto scan_func = [item_list_p](const KeyType &key,
+                                   const ValueType &value) {
+      item_list_p->push_back(std::make_pair(key, value));
+
+      return true;
+    };
+
+    tree_p->ScanLeafLevel(low_key_p,
+                          true,
+                          scan_table_p->GetHighKey(index),
+                          false,
+                          static_cast<size_t>(-1),
+                          scan_func);
+
+    return;
+  }
+
+  KeyComparator key_cmp_obj;
+  KeyEqualityChecker key_eq_obj;
+  KeyHashFunc key_hash_obj;
+  ValueEqualityChecker value_eq_obj;
+  ValueHashFunc value_hash_obj;
+
+  // Passed to the constructor of each tree
+  bool start_gc_thread;
+
+  std::atomic<SplitTable *> table_p;
+
+  // Version of table_p; threads announce this instead of reading it from
+  // the table, which might be freed at any time before it is announced
+  std::atomic<uint64_t> current_version;
+
+  // Only accessed while holding the rebalance lock
+  uint64_t next_version;
+
+  // All trees ever created, in creation order
+  std::vector<TreeType *> tree_list;
+
+  // Serializes splits
+  std::mutex rebalance_lock;
+
+  size_t thread_num;
+  char *slot_buffer_p;
+  ThreadSlot *slot_list_p;
+
+  // Operations of threads without a slot
+  std::atomic<size_t> unowned_count;
+
+  // See SetRebalancePolicy()
+  size_t rebalance_factor;
+  size_t min_split_size;
+  uint64_t rebalance_check_interval;
+
+  std::atomic<uint64_t> rebalance_count;
+
+  // Does splits asked for by writers (see CountWrite())
+  std::thread *rebalance_thread_p;
+  std::atomic<bool> rebalance_exit_flag;
+  std::atomic<bool> rebalance_requested;
+};
+
+}  // End index/bwtree namespace
+}  // End peloton/wangziqi2013 namespace
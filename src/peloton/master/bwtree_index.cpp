@@ -53,13 +53,13 @@ BWTREE_INDEX_TYPE::InsertEntry(const storage::Tuple *key,
   KeyType index_key;
   index_key.SetFromKey(key);
   
-  ItemPointer *item_p = new ItemPointer{location};
+  ValueType value = ValueTraits::Make(location);
   
-  bool ret = container.Insert(index_key, item_p);
-  // If insertion fails we just delete the new value and return false
+  bool ret = container.Insert(index_key, value);
+  // If insertion fails we just release the new value and return false
   // to notify the caller
   if(ret == false) {
-    delete item_p;
+    ValueTraits::Release(value);
   }
 
   return ret;
@@ -77,20 +77,20 @@ BWTREE_INDEX_TYPE::DeleteEntry(const storage::Tuple *key,
   KeyType index_key;
   index_key.SetFromKey(key);
   
-  // Must allocate new memory here
-  ItemPointer *ip_p = new ItemPointer{location};
+  // Must allocate new memory here if values are not inline
+  ValueType value = ValueTraits::Make(location);
   
   // In Delete() since we just use the value for comparison (i.e. read-only)
   // it is unnecessary for us to allocate memory
-  bool ret = container.DeleteExchange(index_key, &ip_p);
+  bool ret = container.DeleteExchange(index_key, &value);
   
   // IF delete succeeds then DeleteExchange() will exchange the deleted
   // value into this variable
   if(ret == true) {
-    //delete ip_p;
+    //ValueTraits::Release(value);
   } else {
     // This will delete the unused memory
-    delete ip_p;
+    ValueTraits::Release(value);
   }
 
   return ret;
@@ -104,16 +104,19 @@ BWTREE_INDEX_TYPE::CondInsertEntry(const storage::Tuple *key,
   KeyType index_key;
   index_key.SetFromKey(key);
   
-  ItemPointer *item_p = new ItemPointer{location};
+  ValueType value = ValueTraits::Make(location);
   bool predicate_satisfied = false;
   
   // This function will complete them in one step
   // predicate will be set to nullptr if the predicate
   // returns true for some value
-  bool ret = container.ConditionalInsert(index_key,
-                                         item_p,
-                                         predicate,
-                                         &predicate_satisfied);
+  bool ret = container.ConditionalInsert(
+      index_key,
+      value,
+      [&predicate](const ValueType &existing_value) {
+        return predicate(ValueTraits::Get(existing_value));
+      },
+      &predicate_satisfied);
 
   // If predicate is not satisfied then we know insertion successes
   if(predicate_satisfied == false) {
@@ -122,109 +125,422 @@ BWTREE_INDEX_TYPE::CondInsertEntry(const storage::Tuple *key,
   } else {
     assert(ret == false);
     
-    delete item_p;
+    ValueTraits::Release(value);
   }
 
   return ret;
 }
 
-BWTREE_TEMPLATE_ARGUMENTS
-void
-BWTREE_INDEX_TYPE::Scan(const std::vector<Value> &values,
-                        const std::vector<oid_t> &key_column_ids,
-                        const std::vector<ExpressionType> &expr_types,
-                        const ScanDirectionType &scan_direction,
-                        std::vector<ItemPointer> &result) {
-  KeyType index_key;
+/*
+ * GetSuccessorValue() - Returns the smallest value of a key column type
+ *                       which is greater than the given value
+ *
+ * NULL sorts before all other values of the type, so the successor of
+ * NULL is the minimum value. The successor of a string is the string with
+ * a '\0' appended. Returns false if the value is the largest of its type,
+ * or the type is neither integer nor varchar
+ */
+static bool GetSuccessorValue(const Value &value,
+                              ValueType value_type,
+                              Value *successor_p) {
+  switch(value_type) {
+    case VALUE_TYPE_TINYINT:
+    case VALUE_TYPE_SMALLINT:
+    case VALUE_TYPE_INTEGER:
+    case VALUE_TYPE_BIGINT: {
+      if(value.IsNull() == true) {
+        *successor_p = Value::GetMinValue(value_type);
+
+        return true;
+      }
+
+      Value column_value = value.CastAs(value_type);
+      if(column_value.Compare(Value::GetMaxValue(value_type)) >= 0) {
+        return false;
+      }
 
-  // Checkif we have leading (leftmost) column equality
-  // refer : http://www.postgresql.org/docs/8.2/static/indexes-multicolumn.html
-  oid_t leading_column_id = 0;
-  auto key_column_ids_itr = std::find(key_column_ids.begin(),
-                                      key_column_ids.end(), leading_column_id);
-
-  // SPECIAL CASE : leading column id is one of the key column ids
-  // and is involved in a equality constraint
-  bool special_case = false;
-  if (key_column_ids_itr != key_column_ids.end()) {
-    auto offset = std::distance(key_column_ids.begin(), key_column_ids_itr);
-    if (expr_types[offset] == EXPRESSION_TYPE_COMPARE_EQUAL) {
-      special_case = true;
+      *successor_p = column_value.OpIncrement();
+
+      return true;
+    }
+    case VALUE_TYPE_VARCHAR: {
+      if(value.IsNull() == true) {
+        *successor_p = ValueFactory::GetStringValue(std::string{});
+
+        return true;
+      }
+
+      Value column_value = value.CastAs(value_type);
+      std::string str{
+        static_cast<const char *>(ValuePeeker::PeekObjectValue(column_value)),
+        ValuePeeker::PeekObjectLength(column_value)};
+      str.push_back('\0');
+
+      *successor_p = ValueFactory::GetStringValue(str);
+
+      return true;
+    }
+    default: {
+      break;
     }
   }
 
-  LOG_TRACE("Special case : %d ", special_case);
+  return false;
+}
 
-  // This is only a placeholder that cannot be moved but can be assigned to
-  auto scan_begin_itr = container.NullIterator();
-  
-  std::unique_ptr<storage::Tuple> start_key;
-  bool all_constraints_are_equal = false;
-
-  // If it is a special case, we can figure out the range to scan in the index
-  if (special_case == true) {
-    start_key.reset(new storage::Tuple(metadata->GetKeySchema(), true));
-
-    // Construct the lower bound key tuple
-    all_constraints_are_equal = ConstructLowerBoundTuple(
-        start_key.get(), values, key_column_ids, expr_types);
-        
-    LOG_TRACE("All constraints are equal : %d ", all_constraints_are_equal);
-    
-    index_key.SetFromKey(start_key.get());
-    
-    // If it is point query then we just do a GetValue() since GetValue()
-    // is way more faster than scanning using iterator
-    if(all_constraints_are_equal == true) {
-      std::vector<ItemPointer *> item_p_list{};
-      
-      // This retrieves a list of ItemPointer *
-      container.GetValue(index_key, item_p_list);
-
-      // To reduce allocation
-      result.reserve(item_p_list.size());
-      
-      // Dereference pointers one by one
-      for(auto p : item_p_list) {
-        result.push_back(*p);
+/*
+ * ConstructScanBoundKeys() - Derives the key range of a scan from predicates
+ *
+ * Key columns are bound in schema order. Columns with an equality predicate
+ * are fixed in both bounds, and the first column without one takes the
+ * tightest lower and upper bound on it. The low key is always inclusive
+ * and the high key exclusive, and columns after the bound prefix are NULL,
+ * which sorts before all values. Strict low bounds and inclusive high
+ * bounds therefore use the successor value (see GetSuccessorValue()), i.e.
+ * "a > 5" becomes the inclusive low key (6, NULL, NULL, ...). This needs
+ * no maximum value, which does not exist for varchar
+ *
+ * If a successor could not be constructed, the bound is relaxed to a
+ * shorter prefix, or the scan is left unbounded on that side, and the
+ * predicates on the dropped columns are evaluated on each key instead.
+ * Predicates with a NULL value are never used as bounds
+ *
+ * *implied_list_p is set to whether each predicate is implied by the key
+ * range, and the return value indicates whether some predicate is not.
+ * If all key columns are bound by equality, *point_query_p is set to true
+ * and low key equals high key, both inclusive
+ */
+BWTREE_TEMPLATE_ARGUMENTS
+bool
+BWTREE_INDEX_TYPE::ConstructScanBoundKeys(
+    const std::vector<Value> &values,
+    const std::vector<oid_t> &key_column_ids,
+    const std::vector<ExpressionType> &expr_types,
+    std::vector<bool> *implied_list_p,
+    KeyType *low_key_p,
+    bool *low_inclusive_p,
+    bool *low_bounded_p,
+    KeyType *high_key_p,
+    bool *high_inclusive_p,
+    bool *high_bounded_p,
+    bool *point_query_p) {
+  auto key_schema = metadata->GetKeySchema();
+  oid_t column_count = key_schema->GetColumnCount();
+
+  // Whether a predicate is implied by the key range being constructed
+  std::vector<bool> &implied_list = *implied_list_p;
+  implied_list.assign(expr_types.size(), false);
+
+  // Column values of both bounds before NULL padding
+  std::vector<Value> low_list{};
+  std::vector<Value> high_list{};
+
+  // Predicates on columns starting from this one are not implied since
+  // a bound had to be relaxed
+  oid_t relaxed_column_id = column_count;
+
+  // Offsets of the predicates that are used as bounds on the range column
+  oid_t range_column_id = column_count;
+  int low_offset = -1;
+  int high_offset = -1;
+
+  for(oid_t column_id = 0; column_id < column_count; column_id++) {
+    int equal_offset = -1;
+
+    for(size_t i = 0; i < key_column_ids.size(); i++) {
+      if((key_column_ids[i] != column_id) || (values[i].IsNull() == true)) {
+        continue;
+      }
+
+      switch(expr_types[i]) {
+        case EXPRESSION_TYPE_COMPARE_EQUAL: {
+          if(equal_offset == -1) {
+            equal_offset = static_cast<int>(i);
+          }
+
+          break;
+        }
+        case EXPRESSION_TYPE_COMPARE_GREATERTHAN:
+        case EXPRESSION_TYPE_COMPARE_GREATERTHANOREQUALTO: {
+          // Larger values are tighter; on the same value the strict one is
+          if(low_offset == -1) {
+            low_offset = static_cast<int>(i);
+          } else {
+            int cmp = values[i].Compare(values[low_offset]);
+            if((cmp > 0) ||
+               ((cmp == 0) &&
+                (expr_types[i] == EXPRESSION_TYPE_COMPARE_GREATERTHAN))) {
+              low_offset = static_cast<int>(i);
+            }
+          }
+
+          break;
+        }
+        case EXPRESSION_TYPE_COMPARE_LESSTHAN:
+        case EXPRESSION_TYPE_COMPARE_LESSTHANOREQUALTO: {
+          if(high_offset == -1) {
+            high_offset = static_cast<int>(i);
+          } else {
+            int cmp = values[i].Compare(values[high_offset]);
+            if((cmp < 0) ||
+               ((cmp == 0) &&
+                (expr_types[i] == EXPRESSION_TYPE_COMPARE_LESSTHAN))) {
+              high_offset = static_cast<int>(i);
+            }
+          }
+
+          break;
+        }
+        default: {
+          break;
+        }
+      } // switch expr_types[i]
+    } // for all predicates
+
+    if(equal_offset != -1) {
+      low_list.push_back(values[equal_offset]);
+      high_list.push_back(values[equal_offset]);
+
+      // Other predicates on this column (e.g. another equality) are not
+      // implied and will be evaluated on each key
+      implied_list[equal_offset] = true;
+
+      // Range predicates seen on this column are not used as bounds
+      low_offset = -1;
+      high_offset = -1;
+
+      continue;
+    }
+
+    // This is the range column. The tightest bound implies all other
+    // bounds in the same direction on this column
+    range_column_id = column_id;
+
+    for(size_t i = 0; i < key_column_ids.size(); i++) {
+      if((key_column_ids[i] != column_id) || (values[i].IsNull() == true)) {
+        continue;
+      }
+
+      if((expr_types[i] == EXPRESSION_TYPE_COMPARE_GREATERTHAN) ||
+         (expr_types[i] == EXPRESSION_TYPE_COMPARE_GREATERTHANOREQUALTO) ||
+         (expr_types[i] == EXPRESSION_TYPE_COMPARE_LESSTHAN) ||
+         (expr_types[i] == EXPRESSION_TYPE_COMPARE_LESSTHANOREQUALTO)) {
+        implied_list[i] = true;
+      }
+    }
+
+    break;
+  } // for all key columns
+
+  *point_query_p = (range_column_id == column_count);
+
+  if(*point_query_p == false) {
+    auto value_type = key_schema->GetType(range_column_id);
+    Value successor{};
+
+    if(low_offset != -1) {
+      if(expr_types[low_offset] == \
+         EXPRESSION_TYPE_COMPARE_GREATERTHANOREQUALTO) {
+        low_list.push_back(values[low_offset]);
+      } else if(GetSuccessorValue(values[low_offset],
+                                  value_type,
+                                  &successor) == true) {
+        low_list.push_back(successor);
+      } else {
+        relaxed_column_id = range_column_id;
+      }
+    } else if(high_offset != -1) {
+      // NULL does not satisfy the upper bound
+      if(GetSuccessorValue(Value::GetNullValue(value_type),
+                           value_type,
+                           &successor) == true) {
+        low_list.push_back(successor);
+      } else {
+        relaxed_column_id = range_column_id;
+      }
+    }
+
+    if((high_offset != -1) &&
+       (expr_types[high_offset] == EXPRESSION_TYPE_COMPARE_LESSTHAN)) {
+      high_list.push_back(values[high_offset]);
+    } else {
+      // Keys up to the inclusive bound, or all keys with the equality
+      // prefix if there is no bound, are below the successor of the last
+      // column. If that does not exist, e.g. on the maximum integer, we
+      // carry to the previous column and relax the bound
+      if(high_offset != -1) {
+        high_list.push_back(values[high_offset]);
+      }
+
+      while(high_list.empty() == false) {
+        oid_t column_id = static_cast<oid_t>(high_list.size() - 1);
+
+        if(GetSuccessorValue(high_list.back(),
+                             key_schema->GetType(column_id),
+                             &successor) == true) {
+          high_list.back() = successor;
+
+          break;
+        }
+
+        high_list.pop_back();
+        relaxed_column_id = std::min(relaxed_column_id, column_id);
       }
-      
-      return;
     }
+  }
+
+  for(size_t i = 0; i < key_column_ids.size(); i++) {
+    if(key_column_ids[i] >= relaxed_column_id) {
+      implied_list[i] = false;
+    }
+  }
+
+  std::unique_ptr<storage::Tuple> low_tuple{
+    new storage::Tuple(key_schema, true)};
+  std::unique_ptr<storage::Tuple> high_tuple{
+    new storage::Tuple(key_schema, true)};
+
+  for(oid_t column_id = 0; column_id < column_count; column_id++) {
+    auto null_value = Value::GetNullValue(key_schema->GetType(column_id));
+
+    low_tuple->SetValue(column_id,
+                        (column_id < low_list.size()) ? \
+                          low_list[column_id] : null_value,
+                        GetPool());
+    high_tuple->SetValue(column_id,
+                         (column_id < high_list.size()) ? \
+                           high_list[column_id] : null_value,
+                         GetPool());
+  }
+
+  low_key_p->SetFromKey(low_tuple.get());
+  *low_inclusive_p = true;
+  *low_bounded_p = (low_list.empty() == false);
 
-    // This returns an iterator pointing to index_key's values
-    scan_begin_itr = container.Begin(index_key);
+  if(*point_query_p == true) {
+    *high_key_p = *low_key_p;
+    *high_inclusive_p = true;
+    *high_bounded_p = true;
   } else {
-    scan_begin_itr = container.Begin();
+    high_key_p->SetFromKey(high_tuple.get());
+    *high_inclusive_p = false;
+    *high_bounded_p = (high_list.empty() == false);
   }
-  
-  //printf("Start scanning\n");
 
-  switch (scan_direction) {
-    case SCAN_DIRECTION_TYPE_FORWARD:
-    case SCAN_DIRECTION_TYPE_BACKWARD: {
-      // Scan the index entries in forward direction
-      for (auto scan_itr = scan_begin_itr;
-           scan_itr.IsEnd() == false;
-           scan_itr++) {
-        KeyType &scan_current_key = const_cast<KeyType &>(scan_itr->first);
-        
-        auto tuple =
-            scan_current_key.GetTupleForComparison(metadata->GetKeySchema());
-
-        // Compare the current key in the scan with "values" based on
-        // "expression types"
-        // For instance, "5" EXPR_GREATER_THAN "2" is true
-        if (Compare(tuple, key_column_ids, expr_types, values) == true) {
-          result.push_back(*(scan_itr->second));
+  LOG_TRACE("Scan bounds: low bounded = %d; high bounded = %d; "
+            "point query = %d",
+            *low_bounded_p,
+            *high_bounded_p,
+            *point_query_p);
+
+  return std::find(implied_list.begin(),
+                   implied_list.end(),
+                   false) != implied_list.end();
+}
+
+/*
+ * ScanWithPredicate() - Calls a function on all values satisfying predicates
+ *
+ * The scan only visits the key range derived by ConstructScanBoundKeys()
+ * and stops at its upper (or lower, for backward scans) end by comparing
+ * leaf keys with the bound keys. Predicates not implied by the key range
+ * are evaluated on the encoded leaf key by KeyResidualPredicate, and the
+ * key is only decoded into a tuple if the key type does not support that.
+ * Point queries go through ForEachValue() which does not build any
+ * iterator state
+ */
+BWTREE_TEMPLATE_ARGUMENTS
+template <typename ItemFunc>
+void
+BWTREE_INDEX_TYPE::ScanWithPredicate(
+    const std::vector<Value> &values,
+    const std::vector<oid_t> &key_column_ids,
+    const std::vector<ExpressionType> &expr_types,
+    const ScanDirectionType &scan_direction,
+    ItemFunc &&item_func) {
+  std::vector<bool> implied_list{};
+  KeyType low_key;
+  KeyType high_key;
+  bool low_inclusive;
+  bool high_inclusive;
+  bool low_bounded;
+  bool high_bounded;
+  bool point_query;
+
+  bool need_compare = ConstructScanBoundKeys(values,
+                                             key_column_ids,
+                                             expr_types,
+                                             &implied_list,
+                                             &low_key,
+                                             &low_inclusive,
+                                             &low_bounded,
+                                             &high_key,
+                                             &high_inclusive,
+                                             &high_bounded,
+                                             &point_query);
+
+  LOG_TRACE("Need to compare : %d ", need_compare);
+
+  // Point query does not depend on scan direction since all values are
+  // mapped by the same key
+  if((point_query == true) && (need_compare == false)) {
+    container.ForEachValue(low_key, item_func);
+
+    return;
+  }
+
+  KeyResidualPredicate<KeyType> residual_predicate{metadata->GetKeySchema(),
+                                                   values,
+                                                   key_column_ids,
+                                                   expr_types,
+                                                   implied_list};
+  bool decode_key = (residual_predicate.IsSupported() == false);
+
+  auto scan_func = \
+    [&](const KeyType &scan_current_key, const ValueType &item_p) {
+      if(need_compare == true) {
+        if(decode_key == false) {
+          if(residual_predicate.Evaluate(scan_current_key) == false) {
+            return true;
+          }
         } else {
-          // We can stop scanning if we know that all constraints are equal
-          if (all_constraints_are_equal == true) {
-            break;
+          auto tuple = const_cast<KeyType &>(scan_current_key).\
+              GetTupleForComparison(metadata->GetKeySchema());
+
+          // Compare the current key in the scan with "values" based on
+          // "expression types"
+          // For instance, "5" EXPR_GREATER_THAN "2" is true
+          if(Compare(tuple, key_column_ids, expr_types, values) == false) {
+            return true;
           }
         }
       }
 
+      item_func(item_p);
+
+      return true;
+    };
+
+  const KeyType *low_key_p = (low_bounded == true) ? &low_key : nullptr;
+  const KeyType *high_key_p = (high_bounded == true) ? &high_key : nullptr;
+
+  switch (scan_direction) {
+    case SCAN_DIRECTION_TYPE_FORWARD: {
+      container.ScanLeafLevel(low_key_p,
+                              low_inclusive,
+                              high_key_p,
+                              high_inclusive,
+                              static_cast<size_t>(-1),
+                              scan_func);
+    } break;
+
+    case SCAN_DIRECTION_TYPE_BACKWARD: {
+      container.ScanLeafLevelReverse(high_key_p,
+                                     high_inclusive,
+                                     low_key_p,
+                                     low_inclusive,
+                                     static_cast<size_t>(-1),
+                                     scan_func);
     } break;
 
     case SCAN_DIRECTION_TYPE_INVALID:
@@ -236,15 +552,35 @@ BWTREE_INDEX_TYPE::Scan(const std::vector<Value> &values,
   return;
 }
 
+BWTREE_TEMPLATE_ARGUMENTS
+void
+BWTREE_INDEX_TYPE::Scan(const std::vector<Value> &values,
+                        const std::vector<oid_t> &key_column_ids,
+                        const std::vector<ExpressionType> &expr_types,
+                        const ScanDirectionType &scan_direction,
+                        std::vector<ItemPointer> &result) {
+  ScanWithPredicate(values,
+                    key_column_ids,
+                    expr_types,
+                    scan_direction,
+                    [&result](const ValueType &item_p) {
+                      result.push_back(ValueTraits::Get(item_p));
+                    });
+
+  return;
+}
+
 BWTREE_TEMPLATE_ARGUMENTS
 void
 BWTREE_INDEX_TYPE::ScanAllKeys(std::vector<ItemPointer> &result) {
-  auto it = container.Begin();
+  // Full table scan reads consolidated leaf nodes in place without
+  // copying them into the iterator
+  auto it = container.PinnedBegin();
 
   // scan all entries
   while (it.IsEnd() == false) {
-    result.push_back(*(it->second));
-    it++;
+    result.push_back(ValueTraits::Get(it->second));
+    ++it;
   }
 
   return;
@@ -257,13 +593,10 @@ BWTREE_INDEX_TYPE::ScanKey(const storage::Tuple *key,
   KeyType index_key;
   index_key.SetFromKey(key);
   
-  std::vector<ItemPointer *> temp_list{};
-
-  // This function in BwTree fills a given vector
-  container.GetValue(index_key, temp_list);
-  for(auto item_pointer_p : temp_list) {
-    result.push_back(*item_pointer_p);
-  }
+  // Values are read in place without an intermediate list
+  container.ForEachValue(index_key, [&result](const ValueType &item_p) {
+    result.push_back(ValueTraits::Get(item_p));
+  });
 
   return;
 }
@@ -275,95 +608,17 @@ BWTREE_INDEX_TYPE::Scan(const std::vector<Value> &values,
                         const std::vector<ExpressionType> &expr_types,
                         const ScanDirectionType &scan_direction,
                         std::vector<ItemPointer *> &result) {
-  KeyType index_key;
-
-  // Checkif we have leading (leftmost) column equality
-  // refer : http://www.postgresql.org/docs/8.2/static/indexes-multicolumn.html
-  oid_t leading_column_id = 0;
-  auto key_column_ids_itr = std::find(key_column_ids.begin(),
-                                      key_column_ids.end(), leading_column_id);
-
-  // SPECIAL CASE : leading column id is one of the key column ids
-  // and is involved in a equality constraint
-  bool special_case = false;
-  if (key_column_ids_itr != key_column_ids.end()) {
-    auto offset = std::distance(key_column_ids.begin(), key_column_ids_itr);
-    if (expr_types[offset] == EXPRESSION_TYPE_COMPARE_EQUAL) {
-      special_case = true;
-    }
+  if(ValueTraits::stable_pointer == false) {
+    throw Exception("Inline BWTree index values have no stable pointer \n");
   }
 
-  LOG_TRACE("Special case : %d ", special_case);
-
-  // This is only a placeholder that cannot be moved but can be assigned to
-  auto scan_begin_itr = container.NullIterator();
-
-  std::unique_ptr<storage::Tuple> start_key;
-  bool all_constraints_are_equal = false;
-
-  // If it is a special case, we can figure out the range to scan in the index
-  if (special_case == true) {
-    start_key.reset(new storage::Tuple(metadata->GetKeySchema(), true));
-
-    // Construct the lower bound key tuple
-    all_constraints_are_equal = ConstructLowerBoundTuple(
-        start_key.get(), values, key_column_ids, expr_types);
-
-    LOG_TRACE("All constraints are equal : %d ", all_constraints_are_equal);
-
-    index_key.SetFromKey(start_key.get());
-/*
-    // If it is point query then we just do a GetValue() since GetValue()
-    // is way more faster than scanning using iterator
-    if(all_constraints_are_equal == true) {
-      //printf("All constraints are equal\n");
-      
-      // This retrieves a list of ItemPointer *
-      container.GetValue(index_key, result);
-
-      return;
-    }
-*/
-    //printf("Non special case\n");
-
-    // This returns an iterator pointing to index_key's values
-    scan_begin_itr = container.Begin(index_key);
-  } else {
-    scan_begin_itr = container.Begin();
-  }
-
-  switch (scan_direction) {
-    case SCAN_DIRECTION_TYPE_FORWARD:
-    case SCAN_DIRECTION_TYPE_BACKWARD: {
-      // Scan the index entries in forward direction
-      for (auto scan_itr = scan_begin_itr;
-           scan_itr.IsEnd() == false;
-           scan_itr++) {
-        KeyType &scan_current_key = const_cast<KeyType &>(scan_itr->first);
-          
-        auto tuple =
-            scan_current_key.GetTupleForComparison(metadata->GetKeySchema());
-
-        // Compare the current key in the scan with "values" based on
-        // "expression types"
-        // For instance, "5" EXPR_GREATER_THAN "2" is true
-        if (Compare(tuple, key_column_ids, expr_types, values) == true) {
-          result.push_back(scan_itr->second);
-        } else {
-          // We can stop scanning if we know that all constraints are equal
-          if (all_constraints_are_equal == true) {
-            break;
-          }
-        }
-      }
-
-    } break;
-
-    case SCAN_DIRECTION_TYPE_INVALID:
-    default:
-      throw Exception("Invalid scan direction \n");
-      break;
-  }
+  ScanWithPredicate(values,
+                    key_column_ids,
+                    expr_types,
+                    scan_direction,
+                    [&result](const ValueType &item_p) {
+                      result.push_back(ValueTraits::GetPointer(item_p));
+                    });
 
   return;
 }
@@ -371,12 +626,18 @@ BWTREE_INDEX_TYPE::Scan(const std::vector<Value> &values,
 BWTREE_TEMPLATE_ARGUMENTS
 void
 BWTREE_INDEX_TYPE::ScanAllKeys(std::vector<ItemPointer *> &result) {
-  auto it = container.Begin();
+  if(ValueTraits::stable_pointer == false) {
+    throw Exception("Inline BWTree index values have no stable pointer \n");
+  }
+
+  // Full table scan reads consolidated leaf nodes in place without
+  // copying them into the iterator
+  auto it = container.PinnedBegin();
 
   // scan all entries
   while (it.IsEnd() == false) {
-    result.push_back(it->second);
-    it++;
+    result.push_back(ValueTraits::GetPointer(it->second));
+    ++it;
   }
 
   return;
@@ -386,11 +647,16 @@ BWTREE_TEMPLATE_ARGUMENTS
 void
 BWTREE_INDEX_TYPE::ScanKey(const storage::Tuple *key,
                            std::vector<ItemPointer *> &result) {
+  if(ValueTraits::stable_pointer == false) {
+    throw Exception("Inline BWTree index values have no stable pointer \n");
+  }
+
   KeyType index_key;
   index_key.SetFromKey(key);
 
-  // This function in BwTree fills a given vector
-  container.GetValue(index_key, result);
+  container.ForEachValue(index_key, [&result](const ValueType &item_p) {
+    result.push_back(ValueTraits::GetPointer(item_p));
+  });
 
   return;
 }
@@ -482,5 +748,81 @@ template class BWTreeIndex<TupleKey,
                            ItemPointerComparator,
                            ItemPointerHashFunc>;
 
+// Generic key with ItemPointer stored inline in leaf nodes
+template class BWTreeIndex<GenericKey<4>,
+                           ItemPointer,
+                           GenericComparator<4>,
+                           GenericEqualityChecker<4>,
+                           GenericHasher<4>,
+                           ItemPointerPackedComparator,
+                           ItemPointerPackedHashFunc>;
+template class BWTreeIndex<GenericKey<8>,
+                           ItemPointer,
+                           GenericComparator<8>,
+                           GenericEqualityChecker<8>,
+                           GenericHasher<8>,
+                           ItemPointerPackedComparator,
+                           ItemPointerPackedHashFunc>;
+template class BWTreeIndex<GenericKey<16>,
+                           ItemPointer,
+                           GenericComparator<16>,
+                           GenericEqualityChecker<16>,
+                           GenericHasher<16>,
+                           ItemPointerPackedComparator,
+                           ItemPointerPackedHashFunc>;
+template class BWTreeIndex<GenericKey<64>,
+                           ItemPointer,
+                           GenericComparator<64>,
+                           GenericEqualityChecker<64>,
+                           GenericHasher<64>,
+                           ItemPointerPackedComparator,
+                           ItemPointerPackedHashFunc>;
+template class BWTreeIndex<GenericKey<256>,
+                           ItemPointer,
+                           GenericComparator<256>,
+                           GenericEqualityChecker<256>,
+                           GenericHasher<256>,
+                           ItemPointerPackedComparator,
+                           ItemPointerPackedHashFunc>;
+
+// Tuple key with ItemPointer stored inline in leaf nodes
+template class BWTreeIndex<TupleKey,
+                           ItemPointer,
+                           TupleKeyComparator,
+                           TupleKeyEqualityChecker,
+                           TupleKeyHasher,
+                           ItemPointerPackedComparator,
+                           ItemPointerPackedHashFunc>;
+
+// Normalized generic key with ItemPointer stored inline in leaf nodes
+template class BWTreeIndex<NormalizedGenericKey<8>,
+                           ItemPointer,
+                           NormalizedGenericComparator<8>,
+                           NormalizedGenericEqualityChecker<8>,
+                           NormalizedGenericHasher<8>,
+                           ItemPointerPackedComparator,
+                           ItemPointerPackedHashFunc>;
+template class BWTreeIndex<NormalizedGenericKey<16>,
+                           ItemPointer,
+                           NormalizedGenericComparator<16>,
+                           NormalizedGenericEqualityChecker<16>,
+                           NormalizedGenericHasher<16>,
+                           ItemPointerPackedComparator,
+                           ItemPointerPackedHashFunc>;
+template class BWTreeIndex<NormalizedGenericKey<64>,
+                           ItemPointer,
+                           NormalizedGenericComparator<64>,
+                           NormalizedGenericEqualityChecker<64>,
+                           NormalizedGenericHasher<64>,
+                           ItemPointerPackedComparator,
+                           ItemPointerPackedHashFunc>;
+template class BWTreeIndex<NormalizedGenericKey<256>,
+                           ItemPointer,
+                           NormalizedGenericComparator<256>,
+                           NormalizedGenericEqualityChecker<256>,
+                           NormalizedGenericHasher<256>,
+                           ItemPointerPackedComparator,
+                           ItemPointerPackedHashFunc>;
+
 }  // End index namespace
 }  // End peloton namespace
@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstring>
 #include <vector>
 #include <string>
 #include <map>
@@ -22,6 +24,7 @@
 #include "index/index.h"
 
 #include "index/bwtree.h"
+#include "index/normalized_key.h"
 
 #define BWTREE_INDEX_TYPE BWTreeIndex <KeyType, \
                                        ValueType, \
@@ -54,6 +57,476 @@ class ItemPointerHashFunc {
   ItemPointerHashFunc() {}
 };
 
+/*
+ * PackItemPointer() - Returns the (block, offset) pair as one 64 bit integer
+ */
+inline uint64_t PackItemPointer(const ItemPointer &p) {
+  return (static_cast<uint64_t>(p.block) << 32) | \
+         static_cast<uint64_t>(p.offset);
+}
+
+/*
+ * class ItemPointerPackedComparator - Equality checker for inline values
+ *
+ * This is used when ItemPointer is stored directly inside leaf nodes
+ * and compares both fields with one 64 bit comparison
+ */
+class ItemPointerPackedComparator {
+ public:
+  bool operator()(const ItemPointer &p1, const ItemPointer &p2) const {
+    return PackItemPointer(p1) == PackItemPointer(p2);
+  }
+
+  ItemPointerPackedComparator(const ItemPointerPackedComparator&) {}
+  ItemPointerPackedComparator() {}
+};
+
+/*
+ * class ItemPointerPackedHashFunc - Hash function for inline values
+ */
+class ItemPointerPackedHashFunc {
+ public:
+  size_t operator()(const ItemPointer &p) const {
+    return std::hash<uint64_t>()(PackItemPointer(p));
+  }
+
+  ItemPointerPackedHashFunc(const ItemPointerPackedHashFunc&) {}
+  ItemPointerPackedHashFunc() {}
+};
+
+/*
+ * struct BWTreeIndexValueTraits - How ItemPointer is stored as BwTree value
+ *
+ * The index is instantiated with either ItemPointer * as value type, in
+ * which case every entry owns a heap allocated ItemPointer, or with
+ * ItemPointer itself, in which case the pointer is stored inline in the
+ * leaf node and no allocation or dereference is needed
+ */
+template <typename ValueType>
+struct BWTreeIndexValueTraits;
+
+template <>
+struct BWTreeIndexValueTraits<ItemPointer *> {
+  // Whether values could be returned as stable ItemPointer *
+  static constexpr bool stable_pointer = true;
+
+  static ItemPointer *Make(const ItemPointer &location) {
+    return new ItemPointer{location};
+  }
+
+  static void Release(ItemPointer *value) {
+    delete value;
+
+    return;
+  }
+
+  static const ItemPointer &Get(ItemPointer * const &value) {
+    return *value;
+  }
+
+  static ItemPointer *GetPointer(ItemPointer * const &value) {
+    return value;
+  }
+};
+
+template <>
+struct BWTreeIndexValueTraits<ItemPointer> {
+  // Inline values live inside leaf nodes which could be freed after
+  // the scan, so their addresses must not be handed out
+  static constexpr bool stable_pointer = false;
+
+  static ItemPointer Make(const ItemPointer &location) {
+    return location;
+  }
+
+  static void Release(const ItemPointer &) {
+    return;
+  }
+
+  static const ItemPointer &Get(const ItemPointer &value) {
+    return value;
+  }
+
+  static ItemPointer *GetPointer(const ItemPointer &) {
+    return nullptr;
+  }
+};
+
+/*
+ * class NormalizedGenericKey - Binary comparable key built from a tuple
+ *
+ * Column values are encoded with NormalizedKey, such that the comparator
+ * compares 8 bytes at a time without consulting the key schema. Integer
+ * and inlined varchar columns are supported. Varchar columns start with a
+ * one byte NULL indicator, and integer NULLs are the smallest value of the
+ * type, so a column is NULL iff all its encoded bytes are zero and NULL
+ * sorts before all other values
+ */
+template <size_t KeySize>
+class NormalizedGenericKey : public NormalizedKey<KeySize> {
+ public:
+  /*
+   * SetFromKey() - Encodes all columns of the key tuple
+   *
+   * Throws if a column type is not supported or the key does not fit
+   */
+  void SetFromKey(const storage::Tuple *tuple) {
+    const catalog::Schema *key_schema = tuple->GetSchema();
+
+    this->Clear();
+
+    for(oid_t i = 0;i < key_schema->GetColumnCount();i++) {
+      if(AppendColumn(key_schema->GetType(i), tuple->GetValue(i)) == false) {
+        throw Exception("Normalized key size is too small \n");
+      }
+    }
+
+    return;
+  }
+
+  /*
+   * AppendColumn() - Encodes a value of the given column type
+   *
+   * Returns false if the column does not fit. Throws if the type is
+   * not supported
+   */
+  bool AppendColumn(ValueType value_type, const Value &value) {
+    switch(value_type) {
+      case VALUE_TYPE_TINYINT:
+        return this->AppendInteger(ValuePeeker::PeekTinyInt(value));
+      case VALUE_TYPE_SMALLINT:
+        return this->AppendInteger(ValuePeeker::PeekSmallInt(value));
+      case VALUE_TYPE_INTEGER:
+        return this->AppendInteger(ValuePeeker::PeekInteger(value));
+      case VALUE_TYPE_BIGINT:
+        return this->AppendInteger(ValuePeeker::PeekBigInt(value));
+      case VALUE_TYPE_VARCHAR: {
+        if(value.IsNull() == true) {
+          return this->AppendUnsigned(static_cast<uint8_t>(0x00));
+        }
+
+        size_t old_size = this->size;
+        if(this->AppendUnsigned(static_cast<uint8_t>(0x01)) == false) {
+          return false;
+        }
+
+        bool ret = this->AppendString(
+          static_cast<const char *>(ValuePeeker::PeekObjectValue(value)),
+          ValuePeeker::PeekObjectLength(value));
+
+        // Leave the key unchanged if the string does not fit
+        if(ret == false) {
+          this->data[old_size] = 0x00;
+          this->size = old_size;
+        }
+
+        return ret;
+      }
+      default:
+        throw Exception("Unsupported normalized key column type \n");
+    }
+
+    return false;
+  }
+
+  /*
+   * GetColumnEnd() - Returns the offset past the column starting at offset
+   */
+  size_t GetColumnEnd(ValueType value_type, size_t offset) const {
+    switch(value_type) {
+      case VALUE_TYPE_TINYINT:
+        return offset + sizeof(int8_t);
+      case VALUE_TYPE_SMALLINT:
+        return offset + sizeof(int16_t);
+      case VALUE_TYPE_INTEGER:
+        return offset + sizeof(int32_t);
+      case VALUE_TYPE_BIGINT:
+        return offset + sizeof(int64_t);
+      case VALUE_TYPE_VARCHAR: {
+        // NULL only has the indicator byte
+        if(this->data[offset] == 0x00) {
+          return offset + 1;
+        }
+
+        offset++;
+
+        // 0x00 is either escaped by 0xFF or is the first terminator byte
+        while(offset + 1 < this->size) {
+          if(this->data[offset] != 0x00) {
+            offset++;
+          } else if(this->data[offset + 1] == 0xFF) {
+            offset += 2;
+          } else {
+            return offset + 2;
+          }
+        }
+
+        return this->size;
+      }
+      default:
+        throw Exception("Unsupported normalized key column type \n");
+    }
+
+    return offset;
+  }
+
+  /*
+   * IsColumnNull() - Whether the column in [offset, end) is NULL
+   */
+  bool IsColumnNull(size_t offset, size_t end) const {
+    for(size_t i = offset;i < end;i++) {
+      if(this->data[i] != 0x00) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  /*
+   * GetTupleForComparison() - Decodes the key into a tuple of key schema
+   *
+   * This is only needed when a scan has predicates that could not be
+   * evaluated on the encoded key, so decoding is not on the common path
+   */
+  storage::Tuple GetTupleForComparison(const catalog::Schema *key_schema) {
+    storage::Tuple tuple{key_schema, true};
+    size_t offset = 0;
+
+    for(oid_t i = 0;i < key_schema->GetColumnCount();i++) {
+      switch(key_schema->GetType(i)) {
+        case VALUE_TYPE_TINYINT:
+          tuple.SetValue(i,
+                         ValueFactory::GetTinyIntValue(
+                           this->template GetInteger<int8_t>(&offset)),
+                         nullptr);
+          break;
+        case VALUE_TYPE_SMALLINT:
+          tuple.SetValue(i,
+                         ValueFactory::GetSmallIntValue(
+                           this->template GetInteger<int16_t>(&offset)),
+                         nullptr);
+          break;
+        case VALUE_TYPE_INTEGER:
+          tuple.SetValue(i,
+                         ValueFactory::GetIntegerValue(
+                           this->template GetInteger<int32_t>(&offset)),
+                         nullptr);
+          break;
+        case VALUE_TYPE_BIGINT:
+          tuple.SetValue(i,
+                         ValueFactory::GetBigIntValue(
+                           this->template GetInteger<int64_t>(&offset)),
+                         nullptr);
+          break;
+        case VALUE_TYPE_VARCHAR:
+          if(this->template GetUnsigned<uint8_t>(&offset) == 0x00) {
+            tuple.SetValue(i,
+                           Value::GetNullValue(VALUE_TYPE_VARCHAR),
+                           nullptr);
+          } else {
+            tuple.SetValue(i,
+                           ValueFactory::GetStringValue(
+                             this->GetString(&offset)),
+                           nullptr);
+          }
+          break;
+        default:
+          throw Exception("Unsupported normalized key column type \n");
+      }
+    }
+
+    return tuple;
+  }
+};
+
+/*
+ * class KeyResidualPredicate - Evaluates scan predicates that are not
+ *                              implied by the key range on the leaf key
+ *
+ * This is the generic version for key types whose columns could not be
+ * compared in place. IsSupported() returns false, and the scan then
+ * decodes the key with GetTupleForComparison() and calls Index::Compare()
+ */
+template <typename KeyType>
+class KeyResidualPredicate {
+ public:
+  KeyResidualPredicate(const catalog::Schema *,
+                       const std::vector<Value> &,
+                       const std::vector<oid_t> &,
+                       const std::vector<ExpressionType> &,
+                       const std::vector<bool> &) {
+    return;
+  }
+
+  bool IsSupported() const {
+    return false;
+  }
+
+  bool Evaluate(const KeyType &) const {
+    return true;
+  }
+};
+
+/*
+ * class KeyResidualPredicate - Compares encoded columns of normalized keys
+ *
+ * Each predicate value is encoded once with the column type, and then
+ * compared with the encoded column of the leaf key using memcmp(). Since
+ * the encoding of a column never is a proper prefix of another encoding
+ * of the same type, this gives the same order as comparing values.
+ * Predicates on a NULL column are false. Predicates with a NULL value or
+ * an expression type other than comparison are not supported
+ */
+template <size_t KeySize>
+class KeyResidualPredicate<NormalizedGenericKey<KeySize>> {
+ private:
+  struct ColumnPredicate {
+    oid_t column_id;
+    ExpressionType expr_type;
+
+    // Encoded bytes of the predicate value
+    std::string value;
+  };
+
+  std::vector<ValueType> type_list;
+  std::vector<ColumnPredicate> predicate_list;
+  bool supported;
+
+ public:
+  KeyResidualPredicate(const catalog::Schema *key_schema,
+                       const std::vector<Value> &values,
+                       const std::vector<oid_t> &key_column_ids,
+                       const std::vector<ExpressionType> &expr_types,
+                       const std::vector<bool> &implied_list) :
+    type_list{},
+    predicate_list{},
+    supported{true} {
+    for(oid_t i = 0;i < key_schema->GetColumnCount();i++) {
+      type_list.push_back(key_schema->GetType(i));
+    }
+
+    for(size_t i = 0;i < key_column_ids.size();i++) {
+      if(implied_list[i] == true) {
+        continue;
+      }
+
+      switch(expr_types[i]) {
+        case EXPRESSION_TYPE_COMPARE_EQUAL:
+        case EXPRESSION_TYPE_COMPARE_NOTEQUAL:
+        case EXPRESSION_TYPE_COMPARE_LESSTHAN:
+        case EXPRESSION_TYPE_COMPARE_LESSTHANOREQUALTO:
+        case EXPRESSION_TYPE_COMPARE_GREATERTHAN:
+        case EXPRESSION_TYPE_COMPARE_GREATERTHANOREQUALTO:
+          break;
+        default:
+          supported = false;
+          break;
+      }
+
+      if((supported == false) || (values[i].IsNull() == true)) {
+        supported = false;
+
+        return;
+      }
+
+      ValueType value_type = type_list[key_column_ids[i]];
+      NormalizedGenericKey<KeySize> value_key{};
+      if(value_key.AppendColumn(value_type,
+                                values[i].CastAs(value_type)) == false) {
+        supported = false;
+
+        return;
+      }
+
+      predicate_list.push_back(ColumnPredicate{
+        key_column_ids[i],
+        expr_types[i],
+        std::string{reinterpret_cast<const char *>(value_key.data),
+                    value_key.size}});
+    }
+
+    // Columns are located from left to right in one pass over the key
+    std::stable_sort(predicate_list.begin(),
+                     predicate_list.end(),
+                     [](const ColumnPredicate &p1, const ColumnPredicate &p2) {
+                       return p1.column_id < p2.column_id;
+                     });
+
+    return;
+  }
+
+  bool IsSupported() const {
+    return supported;
+  }
+
+  /*
+   * Evaluate() - Whether all predicates are satisfied by the key
+   */
+  bool Evaluate(const NormalizedGenericKey<KeySize> &key) const {
+    oid_t column_id = 0;
+    size_t offset = 0;
+
+    for(const ColumnPredicate &predicate : predicate_list) {
+      while(column_id < predicate.column_id) {
+        offset = key.GetColumnEnd(type_list[column_id], offset);
+        column_id++;
+      }
+
+      size_t end = key.GetColumnEnd(type_list[column_id], offset);
+      if(key.IsColumnNull(offset, end) == true) {
+        return false;
+      }
+
+      size_t length = end - offset;
+      int cmp = memcmp(key.data + offset,
+                       predicate.value.data(),
+                       std::min(length, predicate.value.size()));
+      if(cmp == 0) {
+        cmp = (length < predicate.value.size()) ? -1 : \
+              ((length > predicate.value.size()) ? 1 : 0);
+      }
+
+      bool ret;
+      switch(predicate.expr_type) {
+        case EXPRESSION_TYPE_COMPARE_EQUAL:
+          ret = (cmp == 0);
+          break;
+        case EXPRESSION_TYPE_COMPARE_NOTEQUAL:
+          ret = (cmp != 0);
+          break;
+        case EXPRESSION_TYPE_COMPARE_LESSTHAN:
+          ret = (cmp < 0);
+          break;
+        case EXPRESSION_TYPE_COMPARE_LESSTHANOREQUALTO:
+          ret = (cmp <= 0);
+          break;
+        case EXPRESSION_TYPE_COMPARE_GREATERTHAN:
+          ret = (cmp > 0);
+          break;
+        default:
+          ret = (cmp >= 0);
+          break;
+      }
+
+      if(ret == false) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+};
+
+template <size_t KeySize>
+using NormalizedGenericComparator = NormalizedKeyComparator<KeySize>;
+
+template <size_t KeySize>
+using NormalizedGenericEqualityChecker = NormalizedKeyEqualityChecker<KeySize>;
+
+template <size_t KeySize>
+using NormalizedGenericHasher = NormalizedKeyHashFunc<KeySize>;
+
 /**
  * BW tree-based index implementation.
  *
@@ -62,6 +535,10 @@ class ItemPointerHashFunc {
  * be many values mapped by a single key, and we need to distinguish
  * between values.
  *
+ * ValueType is either ItemPointer * or ItemPointer. The latter stores
+ * the location inline in the leaf and is compared with ItemPointerPacked*
+ * functors; it does not support the ItemPointer * result interface.
+ *
  * @see Index
  */
 template <typename KeyType,
@@ -82,6 +559,8 @@ class BWTreeIndex : public Index {
                          ValueEqualityChecker,
                          ValueHashFunc>;
 
+  using ValueTraits = BWTreeIndexValueTraits<ValueType>;
+
  public:
   BWTreeIndex(IndexMetadata *metadata);
 
@@ -118,13 +597,37 @@ class BWTreeIndex : public Index {
 
   std::string GetTypeName() const;
 
-  // TODO: Implement this
-  bool Cleanup() { return true; }
+  // Consolidates delta chains and collects garbage of the calling thread
+  bool Cleanup() {
+    container.Cleanup();
 
-  // TODO: Implement this
-  size_t GetMemoryFootprint() { return 0; }
+    return true;
+  }
+
+  // Memory used by the tree; in pointer mode the ItemPointer objects
+  // allocated for each entry are not included
+  size_t GetMemoryFootprint() { return container.GetMemoryFootprint(); }
 
  protected:
+  bool ConstructScanBoundKeys(const std::vector<Value> &values,
+                              const std::vector<oid_t> &key_column_ids,
+                              const std::vector<ExpressionType> &expr_types,
+                              std::vector<bool> *implied_list_p,
+                              KeyType *low_key_p,
+                              bool *low_inclusive_p,
+                              bool *low_bounded_p,
+                              KeyType *high_key_p,
+                              bool *high_inclusive_p,
+                              bool *high_bounded_p,
+                              bool *point_query_p);
+
+  template <typename ItemFunc>
+  void ScanWithPredicate(const std::vector<Value> &values,
+                         const std::vector<oid_t> &key_column_ids,
+                         const std::vector<ExpressionType> &expr_types,
+                         const ScanDirectionType &scan_direction,
+                         ItemFunc &&item_func);
+
   // equality checker and comparator
   KeyComparator comparator;
   KeyEqualityChecker equals;
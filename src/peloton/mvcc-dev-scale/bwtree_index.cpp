@@ -242,16 +242,13 @@ BWTREE_INDEX_TYPE::Scan(const std::vector<Value> &values,
     return;
   }
 
-  // This returns an iterator pointing to index_key's values
-  auto scan_begin_itr = container.Begin(index_key);
+  index_key.SetFromKey(start_key.get());
 
   switch (scan_direction) {
-    case SCAN_DIRECTION_TYPE_FORWARD:
-    case SCAN_DIRECTION_TYPE_BACKWARD: {
-      // TODO: This requires further optimization to at least
-      // find an upper bound for scanning (i.e. when the highest columns
-      // has < or <= relation). Otherwise we will have to scan till the
-      // end of the index which is toooooooooooooooooooooooooooooo slow
+    case SCAN_DIRECTION_TYPE_FORWARD: {
+      // This returns an iterator pointing to index_key's values
+      auto scan_begin_itr = container.Begin(index_key);
+
       for (auto scan_itr = scan_begin_itr;
            scan_itr.IsEnd() == false;
            scan_itr++) {
@@ -271,6 +268,32 @@ BWTREE_INDEX_TYPE::Scan(const std::vector<Value> &values,
       break;
     }
 
+    case SCAN_DIRECTION_TYPE_BACKWARD: {
+      // Scans from the last key down to the lower bound. Leaf nodes are
+      // located through a cached parent node instead of traversing from
+      // the root for every key as MoveBackByOne() does
+      auto scan_func = \
+        [&](const KeyType &scan_current_key, ItemPointer * const &item_p) {
+          auto tuple = const_cast<KeyType &>(scan_current_key).\
+              GetTupleForComparison(metadata->GetKeySchema());
+
+          if (Compare(tuple, key_column_ids, expr_types, values) == true) {
+            result.push_back(*item_p);
+          }
+
+          return true;
+        };
+
+      container.ScanLeafLevelReverse(nullptr,
+                                     true,
+                                     &index_key,
+                                     true,
+                                     static_cast<size_t>(-1),
+                                     scan_func);
+
+      break;
+    }
+
     case SCAN_DIRECTION_TYPE_INVALID:
     default:
       throw Exception("Invalid scan direction \n");
@@ -283,12 +306,14 @@ BWTREE_INDEX_TYPE::Scan(const std::vector<Value> &values,
 BWTREE_TEMPLATE_ARGUMENTS
 void
 BWTREE_INDEX_TYPE::ScanAllKeys(std::vector<ItemPointer> &result) {
-  auto it = container.Begin();
+  // Full table scan reads consolidated leaf nodes in place without
+  // copying them into the iterator
+  auto it = container.PinnedBegin();
 
   // scan all entries
   while (it.IsEnd() == false) {
     result.push_back(*(it->second));
-    it++;
+    ++it;
   }
 
   return;
@@ -332,16 +357,13 @@ BWTREE_INDEX_TYPE::Scan(const std::vector<Value> &values,
     return;
   }
 
-  // This returns an iterator pointing to index_key's values
-  auto scan_begin_itr = container.Begin(index_key);
+  index_key.SetFromKey(start_key.get());
 
   switch (scan_direction) {
-    case SCAN_DIRECTION_TYPE_FORWARD:
-    case SCAN_DIRECTION_TYPE_BACKWARD: {
-      // TODO: This requires further optimization to at least
-      // find an upper bound for scanning (i.e. when the highest columns
-      // has < or <= relation). Otherwise we will have to scan till the
-      // end of the index which is toooooooooooooooooooooooooooooo slow
+    case SCAN_DIRECTION_TYPE_FORWARD: {
+      // This returns an iterator pointing to index_key's values
+      auto scan_begin_itr = container.Begin(index_key);
+
       for (auto scan_itr = scan_begin_itr;
            scan_itr.IsEnd() == false;
            scan_itr++) {
@@ -361,6 +383,32 @@ BWTREE_INDEX_TYPE::Scan(const std::vector<Value> &values,
       break;
     }
 
+    case SCAN_DIRECTION_TYPE_BACKWARD: {
+      // Scans from the last key down to the lower bound. Leaf nodes are
+      // located through a cached parent node instead of traversing from
+      // the root for every key as MoveBackByOne() does
+      auto scan_func = \
+        [&](const KeyType &scan_current_key, ItemPointer * const &item_p) {
+          auto tuple = const_cast<KeyType &>(scan_current_key).\
+              GetTupleForComparison(metadata->GetKeySchema());
+
+          if (Compare(tuple, key_column_ids, expr_types, values) == true) {
+            result.push_back(item_p);
+          }
+
+          return true;
+        };
+
+      container.ScanLeafLevelReverse(nullptr,
+                                     true,
+                                     &index_key,
+                                     true,
+                                     static_cast<size_t>(-1),
+                                     scan_func);
+
+      break;
+    }
+
     case SCAN_DIRECTION_TYPE_INVALID:
     default:
       throw Exception("Invalid scan direction \n");
@@ -373,12 +421,14 @@ BWTREE_INDEX_TYPE::Scan(const std::vector<Value> &values,
 BWTREE_TEMPLATE_ARGUMENTS
 void
 BWTREE_INDEX_TYPE::ScanAllKeys(std::vector<ItemPointer *> &result) {
-  auto it = container.Begin();
+  // Full table scan reads consolidated leaf nodes in place without
+  // copying them into the iterator
+  auto it = container.PinnedBegin();
 
   // scan all entries
   while (it.IsEnd() == false) {
     result.push_back(it->second);
-    it++;
+    ++it;
   }
 
   return;
@@ -96,6 +96,10 @@ void DeleteGetValueTest(TreeType *t) {
     auto value_set = t->GetValue(i);
 
     assert(value_set.size() == 0);
+    
+    // The allocation-free interfaces should agree with GetValue()
+    long value_buffer[4];
+    assert(t->GetValue(i, value_buffer, 4) == 0);
   }
 
   return;
@@ -109,6 +113,20 @@ void InsertGetValueTest(TreeType *t) {
     auto value_set = t->GetValue(i);
 
     assert(value_set.size() == 4);
+    
+    // The allocation-free interfaces should agree with GetValue()
+    long value_buffer[2];
+    assert(t->GetValue(i, value_buffer, 2) == 4);
+    assert(value_set.count(value_buffer[0]) == 1);
+    assert(value_set.count(value_buffer[1]) == 1);
+    
+    long value_sum = 0;
+    t->ForEachValue(i, [&value_sum](const long &value) {
+      value_sum += value;
+    });
+    
+    // Values inserted are i + 1, i + 2, i + 3 and i + 4
+    assert(value_sum == 4L * i + 10);
   }
 
   return;
@@ -24,15 +24,21 @@ void BenchmarkBwTreeRandInsert(int key_num, int thread_num) {
     thread_time[i] = 0.0;
   }
   
+  // Latency of each insert is recorded into the thread's own histogram
+  std::vector<LatencyHistogram> latency_list(thread_num);
+  
   // This generates a permutation on [0, key_num)
   Permutation<long long int> perm{(size_t)key_num, 0};
   
   auto func = [key_num, 
                &thread_time, 
+               &latency_list,
                thread_num,
                &perm](uint64_t thread_id, TreeType *t) {
     long int start_key = key_num / thread_num * (long)thread_id;
     long int end_key = start_key + key_num / thread_num;
+    
+    LatencyHistogram &latency = latency_list[thread_id];
 
     // Declare timer and start it immediately
     Timer timer{true};
@@ -41,7 +47,9 @@ void BenchmarkBwTreeRandInsert(int key_num, int thread_num) {
     for(int i = start_key;i < end_key;i++) {
       long long int key = perm[i];
       
+      uint64_t op_start = LatencyHistogram::ReadTSC();
       t->Insert(key, key);
+      latency.Record(LatencyHistogram::ReadTSC() - op_start);
     }
 
     cache.Stop();
@@ -71,6 +79,8 @@ void BenchmarkBwTreeRandInsert(int key_num, int thread_num) {
             << (key_num / (1024.0 * 1024.0) * thread_num) / elapsed_seconds
             << " million random insert/sec" << "\n";
   
+  LatencyHistogram::MergeAll(latency_list).Print("BwTree random insert");
+  
   // Remove the tree instance
   delete t;
   
@@ -91,18 +101,25 @@ void BenchmarkBwTreeSeqInsert(TreeType *t,
     thread_time[i] = 0.0;
   }
 
+  std::vector<LatencyHistogram> latency_list(num_thread);
+
   auto func = [key_num, 
                &thread_time, 
+               &latency_list,
                num_thread](uint64_t thread_id, TreeType *t) {
     long int start_key = key_num / num_thread * (long)thread_id;
     long int end_key = start_key + key_num / num_thread;
+    
+    LatencyHistogram &latency = latency_list[thread_id];
 
     // Declare timer and start it immediately
     Timer timer{true};
     CacheMeter cache{true};
 
     for(int i = start_key;i < end_key;i++) {
+      uint64_t op_start = LatencyHistogram::ReadTSC();
       t->Insert(i, i);
+      latency.Record(LatencyHistogram::ReadTSC() - op_start);
     }
 
     cache.Stop();
@@ -131,6 +148,13 @@ void BenchmarkBwTreeSeqInsert(TreeType *t,
   std::cout << num_thread << " Threads BwTree: overall "
             << (key_num / (1024.0 * 1024.0) * num_thread) / elapsed_seconds
             << " million insert/sec" << "\n";
+  
+  LatencyHistogram::MergeAll(latency_list).Print("BwTree insert");
+
+  // Sequential keys are split towards the right; see FindAppendSplitPoint()
+  TreeType::Stats stats = t->GetStats();
+  std::cout << "    split = " << stats.split_count
+            << "; append split = " << stats.append_split_count << "\n";
             
   return;
 }
@@ -150,20 +174,27 @@ void BenchmarkBwTreeSeqRead(TreeType *t,
     thread_time[i] = 0.0;
   }
   
+  std::vector<LatencyHistogram> latency_list(num_thread);
+  
   auto func = [key_num, 
                iter, 
                &thread_time, 
+               &latency_list,
                num_thread](uint64_t thread_id, TreeType *t) {
     std::vector<long> v{};
 
     v.reserve(1);
+    
+    LatencyHistogram &latency = latency_list[thread_id];
 
     Timer timer{true};
     CacheMeter cache{true};
 
     for(int j = 0;j < iter;j++) {
       for(int i = 0;i < key_num;i++) {
+        uint64_t op_start = LatencyHistogram::ReadTSC();
         t->GetValue(i, v);
+        latency.Record(LatencyHistogram::ReadTSC() - op_start);
 
         v.clear();
       }
@@ -194,6 +225,8 @@ void BenchmarkBwTreeSeqRead(TreeType *t,
   std::cout << num_thread << " Threads BwTree: overall "
             << (iter * key_num / (1024.0 * 1024.0) * num_thread * num_thread) / elapsed_seconds
             << " million read/sec" << "\n";
+  
+  LatencyHistogram::MergeAll(latency_list).Print("BwTree read");
 
   return;
 }
@@ -213,9 +246,12 @@ void BenchmarkBwTreeRandRead(TreeType *t,
     thread_time[i] = 0.0;
   }
   
+  std::vector<LatencyHistogram> latency_list(num_thread);
+  
   auto func2 = [key_num, 
                 iter, 
                 &thread_time,
+                &latency_list,
                 num_thread](uint64_t thread_id, TreeType *t) {
     std::vector<long> v{};
 
@@ -223,6 +259,8 @@ void BenchmarkBwTreeRandRead(TreeType *t,
     
     // This is the random number generator we use
     SimpleInt64Random<0, 30 * 1024 * 1024> h{};
+    
+    LatencyHistogram &latency = latency_list[thread_id];
 
     Timer timer{true};
     CacheMeter cache{true};
@@ -232,7 +270,9 @@ void BenchmarkBwTreeRandRead(TreeType *t,
         //int key = uniform_dist(e1);
         long int key = (long int)h((uint64_t)i, thread_id);
 
+        uint64_t op_start = LatencyHistogram::ReadTSC();
         t->GetValue(key, v);
+        latency.Record(LatencyHistogram::ReadTSC() - op_start);
 
         v.clear();
       }
@@ -263,6 +303,8 @@ void BenchmarkBwTreeRandRead(TreeType *t,
   std::cout << num_thread << " Threads BwTree: overall "
             << (iter * key_num / (1024.0 * 1024.0) * num_thread * num_thread) / elapsed_seconds
             << " million read (random)/sec" << "\n";
+  
+  LatencyHistogram::MergeAll(latency_list).Print("BwTree random read");
 
   return;
 }
@@ -295,9 +337,12 @@ void BenchmarkBwTreeZipfRead(TreeType *t,
     zipfian_key_list.push_back(zipf.Get()); 
   }
   
+  std::vector<LatencyHistogram> latency_list(num_thread);
+  
   auto func2 = [key_num, 
                 iter, 
                 &thread_time,
+                &latency_list,
                 &zipfian_key_list,
                 num_thread](uint64_t thread_id, TreeType *t) {
     // This is the start and end index we read into the zipfian array
@@ -307,6 +352,8 @@ void BenchmarkBwTreeZipfRead(TreeType *t,
     std::vector<long> v{};
 
     v.reserve(1);
+    
+    LatencyHistogram &latency = latency_list[thread_id];
 
     Timer timer{true};
     CacheMeter cache{true};
@@ -315,7 +362,9 @@ void BenchmarkBwTreeZipfRead(TreeType *t,
       for(long i = start_index;i < end_index;i++) {
         long int key = zipfian_key_list[i];
 
+        uint64_t op_start = LatencyHistogram::ReadTSC();
         t->GetValue(key, v);
+        latency.Record(LatencyHistogram::ReadTSC() - op_start);
 
         v.clear();
       }
@@ -346,6 +395,660 @@ void BenchmarkBwTreeZipfRead(TreeType *t,
   std::cout << num_thread << " Threads BwTree: overall "
             << (iter * key_num / (1024.0 * 1024.0)) / (elapsed_seconds / num_thread)
             << " million read (zipfian)/sec" << "\n";
+  
+  LatencyHistogram::MergeAll(latency_list).Print("BwTree zipfian read");
+
+  return;
+}
+
+/*
+ * BenchmarkBwTreeAllocFreeRead() - Compares point lookup interfaces
+ *
+ * This function runs random reads using three different interfaces:
+ *   (1) GetValue() with an std::vector
+ *   (2) GetValue() with a fixed sized buffer
+ *   (3) ForEachValue() with a callback
+ * and reports the throughput as well as the number of heap allocations
+ * per lookup for each of them. Note that for (1) we create a new vector 
+ * for every lookup, which is how most callers use this interface
+ */
+void BenchmarkBwTreeAllocFreeRead(TreeType *t, 
+                                  int key_num,
+                                  int thread_num) {
+  const int num_thread = thread_num;
+  
+  // Names of the interfaces being tested
+  const char *interface_name_list[3] = {
+    "GetValue(vector)",
+    "GetValue(buffer)",
+    "ForEachValue()",
+  };
+  
+  for(int interface = 0;interface < 3;interface++) {
+    // This is used to record time and allocations for each individual thread
+    double thread_time[num_thread];
+    uint64_t thread_alloc[num_thread];
+    for(int i = 0;i < num_thread;i++) {
+      thread_time[i] = 0.0;
+      thread_alloc[i] = 0UL;
+    }
+    
+    std::vector<LatencyHistogram> latency_list(num_thread);
+    
+    auto func = [key_num, 
+                 interface,
+                 &thread_time,
+                 &thread_alloc,
+                 &latency_list](uint64_t thread_id, TreeType *t) {
+      // This is the random number generator we use
+      SimpleInt64Random<0, 30 * 1024 * 1024> h{};
+      
+      long value_buffer[4];
+      long sum = 0;
+      
+      LatencyHistogram &latency = latency_list[thread_id];
+      
+      uint64_t alloc_start = GetThreadAllocCount();
+      Timer timer{true};
+      
+      for(int i = 0;i < key_num;i++) {
+        long int key = (long int)h((uint64_t)i, thread_id) % key_num;
+        
+        uint64_t op_start = LatencyHistogram::ReadTSC();
+        
+        if(interface == 0) {
+          std::vector<long> v{};
+          t->GetValue(key, v);
+          sum += v.size();
+        } else if(interface == 1) {
+          sum += t->GetValue(key, value_buffer, 4);
+        } else {
+          t->ForEachValue(key, [&sum](const long &value) {
+            sum += value;
+          });
+        }
+        
+        latency.Record(LatencyHistogram::ReadTSC() - op_start);
+      }
+      
+      double duration = timer.Stop();
+      
+      thread_time[thread_id] = duration;
+      thread_alloc[thread_id] = GetThreadAllocCount() - alloc_start;
+      
+      // Prevent the compiler from optimizing out the lookups
+      assert(sum >= 0);
+      (void)sum;
+      
+      return;
+    };
+    
+    LaunchParallelTestID(t, num_thread, func, t);
+    
+    double elapsed_seconds = 0.0;
+    uint64_t alloc_count = 0UL;
+    for(int i = 0;i < num_thread;i++) {
+      elapsed_seconds += thread_time[i];
+      alloc_count += thread_alloc[i];
+    }
+    
+    std::cout << num_thread << " Threads BwTree " 
+              << interface_name_list[interface] << ": overall "
+              << (key_num / (1024.0 * 1024.0) * num_thread * num_thread) / elapsed_seconds
+              << " million read (random)/sec; "
+              << (double)alloc_count / ((double)key_num * num_thread)
+              << " alloc/lookup" << "\n";
+    
+    std::string latency_name = std::string{"BwTree "} + \
+                               interface_name_list[interface];
+    LatencyHistogram::MergeAll(latency_list).Print(latency_name.c_str());
+  }
+  
+  return;
+}
+
+/*
+ * BenchmarkBwTreeFullScan() - Compares full table scan using normal and
+ *                             pinned iterators, and the callback based scan
+ *
+ * Backward scan using the iterator and the callback based reverse scan
+ * are also compared
+ *
+ * This mimics BWTreeIndex::ScanAllKeys() in Peloton, which copies all
+ * values into a vector. We report the throughput and the number of heap 
+ * allocations excluding the result vector, as well as the latency of
+ * producing each item, which is measured between consecutive items
+ */
+void BenchmarkBwTreeFullScan(TreeType *t, int key_num) {
+  std::vector<long> result{};
+  result.reserve(key_num);
+  
+  // Names of the scan methods being tested
+  const char *method_name_list[5] = {
+    "copy",
+    "pinned",
+    "ScanRange",
+    "backward iterator",
+    "ReverseScanAll",
+  };
+  
+  for(int method = 0;method < 5;method++) {
+    result.clear();
+    
+    LatencyHistogram latency{};
+    
+    uint64_t alloc_start = GetThreadAllocCount();
+    Timer timer{true};
+    
+    uint64_t last_tsc = LatencyHistogram::ReadTSC();
+    
+    // Records the time since the previous item and appends the value
+    auto push_value = [&result, &latency, &last_tsc](long value) {
+      uint64_t now_tsc = LatencyHistogram::ReadTSC();
+      latency.Record(now_tsc - last_tsc);
+      last_tsc = now_tsc;
+      
+      result.push_back(value);
+      
+      return;
+    };
+    
+    if(method == 2) {
+      t->ScanRangeLimit(0, 
+                        key_num, 
+                        [&push_value](const long &key, const long &value) {
+        (void)key;
+        push_value(value);
+        
+        return true;
+      });
+    } else if(method == 3) {
+      auto it = t->Begin(key_num - 1);
+      while(it.IsREnd() == false) {
+        push_value(it->second);
+        --it;
+      }
+    } else if(method == 4) {
+      t->ReverseScanAll([&push_value](const long &key, const long &value) {
+        (void)key;
+        push_value(value);
+        
+        return true;
+      });
+    } else {
+      auto it = (method == 0) ? t->Begin() : t->PinnedBegin();
+      while(it.IsEnd() == false) {
+        push_value(it->second);
+        ++it;
+      }
+    }
+    
+    double duration = timer.Stop();
+    uint64_t alloc_count = GetThreadAllocCount() - alloc_start;
+    
+    std::cout << "BwTree full scan (" << method_name_list[method]
+              << "): " << result.size() / (1024.0 * 1024.0) / duration
+              << " million key/sec; " << alloc_count << " allocations" << "\n";
+    
+    std::string latency_name = std::string{"BwTree full scan item ("} + \
+                               method_name_list[method] + ")";
+    latency.Print(latency_name.c_str());
+  }
+  
+  return;
+}
+
+/*
+ * BenchmarkBwTreeParallelScan() - Measures scalability of parallel full
+ *                                 table scan
+ *
+ * The number of worker threads goes from 1 to thread_num, doubling each 
+ * time. Each partition collects values into its own vector, which mimics
+ * a parallel version of BWTreeIndex::ScanAllKeys(). We use more partitions
+ * than threads such that the load is still balanced if partitions
+ * are not of equal sizes
+ *
+ * Since a partition is only scanned by one thread at a time, each
+ * partition records the latency between its consecutive items into its own
+ * histogram, and histograms of all partitions are merged after the scan
+ */
+void BenchmarkBwTreeParallelScan(TreeType *t, int key_num, int thread_num) {
+  const int partition_per_thread = 4;
+  
+  int worker_num = 1;
+  while(1) {
+    // GC ID 0 is used by the current thread
+    t->UpdateThreadLocal(worker_num + 1);
+    
+    const size_t partition_num = worker_num * partition_per_thread;
+    
+    std::vector<std::vector<long>> result_list{};
+    result_list.resize(partition_num);
+    
+    std::vector<LatencyHistogram> latency_list(partition_num);
+    
+    // 0 means the partition has not produced its first item yet
+    std::vector<uint64_t> last_tsc_list(partition_num, 0UL);
+    
+    size_t scan_count;
+    double duration;
+    
+    {
+      ThreadPool pool{t, (size_t)worker_num, 1};
+      
+      Timer timer{true};
+      
+      scan_count = \
+        t->ParallelScan(partition_num,
+                        [&pool](std::function<void()> &&task) {
+                          pool.Submit(std::move(task));
+                        },
+                        [&result_list,
+                         &latency_list,
+                         &last_tsc_list](size_t partition_id,
+                                         const long &key,
+                                         const long &value) {
+                          (void)key;
+                          
+                          uint64_t now_tsc = LatencyHistogram::ReadTSC();
+                          uint64_t &last_tsc = last_tsc_list[partition_id];
+                          if(last_tsc != 0UL) {
+                            latency_list[partition_id].Record(
+                              now_tsc - last_tsc);
+                          }
+                          
+                          last_tsc = now_tsc;
+                          
+                          result_list[partition_id].push_back(value);
+                          
+                          return true;
+                        });
+      
+      duration = timer.Stop();
+    }
+    
+    assert(scan_count == (size_t)key_num);
+    
+    std::cout << "BwTree parallel scan with " << worker_num << " threads: "
+              << scan_count / (1024.0 * 1024.0) / duration
+              << " million key/sec" << "\n";
+    
+    LatencyHistogram::MergeAll(latency_list).Print("BwTree parallel scan item");
+    
+    if(worker_num == thread_num) {
+      break;
+    }
+    
+    worker_num = std::min(worker_num * 2, thread_num);
+  }
+  
+  t->UpdateThreadLocal(1);
+  
+  return;
+}
+
+/*
+ * BenchmarkBwTreeContentionSplit() - Compares abort rates of Zipfian
+ *                                    updates with and without splitting
+ *                                    hot leaves
+ *
+ * The tree is loaded with key_num keys. Each thread then toggles Zipfian
+ * distributed (key, thread_id) pairs, i.e. it inserts the pair if it is
+ * not there and deletes it otherwise, such that leaf sizes stay stable
+ * and only contention could cause splits
+ */
+void BenchmarkBwTreeContentionSplit(int key_num, int thread_num) {
+  Zipfian zipf{(uint64_t)key_num, 0.99, (uint64_t)time(NULL)};
+
+  std::vector<long> zipfian_key_list{};
+  zipfian_key_list.reserve(key_num);
+  for(int i = 0;i < key_num;i++) {
+    zipfian_key_list.push_back(zipf.Get());
+  }
+
+  for(size_t threshold : {(size_t)0, (size_t)LEAF_CONTENTION_SPLIT_THRESHOLD}) {
+    TreeType *t = GetEmptyTree(true);
+    t->SetContentionSplitThreshold(threshold);
+
+    for(int i = 0;i < key_num;i++) {
+      t->Insert(i, i);
+    }
+
+    std::vector<LatencyHistogram> latency_list(thread_num);
+
+    auto func = [key_num,
+                 thread_num,
+                 &zipfian_key_list,
+                 &latency_list](uint64_t thread_id, TreeType *t) {
+      LatencyHistogram &latency = latency_list[thread_id];
+      long value = -1 - (long)thread_id;
+
+      for(int i = (int)thread_id;i < key_num;i += thread_num) {
+        long key = zipfian_key_list[i];
+
+        uint64_t op_start = LatencyHistogram::ReadTSC();
+        if(t->Insert(key, value) == false) {
+          t->Delete(key, value);
+        }
+        latency.Record(LatencyHistogram::ReadTSC() - op_start);
+      }
+
+      return;
+    };
+
+    TreeType::Stats before = t->GetStats();
+
+    Timer timer{true};
+    LaunchParallelTestID(t, thread_num, func, t);
+    double duration = timer.Stop();
+
+    TreeType::Stats after = t->GetStats();
+
+    uint64_t op_count = (after.insert_count - before.insert_count) + \
+                        (after.delete_count - before.delete_count);
+    uint64_t abort_count = \
+      after.traverse_abort_count - before.traverse_abort_count;
+    uint64_t cas_failure_count = \
+      after.GetCASFailureCount(TreeType::CASSite::LeafData) - \
+      before.GetCASFailureCount(TreeType::CASSite::LeafData);
+
+    std::cout << thread_num << " Threads BwTree Zipfian update (contention "
+              << "split threshold " << threshold << "): "
+              << op_count / (1024.0 * 1024.0) / duration
+              << " million op/sec" << "\n";
+    std::cout << "    abort rate = " << (double)abort_count / op_count
+              << "; leaf CAS failure rate = "
+              << (double)cas_failure_count / op_count
+              << "; contention split = "
+              << after.contention_split_count - before.contention_split_count
+              << "; backoff = "
+              << after.backoff_count - before.backoff_count
+              << "; leaf retry = "
+              << after.leaf_retry_count - before.leaf_retry_count
+              << "\n";
+
+    std::string latency_name = \
+      "BwTree Zipfian update (contention split threshold " + \
+      std::to_string(threshold) + ")";
+    LatencyHistogram::MergeAll(latency_list).Print(latency_name.c_str());
+
+    DestroyTree(t, true);
+  }
+
+  return;
+}
+
+/*
+ * BenchmarkBwTreeAsync() - Compares point operations of the synchronous
+ *                          API with interleaved asynchronous operations
+ *
+ * All operations run on one thread. Reads look up random keys in a tree of
+ * key_num keys, and inserts put key_num random keys into an empty tree.
+ * The asynchronous runs use AsyncExecutor with different numbers of slots,
+ * i.e. operations in flight. Latency of an asynchronous operation is from
+ * its submission to its completion, so it includes the time spent on
+ * other operations interleaved with it
+ */
+void BenchmarkBwTreeAsync(int key_num) {
+  std::vector<long> key_list{};
+  key_list.reserve(key_num);
+
+  Permutation<long> perm{(size_t)key_num};
+  for(int i = 0;i < key_num;i++) {
+    key_list.push_back(perm[i]);
+  }
+
+  const size_t slot_count_list[] = {1, 4, 16, 64, 256};
+
+  // Submission time of the operation running in each slot; slots keep
+  // their address for the lifetime of the executor
+  std::unordered_map<const TreeType::AsyncOperation *, uint64_t> submit_map{};
+
+  /////////////////////////////////////////////////////////////////
+  // Insert
+  /////////////////////////////////////////////////////////////////
+
+  {
+    TreeType *t = GetEmptyTree(true);
+    LatencyHistogram latency{};
+
+    Timer timer{true};
+    for(int i = 0;i < key_num;i++) {
+      uint64_t op_start = LatencyHistogram::ReadTSC();
+      t->Insert(key_list[i], key_list[i]);
+      latency.Record(LatencyHistogram::ReadTSC() - op_start);
+    }
+    double duration = timer.Stop();
+
+    std::cout << "BwTree sync insert: "
+              << key_num / (1024.0 * 1024.0) / duration
+              << " million insert/sec" << "\n";
+
+    latency.Print("BwTree sync insert");
+
+    DestroyTree(t, true);
+  }
+
+  for(size_t slot_count : slot_count_list) {
+    TreeType *t = GetEmptyTree(true);
+    TreeType::AsyncExecutor executor{t, slot_count};
+
+    LatencyHistogram latency{};
+
+    int next_index = 0;
+    submit_map.clear();
+
+    Timer timer{true};
+    executor.Run([t, &key_list, &next_index, key_num, &submit_map]
+                 (TreeType::AsyncOperation *op_p) {
+                   if(next_index == key_num) {
+                     return false;
+                   }
+
+                   long key = key_list[next_index++];
+                   op_p->StartInsert(t, key, key);
+                   submit_map[op_p] = LatencyHistogram::ReadTSC();
+
+                   return true;
+                 },
+                 [&latency, &submit_map](const TreeType::AsyncOperation &op) {
+                   latency.Record(LatencyHistogram::ReadTSC() - \
+                                  submit_map[&op]);
+                 });
+    double duration = timer.Stop();
+
+    std::cout << "BwTree async insert (" << slot_count << " slots): "
+              << key_num / (1024.0 * 1024.0) / duration
+              << " million insert/sec" << "\n";
+
+    std::string latency_name = \
+      "BwTree async insert (" + std::to_string(slot_count) + " slots)";
+    latency.Print(latency_name.c_str());
+
+    DestroyTree(t, true);
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Read
+  /////////////////////////////////////////////////////////////////
+
+  TreeType *t = GetEmptyTree(true);
+  for(int i = 0;i < key_num;i++) {
+    t->Insert(key_list[i], key_list[i]);
+  }
+
+  SimpleInt64Random<0, UINT64_MAX> h{};
+  size_t found_count = 0;
+
+  {
+    LatencyHistogram latency{};
+    long value;
+
+    Timer timer{true};
+    for(int i = 0;i < key_num;i++) {
+      long key = (long)(h((uint64_t)i, 0) % key_num);
+
+      uint64_t op_start = LatencyHistogram::ReadTSC();
+      found_count += t->GetValue(key, &value, 1);
+      latency.Record(LatencyHistogram::ReadTSC() - op_start);
+    }
+    double duration = timer.Stop();
+
+    std::cout << "BwTree sync read: "
+              << key_num / (1024.0 * 1024.0) / duration
+              << " million read/sec (found " << found_count << ")\n";
+
+    latency.Print("BwTree sync read");
+  }
+
+  for(size_t slot_count : slot_count_list) {
+    TreeType::AsyncExecutor executor{t, slot_count};
+
+    LatencyHistogram latency{};
+
+    int next_index = 0;
+    found_count = 0;
+    submit_map.clear();
+
+    Timer timer{true};
+    executor.Run([t, &h, &next_index, key_num, &submit_map]
+                 (TreeType::AsyncOperation *op_p) {
+                   if(next_index == key_num) {
+                     return false;
+                   }
+
+                   long key = (long)(h((uint64_t)next_index++, 0) % key_num);
+                   op_p->StartRead(t, key);
+                   submit_map[op_p] = LatencyHistogram::ReadTSC();
+
+                   return true;
+                 },
+                 [&found_count,
+                  &latency,
+                  &submit_map](const TreeType::AsyncOperation &op) {
+                   latency.Record(LatencyHistogram::ReadTSC() - \
+                                  submit_map[&op]);
+                   found_count += op.GetValueList().size();
+                 });
+    double duration = timer.Stop();
+
+    std::cout << "BwTree async read (" << slot_count << " slots): "
+              << key_num / (1024.0 * 1024.0) / duration
+              << " million read/sec (found " << found_count << ")\n";
+
+    std::string latency_name = \
+      "BwTree async read (" + std::to_string(slot_count) + " slots)";
+    latency.Print(latency_name.c_str());
+  }
+
+  DestroyTree(t, true);
+
+  return;
+}
+
+/*
+ * BenchmarkBwTreeFrozen() - Compares reads on a tree before and after
+ *                           Freeze()
+ *
+ * key_num keys are inserted in random order such that leaves carry delta
+ * chains as they would after a bulk load, and then random point lookups
+ * and full scans in both directions are run on the tree, on the tree after
+ * all delta chains are consolidated, and on the frozen layout. The second
+ * round tells how much of the gain comes from the layout itself rather
+ * than from consolidation, which Freeze() also does
+ */
+void BenchmarkBwTreeFrozen(int key_num) {
+  TreeType *t = GetEmptyTree(true);
+
+  Permutation<long> perm{(size_t)key_num};
+  for(int i = 0;i < key_num;i++) {
+    t->Insert(perm[i], perm[i]);
+  }
+
+  const char *name_list[] = {"BwTree", "Consolidated BwTree", "Frozen BwTree"};
+
+  for(int round = 0;round < 3;round++) {
+    const char *name = name_list[round];
+
+    if(round == 1) {
+      Timer timer{true};
+      size_t consolidated_count = t->Cleanup();
+      double duration = timer.Stop();
+
+      std::cout << "Consolidate: " << duration << " sec; "
+                << consolidated_count << " nodes\n";
+    } else if(round == 2) {
+      Timer timer{true};
+      t->Freeze();
+      double duration = timer.Stop();
+
+      std::cout << "Freeze: " << duration << " sec; frozen layout = "
+                << t->GetMemoryUsage().frozen_layout_size / (1024.0 * 1024.0)
+                << " MB\n";
+    }
+
+    SimpleInt64Random<0, UINT64_MAX> h{};
+    LatencyHistogram latency{};
+    size_t found_count = 0;
+    long value;
+
+    Timer timer{true};
+    for(int i = 0;i < key_num;i++) {
+      long key = (long)(h((uint64_t)i, 0) % key_num);
+
+      uint64_t op_start = LatencyHistogram::ReadTSC();
+      found_count += t->GetValue(key, &value, 1);
+      latency.Record(LatencyHistogram::ReadTSC() - op_start);
+    }
+    double duration = timer.Stop();
+
+    std::cout << name << " random read: "
+              << key_num / (1024.0 * 1024.0) / duration
+              << " million read/sec (found " << found_count << ")\n";
+
+    std::string latency_name = std::string{name} + " random read";
+    latency.Print(latency_name.c_str());
+
+    timer.Start();
+    size_t scan_count = t->ScanRangeLimit(0L,
+                                          static_cast<size_t>(-1),
+                                          [](long, long) { return true; });
+    duration = timer.Stop();
+
+    std::cout << name << " full scan: "
+              << scan_count / (1024.0 * 1024.0) / duration
+              << " million key/sec\n";
+
+    timer.Start();
+    scan_count = t->ReverseScanAll([](long, long) { return true; });
+    duration = timer.Stop();
+
+    std::cout << name << " full reverse scan: "
+              << scan_count / (1024.0 * 1024.0) / duration
+              << " million key/sec\n";
+
+    // Short scans as issued by range queries; latency is per scan
+    LatencyHistogram scan_latency{};
+
+    timer.Start();
+    for(int i = 0;i < key_num / 16;i++) {
+      long key = (long)(h((uint64_t)i, 1) % key_num);
+
+      uint64_t op_start = LatencyHistogram::ReadTSC();
+      t->ScanRangeLimit(key, 16, [](long, long) { return true; });
+      scan_latency.Record(LatencyHistogram::ReadTSC() - op_start);
+    }
+    duration = timer.Stop();
+
+    std::cout << name << " 16-key scan: "
+              << key_num / 16 / (1024.0 * 1024.0) / duration
+              << " million scan/sec\n";
+
+    latency_name = std::string{name} + " 16-key scan";
+    scan_latency.Print(latency_name.c_str());
+  }
+
+  DestroyTree(t, true);
 
   return;
 }
@@ -0,0 +1,492 @@
+/*
+ * benchmark_normalized_key.cpp - This file contains benchmarks for command
+ *                                benchmark-normalized-key
+ *
+ * We compare a Peloton style key, which stores column values in native
+ * format and compares them column by column through the key schema,
+ * against a normalized key of the same columns which is compared as
+ * a byte string
+ */
+
+#include "test_suite.h"
+
+/*
+ * enum class TupleColumnType - Column types used by the tuple style key
+ */
+enum class TupleColumnType {
+  INTEGER = 0,
+  BIGINT,
+  VARCHAR,
+};
+
+/*
+ * class TupleKeySchema - Describes column type and offset of a key
+ *
+ * This mimics catalog::Schema in Peloton, which is consulted by the
+ * comparator on every comparison
+ */
+class TupleKeySchema {
+ public:
+  static constexpr int MAX_COLUMN_COUNT = 4;
+
+  int column_count;
+  TupleColumnType column_type[MAX_COLUMN_COUNT];
+  size_t column_offset[MAX_COLUMN_COUNT];
+};
+
+/*
+ * class TupleStyleKey - Column values in native format
+ *
+ * Varchar columns are stored inline as one length byte followed by
+ * the characters, just like an inlined varchar in a Peloton tuple
+ */
+class TupleStyleKey {
+ public:
+  char data[32];
+
+  TupleStyleKey() {
+    memset(data, 0x00, sizeof(data));
+  }
+};
+
+/*
+ * class TupleColumnValue - Type tagged value read from a tuple style key
+ *
+ * This plays the role of Peloton's Value, which is constructed for each
+ * column before it is compared
+ */
+class TupleColumnValue {
+ public:
+  TupleColumnType type;
+  int64_t int_value;
+  const char *str_p;
+  size_t str_length;
+
+  /*
+   * Compare() - Compares two values of the same type
+   */
+  int Compare(const TupleColumnValue &other) const {
+    switch(type) {
+      case TupleColumnType::INTEGER:
+      case TupleColumnType::BIGINT:
+        if(int_value < other.int_value) {
+          return -1;
+        } else if(int_value > other.int_value) {
+          return 1;
+        }
+
+        return 0;
+      case TupleColumnType::VARCHAR: {
+        size_t length = std::min(str_length, other.str_length);
+        int ret = memcmp(str_p, other.str_p, length);
+        if(ret != 0) {
+          return ret;
+        }
+
+        if(str_length < other.str_length) {
+          return -1;
+        } else if(str_length > other.str_length) {
+          return 1;
+        }
+
+        return 0;
+      }
+      default:
+        assert(false);
+    }
+
+    return 0;
+  }
+};
+
+/*
+ * GetTupleColumnValue() - Reads the i-th column of a tuple style key
+ */
+static TupleColumnValue GetTupleColumnValue(const TupleKeySchema *schema_p,
+                                            const TupleStyleKey &key,
+                                            int column) {
+  TupleColumnValue value;
+  const char *p = key.data + schema_p->column_offset[column];
+
+  value.type = schema_p->column_type[column];
+  value.int_value = 0;
+  value.str_p = nullptr;
+  value.str_length = 0;
+
+  switch(value.type) {
+    case TupleColumnType::INTEGER: {
+      int32_t v;
+      memcpy(&v, p, sizeof(v));
+      value.int_value = v;
+
+      break;
+    }
+    case TupleColumnType::BIGINT: {
+      int64_t v;
+      memcpy(&v, p, sizeof(v));
+      value.int_value = v;
+
+      break;
+    }
+    case TupleColumnType::VARCHAR:
+      value.str_length = static_cast<unsigned char>(p[0]);
+      value.str_p = p + 1;
+
+      break;
+    default:
+      assert(false);
+  }
+
+  return value;
+}
+
+/*
+ * CompareTupleStyleKey() - Compares two keys column by column
+ */
+static int CompareTupleStyleKey(const TupleKeySchema *schema_p,
+                                const TupleStyleKey &k1,
+                                const TupleStyleKey &k2) {
+  for(int i = 0;i < schema_p->column_count;i++) {
+    TupleColumnValue v1 = GetTupleColumnValue(schema_p, k1, i);
+    TupleColumnValue v2 = GetTupleColumnValue(schema_p, k2, i);
+
+    int ret = v1.Compare(v2);
+    if(ret != 0) {
+      return ret;
+    }
+  }
+
+  return 0;
+}
+
+/*
+ * class TupleStyleKeyComparator - Schema driven key comparator
+ */
+class TupleStyleKeyComparator {
+ public:
+  const TupleKeySchema *schema_p;
+
+  TupleStyleKeyComparator(const TupleKeySchema *p_schema_p) :
+    schema_p{p_schema_p}
+  {}
+
+  TupleStyleKeyComparator() = delete;
+
+  bool operator()(const TupleStyleKey &k1, const TupleStyleKey &k2) const {
+    return CompareTupleStyleKey(schema_p, k1, k2) < 0;
+  }
+};
+
+/*
+ * class TupleStyleKeyEqualityChecker - Schema driven key equality checker
+ */
+class TupleStyleKeyEqualityChecker {
+ public:
+  const TupleKeySchema *schema_p;
+
+  TupleStyleKeyEqualityChecker(const TupleKeySchema *p_schema_p) :
+    schema_p{p_schema_p}
+  {}
+
+  TupleStyleKeyEqualityChecker() = delete;
+
+  bool operator()(const TupleStyleKey &k1, const TupleStyleKey &k2) const {
+    return CompareTupleStyleKey(schema_p, k1, k2) == 0;
+  }
+};
+
+/*
+ * class TupleStyleKeyHashFunc - Hashes raw bytes of a tuple style key
+ *
+ * Unused bytes are always zero so equal keys have equal bytes
+ */
+class TupleStyleKeyHashFunc {
+ public:
+  size_t operator()(const TupleStyleKey &key) const {
+    size_t hash = 0;
+    for(size_t i = 0;i < sizeof(key.data);i += sizeof(uint64_t)) {
+      uint64_t word;
+      memcpy(&word, key.data + i, sizeof(word));
+      hash = hash * 31 + std::hash<uint64_t>()(word);
+    }
+
+    return hash;
+  }
+};
+
+// 4 byte integer + 8 byte integer + at most 16 characters with
+// terminator fits into 32 bytes
+using BenchNormalizedKey = NormalizedKey<32>;
+
+using TupleStyleTreeType = BwTree<TupleStyleKey,
+                                  long int,
+                                  TupleStyleKeyComparator,
+                                  TupleStyleKeyEqualityChecker,
+                                  TupleStyleKeyHashFunc>;
+
+using NormalizedTreeType = BwTree<BenchNormalizedKey,
+                                  long int,
+                                  NormalizedKeyComparator<32>,
+                                  NormalizedKeyEqualityChecker<32>,
+                                  NormalizedKeyHashFunc<32>>;
+
+/*
+ * class BenchKeyColumns - Column values of one benchmark key
+ */
+class BenchKeyColumns {
+ public:
+  int32_t c0;
+  int64_t c1;
+  std::string c2;
+};
+
+/*
+ * GenerateBenchKeyColumns() - Generates keys that share prefixes
+ *
+ * The first column only has a few distinct values and the strings are
+ * drawn from a small alphabet, such that comparisons frequently have
+ * to look at every column
+ */
+static std::vector<BenchKeyColumns> GenerateBenchKeyColumns(int key_num) {
+  std::vector<BenchKeyColumns> ret{};
+  std::mt19937_64 rng{0};
+
+  ret.reserve(key_num);
+  for(int i = 0;i < key_num;i++) {
+    BenchKeyColumns columns;
+
+    columns.c0 = static_cast<int32_t>(rng() % 8) - 4;
+    columns.c1 = static_cast<int64_t>(rng() % 64) - 32;
+
+    size_t length = 8 + rng() % 9;
+    for(size_t j = 0;j < length;j++) {
+      columns.c2.push_back(static_cast<char>('a' + rng() % 4));
+    }
+
+    // Make the last column unique to avoid duplicated keys
+    for(int j = 0;j < 4;j++) {
+      columns.c2[length - 1 - j] = \
+        static_cast<char>('a' + ((i >> (j * 6)) & 0x3F));
+    }
+
+    ret.push_back(columns);
+  }
+
+  return ret;
+}
+
+/*
+ * MakeTupleStyleKey() - Stores columns in native format
+ */
+static TupleStyleKey MakeTupleStyleKey(const TupleKeySchema *schema_p,
+                                       const BenchKeyColumns &columns) {
+  TupleStyleKey key;
+
+  memcpy(key.data + schema_p->column_offset[0], &columns.c0, sizeof(columns.c0));
+  memcpy(key.data + schema_p->column_offset[1], &columns.c1, sizeof(columns.c1));
+
+  char *p = key.data + schema_p->column_offset[2];
+  p[0] = static_cast<char>(columns.c2.size());
+  memcpy(p + 1, columns.c2.data(), columns.c2.size());
+
+  return key;
+}
+
+/*
+ * MakeBenchNormalizedKey() - Encodes columns into a normalized key
+ */
+static BenchNormalizedKey MakeBenchNormalizedKey(const BenchKeyColumns &columns) {
+  BenchNormalizedKey key;
+
+  bool ret = key.AppendInteger(columns.c0);
+  ret = ret && key.AppendInteger(columns.c1);
+  ret = ret && key.AppendString(columns.c2);
+  assert(ret == true);
+  (void)ret;
+
+  return key;
+}
+
+/*
+ * GetBenchKeySchema() - Returns the schema of (INTEGER, BIGINT, VARCHAR(16))
+ */
+static TupleKeySchema GetBenchKeySchema() {
+  TupleKeySchema schema;
+
+  schema.column_count = 3;
+  schema.column_type[0] = TupleColumnType::INTEGER;
+  schema.column_offset[0] = 0;
+  schema.column_type[1] = TupleColumnType::BIGINT;
+  schema.column_offset[1] = 4;
+  schema.column_type[2] = TupleColumnType::VARCHAR;
+  schema.column_offset[2] = 12;
+
+  return schema;
+}
+
+/*
+ * BenchmarkNormalizedKeySort() - Sorts keys with both comparators
+ *
+ * Sorting is dominated by key comparison, so this measures the raw
+ * cost of the two comparators. After sorting we also verify that
+ * the order given by normalized keys agrees with the schema order
+ */
+void BenchmarkNormalizedKeySort(int key_num) {
+  TupleKeySchema schema = GetBenchKeySchema();
+  std::vector<BenchKeyColumns> columns = GenerateBenchKeyColumns(key_num);
+
+  std::vector<TupleStyleKey> tuple_keys{};
+  std::vector<BenchNormalizedKey> normalized_keys{};
+  for(int i = 0;i < key_num;i++) {
+    tuple_keys.push_back(MakeTupleStyleKey(&schema, columns[i]));
+    normalized_keys.push_back(MakeBenchNormalizedKey(columns[i]));
+  }
+
+  std::vector<int> tuple_index{};
+  std::vector<int> normalized_index{};
+  for(int i = 0;i < key_num;i++) {
+    tuple_index.push_back(i);
+    normalized_index.push_back(i);
+  }
+
+  TupleStyleKeyComparator tuple_cmp{&schema};
+  NormalizedKeyComparator<32> normalized_cmp{};
+
+  Timer timer{true};
+
+  std::sort(tuple_index.begin(),
+            tuple_index.end(),
+            [&tuple_keys, &tuple_cmp](int i1, int i2) {
+              return tuple_cmp(tuple_keys[i1], tuple_keys[i2]);
+            });
+
+  double tuple_duration = timer.Stop();
+
+  timer.Start();
+
+  std::sort(normalized_index.begin(),
+            normalized_index.end(),
+            [&normalized_keys, &normalized_cmp](int i1, int i2) {
+              return normalized_cmp(normalized_keys[i1], normalized_keys[i2]);
+            });
+
+  double normalized_duration = timer.Stop();
+
+  // All keys are unique so both orders must be identical
+  if(tuple_index != normalized_index) {
+    printf("ERROR: Normalized key order differs from tuple key order\n");
+
+    exit(1);
+  }
+
+  std::cout << "Tuple style key sort: "
+            << key_num / (1024.0 * 1024.0) / tuple_duration
+            << " million keys/sec" << "\n";
+  std::cout << "Normalized key sort: "
+            << key_num / (1024.0 * 1024.0) / normalized_duration
+            << " million keys/sec" << "\n";
+
+  return;
+}
+
+/*
+ * BenchmarkNormalizedKeyTree() - Inserts and reads keys from BwTree with
+ *                                either comparator
+ *
+ * Keys are inserted and read in random order using a single thread
+ */
+void BenchmarkNormalizedKeyTree(int key_num) {
+  TupleKeySchema schema = GetBenchKeySchema();
+  std::vector<BenchKeyColumns> columns = GenerateBenchKeyColumns(key_num);
+
+  std::vector<TupleStyleKey> tuple_keys{};
+  std::vector<BenchNormalizedKey> normalized_keys{};
+  for(int i = 0;i < key_num;i++) {
+    tuple_keys.push_back(MakeTupleStyleKey(&schema, columns[i]));
+    normalized_keys.push_back(MakeBenchNormalizedKey(columns[i]));
+  }
+
+  // Free column values before running the benchmark
+  columns.clear();
+
+  auto tuple_tree_p = \
+    new TupleStyleTreeType{true,
+                           TupleStyleKeyComparator{&schema},
+                           TupleStyleKeyEqualityChecker{&schema}};
+  tuple_tree_p->UpdateThreadLocal(1);
+  tuple_tree_p->AssignGCID(0);
+
+  auto normalized_tree_p = new NormalizedTreeType{true};
+  normalized_tree_p->UpdateThreadLocal(1);
+  normalized_tree_p->AssignGCID(0);
+
+  // Do not print debug message in the middle of the benchmark
+  print_flag = false;
+
+  Timer timer{true};
+
+  for(int i = 0;i < key_num;i++) {
+    tuple_tree_p->Insert(tuple_keys[i], i);
+  }
+
+  double tuple_insert_duration = timer.Stop();
+
+  timer.Start();
+
+  for(int i = 0;i < key_num;i++) {
+    normalized_tree_p->Insert(normalized_keys[i], i);
+  }
+
+  double normalized_insert_duration = timer.Stop();
+
+  std::vector<long int> v{};
+  v.reserve(4);
+
+  timer.Start();
+
+  for(int i = 0;i < key_num;i++) {
+    v.clear();
+    tuple_tree_p->GetValue(tuple_keys[i], v);
+
+    if(v.size() != 1 || v[0] != i) {
+      printf("ERROR: Tuple style key %d not found\n", i);
+
+      exit(1);
+    }
+  }
+
+  double tuple_read_duration = timer.Stop();
+
+  timer.Start();
+
+  for(int i = 0;i < key_num;i++) {
+    v.clear();
+    normalized_tree_p->GetValue(normalized_keys[i], v);
+
+    if(v.size() != 1 || v[0] != i) {
+      printf("ERROR: Normalized key %d not found\n", i);
+
+      exit(1);
+    }
+  }
+
+  double normalized_read_duration = timer.Stop();
+
+  std::cout << "Tuple style key BwTree insert: "
+            << key_num / (1024.0 * 1024.0) / tuple_insert_duration
+            << " million insert/sec" << "\n";
+  std::cout << "Normalized key BwTree insert: "
+            << key_num / (1024.0 * 1024.0) / normalized_insert_duration
+            << " million insert/sec" << "\n";
+  std::cout << "Tuple style key BwTree read: "
+            << key_num / (1024.0 * 1024.0) / tuple_read_duration
+            << " million read/sec" << "\n";
+  std::cout << "Normalized key BwTree read: "
+            << key_num / (1024.0 * 1024.0) / normalized_read_duration
+            << " million read/sec" << "\n";
+
+  delete tuple_tree_p;
+  delete normalized_tree_p;
+
+  return;
+}
@@ -0,0 +1,205 @@
+
+/*
+ * benchmark_scaling.cpp - This file contains the thread scaling benchmark
+ *                         for command benchmark-scaling
+ *
+ * The number of worker threads goes from 1 up to the number of cores,
+ * doubling each time. Each worker is pinned to its own core, and every
+ * point is repeated several times on a fresh tree such that scaling cliffs
+ * could be told apart from noise. Results are written as CSV
+ */
+
+#include "test_suite.h"
+
+/*
+ * struct ScalingThreadResult - Cache numbers collected by one worker
+ */
+struct ScalingThreadResult {
+  long long l1_access;
+  long long l1_miss;
+  long long l3_access;
+  long long l3_miss;
+};
+
+/*
+ * RunScalingPhase() - Runs one operation on all threads and writes a CSV row
+ *
+ * op_func is called as op_func(thread_id, i) for i in [0, op_per_thread).
+ * Worker thread i is pinned to core (i % core_num). The abort rate is the
+ * number of traversal aborts per operation during this phase, and the CAS
+ * failure rate is defined in the same way
+ */
+template <typename OpFunc>
+static void RunScalingPhase(TreeType *t,
+                            const char *phase_name,
+                            int thread_num,
+                            int core_num,
+                            int repeat,
+                            int op_per_thread,
+                            OpFunc &&op_func,
+                            std::ofstream &csv) {
+  std::vector<ScalingThreadResult> result_list(thread_num);
+
+  auto func = [core_num,
+               op_per_thread,
+               &op_func,
+               &result_list](uint64_t thread_id, TreeType *t) {
+    (void)t;
+
+    PinToCore(thread_id % core_num);
+
+    // Also count L3 events, which are not enabled by default
+    CacheMeter cache{true, 6};
+
+    for(int i = 0;i < op_per_thread;i++) {
+      op_func(thread_id, i);
+    }
+
+    cache.Stop();
+
+    auto l1_util = cache.GetL1CacheUtilization();
+    auto l3_util = cache.GetL3CacheUtilization();
+
+    result_list[thread_id] = ScalingThreadResult{l1_util.first,
+                                                 l1_util.second,
+                                                 l3_util.first,
+                                                 l3_util.second};
+
+    return;
+  };
+
+  auto stats_before = t->GetStats();
+
+  Timer timer{true};
+  LaunchParallelTestID(t, thread_num, func, t);
+  double duration = timer.Stop();
+
+  // Counters of finished threads are kept after they unregister
+  auto stats_after = t->GetStats();
+
+  uint64_t op_count = (uint64_t)op_per_thread * thread_num;
+  uint64_t abort_count = stats_after.traverse_abort_count - \
+                         stats_before.traverse_abort_count;
+  uint64_t cas_failure_count = stats_after.GetTotalCASFailureCount() - \
+                               stats_before.GetTotalCASFailureCount();
+
+  ScalingThreadResult total{0LL, 0LL, 0LL, 0LL};
+  for(const ScalingThreadResult &result : result_list) {
+    total.l1_access += result.l1_access;
+    total.l1_miss += result.l1_miss;
+    total.l3_access += result.l3_access;
+    total.l3_miss += result.l3_miss;
+  }
+
+  // Without PAPI the cache columns are NA rather than zero, such that
+  // they could not be mistaken for measurements
+  char cache_field[128];
+  if(CacheMeter::AVAILABLE == true) {
+    snprintf(cache_field,
+             sizeof(cache_field),
+             "%lld,%lld,%lld,%lld",
+             total.l1_access,
+             total.l1_miss,
+             total.l3_access,
+             total.l3_miss);
+  } else {
+    snprintf(cache_field, sizeof(cache_field), "NA,NA,NA,NA");
+  }
+
+  char line[256];
+  snprintf(line,
+           sizeof(line),
+           "%s,%d,%d,%lu,%.4f,%.4f,%.6f,%.6f,%s",
+           phase_name,
+           thread_num,
+           repeat,
+           op_count,
+           duration,
+           op_count / (1024.0 * 1024.0) / duration,
+           (double)abort_count / op_count,
+           (double)cas_failure_count / op_count,
+           cache_field);
+
+  csv << line << "\n";
+  printf("%s\n", line);
+
+  return;
+}
+
+/*
+ * BenchmarkScaling() - Sweeps the number of threads and reports throughput
+ *
+ * For each thread count and repetition we create a new tree and run three
+ * phases with the same total amount of work (i.e. strong scaling):
+ *   (1) insert: key_num keys in random order
+ *   (2) read: key_num random point lookups
+ *   (3) mixed: key_num inserts and deletes of keys outside the loaded
+ *       range, which causes splits and merges and therefore aborts
+ */
+void BenchmarkScaling(int key_num,
+                      int core_num,
+                      int repeat_num,
+                      const std::string &csv_file_name) {
+  std::ofstream csv{csv_file_name};
+  if(csv.is_open() == false) {
+    throw "Could not open scaling CSV file";
+  }
+
+  const char *header = \
+    "phase,thread_num,repeat,op_num,seconds,million_op_per_sec,"
+    "abort_rate,cas_failure_rate,l1_access,l1_miss,l3_access,l3_miss";
+
+  csv << header << "\n";
+  printf("%s\n", header);
+
+  // Insert order is shared by all runs
+  Permutation<long> perm{(size_t)key_num};
+
+  int thread_num = 1;
+  while(1) {
+    int op_per_thread = key_num / thread_num;
+
+    for(int repeat = 0;repeat < repeat_num;repeat++) {
+      TreeType *t = GetEmptyTree(true);
+
+      RunScalingPhase(t, "insert", thread_num, core_num, repeat, op_per_thread,
+                      [t, &perm, op_per_thread](uint64_t thread_id, int i) {
+                        long key = perm[op_per_thread * thread_id + i];
+                        t->Insert(key, key);
+                      },
+                      csv);
+
+      RunScalingPhase(t, "read", thread_num, core_num, repeat, op_per_thread,
+                      [t, key_num](uint64_t thread_id, int i) {
+                        SimpleInt64Random<0, UINT64_MAX> h{};
+                        long value;
+                        long key = (long)(h((uint64_t)i, thread_id) % key_num);
+                        t->GetValue(key, &value, 1);
+                      },
+                      csv);
+
+      RunScalingPhase(t, "mixed", thread_num, core_num, repeat, op_per_thread,
+                      [t, key_num](uint64_t thread_id, int i) {
+                        SimpleInt64Random<0, UINT64_MAX> h{};
+                        long key = key_num + \
+                                   (long)(h((uint64_t)i / 2, thread_id) % key_num);
+                        if((i % 2) == 0) {
+                          t->Insert(key, key);
+                        } else {
+                          t->Delete(key, key);
+                        }
+                      },
+                      csv);
+
+      delete t;
+    }
+
+    if(thread_num == core_num) {
+      break;
+    }
+
+    thread_num = std::min(thread_num * 2, core_num);
+  }
+
+  return;
+}
@@ -0,0 +1,762 @@
+
+/*
+ * benchmark_ycsb.cpp - This file contains the YCSB style workload driver
+ *                      for command benchmark-ycsb
+ *
+ * Workloads A - F are run against BwTree, stx::btree_multimap protected by
+ * a reader-writer spinlock, the skiplist, libcuckoo and ART, such that all
+ * indices see exactly the same key distribution. Each (index, workload)
+ * pair is written as one CSV row
+ *
+ * Requires all libraries and the spinlock in ./benchmark directory
+ */
+
+#include "test_suite.h"
+#include "../benchmark/spinlock/spinlock.h"
+
+/*
+ * enum class YCSBDistribution - How keys of existing records are chosen
+ */
+enum class YCSBDistribution {
+  Uniform = 0,
+
+  // Skewed towards a few hot records spread over the key space
+  Zipfian,
+
+  // Skewed towards the most recently inserted records
+  Latest,
+};
+
+/*
+ * struct YCSBWorkload - Operation mix of a YCSB workload
+ *
+ * All numbers are percentages of operations, which sum up to 100
+ */
+struct YCSBWorkload {
+  const char *name;
+
+  int read_percent;
+  int update_percent;
+  int insert_percent;
+  int scan_percent;
+  int rmw_percent;
+
+  YCSBDistribution distribution;
+};
+
+/*
+ * Core workloads as defined by YCSB:
+ *   A: Update heavy
+ *   B: Read mostly
+ *   C: Read only
+ *   D: Read latest
+ *   E: Short ranges
+ *   F: Read-modify-write
+ */
+static const YCSBWorkload ycsb_workload_list[] = {
+  {"A", 50, 50, 0, 0, 0, YCSBDistribution::Zipfian},
+  {"B", 95, 5, 0, 0, 0, YCSBDistribution::Zipfian},
+  {"C", 100, 0, 0, 0, 0, YCSBDistribution::Zipfian},
+  {"D", 95, 0, 5, 0, 0, YCSBDistribution::Latest},
+  {"E", 0, 0, 5, 95, 0, YCSBDistribution::Zipfian},
+  {"F", 50, 0, 0, 0, 50, YCSBDistribution::Zipfian},
+};
+
+// Skewness used by both zipfian and latest distribution (YCSB default)
+static constexpr double YCSB_ZIPFIAN_THETA = 0.99;
+
+// Length of short scans is uniformly distributed in [1, this value]
+static constexpr uint64_t YCSB_MAX_SCAN_LENGTH = 100;
+
+/*
+ * class YCSBBwTreeIndex - Runs YCSB operations on BwTree
+ *
+ * Since BwTree is a multimap, an update deletes the current value and
+ * inserts the new one. If another thread replaced the value in the meantime
+ * then the delete fails and we retry with the new value. Reads that happen
+ * between the delete and the insert miss the record, and are reported in
+ * the miss column
+ */
+class YCSBBwTreeIndex {
+ private:
+  TreeType *tree_p;
+
+ public:
+  YCSBBwTreeIndex() :
+    tree_p{GetEmptyTree(true)} {
+    return;
+  }
+
+  ~YCSBBwTreeIndex() {
+    delete tree_p;
+
+    return;
+  }
+
+  static const char *GetName() {
+    return "bwtree";
+  }
+
+  static bool SupportsScan() {
+    return true;
+  }
+
+  static bool SupportsConcurrency() {
+    return true;
+  }
+
+  /*
+   * GetGCTree() - Returns the tree whose GC needs per-thread registration
+   */
+  TreeType *GetGCTree() {
+    return tree_p;
+  }
+
+  inline void Insert(long key, long value) {
+    tree_p->Insert(key, value);
+
+    return;
+  }
+
+  inline bool Read(long key, long *value_p) {
+    return tree_p->GetValue(key, value_p, 1) != 0;
+  }
+
+  inline bool Update(long key, long value) {
+    long old_value;
+
+    while(Read(key, &old_value) == true) {
+      if(tree_p->Delete(key, old_value) == true) {
+        tree_p->Insert(key, value);
+
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  inline size_t Scan(long key, size_t length, long *sum_p) {
+    return tree_p->ScanRangeLimit(key,
+                                  length,
+                                  [sum_p](const long &, const long &value) {
+      *sum_p += value;
+
+      return true;
+    });
+  }
+};
+
+/*
+ * class YCSBBTreeIndex - Runs YCSB operations on stx::btree_multimap
+ *
+ * The B+Tree is not thread-safe, so all operations are protected by the
+ * reader-writer spinlock which is also used by benchmark-btree-full
+ */
+class YCSBBTreeIndex {
+ private:
+  BTreeType *tree_p;
+  spinlock_t lock;
+
+ public:
+  YCSBBTreeIndex() :
+    tree_p{GetEmptyBTree()} {
+    rwlock_init(lock);
+
+    return;
+  }
+
+  ~YCSBBTreeIndex() {
+    DestroyBTree(tree_p);
+
+    return;
+  }
+
+  static const char *GetName() {
+    return "btree";
+  }
+
+  static bool SupportsScan() {
+    return true;
+  }
+
+  static bool SupportsConcurrency() {
+    return true;
+  }
+
+  TreeType *GetGCTree() {
+    return nullptr;
+  }
+
+  inline void Insert(long key, long value) {
+    write_lock(lock);
+    tree_p->insert(key, value);
+    write_unlock(lock);
+
+    return;
+  }
+
+  inline bool Read(long key, long *value_p) {
+    read_lock(lock);
+
+    auto it = tree_p->find(key);
+    bool found = (it != tree_p->end());
+    if(found == true) {
+      *value_p = it->second;
+    }
+
+    read_unlock(lock);
+
+    return found;
+  }
+
+  inline bool Update(long key, long value) {
+    write_lock(lock);
+
+    auto it = tree_p->find(key);
+    bool found = (it != tree_p->end());
+    if(found == true) {
+      it->second = value;
+    }
+
+    write_unlock(lock);
+
+    return found;
+  }
+
+  inline size_t Scan(long key, size_t length, long *sum_p) {
+    size_t count = 0;
+
+    read_lock(lock);
+
+    auto it = tree_p->lower_bound(key);
+    while(count < length && it != tree_p->end()) {
+      *sum_p += it->second;
+      count++;
+      ++it;
+    }
+
+    read_unlock(lock);
+
+    return count;
+  }
+};
+
+/*
+ * class YCSBSkipListIndex - Runs YCSB operations on the concurrent skiplist
+ *
+ * Updates store the new value into the node in-place. sl_map does not
+ * expose a lower bound search, so a scan must start from an existing key;
+ * since scan keys are chosen among inserted records this is only a problem
+ * for records whose insertion is still in progress, which are skipped
+ */
+class YCSBSkipListIndex {
+ private:
+  sl_map_gc<long, long> map;
+
+ public:
+  YCSBSkipListIndex() :
+    map{} {
+    return;
+  }
+
+  static const char *GetName() {
+    return "skiplist";
+  }
+
+  static bool SupportsScan() {
+    return true;
+  }
+
+  static bool SupportsConcurrency() {
+    return true;
+  }
+
+  TreeType *GetGCTree() {
+    return nullptr;
+  }
+
+  inline void Insert(long key, long value) {
+    map.insert(std::make_pair(key, value));
+
+    return;
+  }
+
+  inline bool Read(long key, long *value_p) {
+    auto it = map.find(key);
+    if(it == map.end()) {
+      return false;
+    }
+
+    *value_p = it->second;
+
+    return true;
+  }
+
+  inline bool Update(long key, long value) {
+    auto it = map.find(key);
+    if(it == map.end()) {
+      return false;
+    }
+
+    it->second = value;
+
+    return true;
+  }
+
+  inline size_t Scan(long key, size_t length, long *sum_p) {
+    size_t count = 0;
+
+    auto it = map.find(key);
+    while(count < length && it != map.end()) {
+      *sum_p += it->second;
+      count++;
+      ++it;
+    }
+
+    return count;
+  }
+};
+
+/*
+ * class YCSBCuckooIndex - Runs YCSB operations on libcuckoo
+ *
+ * The hash table does not keep keys in order, so workload E is not run
+ */
+class YCSBCuckooIndex {
+ private:
+  cuckoohash_map<long, long> map;
+
+ public:
+  YCSBCuckooIndex() :
+    map{} {
+    return;
+  }
+
+  static const char *GetName() {
+    return "cuckoo";
+  }
+
+  static bool SupportsScan() {
+    return false;
+  }
+
+  static bool SupportsConcurrency() {
+    return true;
+  }
+
+  TreeType *GetGCTree() {
+    return nullptr;
+  }
+
+  inline void Insert(long key, long value) {
+    map.insert(key, value);
+
+    return;
+  }
+
+  inline bool Read(long key, long *value_p) {
+    return map.find(key, *value_p);
+  }
+
+  inline bool Update(long key, long value) {
+    return map.update(key, value);
+  }
+
+  inline size_t Scan(long, size_t, long *) {
+    assert(false);
+
+    return 0UL;
+  }
+};
+
+/*
+ * class YCSBARTIndex - Runs YCSB operations on ART
+ *
+ * ART only supports single threaded execution, so it is skipped if more
+ * than one thread is used. Keys are stored big-endian such that the byte
+ * order of keys is also their numeric order (all keys are non-negative).
+ * Values are stored directly as the value pointer with an offset of one,
+ * since ART uses nullptr to indicate that the key does not exist
+ */
+class YCSBARTIndex {
+ private:
+  ARTType tree;
+
+  /*
+   * struct ScanState - Passed to the ART iteration callback during scans
+   */
+  struct ScanState {
+    uint64_t low_key;
+    size_t length;
+    size_t count;
+    long *sum_p;
+  };
+
+  static inline uint64_t EncodeKey(long key) {
+    return __builtin_bswap64(static_cast<uint64_t>(key));
+  }
+
+  static inline uint64_t DecodeKey(const unsigned char *key_p) {
+    uint64_t key;
+    memcpy(&key, key_p, sizeof(key));
+
+    return __builtin_bswap64(key);
+  }
+
+  static inline void *EncodeValue(long value) {
+    return reinterpret_cast<void *>(value + 1);
+  }
+
+  static inline long DecodeValue(void *value_p) {
+    return reinterpret_cast<long>(value_p) - 1;
+  }
+
+  /*
+   * ScanCallback() - Called by art_iter_prefix() in key order
+   *
+   * Returns non-zero to stop the iteration after enough keys are collected
+   */
+  static int ScanCallback(void *data,
+                          const unsigned char *key_p,
+                          uint32_t key_len,
+                          void *value_p) {
+    ScanState *state_p = static_cast<ScanState *>(data);
+
+    assert(key_len == sizeof(uint64_t));
+    (void)key_len;
+
+    if(DecodeKey(key_p) < state_p->low_key) {
+      return 0;
+    }
+
+    *state_p->sum_p += DecodeValue(value_p);
+    state_p->count++;
+
+    return (state_p->count == state_p->length) ? 1 : 0;
+  }
+
+ public:
+  YCSBARTIndex() {
+    art_tree_init(&tree);
+
+    return;
+  }
+
+  ~YCSBARTIndex() {
+    art_tree_destroy(&tree);
+
+    return;
+  }
+
+  static const char *GetName() {
+    return "art";
+  }
+
+  static bool SupportsScan() {
+    return true;
+  }
+
+  static bool SupportsConcurrency() {
+    return false;
+  }
+
+  TreeType *GetGCTree() {
+    return nullptr;
+  }
+
+  inline void Insert(long key, long value) {
+    uint64_t encoded_key = EncodeKey(key);
+
+    art_insert(&tree,
+               reinterpret_cast<unsigned char *>(&encoded_key),
+               sizeof(encoded_key),
+               EncodeValue(value));
+
+    return;
+  }
+
+  inline bool Read(long key, long *value_p) {
+    uint64_t encoded_key = EncodeKey(key);
+
+    void *ret = art_search(&tree,
+                           reinterpret_cast<unsigned char *>(&encoded_key),
+                           sizeof(encoded_key));
+    if(ret == nullptr) {
+      return false;
+    }
+
+    *value_p = DecodeValue(ret);
+
+    return true;
+  }
+
+  inline bool Update(long key, long value) {
+    long old_value;
+    if(Read(key, &old_value) == false) {
+      return false;
+    }
+
+    // Inserting an existing key replaces its value
+    Insert(key, value);
+
+    return true;
+  }
+
+  /*
+   * Scan() - Iterates over keys sharing the first 7 bytes with the low key,
+   *          and then over following prefixes until enough keys are found
+   *
+   * libart does not provide a range scan, but prefix iteration visits keys
+   * in byte order, and each 7 byte prefix covers 256 consecutive keys
+   */
+  inline size_t Scan(long key, size_t length, long *sum_p) {
+    art_leaf *max_leaf_p = art_maximum(&tree);
+    if(max_leaf_p == nullptr) {
+      return 0UL;
+    }
+
+    uint64_t max_prefix = DecodeKey(max_leaf_p->key) >> 8;
+
+    ScanState state{static_cast<uint64_t>(key), length, 0UL, sum_p};
+
+    for(uint64_t prefix = state.low_key >> 8;
+        prefix <= max_prefix && state.count < length;
+        prefix++) {
+      uint64_t encoded_prefix = EncodeKey(static_cast<long>(prefix << 8));
+
+      art_iter_prefix(&tree,
+                      reinterpret_cast<unsigned char *>(&encoded_prefix),
+                      sizeof(encoded_prefix) - 1,
+                      ScanCallback,
+                      &state);
+    }
+
+    return state.count;
+  }
+};
+
+/*
+ * RunYCSBWorkload() - Loads records into a new index and runs the workload
+ *
+ * Records have keys 0 to record_num - 1 and are loaded in the random order
+ * given by key_map. key_map is also used to scatter the zipfian ranks over
+ * the key space, such that hot records are not clustered in the same
+ * leaf node (i.e. YCSB's scrambled zipfian). Inserted records have keys
+ * starting from record_num, and the latest distribution prefers the larger
+ * ones among them
+ */
+template <typename IndexType>
+void RunYCSBWorkload(const YCSBWorkload &workload,
+                     const Permutation<long> &key_map,
+                     int record_num,
+                     int op_num,
+                     int thread_num,
+                     std::ofstream &csv) {
+  if(workload.scan_percent > 0 && IndexType::SupportsScan() == false) {
+    printf("Skipping workload %s on %s: scan is not supported\n",
+           workload.name,
+           IndexType::GetName());
+
+    return;
+  }
+
+  if(thread_num > 1 && IndexType::SupportsConcurrency() == false) {
+    printf("Skipping workload %s on %s: only single thread is supported\n",
+           workload.name,
+           IndexType::GetName());
+
+    return;
+  }
+
+  IndexType *index_p = new IndexType{};
+  TreeType *gc_tree_p = index_p->GetGCTree();
+
+  auto load_func = [&key_map,
+                    record_num,
+                    thread_num](uint64_t thread_id, IndexType *index_p) {
+    long start_index = record_num / thread_num * (long)thread_id;
+    long end_index = (thread_id == (uint64_t)thread_num - 1) ? \
+                     record_num : start_index + record_num / thread_num;
+
+    for(long i = start_index;i < end_index;i++) {
+      index_p->Insert(key_map[i], key_map[i]);
+    }
+
+    return;
+  };
+
+  LaunchParallelTestID(gc_tree_p, thread_num, load_func, index_p);
+
+  // Keys of new records are allocated from this counter
+  std::atomic<long> next_insert_key{record_num};
+
+  std::vector<LatencyHistogram> latency_list(thread_num);
+  std::vector<uint64_t> miss_count_list(thread_num, 0UL);
+
+  auto run_func = [&workload,
+                   &key_map,
+                   &next_insert_key,
+                   &latency_list,
+                   &miss_count_list,
+                   record_num,
+                   op_num,
+                   thread_num](uint64_t thread_id, IndexType *index_p) {
+    SimpleInt64Random<0, 100> op_rand{};
+    SimpleInt64Random<1, YCSB_MAX_SCAN_LENGTH + 1> scan_length_rand{};
+    SimpleInt64Random<0, UINT64_MAX> uniform_rand{};
+
+    // Different seeds for each thread; the seed must be less than 2^48
+    Zipfian zipf{(uint64_t)record_num,
+                 YCSB_ZIPFIAN_THETA,
+                 (thread_id + 1) * 0x9E3779B9UL};
+
+    LatencyHistogram &latency = latency_list[thread_id];
+    uint64_t miss_count = 0UL;
+    long sum = 0;
+
+    // Salt used to derive independent random numbers from the same index
+    const uint64_t salt = thread_id * 3;
+
+    for(int i = 0;i < op_num / thread_num;i++) {
+      int op = (int)op_rand((uint64_t)i, salt);
+
+      long key;
+      if(workload.distribution == YCSBDistribution::Zipfian) {
+        key = key_map[zipf.Get() % record_num];
+      } else if(workload.distribution == YCSBDistribution::Latest) {
+        long latest_key = next_insert_key.load() - 1;
+
+        // Zeta is computed incrementally when the number of records grows
+        zipf.ChangeN((uint64_t)latest_key + 1);
+        key = latest_key - (long)(zipf.Get() % (latest_key + 1));
+      } else {
+        key = (long)(uniform_rand((uint64_t)i, salt + 1) % record_num);
+      }
+
+      uint64_t op_start = LatencyHistogram::ReadTSC();
+
+      long value = 0;
+      if(op < workload.read_percent) {
+        if(index_p->Read(key, &value) == false) {
+          miss_count++;
+        }
+
+        sum += value;
+      } else if((op -= workload.read_percent) < workload.update_percent) {
+        if(index_p->Update(key, (long)i) == false) {
+          miss_count++;
+        }
+      } else if((op -= workload.update_percent) < workload.insert_percent) {
+        long new_key = next_insert_key.fetch_add(1);
+
+        index_p->Insert(new_key, new_key);
+      } else if((op -= workload.insert_percent) < workload.scan_percent) {
+        size_t length = scan_length_rand((uint64_t)i, salt + 2);
+
+        if(index_p->Scan(key, length, &sum) == 0) {
+          miss_count++;
+        }
+      } else {
+        if(index_p->Read(key, &value) == false ||
+           index_p->Update(key, value + 1) == false) {
+          miss_count++;
+        }
+      }
+
+      latency.Record(LatencyHistogram::ReadTSC() - op_start);
+    }
+
+    miss_count_list[thread_id] = miss_count;
+
+    // Prevent the compiler from optimizing out the reads
+    (void)sum;
+
+    return;
+  };
+
+  Timer timer{true};
+  LaunchParallelTestID(gc_tree_p, thread_num, run_func, index_p);
+  double duration = timer.Stop();
+
+  LatencyHistogram latency = LatencyHistogram::MergeAll(latency_list);
+  double cycles_per_ns = LatencyHistogram::GetCyclesPerNanosecond();
+
+  uint64_t miss_count = 0UL;
+  for(uint64_t count : miss_count_list) {
+    miss_count += count;
+  }
+
+  uint64_t total_op = latency.GetCount();
+
+  char line[256];
+  snprintf(line,
+           sizeof(line),
+           "%s,%s,%d,%d,%lu,%lu,%.4f,%.4f,%.1f,%.1f,%.1f",
+           IndexType::GetName(),
+           workload.name,
+           thread_num,
+           record_num,
+           total_op,
+           miss_count,
+           duration,
+           total_op / (1024.0 * 1024.0) / duration,
+           latency.GetPercentile(0.5) / cycles_per_ns,
+           latency.GetPercentile(0.99) / cycles_per_ns,
+           latency.GetPercentile(0.999) / cycles_per_ns);
+
+  csv << line << "\n";
+  printf("%s\n", line);
+
+  delete index_p;
+
+  return;
+}
+
+/*
+ * BenchmarkYCSB() - Runs the selected YCSB workloads on all indices
+ *
+ * workload_names is a string of workload letters (e.g. "ABCDEF"), and
+ * op_num is the total number of operations, which is evenly divided among
+ * threads. Results are written to csv_file_name, one row per index and
+ * workload
+ */
+void BenchmarkYCSB(int record_num,
+                   int op_num,
+                   int thread_num,
+                   const std::string &workload_names,
+                   const std::string &csv_file_name) {
+  std::ofstream csv{csv_file_name};
+  if(csv.is_open() == false) {
+    throw "Could not open YCSB CSV file";
+  }
+
+  const char *header = \
+    "index,workload,thread_num,record_num,op_num,miss_num,seconds,"
+    "million_op_per_sec,p50_ns,p99_ns,p999_ns";
+
+  csv << header << "\n";
+  printf("%s\n", header);
+
+  // Shared by all workloads such that every index sees the same keys
+  Permutation<long> key_map{(size_t)record_num};
+
+  for(const YCSBWorkload &workload : ycsb_workload_list) {
+    if(workload_names.find(workload.name) == std::string::npos) {
+      continue;
+    }
+
+    RunYCSBWorkload<YCSBBwTreeIndex>(
+      workload, key_map, record_num, op_num, thread_num, csv);
+    RunYCSBWorkload<YCSBBTreeIndex>(
+      workload, key_map, record_num, op_num, thread_num, csv);
+    RunYCSBWorkload<YCSBSkipListIndex>(
+      workload, key_map, record_num, op_num, thread_num, csv);
+    RunYCSBWorkload<YCSBCuckooIndex>(
+      workload, key_map, record_num, op_num, thread_num, csv);
+    RunYCSBWorkload<YCSBARTIndex>(
+      workload, key_map, record_num, op_num, thread_num, csv);
+  }
+
+  return;
+}
@@ -74,3 +74,375 @@ void BackwardIteratorTest(TreeType *t, int key_num) {
   
   return;
 }
+
+/*
+ * PinnedIteratorTest() - Tests iterators that read leaf nodes in place
+ *
+ * Leaf nodes with and without delta chains are both iterated, and copies
+ * of the iterator must not be affected when the original one advances
+ */
+void PinnedIteratorTest(TreeType *t, int key_num) {
+  printf("========== Pinned Iteration Test ==========\n");
+  
+  long i = 0;
+  
+  {
+    auto it = t->PinnedBegin();
+    while(it.IsEnd() == false) {
+      assert(it->first == it->second);
+      assert(it->first == i);
+      
+      i++;
+      ++it;
+    }
+  }
+  
+  assert(i == key_num);
+  
+  {
+    auto it = t->PinnedBegin(key_num / 2);
+    auto it2 = it;
+    
+    // it2 shares the leaf with it, so advancing it across the leaf boundary
+    // must allocate a new context rather than modifying the shared one
+    for(i = key_num / 2;i < key_num;i++) {
+      assert(it.IsEnd() == false);
+      assert(it->first == i);
+      
+      ++it;
+    }
+    
+    assert(it.IsEnd() == true);
+    assert(it2->first == key_num / 2);
+    
+    // Pinned iterators could also move backward
+    --it2;
+    assert(it2->first == key_num / 2 - 1);
+  }
+  
+  printf("PASS\n");
+  
+  return;
+}
+
+/*
+ * RangeScanTest() - Tests callback based range scan
+ *
+ * The tree must contain keys from 0 to key_num - 1 with value equal to the
+ * key. Some keys are deleted and inserted back during the test to make sure
+ * leaf nodes with delta chains are scanned correctly
+ */
+void RangeScanTest(TreeType *t, int key_num) {
+  printf("========== Range Scan Test ==========\n");
+  
+  long expected = 0;
+  auto check_func = [&expected](const long &key, const long &value) {
+    assert(key == value);
+    assert(key == expected);
+    
+    expected++;
+    
+    return true;
+  };
+  
+  // Full range
+  expected = 0;
+  assert(t->ScanRange(0, key_num, true, true, check_func) == (size_t)key_num);
+  assert(expected == key_num);
+  
+  // Exclusive bounds
+  expected = 101;
+  assert(t->ScanRange(100, 200, false, false, check_func) == 99UL);
+  assert(expected == 200);
+  
+  // Inclusive bounds
+  expected = 100;
+  assert(t->ScanRange(100, 200, true, true, check_func) == 101UL);
+  assert(expected == 201);
+  
+  // Empty range
+  assert(t->ScanRange(key_num, key_num + 100, true, true, check_func) == 0UL);
+  
+  // Limit
+  expected = key_num / 2;
+  assert(t->ScanRangeLimit(key_num / 2, 1000, check_func) == 1000UL);
+  assert(expected == key_num / 2 + 1000);
+  
+  // Early termination by the scan function
+  long count = 0;
+  t->ScanRange(0, key_num, true, true, [&count](const long &, const long &) {
+    count++;
+    
+    return count < 10;
+  });
+  assert(count == 10);
+  
+  // Delete every third key in a range such that leaf nodes have deltas
+  const long delete_start = key_num / 4;
+  const long delete_end = delete_start + 10000;
+  for(long i = delete_start;i < delete_end;i += 3) {
+    t->Delete(i, i);
+  }
+  
+  long prev = delete_start - 1;
+  size_t scan_count = \
+    t->ScanRange(delete_start, 
+                 delete_end, 
+                 true, 
+                 false, 
+                 [&prev, delete_start](const long &key, const long &value) {
+      assert(key == value);
+      assert(key > prev);
+      assert((key - delete_start) % 3 != 0);
+      
+      prev = key;
+      
+      return true;
+    });
+  assert(scan_count == 10000UL - (10000UL + 2) / 3);
+  
+  for(long i = delete_start;i < delete_end;i += 3) {
+    t->Insert(i, i);
+  }
+  
+  expected = 0;
+  assert(t->ScanRange(0, key_num, true, false, check_func) == (size_t)key_num);
+  
+  printf("PASS\n");
+  
+  return;
+}
+
+/*
+ * ParallelScanTest() - Tests parallel scan using a thread pool
+ *
+ * The tree must contain keys from 0 to key_num - 1 with value equal to the
+ * key. Each partition is collected into its own buffer, and concatenating
+ * them should give all keys in order
+ */
+void ParallelScanTest(TreeType *t, int key_num) {
+  printf("========== Parallel Scan Test ==========\n");
+  
+  const size_t thread_num = 4;
+  
+  // GC ID 0 is used by the current thread
+  t->UpdateThreadLocal(thread_num + 1);
+  
+  {
+    ThreadPool pool{t, thread_num, 1};
+    auto submit_func = [&pool](std::function<void()> &&task) {
+      pool.Submit(std::move(task));
+    };
+    
+    // This checks whether the result is [start, end) in key order
+    auto check_result = [](const std::vector<std::vector<long>> &result_list,
+                           long start,
+                           long end) {
+      long expected = start;
+      for(const std::vector<long> &result : result_list) {
+        for(long key : result) {
+          assert(key == expected);
+          
+          expected++;
+        }
+      }
+      
+      assert(expected == end);
+    };
+    
+    for(size_t partition_num : {1UL, 4UL, 16UL, 1000UL}) {
+      std::vector<std::vector<long>> result_list{};
+      result_list.resize(partition_num);
+      
+      size_t scan_count = \
+        t->ParallelScan(partition_num, 
+                        submit_func, 
+                        [&result_list](size_t partition_id, 
+                                       const long &key, 
+                                       const long &value) {
+          assert(key == value);
+          
+          result_list.at(partition_id).push_back(key);
+          
+          return true;
+        });
+      
+      assert(scan_count == (size_t)key_num);
+      check_result(result_list, 0, key_num);
+      
+      // Partitions should be used if there are enough keys
+      size_t non_empty_count = 0;
+      for(const std::vector<long> &result : result_list) {
+        non_empty_count += (result.empty() == false);
+      }
+      
+      printf("Partition num = %lu; non-empty partitions = %lu\n", 
+             partition_num, 
+             non_empty_count);
+      assert((partition_num == 1UL) || (non_empty_count > 1UL));
+    }
+    
+    // Bounded scan
+    std::vector<std::vector<long>> result_list{};
+    result_list.resize(8);
+    
+    size_t scan_count = \
+      t->ParallelScanRange(100, 
+                           key_num - 100, 
+                           true, 
+                           false, 
+                           8, 
+                           submit_func,
+                           [&result_list](size_t partition_id, 
+                                          const long &key, 
+                                          const long &) {
+        result_list.at(partition_id).push_back(key);
+        
+        return true;
+      });
+    
+    assert(scan_count == (size_t)key_num - 200);
+    check_result(result_list, 100, key_num - 100);
+    
+    // Early termination only stops the current partition
+    std::atomic<size_t> partition_count{0};
+    scan_count = \
+      t->ParallelScan(8, 
+                      submit_func,
+                      [&partition_count](size_t, const long &, const long &) {
+        partition_count.fetch_add(1);
+        
+        return false;
+      });
+    
+    assert(scan_count == partition_count.load());
+    assert(scan_count > 1UL);
+  }
+  
+  t->UpdateThreadLocal(1);
+  
+  printf("PASS\n");
+  
+  return;
+}
+
+/*
+ * ReverseScanTest() - Tests callback based reverse range scan
+ *
+ * The tree must contain keys from 0 to key_num - 1 with value equal to the
+ * key. Some keys are deleted and inserted back during the test to make sure
+ * leaf nodes with delta chains are scanned correctly
+ */
+void ReverseScanTest(TreeType *t, int key_num) {
+  printf("========== Reverse Scan Test ==========\n");
+  
+  long expected = 0;
+  auto check_func = [&expected](const long &key, const long &value) {
+    assert(key == value);
+    assert(key == expected);
+    
+    expected--;
+    
+    return true;
+  };
+  
+  // Whole tree
+  expected = key_num - 1;
+  assert(t->ReverseScanAll(check_func) == (size_t)key_num);
+  assert(expected == -1);
+  
+  // Full range
+  expected = key_num - 1;
+  assert(t->ReverseScanRange(0, key_num, true, true, check_func) == \
+         (size_t)key_num);
+  assert(expected == -1);
+  
+  // Exclusive bounds
+  expected = 199;
+  assert(t->ReverseScanRange(100, 200, false, false, check_func) == 99UL);
+  assert(expected == 100);
+  
+  // Inclusive bounds
+  expected = 200;
+  assert(t->ReverseScanRange(100, 200, true, true, check_func) == 101UL);
+  assert(expected == 99);
+  
+  // Empty range
+  assert(t->ReverseScanRange(-100, -1, true, true, check_func) == 0UL);
+  
+  // Limit
+  expected = key_num / 2;
+  assert(t->ReverseScanRangeLimit(key_num / 2, 1000, check_func) == 1000UL);
+  assert(expected == key_num / 2 - 1000);
+  
+  // Early termination by the scan function
+  long count = 0;
+  t->ReverseScanAll([&count](const long &, const long &) {
+    count++;
+    
+    return count < 10;
+  });
+  assert(count == 10);
+  
+  // Delete every third key in a range such that leaf nodes have deltas
+  const long delete_start = key_num / 4;
+  const long delete_end = delete_start + 10000;
+  for(long i = delete_start;i < delete_end;i += 3) {
+    t->Delete(i, i);
+  }
+  
+  long prev = delete_end;
+  size_t scan_count = \
+    t->ReverseScanRange(delete_start, 
+                        delete_end, 
+                        true, 
+                        false, 
+                        [&prev, delete_start](const long &key, 
+                                              const long &value) {
+      assert(key == value);
+      assert(key < prev);
+      assert((key - delete_start) % 3 != 0);
+      
+      prev = key;
+      
+      return true;
+    });
+  assert(scan_count == 10000UL - (10000UL + 2) / 3);
+  
+  for(long i = delete_start;i < delete_end;i += 3) {
+    t->Insert(i, i);
+  }
+  
+  expected = key_num - 1;
+  assert(t->ReverseScanAll(check_func) == (size_t)key_num);
+  
+  // Deleting half of the keys in the upper half causes leaf nodes and
+  // inner nodes to be removed and merged
+  for(long i = key_num / 2 + 1;i < key_num;i += 2) {
+    t->Delete(i, i);
+  }
+  
+  prev = key_num;
+  scan_count = t->ReverseScanAll([&prev, key_num](const long &key, 
+                                                  const long &value) {
+    assert(key == value);
+    assert(key < prev);
+    assert((key < key_num / 2) || (key % 2 == 0));
+    
+    prev = key;
+    
+    return true;
+  });
+  assert(scan_count == (size_t)(key_num / 2 + key_num / 4));
+  
+  for(long i = key_num / 2 + 1;i < key_num;i += 2) {
+    t->Insert(i, i);
+  }
+  
+  expected = key_num - 1;
+  assert(t->ReverseScanAll(check_func) == (size_t)key_num);
+  
+  printf("PASS\n");
+  
+  return;
+}
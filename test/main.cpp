@@ -25,6 +25,12 @@ int main(int argc, char **argv) {
   bool run_benchmark_bwtree_full = false;
   bool run_benchmark_btree_full = false;
   bool run_benchmark_art_full = false;
+  bool run_benchmark_normalized_key = false;
+  bool run_benchmark_ycsb = false;
+  bool run_benchmark_scaling = false;
+  bool run_benchmark_contention = false;
+  bool run_benchmark_async = false;
+  bool run_benchmark_frozen = false;
   bool run_stress = false;
   bool run_epoch_test = false;
   bool run_infinite_insert_test = false;
@@ -47,6 +53,18 @@ int main(int argc, char **argv) {
       run_benchmark_btree_full = true;
     } else if(strcmp(opt_p, "--benchmark-art-full") == 0) {
       run_benchmark_art_full = true;
+    } else if(strcmp(opt_p, "--benchmark-normalized-key") == 0) {
+      run_benchmark_normalized_key = true;
+    } else if(strcmp(opt_p, "--benchmark-ycsb") == 0) {
+      run_benchmark_ycsb = true;
+    } else if(strcmp(opt_p, "--benchmark-scaling") == 0) {
+      run_benchmark_scaling = true;
+    } else if(strcmp(opt_p, "--benchmark-contention") == 0) {
+      run_benchmark_contention = true;
+    } else if(strcmp(opt_p, "--benchmark-async") == 0) {
+      run_benchmark_async = true;
+    } else if(strcmp(opt_p, "--benchmark-frozen") == 0) {
+      run_benchmark_frozen = true;
     } else if(strcmp(opt_p, "--stress-test") == 0) {
       run_stress = true;
     } else if(strcmp(opt_p, "--epoch-test") == 0) {
@@ -70,6 +88,13 @@ int main(int argc, char **argv) {
   bwt_printf("RUN_BENCHMARK_BWTREE_FULL = %d\n", run_benchmark_bwtree_full);
   bwt_printf("RUN_BENCHMARK_BWTREE = %d\n", run_benchmark_bwtree);
   bwt_printf("RUN_BENCHMARK_ART_FULL = %d\n", run_benchmark_art_full);
+  bwt_printf("RUN_BENCHMARK_NORMALIZED_KEY = %d\n",
+             run_benchmark_normalized_key);
+  bwt_printf("RUN_BENCHMARK_YCSB = %d\n", run_benchmark_ycsb);
+  bwt_printf("RUN_BENCHMARK_SCALING = %d\n", run_benchmark_scaling);
+  bwt_printf("RUN_BENCHMARK_CONTENTION = %d\n", run_benchmark_contention);
+  bwt_printf("RUN_BENCHMARK_ASYNC = %d\n", run_benchmark_async);
+  bwt_printf("RUN_BENCHMARK_FROZEN = %d\n", run_benchmark_frozen);
   bwt_printf("RUN_TEST = %d\n", run_test);
   bwt_printf("RUN_STRESS = %d\n", run_stress);
   bwt_printf("RUN_EPOCH_TEST = %d\n", run_epoch_test);
@@ -140,6 +165,118 @@ int main(int argc, char **argv) {
     delete[] array;
   }
 
+  if(run_benchmark_normalized_key == true) {
+    int key_num = 1024 * 1024;
+
+    printf("Using key size = %d (%f million)\n",
+           key_num,
+           key_num / (1024.0 * 1024.0));
+
+    BenchmarkNormalizedKeySort(key_num);
+    BenchmarkNormalizedKeyTree(key_num);
+  }
+
+  if(run_benchmark_ycsb == true) {
+    // All parameters could be overridden by environmental variables
+    unsigned long record_num = 1024 * 1024;
+    unsigned long op_num = 1024 * 1024;
+    
+    if(Envp::GetValueAsUL("YCSB_RECORD_NUM", &record_num) == false ||
+       Envp::GetValueAsUL("YCSB_OP_NUM", &op_num) == false) {
+      throw "YCSB_RECORD_NUM and YCSB_OP_NUM must be unsigned integers!";
+    }
+    
+    std::string workload_names = Envp::Get("YCSB_WORKLOAD");
+    if(workload_names.empty() == true) {
+      workload_names = "ABCDEF";
+    }
+    
+    std::string csv_file_name = Envp::Get("YCSB_CSV");
+    if(csv_file_name.empty() == true) {
+      csv_file_name = "ycsb.csv";
+    }
+    
+    uint64_t thread_num = GetThreadNum();
+    
+    printf("Running YCSB workloads %s with %lu records and %lu operations\n",
+           workload_names.c_str(),
+           record_num,
+           op_num);
+    
+    BenchmarkYCSB((int)record_num,
+                  (int)op_num,
+                  (int)thread_num,
+                  workload_names,
+                  csv_file_name);
+    
+    printf("YCSB results are written to %s\n", csv_file_name.c_str());
+  }
+
+  if(run_benchmark_scaling == true) {
+    // By default sweep up to the number of cores of this machine
+    unsigned long key_num = 3 * 1024 * 1024;
+    unsigned long core_num = std::thread::hardware_concurrency();
+    unsigned long repeat_num = 3;
+    
+    if(Envp::GetValueAsUL("SCALING_KEY_NUM", &key_num) == false ||
+       Envp::GetValueAsUL("SCALING_CORE_NUM", &core_num) == false ||
+       Envp::GetValueAsUL("SCALING_REPEAT", &repeat_num) == false) {
+      throw "SCALING_KEY_NUM, SCALING_CORE_NUM and SCALING_REPEAT "
+            "must be unsigned integers!";
+    }
+    
+    if(core_num == 0) {
+      core_num = 1;
+    }
+    
+    std::string csv_file_name = Envp::Get("SCALING_CSV");
+    if(csv_file_name.empty() == true) {
+      csv_file_name = "scaling.csv";
+    }
+    
+    printf("Scaling from 1 to %lu threads with %lu keys, %lu runs each\n",
+           core_num,
+           key_num,
+           repeat_num);
+    
+    BenchmarkScaling((int)key_num,
+                     (int)core_num,
+                     (int)repeat_num,
+                     csv_file_name);
+    
+    printf("Scaling results are written to %s\n", csv_file_name.c_str());
+  }
+
+  if(run_benchmark_contention == true) {
+    unsigned long key_num = 1024 * 1024;
+    
+    if(Envp::GetValueAsUL("CONTENTION_KEY_NUM", &key_num) == false) {
+      throw "CONTENTION_KEY_NUM must be an unsigned integer!";
+    }
+    
+    BenchmarkBwTreeContentionSplit((int)key_num, (int)GetThreadNum());
+  }
+
+  if(run_benchmark_async == true) {
+    unsigned long key_num = 1024 * 1024;
+    
+    if(Envp::GetValueAsUL("ASYNC_KEY_NUM", &key_num) == false) {
+      throw "ASYNC_KEY_NUM must be an unsigned integer!";
+    }
+    
+    BenchmarkBwTreeAsync((int)key_num);
+  }
+
+  if(run_benchmark_frozen == true) {
+    unsigned long key_num = 1024 * 1024;
+    
+    if(Envp::GetValueAsUL("FROZEN_KEY_NUM", &key_num) == false) {
+      throw "FROZEN_KEY_NUM must be an unsigned integer!";
+    }
+    
+    BenchmarkBwTreeFrozen((int)key_num);
+  }
+
   if(run_benchmark_btree_full == true) {
     BTreeType *t = GetEmptyBTree();
     int key_num = 30 * 1024 * 1024;
@@ -190,6 +327,12 @@ int main(int argc, char **argv) {
       BenchmarkBwTreeRandRead(t1, key_num, (int)thread_num);
       // Zipfan read
       BenchmarkBwTreeZipfRead(t1, key_num, (int)thread_num);
+      // Compare heap allocations of different point lookup interfaces
+      BenchmarkBwTreeAllocFreeRead(t1, key_num, (int)thread_num);
+      // Full table scan with and without zero-copy iterator
+      BenchmarkBwTreeFullScan(t1, key_num);
+      // Parallel full table scan from 1 to thread_num threads
+      BenchmarkBwTreeParallelScan(t1, key_num, (int)thread_num);
     } else {
       // This function will delete all keys at the end, so the tree
       // is empty after it returns
@@ -259,6 +402,10 @@ int main(int argc, char **argv) {
 
     ForwardIteratorTest(t1, key_num);
     BackwardIteratorTest(t1, key_num);
+    PinnedIteratorTest(t1, key_num);
+    RangeScanTest(t1, key_num);
+    ParallelScanTest(t1, key_num);
+    ReverseScanTest(t1, key_num);
     
     PrintStat(t1);
 
@@ -284,6 +431,162 @@ int main(int argc, char **argv) {
     // no print
     DestroyTree(t1, true);
 
+    /////////////////////////////////////////////////////////////////
+    // Test memory accounting
+    /////////////////////////////////////////////////////////////////
+    
+    t1 = GetEmptyTree(true);
+    
+    MemoryUsageTest(t1, 256 * 1024);
+    
+    DestroyTree(t1, true);
+
+    /////////////////////////////////////////////////////////////////
+    // Test operation statistics
+    /////////////////////////////////////////////////////////////////
+
+    t1 = GetEmptyTree(true);
+
+    OperationStatsTest(t1, 256 * 1024);
+
+    DestroyTree(t1, true);
+
+    /////////////////////////////////////////////////////////////////
+    // Test tree analysis
+    /////////////////////////////////////////////////////////////////
+
+    t1 = GetEmptyTree(true);
+
+    AnalyzeTreeTest(t1, 256 * 1024);
+
+    DestroyTree(t1, true);
+
+    /////////////////////////////////////////////////////////////////
+    // Test NodeID recycling
+    /////////////////////////////////////////////////////////////////
+
+    t1 = GetEmptyTree(true);
+
+    NodeIDRecycleTest(t1, 256 * 1024);
+
+    DestroyTree(t1, true);
+
+    t1 = GetEmptyTree(true);
+
+    NodeIDRecycleStressTest(t1, 64 * 1024, 4);
+
+    DestroyTree(t1, true);
+
+    /////////////////////////////////////////////////////////////////
+    // Test helping removals posted on a blocked parent
+    /////////////////////////////////////////////////////////////////
+
+    t1 = GetEmptyTree(true);
+
+    RemovalHelpTest(t1, 4 * 1024);
+
+    DestroyTree(t1, true);
+
+    /////////////////////////////////////////////////////////////////
+    // Test deferred merge
+    /////////////////////////////////////////////////////////////////
+
+    t1 = GetEmptyTree(true);
+
+    DeferredMergeTest(t1, 256 * 1024);
+
+    DestroyTree(t1, true);
+
+    /////////////////////////////////////////////////////////////////
+    // Test append split
+    /////////////////////////////////////////////////////////////////
+
+    t1 = GetEmptyTree(true);
+
+    AppendSplitTest(t1, 256 * 1024);
+
+    DestroyTree(t1, true);
+
+    /////////////////////////////////////////////////////////////////
+    // Test contention split
+    /////////////////////////////////////////////////////////////////
+
+    t1 = GetEmptyTree(true);
+
+    ContentionSplitTest(t1, 64 * 1024);
+
+    DestroyTree(t1, true);
+
+    /////////////////////////////////////////////////////////////////
+    // Test backoff after CAS failures
+    /////////////////////////////////////////////////////////////////
+
+    t1 = GetEmptyTree(true);
+
+    BackoffTest(t1, 64 * 1024, 4);
+
+    DestroyTree(t1, true);
+
+    /////////////////////////////////////////////////////////////////
+    // Test retrying on the leaf after CAS failures
+    /////////////////////////////////////////////////////////////////
+
+    t1 = GetEmptyTree(true);
+
+    LeafRetryTest(t1, 64 * 1024);
+
+    DestroyTree(t1, true);
+
+    /////////////////////////////////////////////////////////////////
+    // Test async operations
+    /////////////////////////////////////////////////////////////////
+
+    t1 = GetEmptyTree(true);
+
+    AsyncOperationTest(t1, 64 * 1024);
+
+    DestroyTree(t1, true);
+
+    t1 = GetEmptyTree(true);
+
+    AsyncConcurrentWriteTest(t1, 64 * 1024);
+
+    DestroyTree(t1, true);
+
+    t1 = GetEmptyTree(true);
+
+    AsyncEpochTest(t1, 64 * 1024);
+
+    DestroyTree(t1, true);
+
+    /////////////////////////////////////////////////////////////////
+    // Test partitioned trees
+    /////////////////////////////////////////////////////////////////
+
+    PartitionedTreeTest(64 * 1024, 4);
+
+    /////////////////////////////////////////////////////////////////
+    // Test frozen trees
+    /////////////////////////////////////////////////////////////////
+
+    t1 = GetEmptyTree(true);
+
+    FreezeTest(t1, 64 * 1024);
+
+    DestroyTree(t1, true);
+
+    /////////////////////////////////////////////////////////////////
+    // Test lookups with key views
+    /////////////////////////////////////////////////////////////////
+
+    HeterogeneousLookupTest(16 * 1024);
+
+    /////////////////////////////////////////////////////////////////
+    // Test normalized key encoding
+    /////////////////////////////////////////////////////////////////
+
+    NormalizedKeyTest(64 * 1024);
+
     /////////////////////////////////////////////////////////////////
     // Test mixed insert/delete
     /////////////////////////////////////////////////////////////////
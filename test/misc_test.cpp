@@ -46,3 +46,2084 @@ void TestEpochManager(TreeType *t) {
 
   return;
 }
+
+/*
+ * GetMappedNodeMemorySize() - Sums memory of all nodes in the mapping table
+ *
+ * This must be called after all garbage has been freed, such that nodes
+ * reachable from the mapping table are all nodes of the tree
+ */
+static size_t GetMappedNodeMemorySize(TreeType *t) {
+  size_t memory_size = 0UL;
+  
+  for(NodeID node_id = 1; 
+      node_id < t->next_unused_node_id.load(); 
+      node_id++) {
+    const TreeType::BaseNode *node_p = t->GetNode(node_id);
+    if(node_p != nullptr) {
+      memory_size += t->GetGarbageMemorySize(node_p);
+    }
+  }
+  
+  return memory_size;
+}
+
+/*
+ * CheckMemoryUsage() - Frees all garbage and compares memory counters with
+ *                      the memory of nodes in the mapping table
+ */
+static void CheckMemoryUsage(TreeType *t) {
+  t->ClearThreadLocalGarbage();
+  
+  TreeType::MemoryUsage usage = t->GetMemoryUsage();
+  size_t mapped_size = GetMappedNodeMemorySize(t);
+  
+  printf("    base = %lu; delta = %lu; garbage = %lu; total = %lu\n",
+         usage.base_node_size,
+         usage.delta_size,
+         usage.garbage_size,
+         usage.GetTotalSize());
+  
+  if((usage.garbage_size != 0UL) ||
+     (usage.garbage_node_count != 0UL) ||
+     (usage.base_node_size + usage.delta_size != mapped_size)) {
+    printf("Memory usage mismatch: counted %lu; mapped %lu\n",
+           usage.base_node_size + usage.delta_size,
+           mapped_size);
+    
+    exit(1);
+  }
+  
+  if(usage.GetTotalSize() != t->GetMemoryFootprint()) {
+    printf("Memory footprint does not equal total size\n");
+    
+    exit(1);
+  }
+  
+  return;
+}
+
+/*
+ * MemoryUsageTest() - Tests memory accounting and Cleanup()
+ *
+ * Memory counters are compared with the memory of all nodes in the mapping
+ * table after single threaded and multi-threaded modifications
+ */
+void MemoryUsageTest(TreeType *t, int key_num) {
+  printf("Testing memory usage on empty tree...\n");
+  CheckMemoryUsage(t);
+  
+  size_t empty_size = t->GetMemoryFootprint();
+  
+  printf("Testing memory usage after sequential insert...\n");
+  
+  for(int i = 0;i < key_num;i++) {
+    t->Insert(i, i);
+  }
+  
+  CheckMemoryUsage(t);
+  
+  if(t->GetMemoryFootprint() <= empty_size) {
+    printf("Memory footprint does not grow after insert\n");
+    
+    exit(1);
+  }
+  
+  printf("Testing memory usage after multi-threaded delete and insert...\n");
+  
+  auto func = [t, key_num](uint64_t thread_id, int thread_num) {
+    // Delete 3/4 of all keys to trigger merges and then insert half back
+    for(int i = static_cast<int>(thread_id); i < key_num; i += thread_num) {
+      if((i % 4) != 0) {
+        t->Delete(i, i);
+      }
+    }
+    
+    for(int i = static_cast<int>(thread_id); i < key_num; i += thread_num) {
+      if((i % 2) != 0) {
+        t->Insert(i, i);
+      }
+    }
+    
+    return;
+  };
+  
+  LaunchParallelTestID(t, 4, func, 4);
+  
+  // Main thread still uses GC ID 0 which has been unregistered 
+  t->AssignGCID(0);
+  
+  CheckMemoryUsage(t);
+  
+  printf("Testing Cleanup()...\n");
+  
+  size_t consolidated_count = t->Cleanup();
+  
+  // All data deltas are consolidated
+  for(NodeID node_id = 1; 
+      node_id < t->next_unused_node_id.load(); 
+      node_id++) {
+    const TreeType::BaseNode *node_p = t->GetNode(node_id);
+    if(node_p == nullptr) {
+      continue;
+    }
+    
+    TreeType::NodeType type = node_p->GetType();
+    if((type == TreeType::NodeType::LeafInsertType) ||
+       (type == TreeType::NodeType::LeafDeleteType) ||
+       (type == TreeType::NodeType::InnerInsertType) ||
+       (type == TreeType::NodeType::InnerDeleteType)) {
+      printf("Node %lu still has data delta after Cleanup()\n", node_id);
+      
+      exit(1);
+    }
+  }
+  
+  printf("    Consolidated %lu nodes\n", consolidated_count);
+  
+  CheckMemoryUsage(t);
+  
+  // Content is not changed
+  for(int i = 0;i < key_num;i++) {
+    auto value_set = t->GetValue(i);
+    bool expected = ((i % 4) == 0) || ((i % 2) != 0);
+    
+    if((value_set.size() == 1UL) != expected) {
+      printf("Wrong value for key %d after Cleanup()\n", i);
+      
+      exit(1);
+    }
+  }
+  
+  printf("Finished testing memory usage\n");
+  
+  return;
+}
+
+/*
+ * NormalizedKeyTest() - Tests order preservation of normalized keys
+ *
+ * Random keys of (int8, int16, int32, int64, double, string) are
+ * compared both as normalized keys and as std::tuple, and the results
+ * must agree. Columns are also decoded back and checked
+ */
+void NormalizedKeyTest(int key_num) {
+  using ColumnTuple = std::tuple<int8_t, int16_t, int32_t, int64_t,
+                                 double, std::string>;
+  using KeyType = NormalizedKey<64>;
+
+  std::mt19937_64 rng{0};
+  std::vector<ColumnTuple> tuple_list{};
+  std::vector<KeyType> key_list{};
+
+  printf("Testing normalized key...\n");
+
+  for(int i = 0;i < key_num;i++) {
+    // Use a narrow value range such that keys frequently have
+    // equal prefixes and later columns are compared
+    int8_t c0 = static_cast<int8_t>(rng() % 4) * 63 - 128;
+    int16_t c1 = static_cast<int16_t>(rng() % 3) * 16383 - 1;
+    int32_t c2 = static_cast<int32_t>(rng() % 3) - 1;
+    int64_t c3 = static_cast<int64_t>(rng() % 3) * 0x3FFFFFFFFFFFFFFFL - \
+                 0x3FFFFFFFFFFFFFFFL;
+    double c4 = (static_cast<double>(rng() % 5) - 2.0) * 1.5;
+
+    // Strings contain '\0' and 0xFF which need escaping
+    std::string c5{};
+    size_t length = rng() % 4;
+    for(size_t j = 0;j < length;j++) {
+      const char alphabet[] = {'\0', '\x01', 'a', '\xFF'};
+      c5.push_back(alphabet[rng() % 4]);
+    }
+
+    KeyType key{};
+    bool ret = key.AppendInteger(c0) && \
+               key.AppendInteger(c1) && \
+               key.AppendInteger(c2) && \
+               key.AppendInteger(c3) && \
+               key.AppendDouble(c4) && \
+               key.AppendString(c5);
+    if(ret == false) {
+      printf("Normalized key does not fit\n");
+
+      exit(1);
+    }
+
+    size_t offset = 0;
+    if((key.GetInteger<int8_t>(&offset) != c0) ||
+       (key.GetInteger<int16_t>(&offset) != c1) ||
+       (key.GetInteger<int32_t>(&offset) != c2) ||
+       (key.GetInteger<int64_t>(&offset) != c3) ||
+       (key.GetDouble(&offset) != c4) ||
+       (key.GetString(&offset) != c5) ||
+       (offset != key.size)) {
+      printf("Normalized key %d could not be decoded\n", i);
+
+      exit(1);
+    }
+
+    tuple_list.push_back(ColumnTuple{c0, c1, c2, c3, c4, c5});
+    key_list.push_back(key);
+  }
+
+  // The string compares unsigned in normalized keys
+  auto tuple_cmp = [](const ColumnTuple &t1, const ColumnTuple &t2) {
+    auto tie_1 = std::tie(std::get<0>(t1), std::get<1>(t1), std::get<2>(t1),
+                          std::get<3>(t1), std::get<4>(t1));
+    auto tie_2 = std::tie(std::get<0>(t2), std::get<1>(t2), std::get<2>(t2),
+                          std::get<3>(t2), std::get<4>(t2));
+    if(tie_1 != tie_2) {
+      return (tie_1 < tie_2) ? -1 : 1;
+    }
+
+    const std::string &s1 = std::get<5>(t1);
+    const std::string &s2 = std::get<5>(t2);
+    size_t length = std::min(s1.size(), s2.size());
+    int ret = memcmp(s1.data(), s2.data(), length);
+    if(ret != 0) {
+      return (ret < 0) ? -1 : 1;
+    } else if(s1.size() != s2.size()) {
+      return (s1.size() < s2.size()) ? -1 : 1;
+    }
+
+    return 0;
+  };
+
+  NormalizedKeyComparator<64> key_cmp{};
+  NormalizedKeyEqualityChecker<64> key_eq{};
+  NormalizedKeyHashFunc<64> key_hash{};
+
+  for(int i = 0;i < key_num;i++) {
+    for(int j = 0;j < 16;j++) {
+      int k = static_cast<int>(rng() % key_num);
+
+      int expected = tuple_cmp(tuple_list[i], tuple_list[k]);
+      bool less = key_cmp(key_list[i], key_list[k]);
+      bool equal = key_eq(key_list[i], key_list[k]);
+
+      if((less != (expected < 0)) || (equal != (expected == 0))) {
+        printf("Normalized key order mismatch for key %d and %d\n", i, k);
+
+        exit(1);
+      }
+
+      if((equal == true) &&
+         (key_hash(key_list[i]) != key_hash(key_list[k]))) {
+        printf("Equal normalized keys have different hash\n");
+
+        exit(1);
+      }
+    }
+  }
+
+  printf("Finished testing normalized key\n");
+
+  return;
+}
+
+/*
+ * OperationStatsTest() - Tests operation statistics returned by GetStats()
+ *
+ * Several threads insert, delete and read disjoint keys, after which the
+ * operation counts must be exact. Deleting the lower half of all keys
+ * should also trigger merges
+ */
+void OperationStatsTest(TreeType *t, int key_num) {
+  const int thread_num = 4;
+
+  printf("Testing operation statistics...\n");
+
+  auto func = [key_num, thread_num](uint64_t thread_id, TreeType *t) {
+    for(int i = (int)thread_id;i < key_num;i += thread_num) {
+      t->Insert(i, i);
+    }
+
+    for(int i = (int)thread_id;i < key_num / 2;i += thread_num) {
+      t->Delete(i, i);
+    }
+
+    for(int i = (int)thread_id;i < key_num;i += thread_num) {
+      t->GetValue(i);
+    }
+
+    return;
+  };
+
+  LaunchParallelTestID(t, thread_num, func, t);
+
+  // Free all garbage such that retired bytes equal freed bytes
+  t->ClearThreadLocalGarbage();
+
+  TreeType::Stats stats = t->GetStats();
+
+  printf("    insert = %lu; delete = %lu; read = %lu; abort = %lu\n",
+         stats.insert_count,
+         stats.delete_count,
+         stats.read_count,
+         stats.traverse_abort_count);
+  printf("    consolidate = %lu; split = %lu; merge = %lu; CAS failure = %lu\n",
+         stats.consolidate_count,
+         stats.split_count,
+         stats.merge_count,
+         stats.GetTotalCASFailureCount());
+  printf("    retired = %lu; freed = %lu\n",
+         stats.retired_size,
+         stats.freed_size);
+
+  if((stats.insert_count != (uint64_t)key_num) ||
+     (stats.delete_count != (uint64_t)(key_num / 2)) ||
+     (stats.read_count != (uint64_t)key_num)) {
+    printf("Operation count mismatch\n");
+
+    exit(1);
+  }
+
+  if((stats.consolidate_count == 0UL) ||
+     (stats.split_count == 0UL) ||
+     (stats.merge_count == 0UL)) {
+    printf("SMO and consolidation are not counted\n");
+
+    exit(1);
+  }
+
+  if((stats.retired_size == 0UL) ||
+     (stats.retired_size != stats.freed_size)) {
+    printf("Retired and freed bytes mismatch\n");
+
+    exit(1);
+  }
+
+  // Counters must survive reallocating thread local data
+  t->UpdateThreadLocal(1);
+  t->AssignGCID(0);
+
+  TreeType::Stats new_stats = t->GetStats();
+  if((new_stats.insert_count != stats.insert_count) ||
+     (new_stats.split_count != stats.split_count)) {
+    printf("Statistics lost after UpdateThreadLocal()\n");
+
+    exit(1);
+  }
+
+  printf("Finished testing operation statistics\n");
+
+  return;
+}
+
+/*
+ * AnalyzeTreeTest() - Tests tree shape statistics returned by AnalyzeTree()
+ */
+void AnalyzeTreeTest(TreeType *t, int key_num) {
+  printf("Testing tree analysis...\n");
+
+  for(int i = 0;i < key_num;i++) {
+    t->Insert(i, i);
+  }
+
+  // Remove every other key such that leaf nodes are not full
+  for(int i = 0;i < key_num;i += 2) {
+    t->Delete(i, i);
+  }
+
+  TreeType::TreeAnalysis analysis = t->AnalyzeTree();
+
+  printf("    height = %d; inner = %lu; leaf = %lu; mapped = %lu\n",
+         analysis.height,
+         analysis.inner_node_count,
+         analysis.leaf_node_count,
+         analysis.mapped_node_count);
+  printf("    average fill = %f; average fanout = %f\n",
+         analysis.GetAverageLeafFill(),
+         analysis.GetAverageFanout());
+  printf("    split = %lu; merge = %lu; abort = %lu; remove = %lu\n",
+         analysis.split_delta_count,
+         analysis.merge_delta_count,
+         analysis.abort_delta_count,
+         analysis.remove_delta_count);
+
+  // Every live key-value pair is on exactly one leaf
+  if(analysis.leaf_item_count != (size_t)(key_num / 2)) {
+    printf("Leaf item count %lu does not match key count\n",
+           analysis.leaf_item_count);
+
+    exit(1);
+  }
+
+  size_t leaf_histogram_sum = 0UL;
+  size_t inner_histogram_sum = 0UL;
+  for(int i = 0;i < TreeType::FILL_HISTOGRAM_BUCKET_COUNT;i++) {
+    leaf_histogram_sum += analysis.leaf_fill_histogram[i];
+    inner_histogram_sum += analysis.inner_fanout_histogram[i];
+  }
+
+  size_t depth_histogram_sum = 0UL;
+  for(size_t count : analysis.delta_depth_histogram) {
+    depth_histogram_sum += count;
+  }
+
+  if((leaf_histogram_sum != analysis.leaf_node_count) ||
+     (inner_histogram_sum != analysis.inner_node_count) ||
+     (depth_histogram_sum != \
+        analysis.leaf_node_count + analysis.inner_node_count)) {
+    printf("Histograms do not sum up to node count\n");
+
+    exit(1);
+  }
+
+  // With at least 2 ^ 16 keys the tree could not be a single leaf, and
+  // all inner nodes except the root have at least 2 children
+  if((analysis.height < 2) ||
+     (analysis.leaf_node_count <= analysis.inner_node_count) ||
+     (analysis.mapped_node_count > analysis.allocated_node_id_count)) {
+    printf("Invalid tree shape\n");
+
+    exit(1);
+  }
+
+  // Sampling every 4th NodeID should see about a quarter of all leaves
+  TreeType::TreeAnalysis sampled = t->AnalyzeTree(4);
+
+  printf("    sampled leaf = %lu\n", sampled.leaf_node_count);
+
+  if((sampled.height != analysis.height) ||
+     (sampled.leaf_node_count * 4 < analysis.leaf_node_count / 2) ||
+     (sampled.leaf_node_count * 4 > analysis.leaf_node_count * 2)) {
+    printf("Sampled analysis is far from the full analysis\n");
+
+    exit(1);
+  }
+
+  printf("Finished testing tree analysis\n");
+
+  return;
+}
+
+/*
+ * NodeIDRecycleTest() - Tests that NodeIDs of removed nodes are reused
+ *
+ * All keys are deleted to cause merges, and after GC has recycled the
+ * removed NodeIDs the keys are inserted back by multiple threads. New
+ * nodes should then mostly take recycled IDs instead of fresh ones
+ */
+void NodeIDRecycleTest(TreeType *t, int key_num) {
+  printf("Testing NodeID recycling...\n");
+
+  for(int i = 0;i < key_num;i++) {
+    t->Insert(i, i);
+  }
+
+  for(int i = 0;i < key_num;i++) {
+    t->Delete(i, i);
+  }
+
+  t->ClearThreadLocalGarbage();
+
+  TreeType::TreeAnalysis before = t->AnalyzeTree();
+
+  printf("    allocated = %lu; mapped = %lu; free = %lu\n",
+         before.allocated_node_id_count,
+         before.mapped_node_count,
+         before.free_node_id_count);
+
+  if(before.free_node_id_count == 0UL) {
+    printf("No NodeID is recycled after deleting all keys\n");
+
+    exit(1);
+  }
+
+  auto func = [t, key_num](uint64_t thread_id, int thread_num) {
+    for(int i = static_cast<int>(thread_id); i < key_num; i += thread_num) {
+      t->Insert(i, i);
+    }
+
+    return;
+  };
+
+  LaunchParallelTestID(t, 4, func, 4);
+
+  // Main thread still uses GC ID 0 which has been unregistered
+  t->AssignGCID(0);
+
+  t->ClearThreadLocalGarbage();
+
+  TreeType::TreeAnalysis after = t->AnalyzeTree();
+
+  printf("    allocated = %lu; mapped = %lu; free = %lu\n",
+         after.allocated_node_id_count,
+         after.mapped_node_count,
+         after.free_node_id_count);
+
+  // If nodes only took fresh IDs then there would be at least one new
+  // ID for each mapped node
+  if(after.allocated_node_id_count - before.allocated_node_id_count >= \
+     after.mapped_node_count) {
+    printf("NodeIDs are not reused\n");
+
+    exit(1);
+  }
+
+  if(after.leaf_item_count != (size_t)key_num) {
+    printf("Leaf item count %lu does not match key count\n",
+           after.leaf_item_count);
+
+    exit(1);
+  }
+
+  for(int i = 0;i < key_num;i++) {
+    auto value_set = t->GetValue(i);
+
+    if(value_set.size() != 1UL) {
+      printf("Wrong value for key %d after NodeID reuse\n", i);
+
+      exit(1);
+    }
+  }
+
+  printf("Finished testing NodeID recycling\n");
+
+  return;
+}
+
+/*
+ * NodeIDRecycleStressTest() - Tests iterators and point lookups while
+ *                             NodeIDs of removed leaves are reused
+ *
+ * The magazine holds only one ID, so every recycled ID goes to the shared
+ * pool right away and could be taken by any thread for a new node. Half
+ * of the threads repeatedly fill and empty their key ranges such that
+ * leaves are split and removed, and the other half scan the tree and look
+ * up keys that are never deleted
+ */
+void NodeIDRecycleStressTest(TreeType *t, int key_num, int thread_num) {
+  printf("Testing NodeID recycling under stress...\n");
+
+  // Every leaf keeps only a few keys after its range is emptied
+  const int stable_interval = 64;
+  const int round_num = 8;
+  const int writer_num = thread_num / 2;
+
+  if(t->SetNodeIDMagazineSize(0) == true) {
+    printf("Empty NodeID magazine is accepted\n");
+
+    exit(1);
+  }
+
+  t->SetNodeIDMagazineSize(1);
+
+  for(int i = 0;i < key_num;i += stable_interval) {
+    t->Insert(i, i);
+  }
+
+  std::atomic<int> finished_writer_count{0};
+  std::atomic<uint64_t> scan_count{0UL};
+
+  auto func = [t, key_num, writer_num, stable_interval, round_num, \
+               &finished_writer_count, &scan_count](uint64_t thread_id,
+                                                    int) {
+    if(thread_id < (uint64_t)writer_num) {
+      int range = key_num / writer_num;
+      int start_key = static_cast<int>(thread_id) * range;
+
+      for(int round = 0;round < round_num;round++) {
+        for(int i = start_key;i < start_key + range;i++) {
+          if(i % stable_interval != 0) {
+            t->Insert(i, i);
+          }
+        }
+
+        for(int i = start_key;i < start_key + range;i++) {
+          if(i % stable_interval != 0) {
+            t->Delete(i, i);
+          }
+        }
+      }
+
+      finished_writer_count.fetch_add(1);
+
+      return;
+    }
+
+    while(finished_writer_count.load() < writer_num) {
+      long next_stable_key = 0;
+      long last_key = -1;
+
+      for(auto it = t->Begin();it.IsEnd() == false;it++) {
+        if((it->first <= last_key) || (it->first != it->second)) {
+          printf("Wrong item (%ld, %ld) after key %ld\n",
+                 it->first,
+                 it->second,
+                 last_key);
+
+          exit(1);
+        }
+
+        // Stable keys are never deleted and must all be visited
+        if(it->first % stable_interval == 0) {
+          if(it->first != next_stable_key) {
+            printf("Stable key %ld is missing\n", next_stable_key);
+
+            exit(1);
+          }
+
+          next_stable_key += stable_interval;
+        }
+
+        last_key = it->first;
+      }
+
+      if(next_stable_key < key_num) {
+        printf("Stable key %ld is missing after scan\n", next_stable_key);
+
+        exit(1);
+      }
+
+      for(int i = 0;i < key_num;i += stable_interval) {
+        auto value_set = t->GetValue(i);
+
+        if(value_set.size() != 1UL) {
+          printf("Wrong value for stable key %d\n", i);
+
+          exit(1);
+        }
+      }
+
+      scan_count.fetch_add(1);
+    }
+
+    return;
+  };
+
+  LaunchParallelTestID(t, thread_num, func, 0);
+
+  // Main thread still uses GC ID 0 which has been unregistered
+  t->AssignGCID(0);
+
+  t->Cleanup();
+
+  TreeType::TreeAnalysis analysis = t->AnalyzeTree();
+
+  printf("    scan = %lu; allocated = %lu; mapped = %lu; free = %lu\n",
+         scan_count.load(),
+         analysis.allocated_node_id_count,
+         analysis.mapped_node_count,
+         analysis.free_node_id_count);
+
+  // Each round splits every range into at least this many leaves, all of
+  // which would take fresh IDs if removed leaves were not reused
+  size_t min_leaf_count = \
+    (size_t)round_num * key_num / LEAF_NODE_SIZE_UPPER_THRESHOLD;
+  if(analysis.allocated_node_id_count >= min_leaf_count) {
+    printf("NodeIDs are not reused\n");
+
+    exit(1);
+  }
+
+  if(analysis.leaf_item_count != (size_t)(key_num / stable_interval)) {
+    printf("Leaf item count %lu does not match stable key count\n",
+           analysis.leaf_item_count);
+
+    exit(1);
+  }
+
+  for(int i = 0;i < key_num;i++) {
+    size_t expected_size = (i % stable_interval == 0) ? 1UL : 0UL;
+
+    if(t->GetValue(i).size() != expected_size) {
+      printf("Wrong value for key %d after NodeID reuse\n", i);
+
+      exit(1);
+    }
+  }
+
+  printf("Finished testing NodeID recycling under stress\n");
+
+  return;
+}
+
+/*
+ * RemovalHelpTest() - Tests that a removal posted on a blocked parent is
+ *                     finished by another thread
+ *
+ * The main thread posts an abort node on the root describing the removal
+ * of a leaf, just like StructuralModification() does, and then stalls
+ * before calling FinishRemoval(). A delete of a key in that leaf on another
+ * thread must then observe the abort node, install the remove delta and
+ * unblock the root, and then merge the leaf into its left sibling
+ */
+void RemovalHelpTest(TreeType *t, int key_num) {
+  printf("Testing removal help along...\n");
+
+  for(int i = 0;i < key_num;i++) {
+    t->Insert(i, i);
+  }
+
+  t->Cleanup();
+
+  NodeID parent_node_id = t->root_id.load();
+  const TreeType::BaseNode *parent_node_p = t->GetNode(parent_node_id);
+
+  if((parent_node_p->GetType() != TreeType::NodeType::InnerType) ||
+     (parent_node_p->GetItemCount() < 3)) {
+    printf("Root is not a consolidated inner node with enough children\n");
+
+    exit(1);
+  }
+
+  // The leftmost child could not be removed
+  const TreeType::KeyNodeIDPair &item = \
+    static_cast<const TreeType::InnerNode *>(parent_node_p)->At(1);
+  long removed_key = item.first;
+  NodeID node_id = item.second;
+  const TreeType::BaseNode *node_p = t->GetNode(node_id);
+
+  if(node_p->GetType() != TreeType::NodeType::LeafType) {
+    printf("Child of the root is not a consolidated leaf node\n");
+
+    exit(1);
+  }
+
+  const TreeType::LeafRemoveNode *remove_node_p = \
+    new TreeType::LeafRemoveNode{node_id, node_p};
+  t->GetCurrentMemoryCounter()->delta_size += sizeof(TreeType::LeafRemoveNode);
+
+  TreeType::InnerAbortNode *abort_node_p = \
+    new TreeType::InnerAbortNode{parent_node_p,
+                                 node_id,
+                                 node_p,
+                                 remove_node_p};
+  t->GetCurrentMemoryCounter()->delta_size += sizeof(TreeType::InnerAbortNode);
+
+  if(t->InstallNodeToReplace(parent_node_id,
+                             abort_node_p,
+                             parent_node_p) == false) {
+    printf("Could not post abort node on the root\n");
+
+    exit(1);
+  }
+
+  TreeType::Stats before = t->GetStats();
+
+  // The main thread never calls FinishRemoval(), so the delete could only
+  // proceed if it finishes the removal itself
+  auto func = [removed_key](uint64_t thread_id, TreeType *t) {
+    (void)thread_id;
+
+    t->Delete(removed_key, removed_key);
+
+    return;
+  };
+
+  LaunchParallelTestID(t, 1, func, t);
+
+  // Main thread still uses GC ID 0 which has been unregistered
+  t->AssignGCID(0);
+
+  TreeType::Stats after = t->GetStats();
+
+  printf("    removal help = %lu; merge = %lu; claimed = %d\n",
+         after.removal_help_count - before.removal_help_count,
+         after.merge_count - before.merge_count,
+         (int)abort_node_p->removal_claimed.load());
+
+  if((after.removal_help_count == before.removal_help_count) ||
+     (after.merge_count == before.merge_count) ||
+     (abort_node_p->removal_claimed.load() == false) ||
+     (t->GetNode(parent_node_id) == abort_node_p)) {
+    printf("Removal on the blocked parent is not finished by the helper\n");
+
+    exit(1);
+  }
+
+  for(int i = 0;i < key_num;i++) {
+    auto value_set = t->GetValue(i);
+
+    if(value_set.size() != ((i == removed_key) ? 0UL : 1UL)) {
+      printf("Wrong value for key %d after helped removal\n", i);
+
+      exit(1);
+    }
+  }
+
+  printf("Finished testing removal help along\n");
+
+  return;
+}
+
+/*
+ * DeferredMergeTest() - Tests deferred merge of underfull leaves
+ *
+ * Most keys are deleted with merges deferred, and no leaf should be merged
+ * until Cleanup() is called. Half of the leaves are refilled before that,
+ * which should be counted as avoided merges. Keys are deleted by two threads
+ * over disjoint halves, and Cleanup() on the main thread should also merge
+ * leaves deferred by the other thread. At last leaves are emptied again and
+ * writers should merge them once the GC thread has advanced the epoch
+ */
+void DeferredMergeTest(TreeType *t, int key_num) {
+  printf("Testing deferred merge...\n");
+
+  // A merge threshold that lets both halves of a split be merged again
+  // should be rejected
+  if(t->SetMergeThreshold(LEAF_NODE_SIZE_UPPER_THRESHOLD / 2,
+                          INNER_NODE_SIZE_LOWER_THRESHOLD) == true) {
+    printf("Merge threshold above half of split threshold is accepted\n");
+
+    exit(1);
+  }
+
+  t->SetDeferLeafMerge(true);
+
+  // Writers do not process deferred merges until the last part
+  t->SetDeferredMergeInterval(0);
+
+  for(int i = 0;i < key_num;i++) {
+    t->Insert(i, i);
+  }
+
+  TreeType::Stats before = t->GetStats();
+
+  // Leave 1/8 of keys such that almost all leaves become underfull
+  auto func = [t, key_num](uint64_t thread_id, int thread_num) {
+    int start_key = key_num / thread_num * static_cast<int>(thread_id);
+    int end_key = key_num / thread_num * static_cast<int>(thread_id + 1);
+
+    for(int i = start_key;i < end_key;i++) {
+      if((i % 8) != 0) {
+        t->Delete(i, i);
+      }
+    }
+
+    return;
+  };
+
+  LaunchParallelTestID(t, 2, func, 2);
+
+  // Main thread still uses GC ID 0 which has been unregistered
+  t->AssignGCID(0);
+
+  TreeType::Stats deferred = t->GetStats();
+
+  printf("    deferred = %lu; merge = %lu\n",
+         deferred.deferred_merge_count - before.deferred_merge_count,
+         deferred.merge_count - before.merge_count);
+
+  if((deferred.merge_count != before.merge_count) ||
+     (deferred.deferred_merge_count == before.deferred_merge_count)) {
+    printf("Leaf merges are not deferred\n");
+
+    exit(1);
+  }
+
+  // Refill leaves of the lower half
+  for(int i = 0;i < key_num / 2;i++) {
+    if((i % 8) != 0) {
+      t->Insert(i, i);
+    }
+  }
+
+  size_t leaf_count = t->AnalyzeTree().leaf_node_count;
+
+  t->Cleanup();
+
+  TreeType::Stats merged = t->GetStats();
+  size_t merged_leaf_count = t->AnalyzeTree().leaf_node_count;
+
+  printf("    avoided = %lu; merge = %lu; leaf = %lu -> %lu\n",
+         merged.avoided_merge_count - deferred.avoided_merge_count,
+         merged.merge_count - deferred.merge_count,
+         leaf_count,
+         merged_leaf_count);
+
+  if((merged.merge_count == deferred.merge_count) ||
+     (merged.avoided_merge_count == deferred.avoided_merge_count) ||
+     (merged_leaf_count >= leaf_count)) {
+    printf("Deferred merges are not processed\n");
+
+    exit(1);
+  }
+
+  // Nothing should be left in the queue of the thread deleting the
+  // upper half, whose leaves are not refilled
+  t->AssignGCID(1);
+  size_t remaining_count = t->MergeDeferredNodes();
+  t->AssignGCID(0);
+
+  if(remaining_count != 0UL) {
+    printf("Deferred merges of other threads are not processed\n");
+
+    exit(1);
+  }
+
+  for(int i = 0;i < key_num;i++) {
+    auto value_set = t->GetValue(i);
+    bool expected = ((i % 8) == 0) || (i < key_num / 2);
+
+    if((value_set.size() == 1UL) != expected) {
+      printf("Wrong value for key %d after deferred merge\n", i);
+
+      exit(1);
+    }
+  }
+
+  t->SetDeferredMergeInterval(1);
+
+  for(int i = 0;i < key_num / 2;i++) {
+    if((i % 8) != 0) {
+      t->Delete(i, i);
+    }
+  }
+
+  // Let the GC thread advance the epoch, after which the next write
+  // processes leaves queued by the deletes above
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  t->Insert(key_num, key_num);
+
+  TreeType::Stats epoch_merged = t->GetStats();
+
+  printf("    merge on epoch advance = %lu\n",
+         epoch_merged.merge_count - merged.merge_count);
+
+  if(epoch_merged.merge_count == merged.merge_count) {
+    printf("Deferred merges are not processed by writers\n");
+
+    exit(1);
+  }
+
+  printf("Finished testing deferred merge\n");
+
+  return;
+}
+
+/*
+ * AppendSplitTest() - Tests skewed split of leaves under sequential insert
+ *
+ * Keys are inserted in increasing order, so almost all leaf splits should
+ * be append splits, and leaves should be filled above the 50% of a median
+ * split
+ */
+void AppendSplitTest(TreeType *t, int key_num) {
+  printf("Testing append split...\n");
+
+  for(int i = 0;i < key_num;i++) {
+    t->Insert(i, i);
+  }
+
+  TreeType::Stats stats = t->GetStats();
+  TreeType::TreeAnalysis analysis = t->AnalyzeTree();
+
+  printf("    split = %lu; append split = %lu; leaf = %lu; fill = %f\n",
+         stats.split_count,
+         stats.append_split_count,
+         analysis.leaf_node_count,
+         analysis.GetAverageLeafFill());
+
+  if((stats.append_split_count == 0UL) ||
+     (analysis.GetAverageLeafFill() < 0.65)) {
+    printf("Leaves are not split towards the right\n");
+
+    exit(1);
+  }
+
+  for(int i = 0;i < key_num;i++) {
+    auto value_set = t->GetValue(i);
+
+    if(value_set.size() != 1UL) {
+      printf("Wrong value for key %d after append split\n", i);
+
+      exit(1);
+    }
+  }
+
+  printf("Finished testing append split\n");
+
+  return;
+}
+
+/*
+ * ContentionSplitTest() - Tests that hot leaves are split below the size
+ *                         threshold
+ *
+ * Contention counters of all leaves are raised as if CAS had failed on
+ * them. If a few epochs pass before the next update then the counters
+ * should have decayed and nothing is split. Otherwise the next update on
+ * each leaf should split it
+ */
+void ContentionSplitTest(TreeType *t, int key_num) {
+  printf("Testing contention split...\n");
+
+  for(int i = 0;i < key_num;i++) {
+    t->Insert(i, i);
+  }
+
+  t->Cleanup();
+
+  size_t leaf_count = t->AnalyzeTree().leaf_node_count;
+  TreeType::Stats before = t->GetStats();
+
+  auto raise_func = [t]() {
+    for(NodeID node_id = 1;
+        node_id < t->next_unused_node_id.load();
+        node_id++) {
+      for(int i = 0;i < LEAF_CONTENTION_SPLIT_THRESHOLD;i++) {
+        t->RecordLeafContention(node_id);
+      }
+    }
+  };
+
+  raise_func();
+
+  // Counters are halved by each epoch the GC thread starts, and also by
+  // the one started by Cleanup()
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  t->Cleanup();
+
+  // Deleting values that do not exist visits leaves without changing
+  // their sizes, so only contention could split them
+  for(int i = 0;i < key_num;i++) {
+    t->Delete(i, i + 1);
+  }
+
+  TreeType::Stats decayed = t->GetStats();
+
+  if((decayed.contention_split_count != before.contention_split_count) ||
+     (t->AnalyzeTree().leaf_node_count != leaf_count)) {
+    printf("Leaves are split on old contention\n");
+
+    exit(1);
+  }
+
+  // Visit every leaf once more, raising counters again before each batch
+  // such that they do not decay before the leaves are visited
+  for(int i = 0;i < key_num;i++) {
+    if((i % 1024) == 0) {
+      raise_func();
+    }
+
+    t->Delete(i, i + 1);
+  }
+
+  TreeType::Stats after = t->GetStats();
+  size_t split_leaf_count = t->AnalyzeTree().leaf_node_count;
+
+  printf("    contention split = %lu; leaf = %lu -> %lu\n",
+         after.contention_split_count - before.contention_split_count,
+         leaf_count,
+         split_leaf_count);
+
+  if((after.contention_split_count == before.contention_split_count) ||
+     (split_leaf_count <= leaf_count)) {
+    printf("Hot leaves are not split\n");
+
+    exit(1);
+  }
+
+  for(int i = 0;i < key_num;i++) {
+    auto value_set = t->GetValue(i);
+
+    if(value_set.size() != 1UL) {
+      printf("Wrong value for key %d after contention split\n", i);
+
+      exit(1);
+    }
+  }
+
+  printf("Finished testing contention split\n");
+
+  return;
+}
+
+/*
+ * BackoffTest() - Tests bounded exponential backoff and its counters
+ *
+ * The first part checks the spin sequence of one operation, and the
+ * second part runs contended updates to check that pauses are only taken
+ * after leaf data CAS failures
+ */
+void BackoffTest(TreeType *t, int key_num, int thread_num) {
+  printf("Testing backoff...\n");
+
+  TreeType::Stats counter{};
+  TreeType::Backoff backoff{16};
+
+  // Spins 4, 8 and 16 times and then yields
+  for(int i = 0;i < 5;i++) {
+    backoff.Wait(&counter);
+  }
+
+  if((counter.backoff_count != 5UL) ||
+     (counter.backoff_spin_count != 28UL) ||
+     (counter.backoff_yield_count != 2UL)) {
+    printf("Wrong backoff counters: %lu %lu %lu\n",
+           counter.backoff_count,
+           counter.backoff_spin_count,
+           counter.backoff_yield_count);
+
+    exit(1);
+  }
+
+  TreeType::Backoff disabled_backoff{0};
+  disabled_backoff.Wait(&counter);
+
+  if(counter.backoff_count != 5UL) {
+    printf("Backoff is not disabled\n");
+
+    exit(1);
+  }
+
+  // All threads toggle keys in a small range which fits in a few leaves
+  auto func = [key_num](uint64_t thread_id, TreeType *t) {
+    for(int i = 0;i < key_num;i++) {
+      long key = i % 64;
+
+      if(t->Insert(key, (long)thread_id) == false) {
+        t->Delete(key, (long)thread_id);
+      }
+    }
+
+    return;
+  };
+
+  LaunchParallelTestID(t, thread_num, func, t);
+
+  TreeType::Stats stats = t->GetStats();
+
+  printf("    leaf CAS failure = %lu; backoff = %lu; spin = %lu; yield = %lu\n",
+         stats.GetCASFailureCount(TreeType::CASSite::LeafData),
+         stats.backoff_count,
+         stats.backoff_spin_count,
+         stats.backoff_yield_count);
+
+  if(stats.backoff_count != \
+     stats.GetCASFailureCount(TreeType::CASSite::LeafData)) {
+    printf("Backoff is not taken once per leaf CAS failure\n");
+
+    exit(1);
+  }
+
+  printf("Finished testing backoff\n");
+
+  return;
+}
+
+/*
+ * LeafRetryTest() - Tests restarting traversals on a known leaf
+ *
+ * Restarting on the leaf of the key should not go through the root, while
+ * restarting on a leaf of another range should fall back to the root. In
+ * both cases the result must be the same as a full traversal. A leaf that
+ * should be split is also retried from the root, such that it is split
+ */
+void LeafRetryTest(TreeType *t, int key_num) {
+  printf("Testing leaf retry...\n");
+
+  for(int i = 0;i < key_num;i++) {
+    t->Insert(i, i);
+  }
+
+  auto *epoch_node_p = t->epoch_manager.JoinEpoch();
+
+  TreeType::Stats before = t->GetStats();
+
+  for(int i = 0;i < key_num;i++) {
+    long key = i;
+    long value = i;
+    std::pair<int, bool> index_pair;
+
+    NodeID node_id;
+    {
+      TreeType::Context context{key};
+      t->Traverse(&context, &value, &index_pair);
+      node_id = t->GetLatestNodeSnapshot(&context)->node_id;
+    }
+
+    // Same leaf
+    TreeType::Context context{key};
+    auto item_p = t->TraverseFromLeaf(&context, node_id, &value, &index_pair);
+
+    if((item_p == nullptr) ||
+       (t->GetLatestNodeSnapshot(&context)->node_id != node_id)) {
+      printf("Leaf retry failed on key %d\n", i);
+
+      exit(1);
+    }
+
+    // The first leaf does not contain keys in the right half
+    if(i >= key_num / 2) {
+      TreeType::Context context2{key};
+      item_p = t->TraverseFromLeaf(&context2,
+                                   FIRST_LEAF_NODE_ID,
+                                   &value,
+                                   &index_pair);
+
+      if((item_p == nullptr) ||
+         (t->GetLatestNodeSnapshot(&context2)->node_id != node_id)) {
+        printf("Root retry failed on key %d\n", i);
+
+        exit(1);
+      }
+    }
+  }
+
+  t->epoch_manager.LeaveEpoch(epoch_node_p);
+
+  TreeType::Stats after = t->GetStats();
+  uint64_t leaf_retry_count = after.leaf_retry_count - before.leaf_retry_count;
+  uint64_t root_retry_count = after.root_retry_count - before.root_retry_count;
+
+  printf("    leaf retry = %lu; root retry = %lu\n",
+         leaf_retry_count,
+         root_retry_count);
+
+  // Chains that are due for consolidation are retried from the root
+  if((leaf_retry_count == 0UL) ||
+     (leaf_retry_count + root_retry_count != \
+      (uint64_t)(key_num + key_num / 2)) ||
+     (root_retry_count < (uint64_t)(key_num / 2))) {
+    printf("Wrong number of leaf and root retries\n");
+
+    exit(1);
+  }
+
+  // Make the leaf of a key hot after consolidating it, and retry an
+  // insert on it as if CAS had failed
+  t->Cleanup();
+
+  long key = key_num / 2;
+  NodeID node_id;
+
+  epoch_node_p = t->epoch_manager.JoinEpoch();
+  {
+    TreeType::Context context{key};
+    t->Traverse(&context, nullptr, nullptr);
+    node_id = t->GetLatestNodeSnapshot(&context)->node_id;
+  }
+  t->epoch_manager.LeaveEpoch(epoch_node_p);
+
+  for(int i = 0;i < 4 * LEAF_CONTENTION_SPLIT_THRESHOLD;i++) {
+    t->RecordLeafContention(node_id);
+  }
+
+  TreeType::Stats hot_before = t->GetStats();
+  t->InsertFromLeaf(key, key + 1, node_id);
+  TreeType::Stats hot_after = t->GetStats();
+
+  if((hot_after.root_retry_count == hot_before.root_retry_count) ||
+     (hot_after.contention_split_count == hot_before.contention_split_count) ||
+     (t->GetValue(key).size() != 2UL)) {
+    printf("Hot leaf is not split on retry\n");
+
+    exit(1);
+  }
+
+  printf("Finished testing leaf retry\n");
+
+  return;
+}
+
+/*
+ * AsyncOperationTest() - Tests interleaved asynchronous operations
+ *
+ * Keys are inserted, read and half of them deleted through AsyncExecutor,
+ * and the result is checked with synchronous reads
+ */
+void AsyncOperationTest(TreeType *t, int key_num) {
+  printf("Testing async operations...\n");
+
+  TreeType::AsyncExecutor executor{t, 32};
+
+  // Inserts each key twice; the second insert must fail
+  int next_index = 0;
+  int insert_fail_count = 0;
+  executor.Run([t, &next_index, key_num](TreeType::AsyncOperation *op_p) {
+                 if(next_index == key_num * 2) {
+                   return false;
+                 }
+
+                 long key = next_index % key_num;
+                 next_index++;
+                 op_p->StartInsert(t, key, key);
+
+                 return true;
+               },
+               [&insert_fail_count](const TreeType::AsyncOperation &op) {
+                 assert(op.GetType() == TreeType::AsyncOpType::Insert);
+
+                 if(op.GetResult() == false) {
+                   insert_fail_count++;
+                 }
+               });
+
+  if(insert_fail_count != key_num) {
+    printf("Wrong number of failed async inserts: %d\n", insert_fail_count);
+
+    exit(1);
+  }
+
+  // Deletes even keys
+  next_index = 0;
+  size_t finished_count = \
+    executor.Run([t, &next_index, key_num](TreeType::AsyncOperation *op_p) {
+                   if(next_index >= key_num) {
+                     return false;
+                   }
+
+                   long key = next_index;
+                   next_index += 2;
+                   op_p->StartDelete(t, key, key);
+
+                   return true;
+                 },
+                 [](const TreeType::AsyncOperation &op) {
+                   if(op.GetResult() == false) {
+                     printf("Async delete failed on key %ld\n", op.GetKey());
+
+                     exit(1);
+                   }
+                 });
+
+  if(finished_count != (size_t)(key_num / 2)) {
+    printf("Wrong number of finished async deletes: %lu\n", finished_count);
+
+    exit(1);
+  }
+
+  // Reads all keys and some keys that were never inserted
+  next_index = 0;
+  executor.Run([t, &next_index, key_num](TreeType::AsyncOperation *op_p) {
+                 if(next_index == key_num + 100) {
+                   return false;
+                 }
+
+                 op_p->StartRead(t, (long)next_index);
+                 next_index++;
+
+                 return true;
+               },
+               [key_num](const TreeType::AsyncOperation &op) {
+                 long key = op.GetKey();
+                 bool expected = (key < key_num) && ((key % 2) == 1);
+
+                 if((op.GetResult() != expected) ||
+                    ((expected == true) &&
+                     ((op.GetValueList().size() != 1UL) ||
+                      (op.GetValueList()[0] != key)))) {
+                   printf("Wrong async read result on key %ld\n", key);
+
+                   exit(1);
+                 }
+               });
+
+  for(int i = 0;i < key_num;i++) {
+    size_t expected = ((i % 2) == 1) ? 1UL : 0UL;
+
+    if(t->GetValue(i).size() != expected) {
+      printf("Wrong sync read result on key %d\n", i);
+
+      exit(1);
+    }
+  }
+
+  printf("Finished testing async operations\n");
+
+  return;
+}
+
+/*
+ * AsyncConcurrentWriteTest() - Tests async reads while another thread
+ *                              writes to the same leaves
+ *
+ * Even keys are read through AsyncExecutor on one thread, while the other
+ * thread keeps inserting and deleting odd keys, which splits, merges and
+ * consolidates the leaves being read and frees the old nodes. Operations
+ * in flight must keep the epoch of the reading thread from advancing
+ */
+void AsyncConcurrentWriteTest(TreeType *t, int key_num) {
+  printf("Testing async operations with a concurrent writer...\n");
+
+  for(int i = 0;i < key_num;i += 2) {
+    t->Insert(i, i);
+  }
+
+  auto func = [t, key_num](uint64_t thread_id, int round_num) {
+    if(thread_id == 1) {
+      for(int round = 0;round < round_num;round++) {
+        for(int i = 1;i < key_num;i += 2) {
+          t->Insert(i, i);
+        }
+
+        for(int i = 1;i < key_num;i += 2) {
+          t->Delete(i, i);
+        }
+      }
+
+      return;
+    }
+
+    TreeType::AsyncExecutor executor{t, 32};
+
+    for(int round = 0;round < round_num;round++) {
+      int next_index = 0;
+      executor.Run([t, &next_index, key_num](TreeType::AsyncOperation *op_p) {
+                     if(next_index >= key_num) {
+                       return false;
+                     }
+
+                     op_p->StartRead(t, (long)next_index);
+                     next_index += 2;
+
+                     return true;
+                   },
+                   [](const TreeType::AsyncOperation &op) {
+                     if((op.GetResult() == false) ||
+                        (op.GetValueList().size() != 1UL) ||
+                        (op.GetValueList()[0] != op.GetKey())) {
+                       printf("Wrong async read result on key %ld\n",
+                              op.GetKey());
+
+                       exit(1);
+                     }
+                   });
+    }
+
+    return;
+  };
+
+  LaunchParallelTestID(t, 2, func, 8);
+
+  // Main thread still uses GC ID 0 which has been unregistered
+  t->AssignGCID(0);
+
+  for(int i = 0;i < key_num;i++) {
+    size_t expected = ((i % 2) == 0) ? 1UL : 0UL;
+
+    if(t->GetValue(i).size() != expected) {
+      printf("Wrong sync read result on key %d\n", i);
+
+      exit(1);
+    }
+  }
+
+  printf("Finished testing async operations with a concurrent writer\n");
+
+  return;
+}
+
+/*
+ * AsyncEpochTest() - Tests that garbage is freed while AsyncExecutor::Run()
+ *                    keeps all slots busy
+ *
+ * Keys are inserted and deleted through the executor for about a second,
+ * and consolidation of leaves produces garbage on this thread. Since there
+ * is always some operation in flight, the pinned epoch is only refreshed by
+ * the executor, and freed bytes should grow before Run() returns
+ */
+void AsyncEpochTest(TreeType *t, int key_num) {
+  printf("Testing garbage collection during async operations...\n");
+
+  // Frees all garbage so far, such that anything freed later is garbage
+  // of the async operations
+  t->Cleanup();
+
+  TreeType::AsyncExecutor executor{t, 32};
+
+  auto start_time = std::chrono::steady_clock::now();
+  size_t start_freed_size = t->GetStats().freed_size;
+  size_t run_freed_size = start_freed_size;
+
+  long next_index = 0;
+  size_t finished_count = \
+    executor.Run([t, &next_index, key_num, start_time](
+                   TreeType::AsyncOperation *op_p) {
+                   if((std::chrono::steady_clock::now() - start_time) > \
+                      std::chrono::milliseconds(1000)) {
+                     return false;
+                   }
+
+                   long key = next_index % key_num;
+
+                   // Even passes over the key range insert, odd ones delete
+                   if(((next_index / key_num) % 2) == 0) {
+                     op_p->StartInsert(t, key, key);
+                   } else {
+                     op_p->StartDelete(t, key, key);
+                   }
+
+                   next_index++;
+
+                   return true;
+                 },
+                 [t, &run_freed_size](const TreeType::AsyncOperation &op) {
+                   if(op.GetResult() == false) {
+                     printf("Async write failed on key %ld\n", op.GetKey());
+
+                     exit(1);
+                   }
+
+                   if((op.GetKey() % 1024) == 0) {
+                     run_freed_size = t->GetStats().freed_size;
+                   }
+                 });
+
+  printf("    operation = %lu; freed during run = %lu\n",
+         finished_count,
+         run_freed_size - start_freed_size);
+
+  if(run_freed_size == start_freed_size) {
+    printf("Garbage is not freed while async operations are running\n");
+
+    exit(1);
+  }
+
+  printf("Finished testing garbage collection during async operations\n");
+
+  return;
+}
+
+/*
+ * PartitionedTreeTest() - Tests routing and online splits of partitions
+ *
+ * The forest starts with a few small partitions on the left and a large
+ * key range on the right. With a small split size the right most partition
+ * is split by the rebalance thread while threads are inserting, and all
+ * keys should still be found through point reads, scans and iterators
+ * afterwards. At last partitions are split while an iterator is on them,
+ * and the iterator should still see every key once
+ */
+void PartitionedTreeTest(int key_num, int thread_num) {
+  using ForestType = PartitionedBwTree<long,
+                                       long,
+                                       KeyComparator,
+                                       KeyEqualityChecker>;
+
+  ForestType *forest_p = new ForestType{{1000L, 2000L, 3000L},
+                                        true,
+                                        KeyComparator{1},
+                                        KeyEqualityChecker{1}};
+
+  // Split as soon as one partition is larger than the mean. Every tree
+  // has a mapping table of a few megabytes, which is part of its
+  // footprint, so a larger factor is only reached while there is a lot
+  // of garbage
+  forest_p->SetRebalancePolicy(1, 0, 1024);
+
+  forest_p->UpdateThreadLocal(thread_num);
+
+  auto func = [key_num, thread_num](uint64_t thread_id,
+                                    ForestType *forest_p) {
+    forest_p->AssignGCID(thread_id);
+
+    for(long key = thread_id;key < key_num;key += thread_num) {
+      if(forest_p->Insert(key, key) == false) {
+        printf("Partitioned insert failed on key %ld\n", key);
+
+        exit(1);
+      }
+    }
+
+    forest_p->UnregisterThread(thread_id);
+
+    return;
+  };
+
+  LaunchParallelTestID(nullptr, thread_num, func, forest_p);
+
+  forest_p->UpdateThreadLocal(1);
+  forest_p->AssignGCID(0);
+
+  // Writers only ask for splits, which the rebalance thread might not
+  // have done yet
+  for(int i = 0;(i < 200) && (forest_p->GetRebalanceCount() == 0UL);i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  printf("Partition count = %lu; rebalance count = %lu\n",
+         forest_p->GetPartitionCount(),
+         forest_p->GetRebalanceCount());
+
+  if(forest_p->GetRebalanceCount() == 0UL) {
+    printf("Partitions were not split\n");
+
+    exit(1);
+  }
+
+  // Splits are also allowed without concurrent writers
+  while(forest_p->Rebalance() == true);
+
+  for(long key = 0;key < key_num;key++) {
+    std::vector<long> value_list{};
+    forest_p->GetValue(key, value_list);
+
+    if((value_list.size() != 1UL) || (value_list[0] != key)) {
+      printf("Wrong partitioned read result on key %ld\n", key);
+
+      exit(1);
+    }
+  }
+
+  // Deletes odd keys
+  for(long key = 1;key < key_num;key += 2) {
+    if(forest_p->Delete(key, key) == false) {
+      printf("Partitioned delete failed on key %ld\n", key);
+
+      exit(1);
+    }
+  }
+
+  long expected_key = 100;
+  size_t scan_count = \
+    forest_p->ScanRange(100L,
+                        key_num - 100L,
+                        true,
+                        false,
+                        [&expected_key](long key, long value) {
+                          if((key != expected_key) || (value != key)) {
+                            printf("Wrong partitioned scan key %ld\n", key);
+
+                            exit(1);
+                          }
+
+                          expected_key += 2;
+
+                          return true;
+                        });
+
+  if((scan_count != (size_t)(key_num - 200) / 2) ||
+     (expected_key != key_num - 100)) {
+    printf("Wrong partitioned scan count %lu\n", scan_count);
+
+    exit(1);
+  }
+
+  expected_key = 0;
+  for(auto it = forest_p->Begin();it.IsEnd() == false;++it) {
+    if(it->first != expected_key) {
+      printf("Wrong partitioned iterator key %ld\n", it->first);
+
+      exit(1);
+    }
+
+    expected_key += 2;
+  }
+
+  if(expected_key != key_num) {
+    printf("Wrong partitioned iterator count\n");
+
+    exit(1);
+  }
+
+  auto it = forest_p->Begin(key_num / 2 + 1);
+  if((it.IsEnd() == true) || (it->first != key_num / 2 + 2)) {
+    printf("Wrong partitioned iterator start key\n");
+
+    exit(1);
+  }
+
+  delete forest_p;
+
+  // A single partition without automatic rebalancing, which is split on
+  // every Rebalance() call
+  forest_p = new ForestType{{},
+                            true,
+                            KeyComparator{1},
+                            KeyEqualityChecker{1}};
+  forest_p->SetRebalancePolicy(0, 0, 0);
+
+  for(long key = 0;key < key_num;key++) {
+    forest_p->Insert(key, key);
+  }
+
+  // The first split moves the upper half out of the partition being
+  // iterated, and the second one splits one of the halves again
+  expected_key = 0;
+  for(auto it = forest_p->Begin();it.IsEnd() == false;++it) {
+    if(it->first != expected_key) {
+      printf("Wrong partitioned iterator key %ld during split\n", it->first);
+
+      exit(1);
+    }
+
+    if((expected_key == 10) || (expected_key == key_num * 3 / 4)) {
+      forest_p->Rebalance();
+    }
+
+    expected_key++;
+  }
+
+  if((expected_key != key_num) || (forest_p->GetRebalanceCount() != 2UL)) {
+    printf("Wrong partitioned iterator count %ld during split\n",
+           expected_key);
+
+    exit(1);
+  }
+
+  delete forest_p;
+
+  printf("Finished testing partitioned tree\n");
+
+  return;
+}
+
+/*
+ * FreezeTest() - Tests reads on a frozen tree and thawing on writes
+ *
+ * Even keys have one value and odd keys have two, and one key has enough
+ * values to span several packed leaves, such that values of a key are
+ * found across leaf boundaries
+ */
+void FreezeTest(TreeType *t, int key_num) {
+  const long wide_key = key_num / 2;
+  const int wide_value_num = 100;
+
+  for(long key = 0;key < key_num;key++) {
+    t->Insert(key, key);
+
+    if((key % 2) == 1) {
+      t->Insert(key, key + key_num);
+    }
+  }
+
+  for(int i = 1;i < wide_value_num;i++) {
+    t->Insert(wide_key, wide_key + (long)i * key_num * 2);
+  }
+
+  size_t expected_item_count = key_num + key_num / 2 + wide_value_num - 1;
+
+  auto verify_func = [t, key_num, wide_key, wide_value_num]() {
+    for(long key = -10;key < key_num + 10;key++) {
+      size_t expected = 0;
+      if((key >= 0) && (key < key_num)) {
+        expected = ((key % 2) == 1) ? 2 : 1;
+      }
+
+      if(key == wide_key) {
+        expected = wide_value_num;
+      }
+
+      auto value_set = t->GetValue(key);
+      if((value_set.size() != expected) ||
+         ((expected != 0) && (value_set.count(key) != 1UL))) {
+        printf("Wrong frozen read result on key %ld\n", key);
+
+        exit(1);
+      }
+    }
+
+    // Exclusive start on the wide key skips all its values
+    long expected_key = wide_key + 1;
+    size_t scan_count = \
+      t->ScanRange(wide_key,
+                   wide_key + 10,
+                   false,
+                   true,
+                   [&expected_key](long key, long) {
+                     if(key < expected_key) {
+                       printf("Wrong frozen scan key %ld\n", key);
+
+                       exit(1);
+                     }
+
+                     expected_key = key;
+
+                     return true;
+                   });
+
+    // Keys wide_key + 1 to wide_key + 10, half of which are odd
+    if(scan_count != 15UL) {
+      printf("Wrong frozen scan count %lu\n", scan_count);
+
+      exit(1);
+    }
+
+    scan_count = t->ScanRangeLimit(key_num - 3,
+                                   100,
+                                   [](long, long) { return true; });
+    if(scan_count != 5UL) {
+      printf("Wrong frozen limited scan count %lu\n", scan_count);
+
+      exit(1);
+    }
+
+    // Reverse scans stop before all values of the exclusive low key
+    expected_key = wide_key + 10;
+    scan_count = \
+      t->ReverseScanRange(wide_key,
+                          wide_key + 10,
+                          false,
+                          true,
+                          [&expected_key, wide_key](long key, long) {
+                            if((key > expected_key) || (key <= wide_key)) {
+                              printf("Wrong frozen reverse scan key %ld\n",
+                                     key);
+
+                              exit(1);
+                            }
+
+                            expected_key = key;
+
+                            return true;
+                          });
+
+    if(scan_count != 15UL) {
+      printf("Wrong frozen reverse scan count %lu\n", scan_count);
+
+      exit(1);
+    }
+
+    // Keys 2, 1 and 0, where key 1 has two values
+    scan_count = t->ReverseScanRangeLimit(2L,
+                                          100,
+                                          [](long, long) { return true; });
+    if(scan_count != 4UL) {
+      printf("Wrong frozen limited reverse scan count %lu\n", scan_count);
+
+      exit(1);
+    }
+  };
+
+  verify_func();
+
+  size_t item_count = t->Freeze();
+  if((item_count != expected_item_count) || (t->IsFrozen() == false)) {
+    printf("Wrong frozen item count %lu\n", item_count);
+
+    exit(1);
+  }
+
+  auto before = t->GetStats();
+  verify_func();
+  auto after = t->GetStats();
+
+  printf("Frozen layout: %lu items in %lu leaves; memory = %lu\n",
+         t->frozen_layout_p.load()->GetItemCount(),
+         t->frozen_layout_p.load()->GetLeafCount(),
+         t->GetMemoryUsage().frozen_layout_size);
+
+  if(after.frozen_read_count - before.frozen_read_count < (uint64_t)key_num) {
+    printf("Reads were not served by the frozen layout\n");
+
+    exit(1);
+  }
+
+  // Iterators still use the tree
+  size_t iter_count = 0;
+  for(auto it = t->Begin();it.IsEnd() == false;it++) {
+    iter_count++;
+  }
+
+  if(iter_count != expected_item_count) {
+    printf("Wrong iterator count on frozen tree %lu\n", iter_count);
+
+    exit(1);
+  }
+
+  // The first write thaws the tree
+  t->Insert(key_num, key_num);
+  t->Delete(key_num, key_num);
+
+  if((t->IsFrozen() == true) || (t->GetStats().thaw_count != 1UL)) {
+    printf("Write did not thaw the tree\n");
+
+    exit(1);
+  }
+
+  verify_func();
+
+  // The thawed layout is freed by GC once the epoch has passed
+  t->Cleanup();
+
+  if(t->GetMemoryUsage().frozen_layout_size != 0UL) {
+    printf("Thawed layout is not freed by GC\n");
+
+    exit(1);
+  }
+
+  // Freezes again after deleting even keys
+  for(long key = 0;key < key_num;key += 2) {
+    t->Delete(key, key);
+  }
+
+  item_count = t->Freeze();
+  if(item_count != expected_item_count - key_num / 2) {
+    printf("Wrong frozen item count after delete %lu\n", item_count);
+
+    exit(1);
+  }
+
+  for(long key = 0;key < key_num;key++) {
+    size_t expected = ((key % 2) == 1) ? 2 : 0;
+    if(key == wide_key) {
+      expected = wide_value_num - 1;
+    }
+
+    if(t->GetValue(key).size() != expected) {
+      printf("Wrong frozen read result after delete on key %ld\n", key);
+
+      exit(1);
+    }
+  }
+
+  printf("Finished testing frozen tree\n");
+
+  return;
+}
+
+/*
+ * class StringView - Pointer and length into a string key
+ *
+ * There is intentionally no conversion to std::string, so lookups with
+ * this type only compile if they never construct a key
+ */
+class StringView {
+ public:
+  const char *data_p;
+  size_t size;
+
+  StringView(const char *p_data_p, size_t p_size) :
+    data_p{p_data_p},
+    size{p_size}
+  {}
+
+  /*
+   * Compare() - Compares with a string as std::string::compare() does
+   */
+  int Compare(const std::string &key) const {
+    int ret = std::memcmp(data_p, key.data(), std::min(size, key.size()));
+    if(ret != 0) {
+      return ret;
+    }
+
+    return (size < key.size()) ? -1 : ((size > key.size()) ? 1 : 0);
+  }
+};
+
+/*
+ * class StringViewComparator - Transparent comparator of string keys
+ */
+class StringViewComparator {
+ public:
+  using is_transparent = void;
+
+  inline bool operator()(const std::string &k1, const std::string &k2) const {
+    return k1 < k2;
+  }
+
+  inline bool operator()(const StringView &k1, const std::string &k2) const {
+    return k1.Compare(k2) < 0;
+  }
+
+  inline bool operator()(const std::string &k1, const StringView &k2) const {
+    return k2.Compare(k1) > 0;
+  }
+};
+
+/*
+ * class StringViewEqualityChecker - Equality checker of string keys that
+ *                                   also accepts StringView
+ */
+class StringViewEqualityChecker {
+ public:
+  inline bool operator()(const std::string &k1, const std::string &k2) const {
+    return k1 == k2;
+  }
+
+  inline bool operator()(const StringView &k1, const std::string &k2) const {
+    return k1.Compare(k2) == 0;
+  }
+
+  inline bool operator()(const std::string &k1, const StringView &k2) const {
+    return k2.Compare(k1) == 0;
+  }
+};
+
+/*
+ * HeterogeneousLookupTest() - Tests lookups of string keys with key views
+ *
+ * Keys are looked up with StringView into a buffer that holds the key
+ * followed by garbage, both on the tree and after it has been frozen, and
+ * the results must match lookups with std::string
+ */
+void HeterogeneousLookupTest(int key_num) {
+  using StringTreeType = BwTree<std::string,
+                                long,
+                                StringViewComparator,
+                                StringViewEqualityChecker>;
+
+  printf("Testing heterogeneous lookup...\n");
+
+  StringTreeType *t = new StringTreeType{true};
+  t->UpdateThreadLocal(1);
+  t->AssignGCID(0);
+
+  // Odd numbers are inserted, and even ones are used as missing keys
+  for(long i = 1;i < key_num;i += 2) {
+    t->Insert(std::to_string(i * 7919), i);
+
+    if((i % 3) == 0) {
+      t->Insert(std::to_string(i * 7919), -i);
+    }
+  }
+
+  auto verify_func = [t, key_num]() {
+    char buffer[64];
+
+    for(long i = 0;i < key_num;i++) {
+      std::string key = std::to_string(i * 7919);
+
+      // The view must not see the bytes after the key
+      std::memcpy(buffer, key.data(), key.size());
+      std::memcpy(buffer + key.size(), "0123", 4);
+
+      StringView view{buffer, key.size()};
+
+      size_t expected = 0UL;
+      if((i % 2) == 1) {
+        expected = ((i % 3) == 0) ? 2UL : 1UL;
+      }
+
+      std::vector<long> value_list{};
+      t->GetValue(view, value_list);
+
+      size_t value_count = 0UL;
+      long value_sum = 0L;
+      t->ForEachValue(view,
+                      [&value_count, &value_sum](const long &value) {
+                        value_count++;
+                        value_sum += value;
+                      });
+
+      if((value_list.size() != expected) ||
+         (value_count != expected) ||
+         (t->GetValue(key).size() != expected)) {
+        printf("Wrong value count for key view %s\n", key.c_str());
+
+        exit(1);
+      }
+
+      if((expected == 1UL) && ((value_list[0] != i) || (value_sum != i))) {
+        printf("Wrong value for key view %s\n", key.c_str());
+
+        exit(1);
+      }
+    }
+
+    return;
+  };
+
+  verify_func();
+
+  t->Freeze();
+
+  verify_func();
+
+  if(t->GetStats().frozen_read_count == 0UL) {
+    printf("Key views are not looked up on the frozen tree\n");
+
+    exit(1);
+  }
+
+  delete t;
+
+  printf("Finished testing heterogeneous lookup\n");
+
+  return;
+}
@@ -14,6 +14,12 @@ std::atomic<size_t> mixed_insert_success;
 std::atomic<size_t> mixed_delete_success;
 std::atomic<size_t> mixed_delete_attempt;
 
+// Latency of every Insert() and Delete() call; worker threads record into
+// local histograms and merge them here under the lock when they finish
+LatencyHistogram mixed_insert_latency;
+LatencyHistogram mixed_delete_latency;
+std::mutex mixed_latency_lock;
+
 int mixed_thread_num = 8;
 int mixed_key_num = 1024 * 1024;
 
@@ -23,25 +29,47 @@ int mixed_key_num = 1024 * 1024;
  * This is the place where most implementations break
  */
 void MixedTest1(uint64_t thread_id, TreeType *t) {  
+  LatencyHistogram latency{};
+  
   if((thread_id % 2) == 0) {
     for(int i = 0;i < mixed_key_num;i++) {
       int key = mixed_thread_num * i + thread_id;
 
-      if(t->Insert(key, key)) mixed_insert_success.fetch_add(1);
+      uint64_t op_start = LatencyHistogram::ReadTSC();
+      bool ret = t->Insert(key, key);
+      latency.Record(LatencyHistogram::ReadTSC() - op_start);
+      
+      if(ret) mixed_insert_success.fetch_add(1);
     }
 
     printf("Finish Inserting (%lu)\n", thread_id);
+    
+    std::lock_guard<std::mutex> guard{mixed_latency_lock};
+    mixed_insert_latency.Merge(latency);
   } else {
     for(int i = 0;i < mixed_key_num;i++) {
       int key = mixed_thread_num * i + thread_id - 1;
 
-      while(t->Delete(key, key) == false) mixed_delete_attempt.fetch_add(1);
+      while(1) {
+        uint64_t op_start = LatencyHistogram::ReadTSC();
+        bool ret = t->Delete(key, key);
+        latency.Record(LatencyHistogram::ReadTSC() - op_start);
+        
+        if(ret == true) {
+          break;
+        }
+        
+        mixed_delete_attempt.fetch_add(1);
+      }
 
       mixed_delete_success.fetch_add(1);
       mixed_delete_attempt.fetch_add(1);
     }
     
     printf("Finish Deleting (%lu -> %lu)\n", thread_id, thread_id - 1);
+    
+    std::lock_guard<std::mutex> guard{mixed_latency_lock};
+    mixed_delete_latency.Merge(latency);
   }
 
   return;
@@ -68,6 +96,13 @@ void MixedGetValueTest(TreeType *t) {
          mixed_insert_success.load(),
          mixed_delete_success.load());
   printf("    delete attempt = %lu\n", mixed_delete_attempt.load());
+  
+  // Latency is reported per round, so reset it for the next run
+  mixed_insert_latency.Print("Mixed test insert");
+  mixed_delete_latency.Print("Mixed test delete");
+  
+  mixed_insert_latency.Clear();
+  mixed_delete_latency.Clear();
 
   return;
 }
@@ -19,14 +19,28 @@
  * performance test to see how random insert/delete affects performance
  *
  * Also the epoch manager is tested against memory leak and GC efficiency
+ *
+ * Latency of every insert and delete is recorded into a thread local
+ * histogram, which is merged into the shared one every 64K operations such
+ * that the reported percentiles cover all threads
  */
 void StressTest(uint64_t thread_id, TreeType *t) {
   static std::atomic<size_t> tree_size;
   static std::atomic<size_t> insert_success;
   static std::atomic<size_t> delete_success;
   static std::atomic<size_t> total_op;
+  
+  static LatencyHistogram insert_latency;
+  static LatencyHistogram delete_latency;
+  static std::mutex latency_lock;
 
   const size_t thread_num = 8;
+  
+  // Number of local operations between two merges
+  const size_t latency_merge_interval = 64 * 1024;
+  
+  LatencyHistogram latency{};
+  size_t local_op = 0;
 
   int max_key = 1024 * 1024;
 
@@ -39,6 +53,8 @@ void StressTest(uint64_t thread_id, TreeType *t) {
   while(1) {
     int key = uniform_dist(e1);
 
+    uint64_t op_start = LatencyHistogram::ReadTSC();
+
     if((thread_id % 2) == 0) {
       if(t->Insert(key, key)) {
         tree_size.fetch_add(1);
@@ -50,6 +66,21 @@ void StressTest(uint64_t thread_id, TreeType *t) {
         delete_success.fetch_add(1);
       }
     }
+    
+    latency.Record(LatencyHistogram::ReadTSC() - op_start);
+    
+    local_op++;
+    if(local_op % latency_merge_interval == 0) {
+      std::lock_guard<std::mutex> guard{latency_lock};
+      
+      if((thread_id % 2) == 0) {
+        insert_latency.Merge(latency);
+      } else {
+        delete_latency.Merge(latency);
+      }
+      
+      latency.Clear();
+    }
 
     size_t op = total_op.fetch_add(1);
 
@@ -61,6 +92,10 @@ void StressTest(uint64_t thread_id, TreeType *t) {
       printf("    insert success = %lu; delete success = %lu\n",
              insert_success.load(),
              delete_success.load());
+      
+      std::lock_guard<std::mutex> guard{latency_lock};
+      insert_latency.Print("    Stress test insert");
+      delete_latency.Print("    Stress test delete");
     }
 
     size_t remainder = (op % (1024UL * 1024UL * 10UL));
@@ -9,6 +9,41 @@
 
 #include "test_suite.h"
 
+/*
+ * Heap allocation counter
+ *
+ * We replace the global operator new such that every heap allocation made
+ * by the current thread is counted. Benchmarks use this to report the number
+ * of allocations per operation. The counter is thread local, so it does not
+ * introduce any contention between worker threads
+ */
+static thread_local uint64_t thread_alloc_count = 0UL;
+
+void *operator new(size_t size) {
+  thread_alloc_count++;
+  
+  void *p = malloc(size);
+  if(p == nullptr) {
+    throw std::bad_alloc{};
+  }
+  
+  return p;
+}
+
+void operator delete(void *p) noexcept {
+  free(p);
+  
+  return;
+}
+
+/*
+ * GetThreadAllocCount() - Returns the number of heap allocations made by the
+ *                         calling thread so far
+ */
+uint64_t GetThreadAllocCount() {
+  return thread_alloc_count;
+}
+
 /*
  * GetEmptyTree() - Return an empty BwTree with proper constructor argument
  *                  in order to finish all tests without problem
@@ -84,6 +119,34 @@ void PrintStat(TreeType *t) {
          t->delete_abort_count.load(),
          (double)t->delete_abort_count.load() / (double)t->delete_op_count.load());
 
+  // These are always available and do not depend on BWTREE_DEBUG
+  auto stats = t->GetStats();
+
+  printf("Traverse abort = %lu; CAS failure = %lu (leaf data = %lu)\n",
+         stats.traverse_abort_count,
+         stats.GetTotalCASFailureCount(),
+         stats.GetCASFailureCount(TreeType::CASSite::LeafData));
+
+  printf("Consolidate = %lu; split = %lu; merge = %lu; helped removal = %lu\n",
+         stats.consolidate_count,
+         stats.split_count,
+         stats.merge_count,
+         stats.removal_help_count);
+  printf("Deferred merge = %lu; avoided merge = %lu; contention split = %lu\n",
+         stats.deferred_merge_count,
+         stats.avoided_merge_count,
+         stats.contention_split_count);
+  printf("Backoff = %lu; backoff spin = %lu; backoff yield = %lu\n",
+         stats.backoff_count,
+         stats.backoff_spin_count,
+         stats.backoff_yield_count);
+  printf("Leaf retry = %lu; root retry = %lu\n",
+         stats.leaf_retry_count,
+         stats.root_retry_count);
+  printf("Frozen read = %lu; thaw = %lu\n",
+         stats.frozen_read_count,
+         stats.thaw_count);
+
   return;
 }
 
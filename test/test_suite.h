@@ -14,10 +14,21 @@
 #include <map>
 #include <fstream>
 #include <iostream>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <tuple>
 
 #include <pthread.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
 #include "../src/bwtree.h"
+#include "../src/partitioned_bwtree.h"
+#include "../src/normalized_key.h"
 #include "../benchmark/stx_btree/btree_multimap.h"
 #include "../benchmark/libcuckoo/cuckoohash_map.hh"
 #include "../benchmark/art/art.h"
@@ -180,6 +191,118 @@ void LaunchParallelTestID(TreeType *tree_p,
   return;
 }
 
+/*
+ * class ThreadPool - A fixed size thread pool that runs submitted tasks
+ *
+ * Worker threads are assigned GC IDs starting from gc_id_start such that
+ * they could run tasks that access the tree. The caller should make sure
+ * that the tree has enough thread local GC metadata for these IDs (i.e. 
+ * call UpdateThreadLocal() with a large enough number) before creating 
+ * the pool, and the GC ID of the caller thread does not overlap with
+ * worker threads
+ *
+ * All tasks are finished before the destructor returns
+ */
+class ThreadPool {
+ private:
+  TreeType *tree_p;
+  std::vector<std::thread> thread_group;
+  
+  std::mutex task_lock;
+  std::condition_variable task_cv;
+  std::queue<std::function<void()>> task_queue;
+  bool stop_flag;
+  
+  /*
+   * WorkerLoop() - Runs tasks until the pool is stopped and the queue 
+   *                is empty
+   */
+  void WorkerLoop(int gc_id) {
+    if(tree_p != nullptr) {
+      tree_p->AssignGCID(gc_id);
+    }
+    
+    while(1) {
+      std::function<void()> task{};
+      
+      {
+        std::unique_lock<std::mutex> guard{task_lock};
+        task_cv.wait(guard, [this]() {
+          return (stop_flag == true) || (task_queue.empty() == false);
+        });
+        
+        if(task_queue.empty() == true) {
+          break;
+        }
+        
+        task = std::move(task_queue.front());
+        task_queue.pop();
+      }
+      
+      task();
+    }
+    
+    if(tree_p != nullptr) {
+      // Make sure it does not stand on the way of other threads
+      tree_p->UnregisterThread(gc_id);
+    }
+    
+    return;
+  }
+  
+ public:
+ 
+  /*
+   * Constructor - Starts thread_num worker threads
+   */
+  ThreadPool(TreeType *p_tree_p, size_t thread_num, int gc_id_start) :
+    tree_p{p_tree_p},
+    thread_group{},
+    task_lock{},
+    task_cv{},
+    task_queue{},
+    stop_flag{false} {
+    for(size_t i = 0;i < thread_num;i++) {
+      thread_group.push_back(
+        std::thread{&ThreadPool::WorkerLoop, this, gc_id_start + (int)i});
+    }
+    
+    return;
+  }
+  
+  /*
+   * Destructor - Waits for all tasks to finish and joins worker threads
+   */
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> guard{task_lock};
+      stop_flag = true;
+    }
+    
+    task_cv.notify_all();
+    
+    for(std::thread &t : thread_group) {
+      t.join();
+    }
+    
+    return;
+  }
+  
+  /*
+   * Submit() - Adds a task to the queue
+   */
+  void Submit(std::function<void()> &&task) {
+    {
+      std::lock_guard<std::mutex> guard{task_lock};
+      task_queue.push(std::move(task));
+    }
+    
+    task_cv.notify_one();
+    
+    return;
+  }
+};
+
 /*
  * class Random - A random number generator
  *
@@ -337,6 +460,241 @@ class Timer {
   }
 };
 
+/*
+ * class LatencyHistogram - Log-bucketed histogram of per-operation latency
+ *
+ * Latencies are recorded in TSC cycles. Values below SUB_BUCKET_COUNT have
+ * their own buckets; larger values are grouped by the position of the most
+ * significant bit, and each group is split into SUB_BUCKET_COUNT linear
+ * sub-buckets, which bounds the relative error to about 6%. Recording is
+ * a few arithmetic instructions plus one increment, so every operation
+ * could be sampled without distorting throughput numbers
+ *
+ * Each thread owns one histogram; histograms are merged after all threads
+ * have finished. The object is padded such that adjacent histograms in an
+ * array do not share cache lines
+ */
+class LatencyHistogram {
+ public:
+  // Number of linear sub-buckets per power of two
+  static constexpr int SUB_BUCKET_BITS = 4;
+  static constexpr uint64_t SUB_BUCKET_COUNT = 1UL << SUB_BUCKET_BITS;
+
+  // One group for values < SUB_BUCKET_COUNT plus one group for each
+  // possible most significant bit above that
+  static constexpr size_t BUCKET_COUNT = \
+    (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+ private:
+  uint64_t count;
+  uint64_t sum;
+  uint64_t max;
+
+  uint64_t bucket_list[BUCKET_COUNT];
+
+  // Avoids false sharing with the next histogram in an array; one
+  // cache line is 64 bytes
+  char padding[64];
+
+  /*
+   * GetBucketIndex() - Maps a latency value to its bucket
+   */
+  static inline size_t GetBucketIndex(uint64_t value) {
+    if(value < SUB_BUCKET_COUNT) {
+      return static_cast<size_t>(value);
+    }
+
+    int msb = 63 - __builtin_clzl(value);
+    uint64_t sub = (value >> (msb - SUB_BUCKET_BITS)) & (SUB_BUCKET_COUNT - 1);
+
+    return (msb - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT + sub;
+  }
+
+  /*
+   * GetBucketValue() - Returns the midpoint of the value range of a bucket
+   */
+  static inline uint64_t GetBucketValue(size_t index) {
+    if(index < SUB_BUCKET_COUNT) {
+      return index;
+    }
+
+    uint64_t group = index / SUB_BUCKET_COUNT;
+    uint64_t sub = index % SUB_BUCKET_COUNT;
+    uint64_t width = 1UL << (group - 1);
+
+    return ((SUB_BUCKET_COUNT + sub) << (group - 1)) + width / 2;
+  }
+
+ public:
+
+  /*
+   * Constructor - Initializes an empty histogram
+   */
+  LatencyHistogram() {
+    Clear();
+
+    return;
+  }
+
+  /*
+   * Clear() - Removes all recorded values
+   */
+  void Clear() {
+    count = 0UL;
+    sum = 0UL;
+    max = 0UL;
+
+    memset(bucket_list, 0x00, sizeof(bucket_list));
+
+    return;
+  }
+
+  /*
+   * ReadTSC() - Returns the current value of the time stamp counter
+   *
+   * On platforms without rdtsc we fall back to a nanosecond clock, in which
+   * case GetCyclesPerNanosecond() calibrates to 1.0
+   */
+  static inline uint64_t ReadTSC() {
+    #if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+    #else
+    return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    #endif
+  }
+
+  /*
+   * GetCyclesPerNanosecond() - Calibrates TSC frequency against steady_clock
+   *
+   * This is computed once by spinning for 10 milliseconds on the first call
+   */
+  static double GetCyclesPerNanosecond() {
+    static const double cycles_per_ns = []() {
+      auto start_time = std::chrono::steady_clock::now();
+      uint64_t start_tsc = ReadTSC();
+      auto end_time = start_time;
+
+      do {
+        end_time = std::chrono::steady_clock::now();
+      } while(end_time - start_time < std::chrono::milliseconds(10));
+
+      uint64_t end_tsc = ReadTSC();
+      double ns = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+          end_time - start_time).count());
+
+      return static_cast<double>(end_tsc - start_tsc) / ns;
+    }();
+
+    return cycles_per_ns;
+  }
+
+  /*
+   * Record() - Adds one latency sample in cycles
+   */
+  inline void Record(uint64_t cycles) {
+    bucket_list[GetBucketIndex(cycles)]++;
+    count++;
+    sum += cycles;
+
+    if(cycles > max) {
+      max = cycles;
+    }
+
+    return;
+  }
+
+  /*
+   * Merge() - Adds all samples of another histogram into this one
+   */
+  void Merge(const LatencyHistogram &other) {
+    for(size_t i = 0;i < BUCKET_COUNT;i++) {
+      bucket_list[i] += other.bucket_list[i];
+    }
+
+    count += other.count;
+    sum += other.sum;
+
+    if(other.max > max) {
+      max = other.max;
+    }
+
+    return;
+  }
+
+  /*
+   * MergeAll() - Returns a histogram with samples of all histograms in a list
+   */
+  static LatencyHistogram MergeAll(const std::vector<LatencyHistogram> &list) {
+    LatencyHistogram ret{};
+
+    for(const LatencyHistogram &hist : list) {
+      ret.Merge(hist);
+    }
+
+    return ret;
+  }
+
+  /*
+   * GetCount() - Returns the number of samples
+   */
+  inline uint64_t GetCount() const {
+    return count;
+  }
+
+  /*
+   * GetPercentile() - Returns the latency in cycles below which the given
+   *                   fraction of samples fall
+   *
+   * The result is the midpoint of the bucket, and is never larger than the
+   * maximum sample
+   */
+  uint64_t GetPercentile(double fraction) const {
+    if(count == 0UL) {
+      return 0UL;
+    }
+
+    uint64_t target = static_cast<uint64_t>(fraction * count);
+    if(target >= count) {
+      target = count - 1;
+    }
+
+    uint64_t seen = 0UL;
+    for(size_t i = 0;i < BUCKET_COUNT;i++) {
+      seen += bucket_list[i];
+
+      if(seen > target) {
+        return std::min(GetBucketValue(i), max);
+      }
+    }
+
+    return max;
+  }
+
+  /*
+   * Print() - Prints mean and tail latency in nanoseconds
+   */
+  void Print(const char *name) const {
+    double cycles_per_ns = GetCyclesPerNanosecond();
+    double mean = (count == 0UL) ? 0.0 : static_cast<double>(sum) / count;
+
+    printf("%s latency (ns, %lu samples): mean %.1f; p50 %.1f; p90 %.1f; "
+           "p99 %.1f; p999 %.1f; max %.1f\n",
+           name,
+           count,
+           mean / cycles_per_ns,
+           GetPercentile(0.5) / cycles_per_ns,
+           GetPercentile(0.9) / cycles_per_ns,
+           GetPercentile(0.99) / cycles_per_ns,
+           GetPercentile(0.999) / cycles_per_ns,
+           max / cycles_per_ns);
+
+    return;
+  }
+};
+
 /*
  * class Envp() - Reads environmental variables 
  */
@@ -601,15 +959,25 @@ class Zipfian {
  */
 class CacheMeter {
  public: 
+  // There are no counters, so callers should not report the zeros below
+  static constexpr bool AVAILABLE = false;
+  
   CacheMeter() {};
-  CacheMeter(bool) {};
+  CacheMeter(bool, int=2) {};
   ~CacheMeter() {}
   void Start() {};
   void Stop() {};
   void PrintL3CacheUtilization() {};
   void PrintL1CacheUtilization() {};
-  void GetL3CacheUtilization() {};
-  void GetL1CacheUtilization() {};
+  
+  // Without PAPI there are no accesses or misses to report
+  std::pair<long long, long long> GetL3CacheUtilization() {
+    return std::make_pair(0LL, 0LL);
+  };
+  
+  std::pair<long long, long long> GetL1CacheUtilization() {
+    return std::make_pair(0LL, 0LL);
+  };
 };
 
 #else
@@ -696,6 +1064,9 @@ class CacheMeter {
   }
   
  public:
+  // Events are counted by PAPI; the constructor exits if they are not
+  // supported
+  static constexpr bool AVAILABLE = true;
    
   /*
    * CacheMeter() - Initialize PAPI and events
@@ -917,6 +1288,7 @@ void DestroyBTree(BTreeType *t);
 
 void PrintStat(TreeType *t);
 void PinToCore(size_t core_id);
+uint64_t GetThreadAllocCount();
 
 /*
  * Basic test suite
@@ -942,6 +1314,9 @@ extern std::atomic<size_t> mixed_insert_success;
 extern std::atomic<size_t> mixed_delete_success;
 extern std::atomic<size_t> mixed_delete_attempt;
 
+extern LatencyHistogram mixed_insert_latency;
+extern LatencyHistogram mixed_delete_latency;
+
 extern int mixed_thread_num;
 extern int mixed_key_num;
 
@@ -962,6 +1337,12 @@ void BenchmarkBwTreeSeqInsert(TreeType *t, int key_num, int thread_num);
 void BenchmarkBwTreeSeqRead(TreeType *t, int key_num, int thread_num);
 void BenchmarkBwTreeRandRead(TreeType *t, int key_num, int thread_num);
 void BenchmarkBwTreeZipfRead(TreeType *t, int key_num, int thread_num);
+void BenchmarkBwTreeContentionSplit(int key_num, int thread_num);
+void BenchmarkBwTreeAsync(int key_num);
+void BenchmarkBwTreeFrozen(int key_num);
+void BenchmarkBwTreeAllocFreeRead(TreeType *t, int key_num, int thread_num);
+void BenchmarkBwTreeFullScan(TreeType *t, int key_num);
+void BenchmarkBwTreeParallelScan(TreeType *t, int key_num, int thread_num);
 
 // Benchmark for stx::btree
 void BenchmarkBTreeSeqInsert(BTreeType *t, 
@@ -1014,6 +1395,10 @@ void StressTest(uint64_t thread_id, TreeType *t);
  */
 void ForwardIteratorTest(TreeType *t, int key_num);
 void BackwardIteratorTest(TreeType *t, int key_num);
+void PinnedIteratorTest(TreeType *t, int key_num);
+void RangeScanTest(TreeType *t, int key_num);
+void ParallelScanTest(TreeType *t, int key_num);
+void ReverseScanTest(TreeType *t, int key_num);
 
 /*
  * Random test suite
@@ -1031,4 +1416,45 @@ void RandomInsertVerify(TreeType *t);
  * Misc test suite
  */
 void TestEpochManager(TreeType *t);
+void MemoryUsageTest(TreeType *t, int key_num);
+void NormalizedKeyTest(int key_num);
+void OperationStatsTest(TreeType *t, int key_num);
+void AnalyzeTreeTest(TreeType *t, int key_num);
+void NodeIDRecycleTest(TreeType *t, int key_num);
+void NodeIDRecycleStressTest(TreeType *t, int key_num, int thread_num);
+void RemovalHelpTest(TreeType *t, int key_num);
+void DeferredMergeTest(TreeType *t, int key_num);
+void AppendSplitTest(TreeType *t, int key_num);
+void ContentionSplitTest(TreeType *t, int key_num);
+void BackoffTest(TreeType *t, int key_num, int thread_num);
+void LeafRetryTest(TreeType *t, int key_num);
+void AsyncOperationTest(TreeType *t, int key_num);
+void AsyncConcurrentWriteTest(TreeType *t, int key_num);
+void AsyncEpochTest(TreeType *t, int key_num);
+void PartitionedTreeTest(int key_num, int thread_num);
+void FreezeTest(TreeType *t, int key_num);
+void HeterogeneousLookupTest(int key_num);
+
+/*
+ * Normalized key benchmark
+ */
+void BenchmarkNormalizedKeySort(int key_num);
+void BenchmarkNormalizedKeyTree(int key_num);
+
+/*
+ * YCSB benchmark
+ */
+void BenchmarkYCSB(int record_num,
+                   int op_num,
+                   int thread_num,
+                   const std::string &workload_names,
+                   const std::string &csv_file_name);
+
+/*
+ * Thread scaling benchmark
+ */
+void BenchmarkScaling(int key_num,
+                      int core_num,
+                      int repeat_num,
+                      const std::string &csv_file_name);
 